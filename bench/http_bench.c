@@ -0,0 +1,233 @@
+#define _GNU_SOURCE
+// Web API服务器基准测试 (make httpbench，服务器使用模拟GPIO后端)
+// 与wrk类似：每个连接一个线程，使用keep-alive长连接，每轮流水线发送depth个GET请求再读取全部响应，
+// 统计每秒请求数和每轮的往返延迟。服务器中途关闭连接或返回非200都算失败。
+// 用法: http_bench [-H 地址] [-p 端口] [-c 连接数] [-t 秒] [-d 流水线深度]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "latency_stats.h"
+
+#define MAX_CONNECTIONS 64
+#define MAX_DEPTH 64
+#define RESPONSE_BUF 65536
+
+static const char *g_host = "127.0.0.1";
+static int g_port = 8080;
+static int g_connections = 8;
+static int g_seconds = 5;
+static int g_depth = 8;
+static volatile int g_running = 1;
+
+typedef struct {
+    pthread_t thread;
+    int index;
+    unsigned long requests;        // 收到的完整响应
+    unsigned long bad_status;      // 非200响应
+    int failed;                    // 连接被关闭或收发出错
+    latency_stats_t rtt;           // 每轮流水线的往返时间
+} worker_t;
+
+// 轮流请求的接口 (都只读取缓存，不会阻塞在传感器上)
+static const char *g_paths[] = { "/api/status", "/api/sensors", "/api/distance" };
+
+#define PATH_KINDS (sizeof(g_paths) / sizeof(g_paths[0]))
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int connect_server(void)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_port);
+    inet_pton(AF_INET, g_host, &addr.sin_addr);
+
+    // 服务器可能刚启动，重试几次
+    for (int i = 0; i < 50; i++) {
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        usleep(100000);
+    }
+    close(fd);
+    return -1;
+}
+
+static int send_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// 解析buf开头的一个响应：完整时返回长度，不完整返回0，格式错误或服务器要求关闭时返回-1
+static long parse_response(const char *buf, size_t len, int *ok)
+{
+    const char *end = memmem(buf, len, "\r\n\r\n", 4);
+    if (end == NULL) return 0;
+
+    size_t hdr_len = (size_t)(end - buf) + 4;
+    const char *cl = memmem(buf, hdr_len, "Content-Length: ", 16);
+    if (cl == NULL || memmem(buf, hdr_len, "Connection: close", 17) != NULL) return -1;
+
+    size_t total = hdr_len + strtoul(cl + 16, NULL, 10);
+    if (len < total) return 0;
+    *ok = (len >= 12 && memcmp(buf, "HTTP/1.1 200", 12) == 0);
+    return (long)total;
+}
+
+static void *worker_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    char request[MAX_DEPTH * 128];
+    static __thread char response[RESPONSE_BUF];
+    size_t request_len = 0;
+
+    int fd = connect_server();
+    if (fd < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+
+    // 每轮发送的请求固定，从不同接口开始
+    for (int i = 0; i < g_depth; i++) {
+        request_len += snprintf(request + request_len, sizeof(request) - request_len,
+                                "GET %s HTTP/1.1\r\nHost: %s\r\n\r\n",
+                                g_paths[(w->index + i) % PATH_KINDS], g_host);
+    }
+
+    while (g_running) {
+        uint64_t t0 = now_ns();
+        if (send_all(fd, request, request_len) != 0) {
+            w->failed = 1;
+            break;
+        }
+
+        // 读取本轮的全部响应
+        size_t len = 0;
+        int pending = g_depth;
+        while (pending > 0) {
+            ssize_t n = recv(fd, response + len, sizeof(response) - len, 0);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                w->failed = 1;
+                break;
+            }
+            len += n;
+
+            size_t pos = 0;
+            while (pending > 0) {
+                int ok = 0;
+                long used = parse_response(response + pos, len - pos, &ok);
+                if (used == 0) break;
+                if (used < 0) {
+                    w->failed = 1;
+                    pending = 0;
+                    break;
+                }
+                w->requests++;
+                if (!ok) w->bad_status++;
+                pos += used;
+                pending--;
+            }
+            len -= pos;
+            memmove(response, response + pos, len);
+        }
+        if (w->failed) break;
+        latency_record(&w->rtt, now_ns() - t0);
+    }
+
+    close(fd);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    worker_t workers[MAX_CONNECTIONS];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H:p:c:t:d:")) != -1) {
+        switch (opt) {
+            case 'H': g_host = optarg; break;
+            case 'p': g_port = atoi(optarg); break;
+            case 'c': g_connections = atoi(optarg); break;
+            case 't': g_seconds = atoi(optarg); break;
+            case 'd': g_depth = atoi(optarg); break;
+            default:
+                printf("用法: %s [-H 地址] [-p 端口] [-c 连接数] [-t 秒] [-d 流水线深度]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (g_connections < 1) g_connections = 1;
+    if (g_connections > MAX_CONNECTIONS) g_connections = MAX_CONNECTIONS;
+    if (g_depth < 1) g_depth = 1;
+    if (g_depth > MAX_DEPTH) g_depth = MAX_DEPTH;
+
+    printf("HTTP基准测试: %d 个keep-alive连接, %d 秒, 流水线深度 %d\n", g_connections, g_seconds, g_depth);
+    double t0 = now_sec();
+    for (int i = 0; i < g_connections; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]);
+    }
+
+    sleep(g_seconds);
+    g_running = 0;
+
+    unsigned long requests = 0, bad_status = 0;
+    int failed = 0;
+    latency_stats_t rtt;
+    memset(&rtt, 0, sizeof(rtt));
+    for (int i = 0; i < g_connections; i++) {
+        pthread_join(workers[i].thread, NULL);
+        requests += workers[i].requests;
+        bad_status += workers[i].bad_status;
+        failed += workers[i].failed;
+        rtt.count += workers[i].rtt.count;
+        rtt.total_ns += workers[i].rtt.total_ns;
+        if (workers[i].rtt.max_ns > rtt.max_ns) rtt.max_ns = workers[i].rtt.max_ns;
+        for (int k = 0; k < LATENCY_BUCKETS; k++) rtt.hist[k] += workers[i].rtt.hist[k];
+    }
+    double elapsed = now_sec() - t0;
+
+    printf("请求: %lu, 非200响应: %lu, 失败连接: %d\n", requests, bad_status, failed);
+    printf("吞吐量: %.0f 请求/秒\n", requests / elapsed);
+    printf("每轮往返 (%d 个请求): 平均 %.1fus, p50 %.0fus, p99 %.0fus, 最大 %.1fus\n", g_depth,
+           latency_avg_us(&rtt), latency_percentile_us(&rtt, 50.0), latency_percentile_us(&rtt, 99.0),
+           rtt.max_ns / 1000.0);
+
+    return (failed == 0 && bad_status == 0 && requests > 0) ? 0 : 1;
+}
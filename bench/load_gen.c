@@ -0,0 +1,1410 @@
+#define _GNU_SOURCE
+// 控制服务器负载测试 (make loadtest，服务器使用模拟GPIO后端)
+// 多个客户端并发发送命令，结束后查询服务器统计，计算每秒处理的命令数。
+// 二进制模式每PROTO_ACK_EVERY帧请求一次ACK，统计往返延迟。
+// UDP模式 (-U) 按固定频率发送遥控命令，可模拟丢包 (-l %) 和乱序重发 (-x %)，
+// 统计两端看到的丢失、旧命令和往返延迟，最后验证死人开关会停车；
+// 同时请求APPLIED回复统计命令到PWM的延迟，并穿插PING测量网络往返时间。
+// 遥测模式 (-T) 客户端订阅遥测，半数客户端从不读取，验证慢客户端只会丢帧而不影响其他订阅者。
+// WebSocket模式 (-W) 客户端连接实时数据推送 (JSON和二进制各半)，同时用文本命令不断改变运动状态，
+// 验证首条消息是完整状态、之后只推送变化的字段组，半数客户端从不读取时服务器跳过推送而不影响其他连接。
+// 运动程序模式 (-P) 通过HTTP端口上传一段定时程序，同时多个客户端不断查询统计，检查程序按本地时钟准时完成。
+// 共享内存模式 (-S) 映射服务器的共享内存状态块，通过邮箱连续提交命令，多个线程同时读取运动状态检查快照一致，
+// 测量命令被取出执行的延迟，最后验证占用邮箱的进程退出后服务器停车。
+// 控制权仲裁模式 (-A) 多个连接争夺控制权，检查拒绝、抢占、观察者、限时租约到期停车和空闲租约失效
+// (通过共享内存读取运动状态和持有者)。
+// 用法: load_gen [-H 地址] [-p 端口] [-c 客户端数] [-t 秒] [-b 每次发送的命令数] [-B]
+//                [-U [-r 每客户端频率Hz] [-l 丢包%] [-x 乱序%]] [-T [-r 订阅频率Hz]]
+//                [-W [-w WebSocket端口] [-r 推送频率Hz]] [-P [-w HTTP端口]] [-S [-m 共享内存名称]]
+//                [-A [-m 共享内存名称]]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "protocol.h"
+#include "control_server.h"
+#include "shm_status.h"
+#include "arbiter.h"
+#include "latency_stats.h"
+
+#define MAX_CLIENTS 64
+#define PROTO_ACK_EVERY 16
+#define UDP_WAIT_DEADMAN_MS 500    // 大于服务器默认的死人开关时间
+#define TLM_SLOW_RCVBUF 1024       // 不读取的订阅者使用很小的接收缓冲区，尽快填满
+#define UDP_PING_EVERY 10          // UDP模式每发送10条命令发送一次PING
+#define WS_DRIVE_INTERVAL_US 15000 // WebSocket模式切换运动命令的间隔
+#define PROGRAM_PERIODS 10         // 运动程序模式的方波周期数
+#define PROGRAM_STEP_MS 50
+#define PROGRAM_MAX_ERROR_MS 20    // 程序总时长允许的误差
+#define SHM_LATENCY_SAMPLES 200    // 共享内存模式逐条测量取出延迟的命令数
+#define SHM_MAX_LATENCY_US 20000   // 取出延迟上限 (服务器每SHM_TICK_MS取出一次)
+#define SHM_EXIT_WAIT_MS 3000      // 等待服务器发现邮箱进程退出
+#define SHM_MOTION_STOP 0          // motion_type_t (components/control.h)
+#define SHM_MOTION_FORWARD 1
+#define SHM_MOTION_BACKWARD 2
+#define ARB_LEASE_MS 300           // 控制权仲裁模式的限时租约
+#define ARB_EXPIRE_SLACK_MS 100    // 到期停车允许的延迟 (到期检查周期 + 共享内存发布周期)
+
+static const char *g_host = "127.0.0.1";
+static int g_port = 25500;
+static int g_clients = 8;
+static int g_seconds = 5;
+static int g_batch = 16;
+static int g_binary = 0;
+static int g_udp = 0;
+static int g_telemetry = 0;
+static int g_websocket = 0;
+static int g_program = 0;
+static int g_shm = 0;
+static int g_arbitration = 0;
+static const char *g_shm_name = SHM_STATUS_NAME;
+static shm_status_t *g_status;
+static int g_ws_port = 8081;
+static int g_rate_hz = 1000;
+static int g_loss_pct = 0;
+static int g_reorder_pct = 0;
+static volatile int g_running = 1;
+
+typedef struct {
+    pthread_t thread;
+    int index;
+    unsigned long sent;
+    int failed;
+    unsigned long acks;
+    uint64_t rtt_total_us;
+    uint64_t rtt_max_us;
+    // UDP模式
+    unsigned long dropped;         // 模拟丢弃 (未发送) 的命令
+    unsigned long replayed;        // 模拟乱序重发的旧命令
+    unsigned long ack_status[4];   // 按状态统计的ACK
+    latency_stats_t rtt;
+    unsigned long applied_status[4]; // 按状态统计的APPLIED
+    latency_stats_t apply;         // 服务器读入到写入PWM
+    latency_stats_t ping;          // PING往返
+    // 遥测模式
+    unsigned long frames;          // 收到的遥测帧
+    unsigned long gaps;            // 帧序号不连续的次数
+    // WebSocket模式
+    unsigned long bytes;
+    unsigned long redundant;       // 首条消息之后包含未变化字段组的消息
+    int first_full;                // 首条消息包含完整状态
+    // 共享内存模式
+    unsigned long torn;            // 不一致的运动状态快照
+    unsigned long retries;         // seqlock重试次数
+} worker_t;
+
+// 客户端命令序列，包含不带分隔符的合并命令
+static const char *g_commands[] = {
+    "forward\n", "stop\n", "spinleft", "spinright", "backward\n", "forwardleft;", "stop",
+};
+
+#define COMMAND_KINDS (sizeof(g_commands) / sizeof(g_commands[0]))
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int connect_port(int port)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, g_host, &addr.sin_addr);
+
+    // 服务器可能刚启动，重试几次
+    for (int i = 0; i < 50; i++) {
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        usleep(100000);
+    }
+    close(fd);
+    return -1;
+}
+
+static int connect_server(void)
+{
+    return connect_port(g_port);
+}
+
+static int send_all(int fd, const char *data, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// 读取并统计已到达的ACK (不阻塞)，frames/len为跨读取保留的半帧
+static void drain_acks(worker_t *w, int fd, uint8_t *frames, size_t *len)
+{
+    for (;;) {
+        ssize_t n = recv(fd, frames + *len, 4096 - *len, MSG_DONTWAIT);
+        if (n <= 0) return;
+        *len += n;
+
+        size_t pos = 0;
+        uint64_t now = now_us();
+        for (;;) {
+            proto_frame_t frame;
+            proto_ack_t ack;
+            int used = proto_parse(frames + pos, *len - pos, &frame);
+            if (used == 0) break;
+            if (used < 0) {
+                pos++;
+                continue;
+            }
+            pos += used;
+            if (proto_decode_ack(&frame, &ack) == 0) {
+                uint64_t rtt = now - ack.echo_us;
+                w->acks++;
+                w->rtt_total_us += rtt;
+                if (rtt > w->rtt_max_us) w->rtt_max_us = rtt;
+            }
+        }
+        *len -= pos;
+        memmove(frames, frames + pos, *len);
+    }
+}
+
+// 填充一批命令，返回字节数
+static size_t fill_batch(worker_t *w, char *buf, size_t size, int *kind, uint32_t *seq)
+{
+    size_t len = 0;
+
+    for (int i = 0; i < g_batch; i++) {
+        if (g_binary) {
+            if (len + PROTO_MAX_FRAME > size) break;
+            uint8_t flags = (*seq % PROTO_ACK_EVERY == 0) ? PROTO_FLAG_ACK_REQ : 0;
+            uint8_t motion = (uint8_t)(*kind % PROTO_MOTION_COUNT);
+            len += proto_encode_drive((uint8_t *)buf + len, (*seq)++, now_us(), flags, motion, 50, 50);
+        } else {
+            const char *cmd = g_commands[*kind % COMMAND_KINDS];
+            size_t n = strlen(cmd);
+            if (len + n > size) break;
+            memcpy(buf + len, cmd, n);
+            len += n;
+        }
+        (*kind)++;
+        w->sent++;
+    }
+    return len;
+}
+
+static void *worker_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    char buf[4096];
+    uint8_t frames[4096];
+    size_t frames_len = 0;
+    uint32_t seq = 1;
+    int fd = connect_server();
+
+    if (fd < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+
+    int kind = w->index;
+    while (g_running) {
+        size_t len = fill_batch(w, buf, sizeof(buf), &kind, &seq);
+        if (send_all(fd, buf, len) != 0) {
+            w->failed = 1;
+            break;
+        }
+        if (g_binary) {
+            drain_acks(w, fd, frames, &frames_len);
+        }
+    }
+
+    // 确保最后一条是停车命令
+    if (g_binary) {
+        size_t len = proto_encode_drive((uint8_t *)buf, seq++, now_us(), 0, PROTO_MOTION_STOP, 0, 0);
+        send_all(fd, buf, len);
+    } else {
+        send_all(fd, " stop\n", 6);
+    }
+
+    // 半关闭后读到EOF再关闭：带着未读的ACK直接close会发出RST，服务器会丢弃尚未处理的命令
+    shutdown(fd, SHUT_WR);
+    while (recv(fd, buf, sizeof(buf), 0) > 0)
+        ;
+    close(fd);
+    return NULL;
+}
+
+// UDP遥控客户端：按固定频率发送最新状态，每帧请求ACK
+static void *udp_worker_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    struct sockaddr_in addr;
+    uint8_t frame[PROTO_MAX_FRAME], old_frame[PROTO_MAX_FRAME], rx[256];
+    size_t old_len = 0;
+    uint32_t seq = 1;
+    unsigned int rand_state = 12345u + (unsigned int)w->index;
+    struct timespec next;
+    long period_ns = 1000000000L / g_rate_hz;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_port);
+    inet_pton(AF_INET, g_host, &addr.sin_addr);
+    connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    while (g_running) {
+        uint8_t motion = (uint8_t)(1 + (seq / 50) % (PROTO_MOTION_COUNT - 1));
+        size_t len = proto_encode_drive(frame, seq++, now_us(), PROTO_FLAG_ACK_REQ | PROTO_FLAG_APPLIED_REQ,
+                                        motion, 50, 50);
+
+        if ((int)(rand_r(&rand_state) % 100) < g_loss_pct) {
+            w->dropped++;
+        } else {
+            send(fd, frame, len, 0);
+            w->sent++;
+        }
+
+        // 偶尔重发一条较早的命令，服务器应判定为旧命令并丢弃
+        if (old_len > 0 && (int)(rand_r(&rand_state) % 100) < g_reorder_pct) {
+            send(fd, old_frame, old_len, 0);
+            w->replayed++;
+        }
+        if (seq % 8 == 0) {
+            memcpy(old_frame, frame, len);
+            old_len = len;
+        }
+        if (seq % UDP_PING_EVERY == 0) {
+            uint8_t ping[PROTO_MAX_FRAME];
+            send(fd, ping, proto_encode_ping(ping, seq, now_us()), 0);
+        }
+
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+
+        // 等待下一个发送时刻，期间ACK一到就读取，往返时间不受发送周期影响
+        for (;;) {
+            struct timespec now, timeout;
+            struct pollfd pfd = { fd, POLLIN, 0 };
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            long remain = (next.tv_sec - now.tv_sec) * 1000000000L + (next.tv_nsec - now.tv_nsec);
+            if (remain <= 0) break;
+            timeout.tv_sec = remain / 1000000000L;
+            timeout.tv_nsec = remain % 1000000000L;
+            if (ppoll(&pfd, 1, &timeout, NULL) <= 0) continue;
+
+            ssize_t n;
+            while ((n = recv(fd, rx, sizeof(rx), MSG_DONTWAIT)) > 0) {
+                proto_frame_t f;
+                proto_ack_t ack;
+                proto_pong_t pong;
+                if (proto_parse(rx, n, &f) != n) continue;
+                if (proto_decode_ack(&f, &ack) == 0) {
+                    if (ack.status < 4) w->ack_status[ack.status]++;
+                    if (ack.status == PROTO_STATUS_OK || ack.status == PROTO_STATUS_SUPERSEDED) {
+                        latency_record(&w->rtt, (now_us() - ack.echo_us) * 1000ULL);
+                    }
+                } else if (proto_decode_applied(&f, &ack) == 0) {
+                    if (ack.status < 4) w->applied_status[ack.status]++;
+                    if (ack.status == PROTO_STATUS_OK) latency_record(&w->apply, ack.latency_us * 1000ULL);
+                } else if (proto_decode_pong(&f, &pong) == 0) {
+                    latency_record(&w->ping, (now_us() - pong.echo_us) * 1000ULL);
+                }
+            }
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+// 遥测订阅者：偶数编号的客户端持续读取并统计帧龄，奇数编号的客户端订阅后从不读取
+static void *tlm_worker_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    uint8_t frames[4096];
+    size_t len = 0;
+    uint32_t last_seq = 0;
+    int slow = w->index % 2;
+    int fd = connect_server();
+
+    if (fd < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+    if (slow) {
+        int rcvbuf = TLM_SLOW_RCVBUF;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    uint8_t sub[PROTO_MAX_FRAME];
+    size_t sub_len = proto_encode_subscribe(sub, 1, now_us(), PROTO_TLM_ALL, (uint16_t)g_rate_hz);
+    if (send_all(fd, (const char *)sub, sub_len) != 0) {
+        w->failed = 1;
+        close(fd);
+        return NULL;
+    }
+
+    while (g_running) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+
+        if (slow || poll(&pfd, 1, 100) <= 0) {
+            if (slow) usleep(100000);
+            continue;
+        }
+        ssize_t n = recv(fd, frames + len, sizeof(frames) - len, 0);
+        if (n <= 0) {
+            w->failed = 1;
+            break;
+        }
+        len += n;
+
+        size_t pos = 0;
+        uint64_t now = now_us();
+        for (;;) {
+            proto_frame_t frame;
+            proto_telemetry_t tlm;
+            int used = proto_parse(frames + pos, len - pos, &frame);
+            if (used == 0) break;
+            if (used < 0) {
+                pos++;
+                continue;
+            }
+            pos += used;
+            if (proto_decode_telemetry(&frame, &tlm) != 0 || !(tlm.fields & PROTO_TLM_MOTION)) continue;
+
+            if (w->frames > 0 && frame.header.seq != last_seq + 1) w->gaps++;
+            last_seq = frame.header.seq;
+            w->frames++;
+            latency_record(&w->rtt, (now - frame.header.timestamp_us) * 1000ULL);
+        }
+        len -= pos;
+        memmove(frames, frames + pos, len);
+    }
+
+    close(fd);
+    return NULL;
+}
+
+// WebSocket握手，成功时返回响应头之后已读入的字节数 (已在buf开头)，失败返回-1
+static int ws_handshake(int fd, const char *query, uint8_t *buf, size_t size)
+{
+    char request[256];
+    size_t len = 0;
+    int n = snprintf(request, sizeof(request),
+                     "GET /ws/live?%s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+                     query, g_host);
+
+    if (send_all(fd, request, n) != 0) return -1;
+    for (;;) {
+        ssize_t got = recv(fd, buf + len, size - 1 - len, 0);
+        if (got <= 0) return -1;
+        len += got;
+        buf[len] = '\0';
+        char *end = strstr((char *)buf, "\r\n\r\n");
+        if (end != NULL) {
+            if (strncmp((char *)buf, "HTTP/1.1 101", 12) != 0) return -1;
+            size_t header = (size_t)(end + 4 - (char *)buf);
+            memmove(buf, buf + header, len - header);
+            return (int)(len - header);
+        }
+        if (len >= size - 1) return -1;
+    }
+}
+
+// 检查一条推送消息：返回其中的字段组 (PROTO_TLM_*)，seq为消息序号
+static uint32_t ws_message_fields(int binary, const uint8_t *data, size_t len, uint16_t *seq)
+{
+    uint32_t fields = 0;
+
+    if (binary) {
+        if (len < 8) return 0;
+        *seq = proto_get_u16(data + 2);
+        return data[0];
+    }
+
+    char text[512];
+    if (len >= sizeof(text)) len = sizeof(text) - 1;
+    memcpy(text, data, len);
+    text[len] = '\0';
+    const char *p = strstr(text, "\"seq\":");
+    *seq = p ? (uint16_t)atol(p + 6) : 0;
+    if (strstr(text, "\"motion\":{")) fields |= PROTO_TLM_MOTION;
+    if (strstr(text, "\"env\":")) fields |= PROTO_TLM_ENV;
+    if (strstr(text, "\"distance\":")) fields |= PROTO_TLM_DISTANCE;
+    if (strstr(text, "\"display\":")) fields |= PROTO_TLM_DISPLAY;
+    if (strstr(text, "\"rgb\":")) fields |= PROTO_TLM_RGB;
+    return fields;
+}
+
+// 发送带掩码的文本消息 (客户端发出的帧必须带掩码，这里使用全0掩码)
+static int ws_send_text(int fd, const char *text)
+{
+    uint8_t frame[128];
+    size_t len = strlen(text);
+
+    if (len > 125) return -1;
+    frame[0] = 0x81;
+    frame[1] = 0x80 | (uint8_t)len;
+    memset(frame + 2, 0, 4);
+    memcpy(frame + 6, text, len);
+    return send_all(fd, (const char *)frame, len + 6);
+}
+
+// 实时数据推送订阅者：偶数编号的客户端读取并检查消息 (按编号交替使用JSON和二进制)；
+// 奇数编号的客户端从不读取，并不断修改订阅让服务器每次都推送完整状态，尽快填满缓冲区
+static void *ws_worker_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    uint8_t buf[8192];
+    char query[64];
+    uint16_t last_seq = 0;
+    int slow = w->index % 2;
+    int binary = (w->index / 2) % 2;
+    int fd = connect_port(g_ws_port);
+
+    if (fd < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+    if (slow) {
+        int rcvbuf = TLM_SLOW_RCVBUF;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+
+    snprintf(query, sizeof(query), "format=%s&rate=%d", binary ? "binary" : "json", g_rate_hz);
+    int got = ws_handshake(fd, query, buf, sizeof(buf));
+    if (got < 0) {
+        w->failed = 1;
+        close(fd);
+        return NULL;
+    }
+    size_t len = (size_t)got;
+
+    while (g_running) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+
+        if (slow) {
+            if (ws_send_text(fd, "{\"rate\":50}") != 0) break;
+            usleep(WS_DRIVE_INTERVAL_US);
+            continue;
+        }
+
+        // 服务器发出的帧不带掩码: 2字节头 (+2字节扩展长度)
+        size_t pos = 0;
+        while (len - pos >= 2) {
+            uint8_t opcode = buf[pos] & 0x0f;
+            size_t payload = buf[pos + 1] & 0x7f;
+            size_t header = 2;
+            if (payload == 126) {
+                if (len - pos < 4) break;
+                payload = ((size_t)buf[pos + 2] << 8) | buf[pos + 3];
+                header = 4;
+            } else if (payload == 127) {
+                w->failed = 1;
+                goto out;
+            }
+            if (len - pos < header + payload) break;
+
+            const uint8_t *data = buf + pos + header;
+            pos += header + payload;
+            if (opcode != 1 && opcode != 2) continue;
+
+            uint16_t seq = 0;
+            uint32_t fields = ws_message_fields(opcode == 2, data, payload, &seq);
+            if (w->frames == 0) {
+                w->first_full = (fields & (PROTO_TLM_MOTION | PROTO_TLM_DISPLAY | PROTO_TLM_RGB)) ==
+                                (PROTO_TLM_MOTION | PROTO_TLM_DISPLAY | PROTO_TLM_RGB);
+            } else {
+                // 测试中只改变运动状态，数码管和RGB只应出现在首条消息中
+                if (fields & (PROTO_TLM_DISPLAY | PROTO_TLM_RGB)) w->redundant++;
+                if (seq != (uint16_t)(last_seq + 1)) w->gaps++;
+            }
+            last_seq = seq;
+            w->frames++;
+            w->bytes += payload;
+        }
+        len -= pos;
+        memmove(buf, buf + pos, len);
+
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        ssize_t n = recv(fd, buf + len, sizeof(buf) - len, 0);
+        if (n <= 0) {
+            w->failed = 1;
+            break;
+        }
+        len += n;
+    }
+
+out:
+    close(fd);
+    return NULL;
+}
+
+// 发送一个HTTP请求 (Connection: close)，返回状态码，响应体写入body
+static int http_request(const char *method, const char *path, const char *body, char *out, size_t size)
+{
+    char request[1024];
+    size_t len = 0;
+    int fd = connect_port(g_ws_port);
+
+    if (fd < 0) return -1;
+    int n = snprintf(request, sizeof(request),
+                     "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\nContent-Length: %zu\r\n\r\n%s",
+                     method, path, g_host, strlen(body), body);
+    if (n >= (int)sizeof(request) || send_all(fd, request, n) != 0) {
+        close(fd);
+        return -1;
+    }
+    for (;;) {
+        ssize_t got = recv(fd, out + len, size - 1 - len, 0);
+        if (got <= 0) break;
+        len += got;
+        if (len >= size - 1) break;
+    }
+    close(fd);
+    out[len] = '\0';
+
+    int status = strncmp(out, "HTTP/1.1 ", 9) == 0 ? atoi(out + 9) : -1;
+    char *start = strstr(out, "\r\n\r\n");
+    if (start != NULL) memmove(out, start + 4, strlen(start + 4) + 1);
+    return status;
+}
+
+// 从JSON响应中读取 "key":数值
+static double json_number(const char *json, const char *key)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(json, pattern);
+    return p ? atof(p + strlen(pattern)) : -1;
+}
+
+// 统计查询客户端：不断发送"stats"并读取回复，制造网络负载 (不发送运动命令，不会接管程序)
+static void *stats_worker_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    char reply[2048];
+    int fd = connect_server();
+
+    if (fd < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+    while (g_running) {
+        if (send_all(fd, "stats\n", 6) != 0) {
+            w->failed = 1;
+            break;
+        }
+        ssize_t n = recv(fd, reply, sizeof(reply), 0);
+        if (n <= 0) {
+            w->failed = 1;
+            break;
+        }
+        w->sent++;
+    }
+    close(fd);
+    return NULL;
+}
+
+// 查询服务器统计，返回已处理的命令数
+static long query_stats(char *line, size_t size)
+{
+    int fd = connect_server();
+    size_t len = 0;
+
+    if (fd < 0) return -1;
+    send_all(fd, "stats\n", 6);
+    while (len < size - 1) {
+        ssize_t n = recv(fd, line + len, size - 1 - len, 0);
+        if (n <= 0) break;
+        len += n;
+        if (memchr(line, '\n', len)) break;
+    }
+    close(fd);
+    line[len] = '\0';
+    line[strcspn(line, "\n")] = '\0';
+
+    // 处理的运动命令包括执行的和没有控制权而未执行的
+    const char *p = strstr(line, "commands=");
+    const char *d = strstr(line, " denied=");
+    if (!p) return -1;
+    return atol(p + 9) + (d ? atol(d + 8) : 0);
+}
+
+// 从统计行中读取 key=数值
+static long stat_value(const char *line, const char *key)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), " %s=", key);
+    const char *p = strstr(line, pattern);
+    return p ? atol(p + strlen(pattern)) : -1;
+}
+
+static void latency_merge(latency_stats_t *dst, const latency_stats_t *src)
+{
+    dst->count += src->count;
+    dst->total_ns += src->total_ns;
+    if (src->max_ns > dst->max_ns) dst->max_ns = src->max_ns;
+    for (int k = 0; k < LATENCY_BUCKETS; k++) dst->hist[k] += src->hist[k];
+}
+
+static void print_latency(const char *name, const latency_stats_t *stats)
+{
+    printf("%s: %lu 次, 平均 %.1fus, p50 %.0fus, p99 %.0fus, 最大 %.1fus\n", name, stats->count,
+           latency_avg_us(stats), latency_percentile_us(stats, 50.0), latency_percentile_us(stats, 99.0),
+           stats->max_ns / 1000.0);
+}
+
+// 等待一条ACK，返回其状态，超时返回-1
+static int udp_wait_ack(int fd, int timeout_ms)
+{
+    uint8_t rx[256];
+    struct pollfd pfd = { fd, POLLIN, 0 };
+
+    while (poll(&pfd, 1, timeout_ms) > 0) {
+        ssize_t n = recv(fd, rx, sizeof(rx), 0);
+        proto_frame_t f;
+        proto_ack_t ack;
+        if (n > 0 && proto_parse(rx, n, &f) == n && proto_decode_ack(&f, &ack) == 0) return ack.status;
+    }
+    return -1;
+}
+
+// 新的发送方从序号0开始：第一条 (停车) 命令被接受，重复的序号0必须判定为旧命令
+static int udp_seq_zero_check(void)
+{
+    struct sockaddr_in addr;
+    uint8_t frame[PROTO_MAX_FRAME];
+    int first, second;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(g_port);
+    inet_pton(AF_INET, g_host, &addr.sin_addr);
+    connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+
+    size_t len = proto_encode_drive(frame, 0, now_us(), PROTO_FLAG_ACK_REQ, PROTO_MOTION_STOP, 0, 0);
+    send(fd, frame, len, 0);
+    first = udp_wait_ack(fd, 500);
+    send(fd, frame, len, 0);
+    second = udp_wait_ack(fd, 500);
+    close(fd);
+
+    printf("序号0: 第一条ACK状态 %d, 重复的ACK状态 %d (应为旧命令 %d)\n", first, second, PROTO_STATUS_STALE);
+    return (first >= 0 && first != PROTO_STATUS_STALE && second == PROTO_STATUS_STALE) ? 0 : -1;
+}
+
+// UDP遥控测试：客户端和服务器两端的丢失、旧命令和延迟统计，验证死人开关，最后检查重复的序号0被丢弃
+static int run_udp(worker_t *workers)
+{
+    char before[2048], after[2048];
+
+    if (query_stats(before, sizeof(before)) < 0) {
+        printf("无法连接服务器 %s:%d\n", g_host, g_port);
+        return 1;
+    }
+
+    printf("UDP遥控测试: %d 个客户端, 每客户端 %d Hz, %d 秒, 模拟丢包 %d%%, 乱序重发 %d%%\n",
+           g_clients, g_rate_hz, g_seconds, g_loss_pct, g_reorder_pct);
+    for (int i = 0; i < g_clients; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, udp_worker_thread, &workers[i]);
+    }
+    sleep(g_seconds);
+    g_running = 0;
+
+    unsigned long sent = 0, dropped = 0, replayed = 0, status[4] = {0, 0, 0, 0}, applied[4] = {0, 0, 0, 0};
+    latency_stats_t rtt, apply, ping;
+    memset(&rtt, 0, sizeof(rtt));
+    memset(&apply, 0, sizeof(apply));
+    memset(&ping, 0, sizeof(ping));
+    for (int i = 0; i < g_clients; i++) {
+        pthread_join(workers[i].thread, NULL);
+        sent += workers[i].sent;
+        dropped += workers[i].dropped;
+        replayed += workers[i].replayed;
+        for (int k = 0; k < 4; k++) status[k] += workers[i].ack_status[k];
+        for (int k = 0; k < 4; k++) applied[k] += workers[i].applied_status[k];
+        latency_merge(&rtt, &workers[i].rtt);
+        latency_merge(&apply, &workers[i].apply);
+        latency_merge(&ping, &workers[i].ping);
+    }
+
+    // 停止发送后等待死人开关触发
+    usleep((UDP_WAIT_DEADMAN_MS) * 1000);
+    query_stats(after, sizeof(after));
+
+    unsigned long acked = status[0] + status[1] + status[2] + status[3];
+    unsigned long expected = sent + replayed;
+    printf("客户端: 发送 %lu, 模拟丢弃 %lu, 乱序重发 %lu, 收到ACK %lu (执行 %lu, 取代 %lu, 旧命令 %lu), "
+           "未确认 %.2f%%\n", sent, dropped, replayed, acked, status[PROTO_STATUS_OK],
+           status[PROTO_STATUS_SUPERSEDED], status[PROTO_STATUS_STALE],
+           expected ? 100.0 * (expected - acked) / expected : 0.0);
+    print_latency("命令往返 (ACK)", &rtt);
+    print_latency("PING往返", &ping);
+    print_latency("命令到PWM (APPLIED)", &apply);
+    printf("APPLIED: 已执行 %lu, 被取代 %lu (执行的命令 %lu)\n",
+           applied[PROTO_STATUS_OK], applied[PROTO_STATUS_SUPERSEDED], status[PROTO_STATUS_OK]);
+
+    long lost = stat_value(after, "udp_lost") - stat_value(before, "udp_lost");
+    long stale = stat_value(after, "udp_stale") - stat_value(before, "udp_stale");
+    long deadman = stat_value(after, "udp_deadman") - stat_value(before, "udp_deadman");
+    printf("服务器: 推算丢失 %ld (模拟 %lu), 丢弃旧命令 %ld (模拟 %lu), 死人开关停车 %ld 次\n",
+           lost, dropped, stale, replayed, deadman);
+    printf("服务器: %s\n", after);
+
+    // 旧命令必须全部被丢弃，死人开关必须触发，每条执行的命令都有APPLIED回复 (允许个别丢包)
+    unsigned long reported = applied[PROTO_STATUS_OK] + applied[PROTO_STATUS_SUPERSEDED];
+    int applied_ok = reported * 100 >= status[PROTO_STATUS_OK] * 99 && ping.count > 0;
+    int seq_zero_ok = udp_seq_zero_check() == 0;
+    return (stale >= (long)replayed && deadman >= 1 && applied_ok && seq_zero_ok) ? 0 : 1;
+}
+
+// 遥测测试：正常读取的订阅者应按订阅频率收到连续的帧，不读取的订阅者只导致服务器丢弃旧帧
+static int run_telemetry(worker_t *workers)
+{
+    char before[2048], after[2048];
+
+    if (query_stats(before, sizeof(before)) < 0) {
+        printf("无法连接服务器 %s:%d\n", g_host, g_port);
+        return 1;
+    }
+
+    printf("遥测测试: %d 个订阅者 (其中 %d 个从不读取), %d Hz, %d 秒\n",
+           g_clients, g_clients / 2, g_rate_hz, g_seconds);
+    for (int i = 0; i < g_clients; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, tlm_worker_thread, &workers[i]);
+    }
+    sleep(g_seconds);
+    g_running = 0;
+
+    unsigned long frames = 0, gaps = 0;
+    int readers = 0, failed = 0;
+    latency_stats_t age;
+    memset(&age, 0, sizeof(age));
+    for (int i = 0; i < g_clients; i++) {
+        pthread_join(workers[i].thread, NULL);
+        failed += workers[i].failed;
+        if (workers[i].index % 2) continue;
+        readers++;
+        frames += workers[i].frames;
+        gaps += workers[i].gaps;
+        age.count += workers[i].rtt.count;
+        age.total_ns += workers[i].rtt.total_ns;
+        if (workers[i].rtt.max_ns > age.max_ns) age.max_ns = workers[i].rtt.max_ns;
+        for (int k = 0; k < LATENCY_BUCKETS; k++) age.hist[k] += workers[i].rtt.hist[k];
+    }
+    query_stats(after, sizeof(after));
+
+    int rate = g_rate_hz > PROTO_TLM_MAX_HZ ? PROTO_TLM_MAX_HZ : g_rate_hz;
+    double expected = (double)readers * rate * g_seconds;
+    long dropped = stat_value(after, "frames_dropped") - stat_value(before, "frames_dropped");
+    printf("读取的订阅者: 收到 %lu 帧 (期望约 %.0f), 序号不连续 %lu 次, 失败连接 %d\n",
+           frames, expected, gaps, failed);
+    printf("帧龄: 平均 %.1fus, p50 %.0fus, p99 %.0fus, 最大 %.1fus\n",
+           latency_avg_us(&age), latency_percentile_us(&age, 50.0), latency_percentile_us(&age, 99.0),
+           age.max_ns / 1000.0);
+    printf("服务器: 推送 %ld 帧, 慢客户端丢弃旧帧 %ld\n",
+           stat_value(after, "telemetry_sent") - stat_value(before, "telemetry_sent"), dropped);
+    printf("服务器: %s\n", after);
+
+    // 读取的订阅者不能受慢客户端影响；有不读取的订阅者时服务器必须丢弃旧帧
+    int ok = failed == 0 && gaps == 0 && frames >= expected * 0.9;
+    if (g_clients >= 2) ok = ok && dropped > 0;
+    return ok ? 0 : 1;
+}
+
+// 实时数据推送测试：文本命令不断切换运动状态，检查各订阅者收到的增量消息
+static int run_websocket(worker_t *workers)
+{
+    char before[2048], after[2048];
+
+    if (query_stats(before, sizeof(before)) < 0) {
+        printf("无法连接服务器 %s:%d\n", g_host, g_port);
+        return 1;
+    }
+    int driver = connect_server();
+    if (driver < 0) return 1;
+
+    printf("实时数据推送测试: %d 个连接 (其中 %d 个从不读取), %d Hz, %d 秒\n",
+           g_clients, g_clients / 2, g_rate_hz, g_seconds);
+    for (int i = 0; i < g_clients; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, ws_worker_thread, &workers[i]);
+    }
+
+    unsigned long commands = 0;
+    double end = now_sec() + g_seconds;
+    while (now_sec() < end) {
+        const char *cmd = (commands++ % 2) ? "stop\n" : "forward\n";
+        if (send_all(driver, cmd, strlen(cmd)) != 0) break;
+        usleep(WS_DRIVE_INTERVAL_US);
+    }
+    send_all(driver, "stop\n", 5);
+    g_running = 0;
+
+    unsigned long messages = 0, bytes = 0, gaps = 0, redundant = 0;
+    int readers = 0, failed = 0, partial = 0;
+    for (int i = 0; i < g_clients; i++) {
+        pthread_join(workers[i].thread, NULL);
+        failed += workers[i].failed;
+        if (workers[i].index % 2) continue;
+        readers++;
+        messages += workers[i].frames;
+        bytes += workers[i].bytes;
+        gaps += workers[i].gaps;
+        redundant += workers[i].redundant;
+        if (!workers[i].first_full) partial++;
+    }
+    close(driver);
+    query_stats(after, sizeof(after));
+
+    int rate = g_rate_hz > PROTO_TLM_MAX_HZ ? PROTO_TLM_MAX_HZ : g_rate_hz;
+    double expected = (double)readers * rate * g_seconds;
+    long skipped = stat_value(after, "ws_skipped") - stat_value(before, "ws_skipped");
+    long unchanged = stat_value(after, "ws_unchanged") - stat_value(before, "ws_unchanged");
+    printf("读取的连接: 收到 %lu 条消息 (上限约 %.0f), 平均 %.1f 字节, 序号不连续 %lu 次, "
+           "首条不完整 %d, 重复未变化字段 %lu, 失败连接 %d\n",
+           messages, expected, messages ? (double)bytes / messages : 0.0, gaps, partial, redundant, failed);
+    printf("服务器: 没有变化不推送 %ld 次, 连接积压跳过 %ld 次\n", unchanged, skipped);
+    printf("服务器: %s\n", after);
+
+    // 读取的连接按频率收到连续的增量；有不读取的连接时服务器必须跳过推送
+    int ok = failed == 0 && gaps == 0 && partial == 0 && redundant == 0 && messages >= expected * 0.5;
+    if (g_clients >= 2) ok = ok && skipped > 0;
+    return ok ? 0 : 1;
+}
+
+// 运动程序测试：方波程序在网络负载下应按本地时钟准时完成
+static int run_program(worker_t *workers)
+{
+    char program[256], reply[2048];
+    int expected_ms = PROGRAM_PERIODS * PROGRAM_STEP_MS * 2;
+
+    snprintf(program, sizeof(program), "loop %d\nmove 60 %d\nmove -60 %d\nend\nstop\n",
+             PROGRAM_PERIODS, PROGRAM_STEP_MS, PROGRAM_STEP_MS);
+
+    // 无效程序必须在执行前被拒绝
+    if (http_request("POST", "/api/program", "loop\nmove 60\nend\n", reply, sizeof(reply)) != 400) {
+        printf("没有定时步骤的循环应被拒绝: %s\n", reply);
+        return 1;
+    }
+
+    printf("运动程序测试: %d 个客户端不断查询统计, 程序 %d 个周期 x %dms (期望 %dms)\n",
+           g_clients, PROGRAM_PERIODS, PROGRAM_STEP_MS * 2, expected_ms);
+    for (int i = 0; i < g_clients; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, stats_worker_thread, &workers[i]);
+    }
+
+    int status = http_request("POST", "/api/program", program, reply, sizeof(reply));
+    if (status != 200) {
+        printf("上传失败 (%d): %s\n", status, reply);
+        g_running = 0;
+    }
+
+    // 轮询执行状态直到结束
+    double deadline = now_sec() + expected_ms / 1000.0 + 2.0;
+    while (g_running && now_sec() < deadline) {
+        usleep(50000);
+        if (http_request("GET", "/api/program", "", reply, sizeof(reply)) != 200) continue;
+        if (strstr(reply, "\"state\":\"running\"") == NULL) break;
+    }
+    g_running = 0;
+
+    unsigned long queries = 0;
+    int failed = 0;
+    for (int i = 0; i < g_clients; i++) {
+        pthread_join(workers[i].thread, NULL);
+        queries += workers[i].sent;
+        failed += workers[i].failed;
+    }
+    if (status != 200) return 1;
+
+    double elapsed = json_number(reply, "elapsed_ms");
+    printf("程序: %s\n", reply);
+    printf("同时处理统计查询 %lu 次, 失败连接 %d; 程序用时 %.0fms (期望 %dms), 步骤延迟最大 %.1fus\n",
+           queries, failed, elapsed, expected_ms, json_number(reply, "late_max_us"));
+
+    int done = strstr(reply, "\"state\":\"done\"") != NULL;
+    return (done && failed == 0 && elapsed >= expected_ms && elapsed <= expected_ms + PROGRAM_MAX_ERROR_MS) ? 0 : 1;
+}
+
+// 共享内存读取线程：运动状态只可能是停车或两轮同速前进，读到其他组合说明快照不一致
+static void *shm_reader_thread(void *arg)
+{
+    worker_t *w = (worker_t *)arg;
+    uint32_t last_updates = 0;
+
+    while (g_running) {
+        shm_motion_t m;
+        w->retries += seqlock_read(&g_status->motion.lock, &m, &g_status->motion, sizeof(m));
+        int stopped = m.motion == SHM_MOTION_STOP && m.left_speed == 0 && m.right_speed == 0;
+        int forward = m.motion == SHM_MOTION_FORWARD && m.left_speed == m.right_speed && m.left_speed > 0;
+        if ((!stopped && !forward) || m.updates < last_updates) w->torn++;
+        last_updates = m.updates;
+        w->frames++;
+    }
+    return NULL;
+}
+
+static shm_status_t *shm_map(const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) return NULL;
+    shm_status_t *shm = mmap(NULL, sizeof(shm_status_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) return NULL;
+    if (__atomic_load_n(&shm->header.magic, __ATOMIC_ACQUIRE) != SHM_STATUS_MAGIC ||
+        shm->header.version != SHM_STATUS_VERSION || shm->header.size != sizeof(shm_status_t)) {
+        munmap(shm, sizeof(shm_status_t));
+        return NULL;
+    }
+    return shm;
+}
+
+// 提交一条命令，邮箱满时等待服务器取出
+static uint32_t shm_push_wait(uint16_t type, int32_t a0, int32_t a1, int32_t a2, unsigned long *full)
+{
+    int64_t seq;
+
+    while ((seq = shm_mailbox_push(g_status, type, a0, a1, a2)) < 0) {
+        if (full) (*full)++;
+        usleep(100);
+    }
+    return (uint32_t)seq;
+}
+
+static void shm_wait_head(uint32_t seq)
+{
+    while ((int32_t)(__atomic_load_n(&g_status->mailbox.head, __ATOMIC_ACQUIRE) - seq) < 0) {
+        usleep(20);
+    }
+}
+
+// 共享内存测试：邮箱吞吐和取出延迟、并发读取的快照一致性、邮箱进程退出后停车
+static int run_shm(worker_t *workers)
+{
+    char before[2048], after[2048];
+    uint32_t pid = (uint32_t)getpid();
+
+    if (query_stats(before, sizeof(before)) < 0) {
+        printf("无法连接服务器 %s:%d\n", g_host, g_port);
+        return 1;
+    }
+    g_status = shm_map(g_shm_name);
+    if (g_status == NULL) {
+        printf("无法映射共享内存 %s (名称、版本或大小不匹配)\n", g_shm_name);
+        return 1;
+    }
+    if (shm_mailbox_claim(g_status, pid) != 0) {
+        printf("邮箱已被进程%u占用\n", g_status->mailbox.producer_pid);
+        return 1;
+    }
+
+    printf("共享内存测试: %d 个读取线程, 连续提交命令 %d 秒\n", g_clients, g_seconds);
+    for (int i = 0; i < g_clients; i++) {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].index = i;
+        pthread_create(&workers[i].thread, NULL, shm_reader_thread, &workers[i]);
+    }
+
+    // 吞吐：交替提交不同速度的前进和停车，邮箱满时等待
+    unsigned long pushed = 0, full = 0;
+    double t0 = now_sec();
+    while (now_sec() - t0 < g_seconds) {
+        int speed = 20 + (int)(pushed / 2 % 60);
+        if (pushed % 2) {
+            shm_push_wait(SHM_CMD_MOTION, PROTO_MOTION_STOP, 0, 0, &full);
+        } else {
+            shm_push_wait(SHM_CMD_MOTION, PROTO_MOTION_FORWARD, speed, 0, &full);
+        }
+        pushed++;
+    }
+    double elapsed = now_sec() - t0;
+
+    // 延迟：逐条提交，等待服务器取出并执行
+    latency_stats_t latency;
+    memset(&latency, 0, sizeof(latency));
+    for (int i = 0; i < SHM_LATENCY_SAMPLES; i++) {
+        uint64_t start = now_us();
+        uint32_t seq = shm_push_wait(SHM_CMD_MOTION, (i % 2) ? PROTO_MOTION_STOP : PROTO_MOTION_FORWARD, 0, 0, NULL);
+        shm_wait_head(seq);
+        latency_record(&latency, (now_us() - start) * 1000);
+        pushed++;
+        usleep(1000 + i % 7 * 300);
+    }
+
+    // 无效命令被拒绝，不影响之后的命令
+    uint32_t rejected_before = g_status->mailbox.rejected;
+    shm_wait_head(shm_push_wait(99, 0, 0, 0, NULL));
+    shm_wait_head(shm_push_wait(SHM_CMD_MOTION, PROTO_MOTION_STOP, 0, 0, NULL));
+    pushed++;
+    int rejected = (int)(g_status->mailbox.rejected - rejected_before);
+    g_running = 0;
+
+    unsigned long reads = 0, torn = 0, retries = 0;
+    for (int i = 0; i < g_clients; i++) {
+        pthread_join(workers[i].thread, NULL);
+        reads += workers[i].frames;
+        torn += workers[i].torn;
+        retries += workers[i].retries;
+    }
+    shm_mailbox_release(g_status, pid);
+
+    // 邮箱进程不释放邮箱直接退出：服务器应释放邮箱并停车
+    pid_t child = fork();
+    if (child == 0) {
+        if (shm_mailbox_claim(g_status, (uint32_t)getpid()) != 0) _exit(1);
+        shm_wait_head(shm_push_wait(SHM_CMD_MOTION, PROTO_MOTION_FORWARD, 50, 0, NULL));
+        _exit(0);
+    }
+    int child_status = 0;
+    waitpid(child, &child_status, 0);
+    double exit_start = now_sec();
+    int stopped_after_exit = 0;
+    while (now_sec() - exit_start < SHM_EXIT_WAIT_MS / 1000.0) {
+        shm_motion_t m;
+        shm_status_read(&g_status->motion, &m, sizeof(m));
+        if (__atomic_load_n(&g_status->mailbox.producer_pid, __ATOMIC_ACQUIRE) == 0 &&
+            m.motion == SHM_MOTION_STOP && m.commander == CONTROL_COMMANDER_NONE) {
+            stopped_after_exit = 1;
+            break;
+        }
+        usleep(10000);
+    }
+    double exit_ms = (now_sec() - exit_start) * 1000.0;
+
+    query_stats(after, sizeof(after));
+    long commands = stat_value(after, "shm_commands") - stat_value(before, "shm_commands");
+    long exits = stat_value(after, "shm_producer_exits") - stat_value(before, "shm_producer_exits");
+
+    printf("提交 %lu 条命令, %.0f 条/秒, 邮箱满等待 %lu 次; 服务器取出 %ld 条, 执行 %u 条, 被同周期新命令取代 %u 条\n",
+           pushed, pushed / elapsed, full, commands, g_status->mailbox.applied, g_status->mailbox.superseded);
+    printf("读取运动状态 %lu 次, %.0f 次/秒, seqlock重试 %lu 次, 不一致快照 %lu 次\n",
+           reads, reads / elapsed, retries, torn);
+    print_latency("提交到取出执行", &latency);
+    printf("无效命令拒绝 %d 条; 邮箱进程退出后%s (%.0fms)\n", rejected,
+           stopped_after_exit ? "已释放邮箱并停车" : "没有停车", exit_ms);
+    printf("服务器: %s\n", after);
+
+    int ok = torn == 0 && reads > 0 && commands == (long)pushed + 1 && rejected == 1 && stopped_after_exit &&
+             exits == 1 && WIFEXITED(child_status) && WEXITSTATUS(child_status) == 0 &&
+             latency.max_ns <= (uint64_t)SHM_MAX_LATENCY_US * 1000;
+    munmap(g_status, sizeof(shm_status_t));
+    return ok ? 0 : 1;
+}
+
+// 发送一帧并等待对应的ACK，返回ACK状态，连接出错返回-1
+static int request_ack(int fd, const uint8_t *frame, size_t len, uint32_t seq)
+{
+    uint8_t buf[1024];
+    size_t have = 0;
+
+    if (send_all(fd, (const char *)frame, len) != 0) return -1;
+    for (;;) {
+        ssize_t n = recv(fd, buf + have, sizeof(buf) - have, 0);
+        if (n <= 0) return -1;
+        have += n;
+
+        size_t pos = 0;
+        for (;;) {
+            proto_frame_t reply;
+            proto_ack_t ack;
+            int used = proto_parse(buf + pos, have - pos, &reply);
+            if (used == 0) break;
+            if (used < 0) {
+                pos++;
+                continue;
+            }
+            pos += used;
+            if (proto_decode_ack(&reply, &ack) == 0 && ack.ack_seq == seq) return ack.status;
+        }
+        have -= pos;
+        memmove(buf, buf + pos, have);
+    }
+}
+
+static int drive_ack(int fd, uint32_t *seq, uint8_t motion)
+{
+    uint8_t frame[PROTO_MAX_FRAME];
+    size_t len = proto_encode_drive(frame, *seq, now_us(), PROTO_FLAG_ACK_REQ, motion, 50, 50);
+    return request_ack(fd, frame, len, (*seq)++);
+}
+
+static int lease_ack(int fd, uint32_t *seq, uint8_t priority, uint8_t flags, uint16_t lease_ms)
+{
+    uint8_t frame[PROTO_MAX_FRAME];
+    proto_lease_t lease = { priority, flags, lease_ms };
+    size_t len = proto_encode_lease(frame, *seq, now_us(), PROTO_FLAG_ACK_REQ, &lease);
+    return request_ack(fd, frame, len, (*seq)++);
+}
+
+// 检查一步的结果，不符合时打印并返回0
+static int expect_status(const char *step, int status, int expected)
+{
+    static const char *names[] = { "OK", "STALE", "INVALID", "SUPERSEDED", "DENIED" };
+    const char *name = status >= 0 && status <= PROTO_STATUS_DENIED ? names[status] : "连接错误";
+
+    printf("  %-36s %s\n", step, name);
+    if (status != expected) {
+        printf("  期望 %s\n", names[expected]);
+        return 0;
+    }
+    return 1;
+}
+
+// 控制权仲裁测试：拒绝、抢占、观察者、限时租约到期停车、空闲租约失效
+static int run_arbitration(void)
+{
+    char before[2048], after[2048];
+    uint32_t seq_a = 1, seq_b = 1, seq_c = 1;
+    shm_motion_t m;
+
+    if (query_stats(before, sizeof(before)) < 0) {
+        printf("无法连接服务器 %s:%d\n", g_host, g_port);
+        return 1;
+    }
+    g_status = shm_map(g_shm_name);
+    if (g_status == NULL) {
+        printf("无法映射共享内存 %s\n", g_shm_name);
+        return 1;
+    }
+    int a = connect_server(), b = connect_server(), c = connect_server(), d = connect_server();
+    if (a < 0 || b < 0 || c < 0 || d < 0) return 1;
+
+    printf("控制权仲裁测试:\n");
+    int ok = expect_status("A 前进 (获得控制权)", drive_ack(a, &seq_a, PROTO_MOTION_FORWARD), PROTO_STATUS_OK) &&
+             expect_status("B 前进 (同优先级)", drive_ack(b, &seq_b, PROTO_MOTION_FORWARD), PROTO_STATUS_DENIED) &&
+             expect_status("C 申请接管优先级的限时租约", lease_ack(c, &seq_c, ARBITER_PRIO_OVERRIDE, 0, ARB_LEASE_MS),
+                           PROTO_STATUS_OK) &&
+             expect_status("C 后退", drive_ack(c, &seq_c, PROTO_MOTION_BACKWARD), PROTO_STATUS_OK) &&
+             expect_status("A 停车 (已被抢占)", drive_ack(a, &seq_a, PROTO_MOTION_STOP), PROTO_STATUS_DENIED);
+
+    // C不再发送命令：租约到期后服务器停车并释放控制权 (先等共享内存发布C的后退)
+    double expire_start = now_sec();
+    double expire_ms = -1;
+    int seen_backward = 0;
+    while (ok && now_sec() - expire_start < (ARB_LEASE_MS + ARB_EXPIRE_SLACK_MS * 5) / 1000.0) {
+        shm_status_read(&g_status->motion, &m, sizeof(m));
+        if (m.motion == SHM_MOTION_BACKWARD && m.commander > 0) seen_backward = 1;
+        if (seen_backward && m.commander == CONTROL_COMMANDER_NONE && m.motion == SHM_MOTION_STOP) {
+            expire_ms = (now_sec() - expire_start) * 1000.0;
+            break;
+        }
+        usleep(1000);
+    }
+    if (ok) printf("  %-36s %.0fms后停车 (租约 %dms)\n", "C 的租约到期", expire_ms, ARB_LEASE_MS);
+    ok = ok && expire_ms >= ARB_LEASE_MS - 5 && expire_ms <= ARB_LEASE_MS + ARB_EXPIRE_SLACK_MS;
+
+    ok = ok && expect_status("A 前进 (没有持有者)", drive_ack(a, &seq_a, PROTO_MOTION_FORWARD), PROTO_STATUS_OK);
+
+    // 文本连接切换为观察者后命令不执行 (先等共享内存发布A的前进，用同一连接上的stats等服务器处理完)
+    if (ok) {
+        double start = now_sec();
+        do {
+            usleep(1000);
+            shm_status_read(&g_status->motion, &m, sizeof(m));
+        } while (!(m.motion == SHM_MOTION_FORWARD && m.commander > 0) && now_sec() - start < 1.0);
+        int holder = m.commander;
+        char reply[1024];
+        send_all(d, "observe\nbackward\nstats\n", 24);
+        recv(d, reply, sizeof(reply), 0);
+        usleep(SHM_TICK_MS * 3000);
+        shm_status_read(&g_status->motion, &m, sizeof(m));
+        int unchanged = holder > 0 && m.commander == holder && m.motion == SHM_MOTION_FORWARD;
+        printf("  %-36s %s\n", "D 观察者后退", unchanged ? "未执行" : "被执行");
+        ok = unchanged;
+    }
+
+    // A空闲超过租约时长后其他来源可以接管 (不停车)
+    if (ok) usleep((ARBITER_IDLE_MS + ARB_EXPIRE_SLACK_MS) * 1000);
+    ok = ok && expect_status("B 停车 (A 空闲后)", drive_ack(b, &seq_b, PROTO_MOTION_STOP), PROTO_STATUS_OK) &&
+         expect_status("B 释放控制权", lease_ack(b, &seq_b, ARBITER_PRIO_REMOTE, PROTO_LEASE_RELEASE, 0), PROTO_STATUS_OK);
+
+    close(a);
+    close(b);
+    close(c);
+    close(d);
+    query_stats(after, sizeof(after));
+    long preempted = stat_value(after, "arb_preempted") - stat_value(before, "arb_preempted");
+    long expired = stat_value(after, "arb_expired") - stat_value(before, "arb_expired");
+    long lapsed = stat_value(after, "arb_lapsed") - stat_value(before, "arb_lapsed");
+    long denied = stat_value(after, "arb_denied") - stat_value(before, "arb_denied");
+    printf("服务器: 抢占 %ld 次, 租约到期 %ld 次, 空闲失效 %ld 次, 拒绝 %ld 次, 当前持有者 %ld\n",
+           preempted, expired, lapsed, denied, stat_value(after, "arb_holder"));
+    munmap(g_status, sizeof(shm_status_t));
+    return ok && preempted == 1 && expired == 1 && lapsed >= 1 && denied == 3 && stat_value(after, "arb_holder") == 0
+           ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+    worker_t workers[MAX_CLIENTS];
+    char before[2048], after[2048];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H:p:c:t:b:BUTWPSAm:w:r:l:x:")) != -1) {
+        switch (opt) {
+            case 'H': g_host = optarg; break;
+            case 'p': g_port = atoi(optarg); break;
+            case 'c': g_clients = atoi(optarg); break;
+            case 't': g_seconds = atoi(optarg); break;
+            case 'b': g_batch = atoi(optarg); break;
+            case 'B': g_binary = 1; break;
+            case 'U': g_udp = 1; break;
+            case 'T': g_telemetry = 1; break;
+            case 'W': g_websocket = 1; break;
+            case 'P': g_program = 1; break;
+            case 'S': g_shm = 1; break;
+            case 'A': g_arbitration = 1; break;
+            case 'm': g_shm_name = optarg; break;
+            case 'w': g_ws_port = atoi(optarg); break;
+            case 'r': g_rate_hz = atoi(optarg); break;
+            case 'l': g_loss_pct = atoi(optarg); break;
+            case 'x': g_reorder_pct = atoi(optarg); break;
+            default:
+                printf("用法: %s [-H 地址] [-p 端口] [-c 客户端数] [-t 秒] [-b 每次发送的命令数] [-B] "
+                       "[-U [-r 频率Hz] [-l 丢包%%] [-x 乱序%%]] [-T [-r 订阅频率Hz]] "
+                       "[-W [-w WebSocket端口] [-r 推送频率Hz]] [-P [-w HTTP端口]] [-S [-m 共享内存名称]] [-A [-m 共享内存名称]]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (g_clients < 1) g_clients = 1;
+    if (g_clients > MAX_CLIENTS) g_clients = MAX_CLIENTS;
+    if (g_batch < 1) g_batch = 1;
+    if (g_rate_hz < 1) g_rate_hz = 1;
+
+    if (g_udp) {
+        return run_udp(workers);
+    }
+    if (g_telemetry) {
+        return run_telemetry(workers);
+    }
+    if (g_websocket) {
+        return run_websocket(workers);
+    }
+    if (g_program) {
+        return run_program(workers);
+    }
+    if (g_shm) {
+        return run_shm(workers);
+    }
+    if (g_arbitration) {
+        return run_arbitration();
+    }
+
+    long start_count = query_stats(before, sizeof(before));
+    if (start_count < 0) {
+        printf("无法连接服务器 %s:%d\n", g_host, g_port);
+        return 1;
+    }
+
+    printf("负载测试 (%s协议): %d 个客户端, %d 秒, 每次发送 %d 条命令\n",
+           g_binary ? "二进制" : "文本", g_clients, g_seconds, g_batch);
+    double t0 = now_sec();
+    for (int i = 0; i < g_clients; i++) {
+        workers[i].index = i;
+        workers[i].sent = 0;
+        workers[i].failed = 0;
+        workers[i].acks = 0;
+        workers[i].rtt_total_us = 0;
+        workers[i].rtt_max_us = 0;
+        pthread_create(&workers[i].thread, NULL, worker_thread, &workers[i]);
+    }
+
+    sleep(g_seconds);
+    g_running = 0;
+
+    unsigned long sent = 0, acks = 0;
+    uint64_t rtt_total = 0, rtt_max = 0;
+    int failed = 0;
+    for (int i = 0; i < g_clients; i++) {
+        pthread_join(workers[i].thread, NULL);
+        sent += workers[i].sent + 1;
+        failed += workers[i].failed;
+        acks += workers[i].acks;
+        rtt_total += workers[i].rtt_total_us;
+        if (workers[i].rtt_max_us > rtt_max) rtt_max = workers[i].rtt_max_us;
+    }
+    double elapsed = now_sec() - t0;
+
+    // 等待服务器处理完积压在socket缓冲区中的数据 (1秒内没有进展时放弃)
+    long end_count = start_count, last_count = -1;
+    int idle = 0;
+    while (idle < 10) {
+        end_count = query_stats(after, sizeof(after));
+        if (end_count < 0 || (unsigned long)(end_count - start_count) >= sent) break;
+        idle = (end_count == last_count) ? idle + 1 : 0;
+        last_count = end_count;
+        usleep(100000);
+    }
+    double drained = now_sec() - t0;
+
+    // 同一时间只有一个连接持有控制权，其他连接的命令由仲裁拒绝，吞吐量只按执行的命令计算
+    unsigned long handled = end_count > start_count ? (unsigned long)(end_count - start_count) : 0;
+    long executed = stat_value(after, "commands") - stat_value(before, "commands");
+    long denied = stat_value(after, "denied") - stat_value(before, "denied");
+    printf("发送命令: %lu, 服务器处理: %lu (执行 %ld, 无控制权 %ld), 失败连接: %d\n",
+           sent, handled, executed, denied, failed);
+    printf("吞吐量: %.0f 命令/秒 (只计执行的命令；发送 %.2f 秒，处理完积压共 %.2f 秒)\n",
+           executed / drained, elapsed, drained);
+    if (g_binary) {
+        printf("ACK: %lu, 平均往返 %.1fus, 最大往返 %.1fus\n",
+               acks, acks ? (double)rtt_total / acks : 0.0, (double)rtt_max);
+    }
+    printf("服务器: %s\n", after);
+
+    return (failed == 0 && handled == sent && executed > 0) ? 0 : 1;
+}
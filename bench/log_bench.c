@@ -0,0 +1,158 @@
+// 异步日志基准测试 (make logbench)
+// 比较组件中一次状态输出在调用线程上的开销：
+// 1. log_info写入本线程的环形缓冲区 (后台线程输出到/dev/null)
+// 2. 级别过滤掉的log_debug
+// 3. 原来的做法：fprintf后fflush (行缓冲的控制台每行一次write，这里写到/dev/null，真实控制台更慢)
+// 每次调用单独计时 (减去计时本身的开销)，输出中位数和p99；再用多个线程同时输出比较竞争。
+// 用法: log_bench [-n 每线程调用次数] [-t 线程数]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "logger.h"
+
+#define BURST        (LOG_RING_SIZE / 2)   // 每批调用数，批之间等待后台线程输出，避免缓冲区满
+#define BURST_GAP_MS (LOG_FLUSH_MS * 2)
+#define FILTER_CALLS 1000000
+
+typedef enum { MODE_LOG, MODE_FILTERED, MODE_PRINTF } bench_mode_t;
+
+typedef struct {
+    bench_mode_t mode;
+    int calls;
+    uint32_t *samples;             // 每次调用的耗时 (ns)
+} bench_thread_t;
+
+static FILE *g_null;
+static uint32_t g_timer_ns;        // 两次读取时钟之间的开销
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint32_t percentile(uint32_t *v, int n, double p)
+{
+    int i = (int)(n * p);
+    if (i >= n) i = n - 1;
+    return v[i];
+}
+
+static void *bench_thread(void *arg)
+{
+    bench_thread_t *b = arg;
+
+    for (int i = 0; i < b->calls; i++) {
+        int angle = i % 181;
+        uint64_t start = now_ns();
+        switch (b->mode) {
+            case MODE_LOG:
+                log_info("舵机设置角度: %d° (PWM值: %d) %s", angle, angle / 9 + 5, "测试");
+                break;
+            case MODE_FILTERED:
+                log_debug("舵机设置角度: %d° (PWM值: %d) %s", angle, angle / 9 + 5, "测试");
+                break;
+            case MODE_PRINTF:
+                fprintf(g_null, "舵机设置角度: %d° (PWM值: %d) %s\n", angle, angle / 9 + 5, "测试");
+                fflush(g_null);
+                break;
+        }
+        uint64_t spent = now_ns() - start;
+        b->samples[i] = spent > g_timer_ns ? (uint32_t)(spent - g_timer_ns) : 0;
+        if (b->mode != MODE_FILTERED && (i + 1) % BURST == 0) sleep_ms(BURST_GAP_MS);
+    }
+    return NULL;
+}
+
+// 运行threads个线程，各调用calls次，打印中位数和p99
+static void run(const char *name, bench_mode_t mode, int threads, int calls)
+{
+    pthread_t tids[threads];
+    bench_thread_t b[threads];
+    int total = threads * calls;
+    uint32_t *all = malloc(total * sizeof(uint32_t));
+
+    for (int i = 0; i < threads; i++) {
+        b[i].mode = mode;
+        b[i].calls = calls;
+        b[i].samples = all + i * calls;
+        pthread_create(&tids[i], NULL, bench_thread, &b[i]);
+    }
+    for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+
+    uint64_t sum = 0;
+    for (int i = 0; i < total; i++) sum += all[i];
+    qsort(all, total, sizeof(uint32_t), cmp_u32);
+    printf("  %d线程: 平均 %6.1fns, 中位数 %5uns, p99 %6uns  %s\n", threads,
+           (double)sum / total, percentile(all, total, 0.50), percentile(all, total, 0.99), name);
+    free(all);
+}
+
+static void measure_timer(void)
+{
+    uint32_t samples[10001];
+    for (int i = 0; i < 10001; i++) {
+        uint64_t a = now_ns();
+        samples[i] = (uint32_t)(now_ns() - a);
+    }
+    qsort(samples, 10001, sizeof(uint32_t), cmp_u32);
+    g_timer_ns = samples[5000];
+}
+
+int main(int argc, char *argv[])
+{
+    int calls = 20000;
+    int threads = 4;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:h")) != -1) {
+        switch (opt) {
+            case 'n': calls = atoi(optarg); break;
+            case 't': threads = atoi(optarg); break;
+            default:
+                printf("用法: %s [-n 每线程调用次数] [-t 线程数]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (calls < 1) calls = 1;
+    if (threads < 1) threads = 1;
+
+    g_null = fopen("/dev/null", "w");
+    if (g_null == NULL || log_start(g_null) != 0) {
+        printf("无法打开/dev/null\n");
+        return 1;
+    }
+    log_set_level(LOG_LEVEL_INFO);
+    measure_timer();
+    printf("每次调用的开销 (计时开销 %uns 已扣除, 每批 %d 次):\n", g_timer_ns, BURST);
+
+    run("log_info (环形缓冲区)", MODE_LOG, 1, calls);
+    run("log_debug (级别过滤)", MODE_FILTERED, 1, FILTER_CALLS);
+    run("fprintf+fflush (原printf)", MODE_PRINTF, 1, calls);
+    if (threads > 1) {
+        run("log_info (环形缓冲区)", MODE_LOG, threads, calls);
+        run("fprintf+fflush (原printf)", MODE_PRINTF, threads, calls);
+    }
+
+    log_stop();
+    log_stats_t stats = log_get_stats();
+    printf("日志: 输出 %lu 条, 丢弃 %lu 条, %d 个线程缓冲区\n", stats.records, stats.dropped, stats.threads);
+    fclose(g_null);
+    return stats.dropped == 0 ? 0 : 1;
+}
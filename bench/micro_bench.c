@@ -0,0 +1,444 @@
+// 组件热点路径微基准测试 (make bench 使用真实GPIO，make SIM=1 bench 使用模拟GPIO)
+// 逐个测量组件中被频繁调用的函数：数码管的段码转换和整帧写入、DHT11解码、超声波测距、
+// 舵机角度换算、两轮调速、二进制协议和运动程序的解析。每个样本单独计时 (扣除计时开销)，
+// 耗时很短的操作每个样本连续调用batch次后取平均；结果按纳秒输出中位数、p99、平均值、最小值和最大值，
+// 以JSON写到stdout或-o指定的文件，便于保存每次的结果比较性能回退 (组件的printf输出转到stderr)。
+// 模拟GPIO下DHT11和超声波的输入由读取钩子回放波形；在树莓派上测量真实传感器，
+// 没有接的设备用-f只选择需要的项目 (数码管的DIO和超声波的TRIG同为GPIO22，不要同时测量)。
+// 用法: micro_bench [-o 输出文件] [-f 名称子串] [-l]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <wiringPi.h>
+#include "clock.h"
+#include "DHT.h"
+#include "usonic.h"
+#include "servo.h"
+#include "control.h"
+#include "motion_program.h"
+#include "protocol.h"
+#include "logger.h"
+#ifdef SIM_WIRINGPI_H
+#include "sim_gpio.h"
+#define BENCH_BACKEND "sim"
+#else
+#define BENCH_BACKEND "wiringPi"
+#endif
+
+typedef struct {
+    const char *name;
+    int (*setup)(void);            // 可为NULL，返回非0时跳过该项
+    int (*run)(int i);             // 执行一次，结果不符时返回-1 (计入errors)
+    int iterations;                // 样本数
+    int batch;                     // 每个样本连续调用的次数
+    unsigned int gap_ms;           // 样本之间的间隔 (不计时)
+} bench_case_t;
+
+static uint64_t g_timer_ns;        // 两次读取时钟之间的开销
+static volatile int g_sink;        // 保存结果，避免调用被优化掉
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile(const double *v, int n, double p)
+{
+    int i = (int)(n * p);
+    if (i >= n) i = n - 1;
+    return v[i];
+}
+
+static void measure_timer(void)
+{
+    double samples[10001];
+    for (int i = 0; i < 10001; i++) {
+        uint64_t a = now_ns();
+        samples[i] = (double)(now_ns() - a);
+    }
+    qsort(samples, 10001, sizeof(double), cmp_double);
+    g_timer_ns = (uint64_t)samples[5000];
+}
+
+// ---------------- 数码管 ----------------
+
+static int setup_display(void)
+{
+    tm1637_init();
+    return 0;
+}
+
+static int run_ascii_to_digits(int i)
+{
+    char buf[8];
+    memcpy(buf, "HELLO-42", sizeof(buf));
+    buf[7] = (char)('0' + i % 10);
+    ascii_to_digits(buf, sizeof(buf));
+    g_sink += buf[0] + buf[7];
+    return 0;
+}
+
+static int run_text_display(int i)
+{
+    char text[8];
+    snprintf(text, sizeof(text), "t%03d", i % 1000);
+    text_display(text);
+    return 0;
+}
+
+static int run_data_display(int i)
+{
+    char data[4] = { segdata[i % 10], segdata[(i + 1) % 10], segdata[(i + 2) % 10], segdata[(i + 3) % 10] };
+    data_display(data);
+    return 0;
+}
+
+// ---------------- DHT11 ----------------
+
+// 测试帧: 湿度55%，温度23.5℃，校验和0x53
+static const unsigned char g_dht_frame[5] = { 0x37, 0x00, 0x17, 0x05, 0x53 };
+
+#ifdef SIM_WIRINGPI_H
+// 按DHT11时序生成的40位波形 (每位50us低电平 + 26us/70us高电平，加入±2us抖动，最后50us低电平后释放总线)，
+// 展开为每微秒一个电平样本。解码循环每次读取后延时1us，钩子每被读取一次前进一个样本
+#define DHT_WAVE_MAX 6000
+static unsigned char g_dht_wave[DHT_WAVE_MAX];
+static int g_dht_wave_len;
+static int g_dht_wave_pos;
+
+static void dht_wave_append(int level, int us)
+{
+    while (us-- > 0 && g_dht_wave_len < DHT_WAVE_MAX) g_dht_wave[g_dht_wave_len++] = (unsigned char)level;
+}
+
+static int dht_wave_hook(int pin, void *ctx)
+{
+    (void)pin;
+    (void)ctx;
+    if (g_dht_wave_pos >= g_dht_wave_len) return HIGH;
+    return g_dht_wave[g_dht_wave_pos++];
+}
+
+static int setup_dht(void)
+{
+    unsigned int seed = 1;
+
+    g_dht_wave_len = 0;
+    for (int bit = 0; bit < 40; bit++) {
+        int one = (g_dht_frame[bit / 8] >> (7 - bit % 8)) & 1;
+        seed = seed * 1103515245u + 12345u;
+        int jitter = (int)((seed >> 16) % 5) - 2;
+        dht_wave_append(LOW, 50 + jitter);
+        dht_wave_append(HIGH, (one ? 70 : 26) - jitter);
+    }
+    dht_wave_append(LOW, 50);
+    sim_gpio_set_read_hook(DHT_PIN, dht_wave_hook, NULL);
+    return 0;
+}
+
+// 只测量40位数据的解码 (read_byte ×5 和校验)，不含dht11_read_data中复位所需的120ms
+static int run_dht(int i)
+{
+    unsigned char buf[5];
+
+    (void)i;
+    g_dht_wave_pos = 0;
+    for (int b = 0; b < 5; b++) buf[b] = (unsigned char)read_byte();
+    if (((buf[0] + buf[1] + buf[2] + buf[3]) & 0xFF) != buf[4]) return -1;
+    return memcmp(buf, g_dht_frame, sizeof(buf)) == 0 ? 0 : -1;
+}
+#else
+// 真实传感器：完整的一次读取 (复位、应答和40位数据)，两次读取至少间隔1秒
+static int setup_dht(void)
+{
+    return dht11_init();
+}
+
+static int run_dht(int i)
+{
+    char buf[5];
+
+    (void)i;
+    return dht11_read_data(buf) == DHT_SUCCESS ? 0 : -1;
+}
+#endif
+
+// ---------------- 超声波 ----------------
+
+#ifdef SIM_WIRINGPI_H
+// 模拟回波：第一次读取ECHO后250us开始输出高电平，从第一次读到高电平起保持对应20cm的脉宽，然后等待下一次测量
+#define ECHO_DELAY_US 250
+#define ECHO_CM       20
+#define ECHO_WIDTH_US (ECHO_CM * 20000 / 340)
+
+static uint64_t g_echo_start;      // 0: 空闲
+static uint64_t g_echo_high;       // 第一次返回高电平的时刻，0: 尚未返回
+
+static int echo_hook(int pin, void *ctx)
+{
+    (void)pin;
+    (void)ctx;
+    uint64_t now = now_ns() / 1000;
+    if (g_echo_start == 0) g_echo_start = now;
+    if (now - g_echo_start < ECHO_DELAY_US) return LOW;
+
+    if (g_echo_high == 0) g_echo_high = now;
+    if (now - g_echo_high < ECHO_WIDTH_US) return HIGH;
+    g_echo_start = 0;
+    g_echo_high = 0;
+    return LOW;
+}
+
+static int setup_usonic(void)
+{
+    usonic_init();
+    sim_gpio_set_read_hook(ECHO, echo_hook, NULL);
+    return 0;
+}
+#else
+static int setup_usonic(void)
+{
+    usonic_init();
+    return 0;
+}
+#endif
+
+// 回波超时计为错误 (测距线程被抢占时测得的距离会有偏差，不检查数值)
+static int check_cm(int cm)
+{
+    return cm >= 0 ? 0 : -1;
+}
+
+// read_dist的一个周期 (包括其中的sleep(1))
+static int run_read_dist(int i)
+{
+    (void)i;
+    return check_cm(read_dist());
+}
+
+static int run_usonic_measure(int i)
+{
+    (void)i;
+    return check_cm(usonic_measure_cm(USONIC_TIMEOUT_US));
+}
+
+// ---------------- 舵机和电机 ----------------
+
+static int run_angle_to_pwm(int i)
+{
+    int pwm = angle_to_pwm(i % 200 - 10);
+    g_sink += pwm;
+    return pwm >= SERVO_MIN_PULSE && pwm <= SERVO_MAX_PULSE ? 0 : -1;
+}
+
+static int g_wheels_ready = 0;
+
+// 只初始化电机引脚，不启动运动执行线程 (真实小车上请把车轮架空)
+static int setup_wheels(void)
+{
+    init_wheel();
+    g_wheels_ready = 1;
+    return 0;
+}
+
+static int run_set_wheel_speeds(int i)
+{
+    int speed = (i & 1) ? 30 : 0;
+    set_wheel_speeds(speed, -speed);
+    return 0;
+}
+
+// ---------------- 命令解析 ----------------
+
+#define DRIVE_FRAMES 16
+static uint8_t g_drive_stream[DRIVE_FRAMES * (PROTO_HEADER_SIZE + PROTO_DRIVE_SIZE)];
+static size_t g_drive_offsets[DRIVE_FRAMES];
+
+static int setup_proto(void)
+{
+    size_t len = 0;
+    for (int i = 0; i < DRIVE_FRAMES; i++) {
+        g_drive_offsets[i] = len;
+        len += proto_encode_drive(g_drive_stream + len, (uint32_t)i, now_ns() / 1000, 0,
+                                  PROTO_MOTION_FORWARD, (uint8_t)(i * 6), 50);
+    }
+    return 0;
+}
+
+// 从接收缓冲区中解析一帧运动命令并解码负载
+static int run_proto_drive(int i)
+{
+    size_t off = g_drive_offsets[i % DRIVE_FRAMES];
+    proto_frame_t frame;
+    proto_drive_t drive;
+
+    if (proto_parse(g_drive_stream + off, sizeof(g_drive_stream) - off, &frame) <= 0) return -1;
+    if (proto_decode_drive(&frame, &drive) != 0) return -1;
+    g_sink += drive.speed;
+    return 0;
+}
+
+static const char g_program_src[] =
+    "# 巡逻\n"
+    "servo 90\n"
+    "loop 3\n"
+    "  if distance < 30\n"
+    "    turn left 40 500; rgb 1 0 0\n"
+    "  else\n"
+    "    move 50 1000\n"
+    "  end\n"
+    "  rgb 0 1 0\n"
+    "  wait 200\n"
+    "end\n"
+    "move -30 500\n"
+    "stop\n";
+
+static int setup_program(void)
+{
+    motion_program_init(PROGRAM_DEV_RGB | PROGRAM_DEV_SERVO | PROGRAM_DEV_DISTANCE);
+    return 0;
+}
+
+static int run_program_compile(int i)
+{
+    static motion_program_t prog;
+    char err[PROGRAM_ERROR_SIZE];
+
+    (void)i;
+    if (motion_program_compile(g_program_src, sizeof(g_program_src) - 1, &prog, err, sizeof(err)) != 0) return -1;
+    g_sink += prog.count;
+    return 0;
+}
+
+static const bench_case_t g_cases[] = {
+    { "ascii_to_digits",        NULL,          run_ascii_to_digits,   2000, 100, 0 },
+    { "angle_to_pwm",           NULL,          run_angle_to_pwm,      2000, 100, 0 },
+    { "proto_parse_drive",      setup_proto,   run_proto_drive,       2000, 100, 0 },
+    { "motion_program_compile", setup_program, run_program_compile,   1000, 1,   0 },
+    { "set_wheel_speeds",       setup_wheels,  run_set_wheel_speeds,  2000, 1,   0 },
+    { "text_display",           setup_display, run_text_display,      20,   1,   0 },
+    { "data_display",           setup_display, run_data_display,      20,   1,   0 },
+#ifdef SIM_WIRINGPI_H
+    { "dht11_decode",           setup_dht,     run_dht,               200,  1,   0 },
+#else
+    { "dht11_read",             setup_dht,     run_dht,               5,    1,   2000 },
+#endif
+    { "usonic_measure_cm",      setup_usonic,  run_usonic_measure,    50,   1,   60 },
+    { "read_dist",              setup_usonic,  run_read_dist,         3,    1,   0 },
+};
+
+#define CASE_COUNT ((int)(sizeof(g_cases) / sizeof(g_cases[0])))
+
+// 运行一项并输出一个JSON对象，返回错误次数
+static int run_case(const bench_case_t *c, FILE *out, int first)
+{
+    double *samples = malloc(sizeof(double) * c->iterations);
+    int errors = 0;
+    double sum = 0;
+
+    if (samples == NULL) return -1;
+    for (int n = 0; n < c->iterations; n++) {
+        uint64_t start = now_ns();
+        for (int b = 0; b < c->batch; b++) {
+            if (c->run(n * c->batch + b) != 0) errors++;
+        }
+        uint64_t spent = now_ns() - start;
+        spent = spent > g_timer_ns ? spent - g_timer_ns : 0;
+        samples[n] = (double)spent / c->batch;
+        sum += samples[n];
+        if (c->gap_ms > 0) sleep_ms(c->gap_ms);
+    }
+    qsort(samples, c->iterations, sizeof(double), cmp_double);
+
+    double median = percentile(samples, c->iterations, 0.50);
+    double p99 = percentile(samples, c->iterations, 0.99);
+    fprintf(stderr, "  %-24s 中位数 %12.1fns  p99 %12.1fns  (%d×%d次, 错误 %d)\n",
+            c->name, median, p99, c->iterations, c->batch, errors);
+    fprintf(out, "%s\n    {\"name\":\"%s\",\"iterations\":%d,\"batch\":%d,\"errors\":%d,"
+            "\"median_ns\":%.1f,\"p99_ns\":%.1f,\"mean_ns\":%.1f,\"min_ns\":%.1f,\"max_ns\":%.1f}",
+            first ? "" : ",", c->name, c->iterations, c->batch, errors, median, p99,
+            sum / c->iterations, samples[0], samples[c->iterations - 1]);
+    free(samples);
+    return errors;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *out_path = NULL;
+    const char *filter = NULL;
+    FILE *out;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:f:lh")) != -1) {
+        switch (opt) {
+            case 'o': out_path = optarg; break;
+            case 'f': filter = optarg; break;
+            case 'l':
+                for (int i = 0; i < CASE_COUNT; i++) printf("%s\n", g_cases[i].name);
+                return 0;
+            default:
+                printf("用法: %s [-o 输出文件] [-f 名称子串] [-l 列出项目]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    if (out_path != NULL) {
+        out = fopen(out_path, "w");
+    } else {
+        // stdout只输出JSON，组件和wiringPi的printf转到stderr
+        out = fdopen(dup(STDOUT_FILENO), "w");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    }
+    if (out == NULL) {
+        perror("无法打开输出文件");
+        return 1;
+    }
+
+    if (log_start(stderr) != 0) return 1;
+    log_set_level(LOG_LEVEL_WARN);
+    if (wiringPiSetupGpio() < 0) {
+        fprintf(stderr, "GPIO初始化失败\n");
+        return 1;
+    }
+    measure_timer();
+    fprintf(stderr, "组件微基准测试 (%s, 计时开销 %lluns 已扣除):\n", BENCH_BACKEND, (unsigned long long)g_timer_ns);
+
+    fprintf(out, "{\n  \"suite\":\"micro_bench\",\"backend\":\"%s\",\"timestamp\":%lld,\"timer_overhead_ns\":%llu,\n"
+            "  \"results\":[", BENCH_BACKEND, (long long)time(NULL), (unsigned long long)g_timer_ns);
+
+    int first = 1, errors = 0;
+    for (int i = 0; i < CASE_COUNT; i++) {
+        const bench_case_t *c = &g_cases[i];
+        if (filter != NULL && strstr(c->name, filter) == NULL) continue;
+        if (c->setup != NULL && c->setup() != 0) {
+            fprintf(stderr, "  %-24s 初始化失败，跳过\n", c->name);
+            continue;
+        }
+        int e = run_case(c, out, first);
+        errors += e < 0 ? 1 : e;
+        first = 0;
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (g_wheels_ready) set_wheel_speeds(0, 0);
+    log_stop();
+    if (fclose(out) != 0) return 1;
+    return errors == 0 ? 0 : 1;
+}
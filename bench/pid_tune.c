@@ -0,0 +1,141 @@
+// 闭环速度控制调参和基准测试 (主机模拟，make pid_tune)
+// 在模拟电机上分别以开环和闭环直线行驶，比较轮速误差、航向漂移、阶跃响应和扰动恢复。
+// 用法: pid_tune [Kp Ki Kd] [目标速度%]
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "control.h"
+#include "motion_exec.h"
+#include "sim_plant.h"
+
+#define SAMPLE_MS      10
+#define RUN_MS         3000
+#define DISTURB_AT_MS  1500
+
+typedef struct {
+    float rise_ms[2];       // 实测轮速达到目标90%的时间
+    float overshoot[2];     // 最大超调 (%)
+    float steady_error[2];  // 扰动前最后500ms的平均误差 (%)
+    float disturb_error[2]; // 扰动后最后500ms的平均误差 (%)
+    float heading_deg;      // 结束时航向漂移
+    float lateral_cm;       // 结束时横向偏移
+} run_result_t;
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+// 直线行驶一次并记录响应
+static void run_straight(int target, run_result_t *result)
+{
+    odometry_t odom;
+    float sum_before[2] = {0, 0}, sum_after[2] = {0, 0};
+    int n_before = 0, n_after = 0;
+
+    for (int w = 0; w < 2; w++) {
+        result->rise_ms[w] = -1;
+        result->overshoot[w] = 0;
+    }
+
+    sim_plant_set_battery(1.0f);
+    control_stop();
+    sleep_ms(500);
+    speed_ctrl_reset_odometry();
+    sleep_ms(2 * SAMPLE_MS);
+
+    control_move_forward(target);
+    for (int t = SAMPLE_MS; t <= RUN_MS; t += SAMPLE_MS) {
+        sleep_ms(SAMPLE_MS);
+
+        // 中途电池电压下降20%，模拟电量不足
+        if (t == DISTURB_AT_MS) {
+            sim_plant_set_battery(0.8f);
+        }
+
+        speed_ctrl_get_odometry(&odom);
+        float speed[2] = { odom.left_speed, odom.right_speed };
+        for (int w = 0; w < 2; w++) {
+            if (result->rise_ms[w] < 0 && speed[w] >= 0.9f * target) result->rise_ms[w] = t;
+            if (speed[w] - target > result->overshoot[w]) result->overshoot[w] = speed[w] - target;
+            if (t > DISTURB_AT_MS - 500 && t <= DISTURB_AT_MS) sum_before[w] += fabsf(speed[w] - target);
+            if (t > RUN_MS - 500) sum_after[w] += fabsf(speed[w] - target);
+        }
+        if (t > DISTURB_AT_MS - 500 && t <= DISTURB_AT_MS) n_before++;
+        if (t > RUN_MS - 500) n_after++;
+    }
+    control_stop();
+
+    speed_ctrl_get_odometry(&odom);
+    for (int w = 0; w < 2; w++) {
+        result->steady_error[w] = sum_before[w] / n_before;
+        result->disturb_error[w] = sum_after[w] / n_after;
+    }
+    result->heading_deg = odom.heading * 180.0f / (float)M_PI;
+    result->lateral_cm = odom.y * 100.0f;
+}
+
+static void print_result(const char *name, const run_result_t *r)
+{
+    printf("%-6s 上升时间(L/R): %5.0f/%5.0f ms  超调: %4.1f/%4.1f %%  稳态误差: %4.1f/%4.1f %%  "
+           "降压后误差: %4.1f/%4.1f %%  航向漂移: %6.1f°  横向偏移: %6.1f cm\n",
+           name, r->rise_ms[0], r->rise_ms[1], r->overshoot[0], r->overshoot[1],
+           r->steady_error[0], r->steady_error[1], r->disturb_error[0], r->disturb_error[1],
+           r->heading_deg, r->lateral_cm);
+}
+
+int main(int argc, char *argv[])
+{
+    speed_ctrl_config_t config = SPEED_CTRL_CONFIG_DEFAULT;
+    motor_pinmap_t pinmap = MOTOR_PINMAP_HBRIDGE;
+    int target = 60;
+    run_result_t open_loop, closed_loop;
+
+    if (argc >= 4) {
+        config.kp = atof(argv[1]);
+        config.ki = atof(argv[2]);
+        config.kd = atof(argv[3]);
+    }
+    if (argc >= 5) {
+        target = atoi(argv[4]);
+    }
+
+    // 模拟对象：右轮比左轮弱10%，开环直行会向右偏
+    sim_plant_config_t plant = {
+        .wheel = {
+            { pinmap.left_fwd, pinmap.left_rev, ENC_L_PIN, 3.0f, 0.12f, 8.0f },
+            { pinmap.right_fwd, pinmap.right_rev, ENC_R_PIN, 2.7f, 0.12f, 8.0f },
+        },
+        .edges_per_rev = config.edges_per_rev,
+        .battery = 1.0f,
+        .rate_hz = 5000,
+    };
+
+    wiringPiSetupGpio();
+    control_init_pinmap(&pinmap);
+    sim_plant_start(&plant);
+    if (control_enable_closed_loop(&config) != 0) {
+        return 1;
+    }
+
+    printf("\n目标速度 %d%%，直行 %d ms，%d ms时电池电压降到80%%\n", target, RUN_MS, DISTURB_AT_MS);
+
+    speed_ctrl_set_closed_loop(0);
+    run_straight(target, &open_loop);
+    speed_ctrl_set_closed_loop(1);
+    run_straight(target, &closed_loop);
+
+    print_result("开环", &open_loop);
+    print_result("闭环", &closed_loop);
+
+    speed_ctrl_stats_t stats = speed_ctrl_get_stats();
+    printf("控制循环: %lu 周期, 平均唤醒延迟 %.1fus, 最大唤醒延迟 %.1fus, 最长执行 %.1fus\n",
+           stats.cycles, stats.cycles ? stats.total_late_ns / 1000.0 / stats.cycles : 0.0,
+           stats.max_late_ns / 1000.0, stats.max_exec_ns / 1000.0);
+
+    control_cleanup();
+    sim_plant_stop();
+    return 0;
+}
@@ -0,0 +1,303 @@
+// 控制路径回放和时间线比较 (make replay / make replaytest)
+// 按记录文件 (control_server -r) 中的时间把运动执行器的输入 (提交、斜坡、紧急停止) 重新送入本机的
+// 运动执行线程 (真实电机或 make SIM=1 的模拟GPIO)，同时记录新的执行器输出，最后比较两条输出时间线：
+// 写入PWM的轮速序列是否一致、对应写入的时间偏差，以及每条输入到第一次写入PWM的延迟。
+// 传感器读数只用于查看：运动程序根据距离做出的决定已经体现在执行器输入中，回放时不再注入。
+// 时间偏差按p99判断是否超出容差 (个别写入被调度延迟不算不一致)；-s 只检查轮速序列，时间偏差只报告。
+// 用法: replay [-f] [-s] [-t 容差毫秒] [-o 输出文件] 记录文件   回放并比较 (-f 不等待，尽快送入)
+//       replay -d [-s] 记录文件A 记录文件B                    只比较
+//       replay -p 记录文件                               打印事件
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "control.h"
+#include "motion_exec.h"
+#include "recorder.h"
+
+#define DEFAULT_TOLERANCE_MS  5
+#define RESYNC_WINDOW         16    // 轮速不一致时向后查找的事件数
+#define TAIL_MS               200   // 最后一条输入之后继续记录的时间
+
+typedef struct {
+    recorder_event_t *events;
+    int count;
+} timeline_t;
+
+typedef struct {
+    double avg_us;
+    double p99_us;
+    double max_us;
+    int count;
+} summary_t;
+
+static const char *type_name(int type)
+{
+    switch (type) {
+        case REC_COMMAND: return "command";
+        case REC_SUBMIT: return "submit";
+        case REC_RAMP: return "ramp";
+        case REC_STOP: return "stop";
+        case REC_WRITE: return "write";
+        case REC_SENSOR: return "sensor";
+    }
+    return "?";
+}
+
+static int is_input(int type)
+{
+    return type == REC_SUBMIT || type == REC_RAMP || type == REC_STOP;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static summary_t summarize(uint64_t *values, int n)
+{
+    summary_t s = { 0, 0, 0, n };
+    uint64_t total = 0;
+
+    if (n == 0) return s;
+    qsort(values, n, sizeof(uint64_t), cmp_u64);
+    for (int i = 0; i < n; i++) total += values[i];
+    s.avg_us = total / 1000.0 / n;
+    s.p99_us = values[(n - 1) * 99 / 100] / 1000.0;
+    s.max_us = values[n - 1] / 1000.0;
+    return s;
+}
+
+static int load(const char *path, timeline_t *tl)
+{
+    recorder_header_t header;
+    tl->events = recorder_load(path, &header, &tl->count);
+    return tl->events ? 0 : -1;
+}
+
+// 取出执行器输出 (写入PWM) 的事件
+static recorder_event_t *writes_of(const timeline_t *tl, int *n)
+{
+    recorder_event_t *out = malloc((tl->count ? tl->count : 1) * sizeof(recorder_event_t));
+    *n = 0;
+    for (int i = 0; i < tl->count; i++) {
+        if (tl->events[i].type == REC_WRITE) out[(*n)++] = tl->events[i];
+    }
+    return out;
+}
+
+static int same_write(const recorder_event_t *a, const recorder_event_t *b)
+{
+    return a->motion == b->motion && a->left == b->left && a->right == b->right;
+}
+
+// 每条输入到之后第一次写入PWM的延迟
+static summary_t input_latency(const timeline_t *tl)
+{
+    uint64_t *values = malloc((tl->count ? tl->count : 1) * sizeof(uint64_t));
+    int n = 0;
+
+    for (int i = 0; i < tl->count; i++) {
+        if (!is_input(tl->events[i].type)) continue;
+        for (int j = i + 1; j < tl->count; j++) {
+            if (tl->events[j].type == REC_WRITE) {
+                values[n++] = tl->events[j].t_ns - tl->events[i].t_ns;
+                break;
+            }
+        }
+    }
+    summary_t s = summarize(values, n);
+    free(values);
+    return s;
+}
+
+static void print_events(const timeline_t *tl)
+{
+    for (int i = 0; i < tl->count; i++) {
+        const recorder_event_t *ev = &tl->events[i];
+        printf("%12.3fms %-7s motion=%d source=%d left=%d right=%d value=%d\n", ev->t_ns / 1e6,
+               type_name(ev->type), ev->motion, ev->source, ev->left, ev->right, ev->value);
+    }
+}
+
+// 比较两条执行器输出时间线：check_time为0时只比较轮速序列，gate_time为0时时间偏差只报告不判断
+static int diff(const timeline_t *a, const timeline_t *b, int check_time, int gate_time, int tolerance_ms)
+{
+    int na, nb, matched = 0, only_a = 0, only_b = 0;
+    recorder_event_t *wa = writes_of(a, &na);
+    recorder_event_t *wb = writes_of(b, &nb);
+    uint64_t *offsets = malloc((na ? na : 1) * sizeof(uint64_t));
+    int i = 0, j = 0, first_mismatch = -1;
+
+    while (i < na && j < nb) {
+        if (same_write(&wa[i], &wb[j])) {
+            offsets[matched++] = wa[i].t_ns > wb[j].t_ns ? wa[i].t_ns - wb[j].t_ns : wb[j].t_ns - wa[i].t_ns;
+            i++;
+            j++;
+            continue;
+        }
+        if (first_mismatch < 0) first_mismatch = i;
+
+        // 在较近的一侧找到下一次一致的写入后继续，跳过的写入计为多出/缺少
+        int skip_a = -1, skip_b = -1;
+        for (int k = 1; k <= RESYNC_WINDOW && skip_a < 0 && skip_b < 0; k++) {
+            if (i + k < na && same_write(&wa[i + k], &wb[j])) skip_a = k;
+            else if (j + k < nb && same_write(&wa[i], &wb[j + k])) skip_b = k;
+        }
+        if (skip_a > 0) {
+            only_a += skip_a;
+            i += skip_a;
+        } else if (skip_b > 0) {
+            only_b += skip_b;
+            j += skip_b;
+        } else {
+            only_a++;
+            only_b++;
+            i++;
+            j++;
+        }
+    }
+    only_a += na - i;
+    only_b += nb - j;
+
+    summary_t offset = summarize(offsets, matched);
+    summary_t lat_a = input_latency(a);
+    summary_t lat_b = input_latency(b);
+
+    printf("执行器写入: 记录 %d 次, 回放 %d 次, 一致 %d 次, 只在记录中 %d 次, 只在回放中 %d 次\n",
+           na, nb, matched, only_a, only_b);
+    if (first_mismatch >= 0) {
+        const recorder_event_t *ev = &wa[first_mismatch];
+        printf("第一次不一致: %.3fms motion=%d left=%d right=%d\n", ev->t_ns / 1e6, ev->motion, ev->left, ev->right);
+    }
+    if (check_time) {
+        printf("写入时间偏差: 平均 %.1fus, p99 %.1fus, 最大 %.1fus (p99容差 %dms%s)\n",
+               offset.avg_us, offset.p99_us, offset.max_us, tolerance_ms, gate_time ? "" : "，只报告");
+    }
+    printf("输入到写入PWM: 记录 平均 %.1fus p99 %.1fus 最大 %.1fus (%d 条); "
+           "回放 平均 %.1fus p99 %.1fus 最大 %.1fus (%d 条)\n",
+           lat_a.avg_us, lat_a.p99_us, lat_a.max_us, lat_a.count, lat_b.avg_us, lat_b.p99_us, lat_b.max_us, lat_b.count);
+
+    free(wa);
+    free(wb);
+    free(offsets);
+    if (only_a || only_b) return 1;
+    if (check_time && gate_time && offset.p99_us > tolerance_ms * 1000.0) return 1;
+    return 0;
+}
+
+static void sleep_until(uint64_t ns)
+{
+    struct timespec ts = { ns / 1000000000ULL, ns % 1000000000ULL };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0) {
+    }
+}
+
+// 按记录的时间送入执行器输入 (fast为1时不等待)，返回最后一条输入的时间
+static uint64_t feed(const timeline_t *tl, int fast)
+{
+    uint64_t start = recorder_start_ns();
+    uint64_t last = 0;
+
+    for (int i = 0; i < tl->count; i++) {
+        const recorder_event_t *ev = &tl->events[i];
+        if (!is_input(ev->type)) continue;
+        if (!fast) sleep_until(start + ev->t_ns);
+        switch (ev->type) {
+            case REC_SUBMIT:
+                motion_exec_submit(ev->motion, ev->left, ev->right, ev->value);
+                break;
+            case REC_RAMP:
+                motion_exec_ramp(ev->motion, ev->left, ev->right);
+                break;
+            case REC_STOP:
+                motion_exec_emergency_stop();
+                break;
+        }
+        last = ev->t_ns;
+    }
+    return last;
+}
+
+static void print_usage(const char *prog)
+{
+    printf("用法: %s [-f] [-s] [-t 容差毫秒] [-o 输出文件] 记录文件\n"
+           "      %s -d [-s] 记录文件A 记录文件B\n"
+           "      %s -p 记录文件\n", prog, prog, prog);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *output = "target/replay.rec";
+    int fast = 0, diff_only = 0, print_only = 0, gate_time = 1;
+    int tolerance_ms = DEFAULT_TOLERANCE_MS;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "fsdpt:o:h")) != -1) {
+        switch (opt) {
+            case 'f': fast = 1; break;
+            case 's': gate_time = 0; break;
+            case 'd': diff_only = 1; break;
+            case 'p': print_only = 1; break;
+            case 't': tolerance_ms = atoi(optarg); break;
+            case 'o': output = optarg; break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind >= argc || (diff_only && optind + 1 >= argc)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    timeline_t recorded, replayed;
+    if (load(argv[optind], &recorded) != 0) return 1;
+
+    if (print_only) {
+        print_events(&recorded);
+        return 0;
+    }
+    if (diff_only) {
+        if (load(argv[optind + 1], &replayed) != 0) return 1;
+        return diff(&recorded, &replayed, 1, gate_time, tolerance_ms);
+    }
+
+    int inputs = 0, sensors = 0;
+    for (int i = 0; i < recorded.count; i++) {
+        if (is_input(recorded.events[i].type)) inputs++;
+        if (recorded.events[i].type == REC_SENSOR) sensors++;
+    }
+    printf("回放 %s: %d 个事件, 执行器输入 %d 条, 传感器读数 %d 条 (%s)\n",
+           argv[optind], recorded.count, inputs, sensors, fast ? "尽快送入" : "按记录时间");
+
+    // 与控制服务器相同的接线和初始化顺序，初始化之后才开始记录
+    motor_pinmap_t pinmap = MOTOR_PINMAP_HBRIDGE;
+    if (wiringPiSetupGpio() == -1) {
+        printf("初始化 wiringPi 失败!\n");
+        return 1;
+    }
+    control_init_pinmap(&pinmap);
+    if (recorder_start(output, NULL) != 0) {
+        control_cleanup();
+        return 1;
+    }
+    uint64_t last = feed(&recorded, fast);
+    if (fast) {
+        // 定时命令仍按持续时间执行，等队列清空
+        while (motion_exec_pending() > 0) usleep(1000);
+        last = motion_now_ns() - recorder_start_ns();
+    }
+    sleep_until(recorder_start_ns() + last + (uint64_t)TAIL_MS * 1000000ULL);
+    recorder_stop();
+    control_cleanup();
+
+    if (load(output, &replayed) != 0) return 1;
+    int status = diff(&recorded, &replayed, !fast, gate_time, tolerance_ms);
+    printf("%s\n", status == 0 ? "执行器时间线一致" : "执行器时间线不一致");
+    free(recorded.events);
+    free(replayed.events);
+    return status;
+}
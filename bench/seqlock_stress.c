@@ -0,0 +1,144 @@
+// 运动状态seqlock并发压力测试 (使用模拟GPIO)
+// 一个写者线程通过control_apply()/set_wheel_speeds()连续发布运动状态，
+// 多个读者线程用get_motion_state()无锁读取并校验快照各字段之间的一致性。
+// 用法: seqlock_stress [读者线程数] [持续秒数]
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "control.h"
+#include "logger.h"
+
+#define MAX_READERS 16
+#define MOTION_KINDS 5             // 写者使用的运动类型 (停止、前进、后退、左转、右转)
+
+static volatile int g_stop = 0;
+
+typedef struct {
+    unsigned long reads;
+    unsigned long changes;         // 读到新快照的次数
+    unsigned long torn;
+    unsigned long backwards;
+} reader_stats_t;
+
+typedef struct {
+    unsigned long writes;
+    uint64_t max_write_ns;
+} writer_stats_t;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 写者发布的每个状态满足: 右轮 = -左轮，运动类型由左轮速度决定
+static motion_type_t motion_for(int left_speed)
+{
+    return (motion_type_t)((left_speed + MAX_SPEED) % MOTION_KINDS);
+}
+
+static int state_consistent(const motion_state_t *state)
+{
+    return state->right_speed == -state->left_speed &&
+           state->current_motion == motion_for(state->left_speed) &&
+           state->is_moving == (state->current_motion != MOTION_STOP) &&
+           state->reserved == 0;
+}
+
+// 偶数次用control_apply()发布轮速和运动类型；奇数次用set_wheel_speeds()只改轮速 (保持运动类型)，
+// 新的左轮速度与上一次相差MOTION_KINDS，运动类型不变
+static void *writer_thread(void *arg)
+{
+    writer_stats_t *stats = (writer_stats_t *)arg;
+    uint32_t n = 0;
+    int left = 0;
+
+    while (!g_stop) {
+        n++;
+        uint64_t start = now_ns();
+        if (n & 1) {
+            left = (int)(n % (2 * MAX_SPEED + 1 - MOTION_KINDS)) - MAX_SPEED;
+            control_apply(motion_for(left), left, -left);
+        } else {
+            left += MOTION_KINDS;
+            set_wheel_speeds(left, -left);
+        }
+        uint64_t cost = now_ns() - start;
+        if (cost > stats->max_write_ns) stats->max_write_ns = cost;
+        stats->writes++;
+    }
+    return NULL;
+}
+
+static void *reader_thread(void *arg)
+{
+    reader_stats_t *stats = (reader_stats_t *)arg;
+    motion_state_t state;
+    uint32_t last_seq = 0;
+    uint64_t last_ns = 0;
+
+    while (!g_stop) {
+        state = get_motion_state();
+        stats->reads++;
+        if (!state_consistent(&state)) stats->torn++;
+        if (state.seq < last_seq || (state.seq > last_seq && state.timestamp_ns < last_ns)) stats->backwards++;
+        if (state.seq != last_seq) stats->changes++;
+        last_seq = state.seq;
+        last_ns = state.timestamp_ns;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int readers = argc > 1 ? atoi(argv[1]) : 3;
+    int seconds = argc > 2 ? atoi(argv[2]) : 3;
+    pthread_t writer, threads[MAX_READERS];
+    writer_stats_t wstats = {0, 0};
+    reader_stats_t rstats[MAX_READERS] = {{0, 0, 0, 0}};
+    unsigned long reads = 0, changes = 0, torn = 0, backwards = 0;
+
+    if (readers < 1) readers = 1;
+    if (readers > MAX_READERS) readers = MAX_READERS;
+    if (seconds < 1) seconds = 1;
+
+    // 组件日志只输出警告 (避免初始化信息混在结果中)
+    log_set_level(LOG_LEVEL_WARN);
+    wiringPiSetupGpio();
+    init_wheel();
+
+    printf("seqlock压力测试: 1个写者, %d个读者, %d秒\n", readers, seconds);
+    pthread_create(&writer, NULL, writer_thread, &wstats);
+    for (int i = 0; i < readers; i++) {
+        pthread_create(&threads[i], NULL, reader_thread, &rstats[i]);
+    }
+
+    struct timespec ts = { seconds, 0 };
+    nanosleep(&ts, NULL);
+    g_stop = 1;
+
+    pthread_join(writer, NULL);
+    for (int i = 0; i < readers; i++) {
+        pthread_join(threads[i], NULL);
+        reads += rstats[i].reads;
+        changes += rstats[i].changes;
+        torn += rstats[i].torn;
+        backwards += rstats[i].backwards;
+    }
+
+    printf("写入: %lu 次 (%.0f 次/秒), 最长单次写入 %.1fus\n",
+           wstats.writes, (double)wstats.writes / seconds, wstats.max_write_ns / 1000.0);
+    printf("读取: %lu 次 (%.0f 次/秒), 其中读到新快照 %lu 次\n",
+           reads, (double)reads / seconds, changes);
+    printf("撕裂快照: %lu, 序号回退: %lu\n", torn, backwards);
+
+    if (torn != 0 || backwards != 0) {
+        printf("失败: 读到不一致的快照\n");
+        return 1;
+    }
+    set_wheel_speeds(0, 0);
+    printf("通过\n");
+    return 0;
+}
@@ -0,0 +1,254 @@
+// 无栈协程任务调度基准测试 (make taskbench)
+// 1. 切换开销：大量任务轮流让出，每次切换的平均时间；对照两个线程通过条件变量轮流唤醒的开销
+// 2. 定时任务规模：N个任务各自按周期睡眠 (错开相位)，测量调度线程的CPU占用和唤醒延迟，
+//    得出单核能持续运行的任务数 (CPU占用低于80%且p99延迟低于周期的10%)
+// 3. 事件广播：N个任务等待同一事件，从发出事件到最后一个任务运行的时间
+// 用法: task_bench [-n 最大任务数] [-p 周期毫秒] [-t 每档秒数]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "task.h"
+
+#define YIELD_TASKS        1000
+#define YIELD_ROUNDS       2000
+#define PINGPONG_ROUNDS    200000
+#define BROADCAST_ROUNDS   50
+#define LATE_BUCKET_US     10       // 延迟直方图每格10us
+#define LATE_BUCKETS       1000     // 最大10ms，超出计入最后一格
+#define SUSTAIN_CPU        0.80
+#define SUSTAIN_P99_RATIO  0.10     // p99延迟占周期的比例
+
+typedef struct {
+    task_t task;
+    int n;
+} bench_task_t;
+
+static uint64_t g_late_hist[LATE_BUCKETS];
+static uint64_t g_late_count;
+static int g_period_ms;
+static uint64_t g_stop_ns;
+
+static uint64_t thread_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------- 1. 切换开销 ----------------
+
+static int yield_task(task_t *t)
+{
+    bench_task_t *b = t->ctx;
+
+    TASK_BEGIN(t);
+    for (b->n = 0; b->n < YIELD_ROUNDS; b->n++) {
+        TASK_YIELD(t);
+    }
+    TASK_END(t);
+}
+
+static pthread_mutex_t g_pp_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_pp_cond = PTHREAD_COND_INITIALIZER;
+static int g_pp_turn = 0;
+
+static void *pingpong_thread(void *arg)
+{
+    int me = (int)(long)arg;
+    for (int i = 0; i < PINGPONG_ROUNDS; i++) {
+        pthread_mutex_lock(&g_pp_lock);
+        while (g_pp_turn != me) pthread_cond_wait(&g_pp_cond, &g_pp_lock);
+        g_pp_turn = !me;
+        pthread_cond_signal(&g_pp_cond);
+        pthread_mutex_unlock(&g_pp_lock);
+    }
+    return NULL;
+}
+
+static void bench_switch(void)
+{
+    task_sched_t sched;
+    bench_task_t *tasks = calloc(YIELD_TASKS, sizeof(bench_task_t));
+
+    task_sched_init(&sched);
+    for (int i = 0; i < YIELD_TASKS; i++) task_spawn(&sched, &tasks[i].task, yield_task, &tasks[i], "yield");
+    uint64_t start = task_now_ns();
+    task_sched_run(&sched, NULL);
+    uint64_t elapsed = task_now_ns() - start;
+    printf("任务切换: %d 个任务各让出 %d 次, 共 %llu 次切换, 平均 %.1fns/次\n",
+           YIELD_TASKS, YIELD_ROUNDS, (unsigned long long)sched.stats.switches,
+           (double)elapsed / sched.stats.switches);
+    task_sched_close(&sched);
+    free(tasks);
+
+    pthread_t a, b;
+    start = task_now_ns();
+    pthread_create(&a, NULL, pingpong_thread, (void *)0L);
+    pthread_create(&b, NULL, pingpong_thread, (void *)1L);
+    pthread_join(a, NULL);
+    pthread_join(b, NULL);
+    elapsed = task_now_ns() - start;
+    printf("对照 线程切换 (条件变量轮流唤醒): 平均 %.1fns/次\n", (double)elapsed / (2.0 * PINGPONG_ROUNDS));
+}
+
+// ---------------- 2. 定时任务规模 ----------------
+
+static int periodic_task(task_t *t)
+{
+    bench_task_t *b = t->ctx;
+
+    TASK_BEGIN(t);
+    // 第一次睡眠错开相位，避免所有任务同时到期
+    TASK_SLEEP_MS(t, b->n % g_period_ms);
+    for (;;) {
+        TASK_SLEEP_MS(t, g_period_ms);
+        uint64_t now = task_now_ns();
+        uint64_t late_us = (now - t->wake_ns) / 1000;
+        uint64_t bucket = late_us / LATE_BUCKET_US;
+        g_late_hist[bucket < LATE_BUCKETS ? bucket : LATE_BUCKETS - 1]++;
+        g_late_count++;
+        if (now >= g_stop_ns) break;
+    }
+    TASK_END(t);
+}
+
+static double late_percentile_us(double p)
+{
+    uint64_t target = (uint64_t)(g_late_count * p);
+    uint64_t seen = 0;
+    for (int i = 0; i < LATE_BUCKETS; i++) {
+        seen += g_late_hist[i];
+        if (seen > target) return (i + 1) * LATE_BUCKET_US;
+    }
+    return LATE_BUCKETS * LATE_BUCKET_US;
+}
+
+// 返回是否可持续
+static int bench_periodic(int n, int seconds)
+{
+    task_sched_t sched;
+    bench_task_t *tasks = calloc(n, sizeof(bench_task_t));
+
+    if (tasks == NULL || task_sched_init(&sched) != 0) {
+        printf("%8d 个任务: 内存不足\n", n);
+        free(tasks);
+        return 0;
+    }
+    memset(g_late_hist, 0, sizeof(g_late_hist));
+    g_late_count = 0;
+    for (int i = 0; i < n; i++) {
+        tasks[i].n = i;
+        task_spawn(&sched, &tasks[i].task, periodic_task, &tasks[i], "periodic");
+    }
+
+    uint64_t start = task_now_ns();
+    uint64_t cpu_start = thread_cpu_ns();
+    g_stop_ns = start + (uint64_t)seconds * 1000000000ULL;
+    task_sched_run(&sched, NULL);
+    double wall = (task_now_ns() - start) / 1e9;
+    double cpu = (thread_cpu_ns() - cpu_start) / 1e9 / wall;
+    double p50 = late_percentile_us(0.50), p99 = late_percentile_us(0.99);
+    int sustained = cpu < SUSTAIN_CPU && p99 < g_period_ms * 1000.0 * SUSTAIN_P99_RATIO;
+
+    printf("%8d 个任务: 唤醒 %9.0f 次/秒, CPU %5.1f%%, 延迟 p50<%4.0fus p99<%5.0fus 最大 %7.1fus, "
+           "内存 %5.1fMB %s\n",
+           n, g_late_count / wall, cpu * 100, p50, p99, sched.stats.late_max_ns / 1000.0,
+           (n * sizeof(bench_task_t) + sched.heap_cap * sizeof(task_t *)) / 1048576.0,
+           sustained ? "" : "(超出)");
+
+    task_sched_close(&sched);
+    free(tasks);
+    return sustained;
+}
+
+// ---------------- 3. 事件广播 ----------------
+
+#define BENCH_EV_GO  TASK_EV_USER
+
+static uint64_t g_signal_ns, g_last_run_ns;
+static uint64_t g_broadcast_total_ns, g_broadcast_max_ns;
+
+static int waiter_task(task_t *t)
+{
+    TASK_BEGIN(t);
+    for (;;) {
+        TASK_AWAIT(t, BENCH_EV_GO, -1);
+        g_last_run_ns = task_now_ns();
+    }
+    TASK_END(t);
+}
+
+static int broadcaster_task(task_t *t)
+{
+    bench_task_t *b = t->ctx;
+
+    TASK_BEGIN(t);
+    for (b->n = 0; b->n < BROADCAST_ROUNDS; b->n++) {
+        TASK_SLEEP_MS(t, 10);
+        if (b->n > 0) {
+            uint64_t spent = g_last_run_ns - g_signal_ns;
+            g_broadcast_total_ns += spent;
+            if (spent > g_broadcast_max_ns) g_broadcast_max_ns = spent;
+        }
+        g_signal_ns = task_now_ns();
+        task_signal(t->sched, BENCH_EV_GO);
+    }
+    TASK_SLEEP_MS(t, 10);
+    task_sched_stop(t->sched);
+    TASK_END(t);
+}
+
+static void bench_broadcast(int n)
+{
+    task_sched_t sched;
+    bench_task_t *tasks = calloc(n + 1, sizeof(bench_task_t));
+
+    task_sched_init(&sched);
+    g_broadcast_total_ns = g_broadcast_max_ns = 0;
+    for (int i = 0; i < n; i++) task_spawn(&sched, &tasks[i].task, waiter_task, &tasks[i], "waiter");
+    task_spawn(&sched, &tasks[n].task, broadcaster_task, &tasks[n], "broadcaster");
+    task_sched_run(&sched, NULL);
+    printf("事件广播: %d 个任务等待同一事件, 全部运行平均 %.1fus (每个任务 %.1fns), 最大 %.1fus\n",
+           n, g_broadcast_total_ns / 1000.0 / (BROADCAST_ROUNDS - 1),
+           (double)g_broadcast_total_ns / (BROADCAST_ROUNDS - 1) / n, g_broadcast_max_ns / 1000.0);
+    task_sched_close(&sched);
+    free(tasks);
+}
+
+int main(int argc, char *argv[])
+{
+    int max_tasks = 1000000;
+    int seconds = 2;
+    int opt;
+
+    g_period_ms = 100;
+    while ((opt = getopt(argc, argv, "n:p:t:h")) != -1) {
+        switch (opt) {
+            case 'n': max_tasks = atoi(optarg); break;
+            case 'p': g_period_ms = atoi(optarg); break;
+            case 't': seconds = atoi(optarg); break;
+            default:
+                printf("用法: %s [-n 最大任务数] [-p 周期毫秒] [-t 每档秒数]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (g_period_ms < 1) g_period_ms = 1;
+
+    printf("每个任务: task_t %zu 字节 + 定时堆指针 %zu 字节\n", sizeof(task_t), sizeof(task_t *));
+    bench_switch();
+
+    printf("定时任务 (周期 %dms, 每档 %d 秒):\n", g_period_ms, seconds);
+    int sustained = 0;
+    for (int n = 1000; n <= max_tasks; n *= 10) {
+        if (bench_periodic(n, seconds)) sustained = n;
+        else break;
+        if (n < max_tasks && n * 10 > max_tasks) n = max_tasks / 10;
+    }
+    printf("单核可持续的任务数 (周期 %dms): %d\n", g_period_ms, sustained);
+
+    bench_broadcast(10000);
+    return 0;
+}
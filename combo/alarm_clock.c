@@ -1,4 +1,5 @@
 #include "alarm_clock.h"
+#include "../components/metrics.h"
 
 void alarm_clock_function(void) {
     int choice;
@@ -58,34 +59,119 @@ void alarm_clock_set_time(int *hour, int *minute) {
     getchar();
 }
 
+// ---------------- 任务 ----------------
+
+// 到下一个整分钟的毫秒数
+static int ms_to_next_minute(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return 60000 - (int)(ts.tv_sec % 60) * 1000 - (int)(ts.tv_nsec / 1000000);
+}
+
+static metric_t m_alarm_rings = METRIC_COUNTER("rpi_alarm_rings_total", "mode=\"menu\"", "闹钟响铃次数");
+
+// 响铃：蜂鸣器响 + 红灯闪烁，按按钮停止
+static int alarm_ring_task(task_t *t)
+{
+    alarm_ring_t *ring = t->ctx;
+
+    TASK_BEGIN(t);
+    metric_inc(&m_alarm_rings);
+    for (ring->i = 0; ring->i < ring->cycles; ring->i++) {
+        beep_on();
+        set_rgb(1, 0, 0); // 红色
+        TASK_AWAIT(t, TASK_EV_BUTTON_DOWN, 500);
+        if (t->fired & TASK_EV_BUTTON_DOWN) break;
+        beep_off();
+        set_rgb(0, 0, 0); // 关闭
+        TASK_AWAIT(t, TASK_EV_BUTTON_DOWN, 500);
+        if (t->fired & TASK_EV_BUTTON_DOWN) break;
+    }
+    beep_off();
+    set_rgb(0, 0, 0);
+    TASK_END(t);
+}
+
+int alarm_ring_spawn(task_sched_t *sched, alarm_ring_t *ring, int cycles)
+{
+    ring->cycles = cycles;
+    ring->i = 0;
+    return task_spawn(sched, &ring->task, alarm_ring_task, ring, "alarm_ring");
+}
+
+// 监控：每到整分钟检查一次，到达闹钟时间时启动响铃任务并等它结束
+static int alarm_monitor_task(task_t *t)
+{
+    alarm_monitor_t *m = t->ctx;
+
+    TASK_BEGIN(t);
+    for (;;) {
+        time_t now = time(NULL);
+        struct tm *timeinfo = localtime(&now);
+
+        if (m->show_time) {
+            // 显示当前时间
+            char time_str[8];
+            snprintf(time_str, sizeof(time_str), "%02d%02d", timeinfo->tm_hour, timeinfo->tm_min);
+            text_display(time_str);
+        }
+
+        // 检查是否到达闹钟时间
+        if (timeinfo->tm_hour == m->hour && timeinfo->tm_min == m->minute) {
+            printf("\n⏰ 闹钟响铃！\n");
+            if (alarm_ring_spawn(t->sched, &m->ring, ALARM_RING_CYCLES) == 0) {
+                TASK_JOIN(t, &m->ring.task);
+            }
+            if (m->once) break;
+        }
+
+        if (m->once) {
+            TASK_AWAIT(t, TASK_EV_BUTTON_DOWN, ms_to_next_minute());
+            if (t->fired & TASK_EV_BUTTON_DOWN) break;
+        } else {
+            TASK_SLEEP_MS(t, ms_to_next_minute());
+        }
+    }
+    TASK_END(t);
+}
+
+int alarm_monitor_spawn(task_sched_t *sched, alarm_monitor_t *m, int hour, int minute, int show_time, int once)
+{
+    m->hour = hour;
+    m->minute = minute;
+    m->show_time = show_time;
+    m->once = once;
+    return task_spawn(sched, &m->task, alarm_monitor_task, m, "alarm_monitor");
+}
+
+// 在当前线程运行单个闹钟任务直到结束或按Ctrl+C
+static void run_alarm_task(alarm_monitor_t *monitor, alarm_ring_t *ring, int cycles,
+                           int hour, int minute)
+{
+    task_sched_t sched;
+
+    if (task_sched_init(&sched) != 0) return;
+    if (task_io_attach(&sched, TASK_IO_BUTTON) == 0 &&
+        (monitor != NULL ? alarm_monitor_spawn(&sched, monitor, hour, minute, 1, 1)
+                         : alarm_ring_spawn(&sched, ring, cycles)) == 0) {
+        cancel_token_t *cancel = cancel_begin();
+        task_sched_run(&sched, cancel);
+        cancel_end(cancel);
+    }
+    task_io_detach();
+    task_sched_close(&sched);
+    beep_off();
+    set_rgb(0, 0, 0);
+}
+
 void alarm_clock_monitor(int alarm_hour, int alarm_minute) {
-    int current_hour, current_minute;
-    time_t now;
-    struct tm *timeinfo;
+    alarm_monitor_t monitor;
     
     printf("闹钟监控启动中... (按按钮停止监控)\n");
     printf("当前闹钟设置: %02d:%02d\n", alarm_hour, alarm_minute);
     
-    while (!botton_is_pressed()) {
-        time(&now);
-        timeinfo = localtime(&now);
-        current_hour = timeinfo->tm_hour;
-        current_minute = timeinfo->tm_min;
-        
-        // 显示当前时间
-        char time_str[5];
-        sprintf(time_str, "%02d%02d", current_hour, current_minute);
-        text_display(time_str);
-        
-        // 检查是否到达闹钟时间
-        if (current_hour == alarm_hour && current_minute == alarm_minute) {
-            printf("\n⏰ 闹钟响铃！\n");
-            alarm_clock_ring();
-            break;
-        }
-        
-        sleep(30); // 每30秒检查一次
-    }
+    run_alarm_task(&monitor, NULL, 0, alarm_hour, alarm_minute);
     
     printf("闹钟监控已停止\n");
     printf("按回车键继续...");
@@ -94,31 +180,15 @@ void alarm_clock_monitor(int alarm_hour, int alarm_minute) {
 }
 
 void alarm_clock_ring(void) {
-    // 闹钟响铃：蜂鸣器响 + RGB灯闪烁
-    for (int i = 0; i < 10; i++) {
-        beep_on();
-        set_rgb(1, 0, 0); // 红色
-        usleep(500000);   // 0.5秒
-        beep_off();
-        set_rgb(0, 0, 0); // 关闭
-        usleep(500000);   // 0.5秒
-        
-        if (botton_is_pressed()) break; // 按按钮停止
-    }
-    beep_off();
-    set_rgb(0, 0, 0);
+    alarm_ring_t ring;
+    run_alarm_task(NULL, &ring, ALARM_RING_CYCLES, 0, 0);
 }
 
 void alarm_clock_test_ring(void) {
+    alarm_ring_t ring;
+    
     printf("测试闹钟响铃效果...\n");
-    for (int i = 0; i < 5; i++) {
-        beep_on();
-        set_rgb(1, 0, 0);
-        usleep(500000);
-        beep_off();
-        set_rgb(0, 0, 0);
-        usleep(500000);
-    }
+    run_alarm_task(NULL, &ring, 5, 0, 0);
     printf("测试完成\n");
     printf("按回车键继续...");
     getchar();
@@ -10,6 +10,26 @@
 #include "../components/botton.h"
 #include "../components/clock.h"
 #include "../components/rgb.h"
+#include "task.h"
+#include "task_io.h"
+
+#define ALARM_RING_CYCLES  10    // 响铃次数 (每次1秒)
+
+// 响铃任务：蜂鸣器和红灯闪烁cycles次，按按钮提前停止
+typedef struct {
+    task_t task;
+    int cycles;
+    int i;
+} alarm_ring_t;
+
+// 闹钟监控任务：每到整分钟检查时间，到点时启动响铃任务
+typedef struct {
+    task_t task;
+    alarm_ring_t ring;
+    int hour, minute;
+    int show_time;                 // 在数码管上显示当前时间
+    int once;                      // 响铃一次或按按钮后结束 (否则一直监控)
+} alarm_monitor_t;
 
 // 闹钟功能函数声明
 void alarm_clock_function(void);
@@ -17,5 +37,7 @@ void alarm_clock_set_time(int *hour, int *minute);
 void alarm_clock_monitor(int alarm_hour, int alarm_minute);
 void alarm_clock_ring(void);
 void alarm_clock_test_ring(void);
+int alarm_ring_spawn(task_sched_t *sched, alarm_ring_t *ring, int cycles);
+int alarm_monitor_spawn(task_sched_t *sched, alarm_monitor_t *m, int hour, int minute, int show_time, int once);
 
 #endif // ALARM_CLOCK_H
@@ -0,0 +1,571 @@
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include "daemon.h"
+#include "event_loop.h"
+#include "sensor_cache.h"
+#include "../components/beep.h"
+#include "../components/botton.h"
+#include "../components/clock.h"
+#include "../components/rgb.h"
+#include "../components/metrics.h"
+
+typedef enum {
+    PAGE_CLOCK = 0,
+    PAGE_STOPWATCH,
+    PAGE_TEMP,
+    PAGE_COUNT
+} page_t;
+
+static const char *g_page_names[PAGE_COUNT] = { "clock", "stopwatch", "temp" };
+
+// 指示灯颜色 (bit0红 bit1绿 bit2蓝)
+#define LED_OFF     0
+#define LED_RED     1
+#define LED_GREEN   2
+#define LED_YELLOW  3
+
+static event_loop_t g_loop;
+static event_source_t g_signals = { -1, NULL, NULL, NULL };
+static event_source_t g_tick = { -1, NULL, NULL, NULL };          // 数码管刷新和闹钟检查
+static event_source_t g_button = { -1, NULL, NULL, NULL };        // 按键中断转发的eventfd
+static event_source_t g_debounce = { -1, NULL, NULL, NULL };
+static event_source_t g_ring = { -1, NULL, NULL, NULL };
+static event_source_t g_heartbeat = { -1, NULL, NULL, NULL };
+static event_source_t g_flash = { -1, NULL, NULL, NULL };         // 心跳短闪结束
+static event_source_t g_udp = { -1, NULL, NULL, NULL };
+
+static page_t g_page = PAGE_CLOCK;
+static char g_shown[5] = "";       // 数码管当前内容，不变时不重写
+static int g_led = -1;
+static int g_flash_on = 0;
+static unsigned long g_events = 0; // 事件循环回调次数 (空闲时应很少)
+static uint64_t g_start_ns = 0;
+
+// 闹钟
+static int g_alarm_hour = -1;
+static int g_alarm_minute = 0;
+static int g_alarm_fired = -1;     // 已响过铃的分钟 (当天分钟数)，同一分钟内不重复响铃
+static int g_ringing = 0;
+static int g_ring_toggles = 0;
+
+// 秒表
+static int g_sw_running = 0;
+static uint64_t g_sw_start_ns = 0;
+static uint64_t g_sw_elapsed_ns = 0;
+
+// 温度页
+static int g_fahrenheit = 0;
+
+static metric_t m_events = METRIC_COUNTER("rpi_daemon_events_total", NULL, "守护模式事件循环的回调次数");
+static metric_t m_alarm_rings = METRIC_COUNTER("rpi_alarm_rings_total", "mode=\"daemon\"", "闹钟响铃次数");
+static metric_t m_button_presses = METRIC_COUNTER("rpi_button_presses_total", "mode=\"daemon\"", "按键按下次数");
+
+static void count_event(void)
+{
+    g_events++;
+    metric_inc(&m_events);
+}
+
+// 按键
+static int g_pressed = 0;
+static int g_press_consumed = 0;   // 这次按下已用于停止响铃
+static uint64_t g_press_ns = 0;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t stopwatch_ns(void)
+{
+    return g_sw_elapsed_ns + (g_sw_running ? now_ns() - g_sw_start_ns : 0);
+}
+
+// ---------------- 输出 ----------------
+
+static void show(const char *text)
+{
+    char buf[5];
+
+    snprintf(buf, sizeof(buf), "%-4s", text);
+    if (strcmp(buf, g_shown) == 0) return;
+    strcpy(g_shown, buf);
+    text_display(buf);
+}
+
+static void set_led(int color)
+{
+    if (color == g_led) return;
+    g_led = color;
+    set_rgb(color & 1, (color >> 1) & 1, (color >> 2) & 1);
+}
+
+// 指示灯优先级：响铃 > 秒表状态 > 心跳短闪
+static void update_led(void)
+{
+    if (g_ringing) return;        // 响铃定时器控制红灯
+    if (g_sw_running) set_led(LED_GREEN);
+    else if (g_sw_elapsed_ns > 0) set_led(LED_YELLOW);
+    else set_led(g_flash_on ? LED_GREEN : LED_OFF);
+}
+
+static void format_temperature(char *buf, size_t size)
+{
+    sensor_reading_t reading;
+
+    sensor_cache_get(&reading);
+    if (!(reading.valid & SENSOR_VALID_ENV)) {
+        snprintf(buf, size, "----");
+    } else if (g_fahrenheit) {
+        snprintf(buf, size, "%3dF", (int)(reading.temperature * 9 / 5 + 32));
+    } else {
+        snprintf(buf, size, "%3dC", (int)reading.temperature);
+    }
+}
+
+// 刷新当前页面，返回距下一次需要刷新的毫秒数
+static unsigned int refresh_display(void)
+{
+    char text[16];
+    struct timespec real;
+    struct tm tm;
+
+    clock_gettime(CLOCK_REALTIME, &real);
+    localtime_r(&real.tv_sec, &tm);
+    unsigned int to_second = 1000 - real.tv_nsec / 1000000;
+    unsigned int to_minute = (59 - tm.tm_sec) * 1000 + to_second;
+
+    switch (g_page) {
+        case PAGE_CLOCK:
+            snprintf(text, sizeof(text), "%02d%02d", tm.tm_hour, tm.tm_min);
+            show(text);
+            return to_minute;
+        case PAGE_STOPWATCH: {
+            unsigned int seconds = (unsigned int)(stopwatch_ns() / 1000000000ULL);
+            unsigned int minutes = seconds / 60 > 99 ? 99 : seconds / 60;
+            snprintf(text, sizeof(text), "%02u%02u", minutes, seconds % 60);
+            show(text);
+            if (!g_sw_running) return to_minute;
+            // 对齐到秒表的下一整秒
+            uint64_t into = stopwatch_ns() % 1000000000ULL;
+            return (unsigned int)((1000000000ULL - into) / 1000000ULL) + 1;
+        }
+        default:
+            format_temperature(text, sizeof(text));
+            show(text);
+            return DAEMON_TEMP_REFRESH_MS < to_minute ? DAEMON_TEMP_REFRESH_MS : to_minute;
+    }
+}
+
+// 重新安排刷新定时器 (单次，每次按页面需要决定下一次唤醒)
+static void schedule_tick(void)
+{
+    unsigned int ms = refresh_display();
+    event_timer_set(&g_tick, ms ? ms : 1, 0);
+}
+
+// ---------------- 闹钟 ----------------
+
+static void stop_ring(void)
+{
+    if (!g_ringing) return;
+    g_ringing = 0;
+    event_timer_set(&g_ring, 0, 0);
+    beep_off();
+    g_led = -1;
+    update_led();
+    printf("闹钟响铃已停止\n");
+}
+
+static void start_ring(void)
+{
+    if (g_ringing) return;
+    g_ringing = 1;
+    g_ring_toggles = 0;
+    beep_on();
+    set_led(LED_RED);
+    event_timer_set(&g_ring, 500, 500);
+    metric_inc(&m_alarm_rings);
+    printf("⏰ 闹钟响铃！\n");
+}
+
+static void on_ring(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    count_event();
+    if (event_timer_read(src) == 0) return;
+
+    if (++g_ring_toggles >= DAEMON_RING_TOGGLES) {
+        stop_ring();
+        return;
+    }
+    int on = g_ring_toggles % 2 == 0;
+    beep_set_state(on);
+    set_led(on ? LED_RED : LED_OFF);
+}
+
+static void check_alarm(void)
+{
+    time_t now = time(NULL);
+    struct tm tm;
+
+    localtime_r(&now, &tm);
+    int minute_of_day = tm.tm_hour * 60 + tm.tm_min;
+    if (g_alarm_hour < 0 || minute_of_day != g_alarm_hour * 60 + g_alarm_minute) return;
+    if (g_alarm_fired == minute_of_day) return;
+    g_alarm_fired = minute_of_day;
+    start_ring();
+}
+
+static void on_tick(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    count_event();
+    if (event_timer_read(src) == 0) return;
+    check_alarm();
+    schedule_tick();
+}
+
+// ---------------- 秒表和页面 ----------------
+
+static void stopwatch_start(void)
+{
+    if (g_sw_running) return;
+    g_sw_running = 1;
+    g_sw_start_ns = now_ns();
+}
+
+static void stopwatch_pause(void)
+{
+    if (!g_sw_running) return;
+    g_sw_elapsed_ns += now_ns() - g_sw_start_ns;
+    g_sw_running = 0;
+}
+
+static void stopwatch_reset(void)
+{
+    g_sw_running = 0;
+    g_sw_elapsed_ns = 0;
+}
+
+static void set_page(page_t page)
+{
+    g_page = page;
+    printf("显示页面: %s\n", g_page_names[page]);
+}
+
+// 状态变化后刷新指示灯和数码管
+static void state_changed(void)
+{
+    update_led();
+    schedule_tick();
+}
+
+static void handle_press(uint64_t held_ms)
+{
+    if (g_page == PAGE_STOPWATCH && held_ms >= DAEMON_RESET_PRESS_MS) {
+        stopwatch_reset();
+    } else if (held_ms >= DAEMON_LONG_PRESS_MS) {
+        set_page((g_page + 1) % PAGE_COUNT);
+    } else if (g_page == PAGE_STOPWATCH) {
+        if (g_sw_running) stopwatch_pause();
+        else stopwatch_start();
+    } else if (g_page == PAGE_TEMP) {
+        g_fahrenheit = !g_fahrenheit;
+    }
+    state_changed();
+}
+
+// ---------------- 按键 ----------------
+
+static int g_button_fd = -1;
+
+// 按键边沿中断 (wiringPi中断线程)：只通知事件循环
+static void button_isr(void)
+{
+    uint64_t one = 1;
+    ssize_t ret = write(g_button_fd, &one, sizeof(one));
+    (void)ret;
+}
+
+static void on_button(event_source_t *src, uint32_t events)
+{
+    uint64_t value;
+    (void)events;
+    count_event();
+    while (read(src->fd, &value, sizeof(value)) > 0)
+        ;
+    // 抖动期间的边沿只会推迟采样
+    event_timer_set(&g_debounce, DAEMON_DEBOUNCE_MS, 0);
+}
+
+static void on_debounce(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    count_event();
+    if (event_timer_read(src) == 0) return;
+
+    int pressed = botton_is_pressed();
+    if (pressed == g_pressed) return;
+    g_pressed = pressed;
+
+    if (pressed) {
+        metric_inc(&m_button_presses);
+        g_press_ns = now_ns();
+        g_press_consumed = g_ringing;
+        stop_ring();
+    } else if (!g_press_consumed) {
+        handle_press((now_ns() - g_press_ns) / 1000000ULL);
+    }
+}
+
+// ---------------- 指示灯心跳 ----------------
+
+static void on_heartbeat(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    count_event();
+    if (event_timer_read(src) == 0) return;
+    if (g_ringing || g_sw_running || g_sw_elapsed_ns > 0) return;
+    g_flash_on = 1;
+    update_led();
+    event_timer_set(&g_flash, 100, 0);
+}
+
+static void on_flash(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    count_event();
+    if (event_timer_read(src) == 0) return;
+    g_flash_on = 0;
+    update_led();
+}
+
+// ---------------- 状态和命令 ----------------
+
+static int format_status(char *buf, size_t size)
+{
+    char temp[16];
+    time_t now = time(NULL);
+    struct tm tm;
+    unsigned int sw = (unsigned int)(stopwatch_ns() / 1000000000ULL);
+
+    localtime_r(&now, &tm);
+    format_temperature(temp, sizeof(temp));
+    char alarm[8] = "off";
+    if (g_alarm_hour >= 0) snprintf(alarm, sizeof(alarm), "%02d:%02d", g_alarm_hour, g_alarm_minute);
+    return snprintf(buf, size,
+                    "page=%s time=%02d:%02d stopwatch=%02u:%02u stopwatch_running=%d alarm=%s ringing=%d "
+                    "temp=%s events=%lu uptime_s=%.0f\n",
+                    g_page_names[g_page], tm.tm_hour, tm.tm_min, sw / 60, sw % 60, g_sw_running, alarm,
+                    g_ringing, temp, g_events, (now_ns() - g_start_ns) / 1e9);
+}
+
+// 执行一条文本命令，回复写入reply
+static void handle_command(char *cmd, char *reply, size_t size)
+{
+    char arg[16] = "";
+    int hour, minute;
+
+    cmd[strcspn(cmd, "\r\n")] = '\0';
+    if (strcmp(cmd, "status") == 0) {
+        format_status(reply, size);
+        return;
+    }
+    if (sscanf(cmd, "page %15s", arg) == 1) {
+        for (int i = 0; i < PAGE_COUNT; i++) {
+            if (strcmp(arg, g_page_names[i]) == 0) {
+                set_page(i);
+                state_changed();
+                snprintf(reply, size, "ok\n");
+                return;
+            }
+        }
+    } else if (sscanf(cmd, "stopwatch %15s", arg) == 1) {
+        if (strcmp(arg, "start") == 0) stopwatch_start();
+        else if (strcmp(arg, "pause") == 0) stopwatch_pause();
+        else if (strcmp(arg, "reset") == 0) stopwatch_reset();
+        else arg[0] = '\0';
+        if (arg[0] != '\0') {
+            state_changed();
+            snprintf(reply, size, "ok\n");
+            return;
+        }
+    } else if (strcmp(cmd, "alarm off") == 0) {
+        g_alarm_hour = -1;
+        stop_ring();
+        snprintf(reply, size, "ok\n");
+        return;
+    } else if (sscanf(cmd, "alarm %d:%d", &hour, &minute) == 2 && hour >= 0 && hour <= 23 &&
+               minute >= 0 && minute <= 59) {
+        g_alarm_hour = hour;
+        g_alarm_minute = minute;
+        g_alarm_fired = -1;
+        snprintf(reply, size, "ok\n");
+        return;
+    } else if (strcmp(cmd, "ring") == 0) {
+        start_ring();
+        snprintf(reply, size, "ok\n");
+        return;
+    } else if (strcmp(cmd, "quit") == 0) {
+        event_loop_stop(&g_loop);
+        snprintf(reply, size, "ok\n");
+        return;
+    }
+    snprintf(reply, size, "error 未知命令\n");
+}
+
+static void on_udp(event_source_t *src, uint32_t events)
+{
+    char buf[128], reply[256];
+    struct sockaddr_in peer;
+    socklen_t peer_len;
+    (void)events;
+    count_event();
+
+    for (;;) {
+        peer_len = sizeof(peer);
+        ssize_t n = recvfrom(src->fd, buf, sizeof(buf) - 1, 0, (struct sockaddr *)&peer, &peer_len);
+        if (n < 0) return;
+        buf[n] = '\0';
+        handle_command(buf, reply, sizeof(reply));
+        sendto(src->fd, reply, strlen(reply), 0, (struct sockaddr *)&peer, peer_len);
+    }
+}
+
+static int udp_start(int port)
+{
+    struct sockaddr_in addr;
+
+    g_udp.fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (g_udp.fd < 0) {
+        perror("创建UDP命令套接字失败");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(g_udp.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("绑定UDP命令端口失败");
+        close(g_udp.fd);
+        g_udp.fd = -1;
+        return -1;
+    }
+    g_udp.handler = on_udp;
+    return event_loop_add(&g_loop, &g_udp, EPOLLIN);
+}
+
+// ---------------- 信号 ----------------
+
+static void on_signal(event_source_t *src, uint32_t events)
+{
+    struct signalfd_siginfo info;
+    char status[256];
+    (void)events;
+    count_event();
+
+    while (read(src->fd, &info, sizeof(info)) == sizeof(info)) {
+        if (info.ssi_signo == SIGUSR1) {
+            format_status(status, sizeof(status));
+            printf("%s", status);
+        } else {
+            printf("\n收到信号 %u，退出守护模式\n", info.ssi_signo);
+            event_loop_stop(&g_loop);
+        }
+    }
+}
+
+static void remove_sources(void)
+{
+    g_button_fd = -1;
+    event_loop_remove(&g_udp);
+    event_loop_remove(&g_flash);
+    event_loop_remove(&g_heartbeat);
+    event_loop_remove(&g_ring);
+    event_loop_remove(&g_debounce);
+    event_loop_remove(&g_button);
+    event_loop_remove(&g_tick);
+    event_loop_remove(&g_signals);
+}
+
+int daemon_run(const daemon_config_t *config)
+{
+    sigset_t mask;
+
+    // 先屏蔽信号再创建任何线程 (传感器采样、按键中断)，信号只经signalfd送达事件循环
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    if (event_loop_init(&g_loop) != 0) return 1;
+
+    g_alarm_hour = config->alarm_hour;
+    g_alarm_minute = config->alarm_minute;
+    g_start_ns = now_ns();
+
+    beep_init();
+    botton_init();
+    tm1637_init();
+    rgb_init();
+    sensor_cache_start(SENSOR_CACHE_DHT);
+
+    g_signals.fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    g_signals.handler = on_signal;
+    g_button_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    g_button.fd = g_button_fd;
+    g_button.handler = on_button;
+
+    if (g_signals.fd < 0 || g_button.fd < 0 ||
+        event_loop_add(&g_loop, &g_signals, EPOLLIN) != 0 ||
+        event_loop_add(&g_loop, &g_button, EPOLLIN) != 0 ||
+        event_timer_create(&g_loop, &g_tick, on_tick, NULL) != 0 ||
+        event_timer_create(&g_loop, &g_debounce, on_debounce, NULL) != 0 ||
+        event_timer_create(&g_loop, &g_ring, on_ring, NULL) != 0 ||
+        event_timer_create(&g_loop, &g_heartbeat, on_heartbeat, NULL) != 0 ||
+        event_timer_create(&g_loop, &g_flash, on_flash, NULL) != 0 ||
+        event_timer_set(&g_heartbeat, DAEMON_HEARTBEAT_MS, DAEMON_HEARTBEAT_MS) != 0 ||
+        wiringPiISR(KEY_PIN, INT_EDGE_BOTH, button_isr) < 0 ||
+        (config->port > 0 && udp_start(config->port) != 0)) {
+        printf("守护模式初始化失败\n");
+        remove_sources();
+        sensor_cache_stop();
+        event_loop_close(&g_loop);
+        return 1;
+    }
+
+    printf("守护模式已启动: 时钟、闹钟 (%s)、秒表、指示灯和温度显示在同一事件循环中运行",
+           g_alarm_hour >= 0 ? "已设置" : "未设置");
+    if (config->port > 0) printf("，UDP命令端口 127.0.0.1:%d", config->port);
+    printf("\n");
+
+    g_pressed = botton_is_pressed();
+    check_alarm();
+    state_changed();
+    event_loop_run(&g_loop);
+
+    double uptime = (now_ns() - g_start_ns) / 1e9;
+    printf("守护模式退出: 运行 %.1f 秒, 事件回调 %lu 次 (平均每秒 %.2f 次)\n",
+           uptime, g_events, uptime > 0 ? g_events / uptime : 0.0);
+
+    remove_sources();
+    stop_ring();
+    sensor_cache_stop();
+    beep_off();
+    set_rgb(0, 0, 0);
+    clock_cleanup();
+    event_loop_close(&g_loop);
+    return 0;
+}
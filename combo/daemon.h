@@ -0,0 +1,39 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+// 无界面守护模式 (main_app -d)
+// 时钟、闹钟、秒表、状态指示灯和温度显示在同一个epoll事件循环中同时运行，
+// 不再各自占用进程循环睡眠：定时器 (timerfd) 按需触发，按键边沿经eventfd送入事件循环，
+// SIGINT/SIGTERM/SIGUSR1通过signalfd处理，本地UDP端口接收文本命令。空闲时进程不占用CPU。
+//
+// 数码管按页面显示：时钟 (时:分)、秒表 (分:秒)、温度 (传感器缓存中的读数)。
+// 按键：短按执行当前页面的操作 (秒表开始/暂停，温度页切换摄氏/华氏)，长按切换到下一页，
+// 在秒表页按住3秒清零；闹钟响铃时任意按键停止响铃。
+// 指示灯：闹钟响铃时红灯闪烁，秒表运行时绿灯、暂停时黄灯，其他时候每5秒绿灯短闪一次。
+//
+// UDP命令 (每个数据报一条，回复一行文本)：
+//   status                    当前页面、时间、秒表、闹钟和温度
+//   page clock|stopwatch|temp 切换页面
+//   stopwatch start|pause|reset
+//   alarm HH:MM | alarm off   设置/取消闹钟
+//   ring                      测试响铃
+//   quit                      退出守护模式
+
+#define DAEMON_PORT              25510
+#define DAEMON_DEBOUNCE_MS       30
+#define DAEMON_LONG_PRESS_MS     1000
+#define DAEMON_RESET_PRESS_MS    3000
+#define DAEMON_HEARTBEAT_MS      5000
+#define DAEMON_TEMP_REFRESH_MS   2000
+#define DAEMON_RING_TOGGLES      20     // 响铃时蜂鸣器和红灯切换次数 (每次500ms)
+
+typedef struct {
+    int alarm_hour;                // -1表示不设闹钟
+    int alarm_minute;
+    int port;                      // UDP命令端口，0表示不启用
+} daemon_config_t;
+
+// 运行守护模式，收到SIGINT/SIGTERM或quit命令后返回
+int daemon_run(const daemon_config_t *config);
+
+#endif // DAEMON_H
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include "multitask.h"
+#include "task_io.h"
+#include "../components/sensor_cache.h"
+
+typedef struct {
+    task_t task;
+    float last_temperature;
+    float last_humidity;
+    int shown;
+} temp_task_t;
+
+// 温湿度：传感器缓存有新读数且数值变化时打印
+static int temp_task(task_t *t)
+{
+    temp_task_t *tt = t->ctx;
+    sensor_reading_t reading;
+
+    TASK_BEGIN(t);
+    for (;;) {
+        TASK_AWAIT(t, TASK_EV_SENSOR, -1);
+        sensor_cache_get(&reading);
+        if (!(reading.valid & SENSOR_VALID_ENV)) continue;
+        if (tt->shown && reading.temperature == tt->last_temperature && reading.humidity == tt->last_humidity) continue;
+
+        tt->last_temperature = reading.temperature;
+        tt->last_humidity = reading.humidity;
+        tt->shown = 1;
+        printf("温度: %.1f°C, 湿度: %.1f%%\n", reading.temperature, reading.humidity);
+    }
+    TASK_END(t);
+}
+
+void multitask_demo(void)
+{
+    task_sched_t sched;
+    stopwatch_tasks_t stopwatch;
+    alarm_monitor_t alarm;
+    temp_task_t temp = { .shown = 0 };
+    int hour, minute;
+
+    printf("\n=== 多任务同时运行 ===\n");
+    printf("请输入闹钟时间 (时 分): ");
+    if (scanf("%d %d", &hour, &minute) != 2 || hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        printf("时间无效，不设闹钟\n");
+        hour = -1;
+        minute = 0;
+    }
+    printf("秒表：短按开始/暂停，长按清零；闹钟到点响铃，按按钮停止响铃；温湿度有变化时打印\n");
+    printf("按Ctrl+C返回菜单\n\n");
+
+    if (task_sched_init(&sched) != 0) return;
+    if (task_io_attach(&sched, TASK_IO_BUTTON | TASK_IO_SENSOR) == 0 &&
+        stopwatch_tasks_spawn(&sched, &stopwatch) == 0 &&
+        alarm_monitor_spawn(&sched, &alarm, hour, minute, 0, 0) == 0 &&
+        task_spawn(&sched, &temp.task, temp_task, &temp, "temp") == 0) {
+        uint64_t start = task_now_ns();
+        cancel_token_t *cancel = cancel_begin();
+        task_sched_run(&sched, cancel);
+        cancel_end(cancel);
+
+        double seconds = (task_now_ns() - start) / 1e9;
+        printf("调度器: 运行 %.1f 秒, 任务切换 %llu 次 (每秒 %.1f 次), 定时唤醒 %llu 次, 事件唤醒 %llu 次, "
+               "最大定时延迟 %.1fus, 每个任务 %zu 字节\n",
+               seconds, (unsigned long long)sched.stats.switches, sched.stats.switches / seconds,
+               (unsigned long long)sched.stats.timer_wakes, (unsigned long long)sched.stats.event_wakes,
+               sched.stats.late_max_ns / 1000.0, sizeof(task_t));
+    }
+    task_io_detach();
+    task_sched_close(&sched);
+    stopwatch_cleanup();
+    beep_off();
+}
@@ -0,0 +1,13 @@
+#ifndef MULTITASK_H
+#define MULTITASK_H
+
+#include "alarm_clock.h"
+#include "stopwatch.h"
+#include "task.h"
+
+// 多任务同时运行 (组合演示菜单)
+// 秒表 (按键和数码管)、闹钟监控、温湿度显示在同一个线程的任务调度器中运行，
+// 不再各自占用一个线程或独占菜单：秒表计时的同时闹钟照常响铃，温湿度有新读数时打印。
+void multitask_demo(void);
+
+#endif // MULTITASK_H
@@ -1,112 +1,134 @@
 #include "rgb_control.h"
 
-// 静态变量
-static volatile int rgb_control_running = 1;
-
-// 信号处理函数
-void rgb_control_signal_handler(int signal)
+// 清理函数
+void rgb_control_cleanup(void)
 {
-    printf("\nRGB控制组件接收到信号 %d\n", signal);
-    
-    switch (signal)
-    {
-        case SIGINT:  // Ctrl+C - 设置停止标志
-            printf("RGB控制组件: 接收到退出信号，准备返回主菜单...\n");
-            rgb_control_running = 0;
-            break;
-        default:
-            printf("RGB控制组件: 未处理的信号 %d\n", signal);
-            break;
-    }
+    printf("RGB控制组件清理中...\n");
+    set_rgb(0, 0, 0); // 关闭RGB灯
+    beep_off(); // 关闭蜂鸣器
+    printf("RGB控制组件清理完成\n");
 }
 
-// 设置信号处理器
-void rgb_control_setup_signal_handlers(void)
+static const int colors[8][3] = {
+    {0, 0, 0}, // 关闭
+    {1, 0, 0}, // 红色
+    {0, 1, 0}, // 绿色
+    {0, 0, 1}, // 蓝色
+    {1, 1, 0}, // 黄色
+    {1, 0, 1}, // 紫色
+    {0, 1, 1}, // 青色
+    {1, 1, 1}  // 白色
+};
+
+static const char *color_names[] = {
+    "关闭", "红色", "绿色", "蓝色", "黄色", "紫色", "青色", "白色"
+};
+
+// 在当前线程运行调度器中的任务，直到任务结束或按Ctrl+C
+static void run_tasks(task_sched_t *sched)
 {
-    signal(SIGINT, rgb_control_signal_handler);
-    printf("RGB控制信号处理器设置完成 (仅SIGINT)\n");
+    cancel_token_t *cancel = cancel_begin();
+    task_sched_run(sched, cancel);
+    cancel_end(cancel);
+    task_io_detach();
+    task_sched_close(sched);
 }
 
-// 获取运行状态
-int rgb_control_is_running(void)
+// 按键换色任务：每次按下切换到下一个颜色并提示音
+static int rgb_button_task(task_t *t)
 {
-    return rgb_control_running;
+    rgb_button_t *rb = t->ctx;
+
+    TASK_BEGIN(t);
+    // 设置初始颜色
+    set_rgb(colors[rb->color_index][0], colors[rb->color_index][1], colors[rb->color_index][2]);
+    for (;;) {
+        TASK_AWAIT(t, TASK_EV_BUTTON_DOWN, -1);
+        TASK_SLEEP_MS(t, 50); // 防抖
+        if (!botton_is_pressed()) continue;
+
+        // 切换到下一个颜色
+        rb->color_index = (rb->color_index + 1) % 8;
+        set_rgb(colors[rb->color_index][0], colors[rb->color_index][1], colors[rb->color_index][2]);
+        
+        printf("当前颜色：%s (RGB: %d,%d,%d)\n", 
+               color_names[rb->color_index],
+               colors[rb->color_index][0],
+               colors[rb->color_index][1], 
+               colors[rb->color_index][2]);
+        
+        // 提示音
+        beep_on();
+        TASK_SLEEP_MS(t, 100);
+        beep_off();
+        
+        // 等待按钮释放
+        while (botton_is_pressed()) {
+            TASK_AWAIT(t, TASK_EV_BUTTON_UP, 100);
+        }
+    }
+    TASK_END(t);
 }
 
-// 清理函数
-void rgb_control_cleanup(void)
+int rgb_button_spawn(task_sched_t *sched, rgb_button_t *rb)
 {
-    printf("RGB控制组件清理中...\n");
-    set_rgb(0, 0, 0); // 关闭RGB灯
-    beep_off(); // 关闭蜂鸣器
-    rgb_control_running = 1; // 重置运行状态以便下次使用
-    printf("RGB控制组件清理完成\n");
+    rb->color_index = 0;
+    return task_spawn(sched, &rb->task, rgb_button_task, rb, "rgb_button");
 }
 
 void rgb_button_control(void) {
-    int color_index = 0;
-    int colors[8][3] = {
-        {0, 0, 0}, // 关闭
-        {1, 0, 0}, // 红色
-        {0, 1, 0}, // 绿色
-        {0, 0, 1}, // 蓝色
-        {1, 1, 0}, // 黄色
-        {1, 0, 1}, // 紫色
-        {0, 1, 1}, // 青色
-        {1, 1, 1}  // 白色
-    };
-    
-    char* color_names[] = {
-        "关闭", "红色", "绿色", "蓝色", "黄色", "紫色", "青色", "白色"
-    };
+    task_sched_t sched;
+    rgb_button_t rb;
     
     system("clear");
     printf("\n=== 按键控制RGB灯颜色切换 ===\n");
     printf("按钮功能：按下切换下一个颜色\n");
-    printf("当前颜色：%s\n", color_names[color_index]);
+    printf("当前颜色：%s\n", color_names[0]);
     printf("颜色循环：关闭→红→绿→蓝→黄→紫→青→白→关闭...\n");
     printf("按Ctrl+C退出\n\n");
     
-    // 设置信号处理
-    rgb_control_setup_signal_handlers();
-    rgb_control_running = 1; // 重置运行标志
-    
-    // 设置初始颜色
-    set_rgb(colors[color_index][0], colors[color_index][1], colors[color_index][2]);
-    
-    while (rgb_control_running) {
-        if (botton_is_pressed()) {
-            // 防抖延时
-            usleep(50000);
-            
-            // 切换到下一个颜色
-            color_index = (color_index + 1) % 8;
-            set_rgb(colors[color_index][0], colors[color_index][1], colors[color_index][2]);
-            
-            printf("当前颜色：%s (RGB: %d,%d,%d)\n", 
-                   color_names[color_index],
-                   colors[color_index][0],
-                   colors[color_index][1], 
-                   colors[color_index][2]);
-            
-            // 提示音
-            beep_on();
-            usleep(100000);
-            beep_off();
-            
-            // 等待按钮释放
-            while (botton_is_pressed()) {
-                usleep(10000);
-            }
-        }
-        
-        usleep(50000); // 50ms延时
-    }
+    if (task_sched_init(&sched) != 0) return;
+    if (task_io_attach(&sched, TASK_IO_BUTTON) == 0) rgb_button_spawn(&sched, &rb);
+    run_tasks(&sched);
     
     // 退出时清理
     rgb_control_cleanup();
 }
 
+// 状态灯任务：按步骤循环点亮，按按钮结束 (只有一步且时长为0时常亮)
+static int rgb_pattern_task(task_t *t)
+{
+    rgb_pattern_t *p = t->ctx;
+
+    TASK_BEGIN(t);
+    for (p->i = 0;; p->i = (p->i + 1) % p->count) {
+        const rgb_step_t *step = &p->steps[p->i];
+        set_rgb(step->r, step->g, step->b);
+        TASK_AWAIT(t, p->stop_on_button ? TASK_EV_BUTTON_DOWN : 0, step->ms > 0 ? step->ms : -1);
+        if (t->fired & TASK_EV_BUTTON_DOWN) break;
+    }
+    TASK_END(t);
+}
+
+int rgb_pattern_spawn(task_sched_t *sched, rgb_pattern_t *p, const rgb_step_t *steps, int count, int stop_on_button)
+{
+    p->steps = steps;
+    p->count = count;
+    p->i = 0;
+    p->stop_on_button = stop_on_button;
+    return task_spawn(sched, &p->task, rgb_pattern_task, p, "rgb_pattern");
+}
+
+static void run_pattern(const rgb_step_t *steps, int count)
+{
+    task_sched_t sched;
+    rgb_pattern_t pattern;
+
+    if (task_sched_init(&sched) != 0) return;
+    if (task_io_attach(&sched, TASK_IO_BUTTON) == 0) rgb_pattern_spawn(&sched, &pattern, steps, count, 1);
+    run_tasks(&sched);
+}
+
 void temperature_display_function(void) {
     system("clear");
     printf("\n=== 温度显示功能 ===\n");
@@ -221,56 +243,33 @@ void system_status_indicator(void) {
 }
 
 void status_normal_mode(void) {
+    static const rgb_step_t steps[] = { {0, 1, 0, 0} };
     printf("正常工作模式 - 绿色常亮 (按按钮停止)\n");
-    set_rgb(0, 1, 0);
-    while (!botton_is_pressed()) {
-        usleep(100000);
-    }
+    run_pattern(steps, 1);
 }
 
 void status_warning_mode(void) {
+    static const rgb_step_t steps[] = { {1, 1, 0, 500}, {0, 0, 0, 500} };
     printf("警告模式 - 黄色闪烁 (按按钮停止)\n");
-    while (!botton_is_pressed()) {
-        set_rgb(1, 1, 0);
-        usleep(500000);
-        set_rgb(0, 0, 0);
-        usleep(500000);
-    }
+    run_pattern(steps, 2);
 }
 
 void status_error_mode(void) {
+    static const rgb_step_t steps[] = { {1, 0, 0, 200}, {0, 0, 0, 200} };
     printf("错误模式 - 红色快闪 (按按钮停止)\n");
-    while (!botton_is_pressed()) {
-        set_rgb(1, 0, 0);
-        usleep(200000);
-        set_rgb(0, 0, 0);
-        usleep(200000);
-    }
+    run_pattern(steps, 2);
 }
 
 void status_standby_mode(void) {
+    static const rgb_step_t steps[] = { {0, 0, 1, 1000}, {0, 0, 0, 1000} };
     printf("待机模式 - 蓝色慢闪 (按按钮停止)\n");
-    while (!botton_is_pressed()) {
-        set_rgb(0, 0, 1);
-        usleep(1000000);
-        set_rgb(0, 0, 0);
-        usleep(1000000);
-    }
+    run_pattern(steps, 2);
 }
 
 void status_rainbow_mode(void) {
+    static const rgb_step_t steps[] = {
+        {1, 0, 0, 300}, {1, 1, 0, 300}, {0, 1, 0, 300}, {0, 1, 1, 300}, {0, 0, 1, 300}, {1, 0, 1, 300}
+    };
     printf("彩虹模式 - 颜色循环 (按按钮停止)\n");
-    while (!botton_is_pressed()) {
-        set_rgb(1, 0, 0); usleep(300000);
-        if (botton_is_pressed()) break;
-        set_rgb(1, 1, 0); usleep(300000);
-        if (botton_is_pressed()) break;
-        set_rgb(0, 1, 0); usleep(300000);
-        if (botton_is_pressed()) break;
-        set_rgb(0, 1, 1); usleep(300000);
-        if (botton_is_pressed()) break;
-        set_rgb(0, 0, 1); usleep(300000);
-        if (botton_is_pressed()) break;
-        set_rgb(1, 0, 1); usleep(300000);
-    }
+    run_pattern(steps, 6);
 }
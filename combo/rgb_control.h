@@ -4,12 +4,34 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <signal.h>
 #include <wiringPi.h>
 #include "../components/beep.h"
 #include "../components/botton.h"
 #include "../components/clock.h"
 #include "../components/rgb.h"
+#include "task.h"
+#include "task_io.h"
+
+// 按键换色任务
+typedef struct {
+    task_t task;
+    int color_index;
+} rgb_button_t;
+
+// 状态灯的一步：颜色和持续时间 (毫秒)
+typedef struct {
+    unsigned char r, g, b;
+    int ms;
+} rgb_step_t;
+
+// 状态灯任务：按步骤循环点亮
+typedef struct {
+    task_t task;
+    const rgb_step_t *steps;
+    int count;
+    int i;
+    int stop_on_button;            // 按按钮时结束
+} rgb_pattern_t;
 
 // RGB控制功能函数声明
 void rgb_button_control(void);
@@ -23,10 +45,9 @@ void status_error_mode(void);
 void status_standby_mode(void);
 void status_rainbow_mode(void);
 
-// 信号处理函数声明
-void rgb_control_signal_handler(int signal);
-void rgb_control_setup_signal_handlers(void);
-int rgb_control_is_running(void);
+// 任务 (可与其他任务在同一调度器中运行)
+int rgb_button_spawn(task_sched_t *sched, rgb_button_t *rb);
+int rgb_pattern_spawn(task_sched_t *sched, rgb_pattern_t *p, const rgb_step_t *steps, int count, int stop_on_button);
 void rgb_control_cleanup(void);
 
 #endif // RGB_CONTROL_H
@@ -1,45 +1,11 @@
 #include "stopwatch.h"
 
-// 静态变量
-static volatile int stopwatch_running = 1;
-
-// 信号处理函数
-void stopwatch_signal_handler(int signal)
-{
-    printf("\n秒表组件接收到信号 %d\n", signal);
-    
-    switch (signal)
-    {
-        case SIGINT:  // Ctrl+C - 设置停止标志
-            printf("秒表组件: 接收到退出信号，准备返回主菜单...\n");
-            stopwatch_running = 0;
-            break;
-        default:
-            printf("秒表组件: 未处理的信号 %d\n", signal);
-            break;
-    }
-}
-
-// 设置信号处理器
-void stopwatch_setup_signal_handlers(void)
-{
-    signal(SIGINT, stopwatch_signal_handler);
-    printf("秒表信号处理器设置完成 (仅SIGINT)\n");
-}
-
-// 获取运行状态
-int stopwatch_is_running(void)
-{
-    return stopwatch_running;
-}
-
 // 清理函数
 void stopwatch_cleanup(void)
 {
     printf("秒表组件清理中...\n");
     set_rgb(0, 0, 0); // 关闭RGB灯
     data_display("    "); // 清空显示
-    stopwatch_running = 1; // 重置运行状态以便下次使用
     printf("秒表组件清理完成\n");
 }
 
@@ -133,64 +99,103 @@ void stopwatch_reset(int *running, int *total_seconds) {
     getchar();
 }
 
+// ---------------- 按键控制模式 (任务) ----------------
+
+static int64_t stopwatch_elapsed_ms(const stopwatch_tasks_t *sw)
+{
+    uint64_t elapsed = sw->elapsed_ns;
+    if (sw->running) elapsed += task_now_ns() - sw->start_ns;
+    return (int64_t)(elapsed / 1000000ULL);
+}
+
+// 按键：短按 (松开时) 开始/暂停，按住超过STOPWATCH_LONG_PRESS_MS清零
+static int stopwatch_button_task(task_t *t)
+{
+    stopwatch_tasks_t *sw = t->ctx;
+
+    TASK_BEGIN(t);
+    for (;;) {
+        TASK_AWAIT(t, TASK_EV_BUTTON_DOWN, -1);
+        TASK_SLEEP_MS(t, STOPWATCH_DEBOUNCE_MS); // 防抖
+        if (!botton_is_pressed()) continue;
+
+        TASK_AWAIT(t, TASK_EV_BUTTON_UP, STOPWATCH_LONG_PRESS_MS);
+        if (t->fired & TASK_EV_TIMEOUT) {
+            sw->running = 0;
+            sw->elapsed_ns = 0;
+            printf("计时重置！\n");
+            set_rgb(0, 0, 0);
+            sw->beep_ms = 500;
+        } else if (!sw->running) {
+            sw->running = 1;
+            sw->start_ns = task_now_ns();
+            printf("计时开始！\n");
+            set_rgb(0, 1, 0); // 绿色表示运行
+            sw->beep_ms = 100;
+        } else {
+            sw->running = 0;
+            sw->elapsed_ns += task_now_ns() - sw->start_ns;
+            printf("计时暂停！\n");
+            set_rgb(1, 1, 0); // 黄色表示暂停
+            sw->beep_ms = 200;
+        }
+        task_signal(t->sched, STOPWATCH_EV_CHANGED);
+
+        beep_on();
+        TASK_SLEEP_MS(t, sw->beep_ms);
+        beep_off();
+
+        // 长按时等待松开
+        while (botton_is_pressed()) {
+            TASK_AWAIT(t, TASK_EV_BUTTON_UP, 100);
+        }
+    }
+    TASK_END(t);
+}
+
+// 数码管：运行时在每秒整点刷新，暂停后等待状态变化
+static int stopwatch_display_task(task_t *t)
+{
+    stopwatch_tasks_t *sw = t->ctx;
+
+    TASK_BEGIN(t);
+    for (;;) {
+        int64_t ms = stopwatch_elapsed_ms(sw);
+        int minutes = (int)(ms / 60000);
+        char time_str[16];
+
+        // 限制显示范围，防止溢出
+        if (minutes > 99) minutes = 99;
+        snprintf(time_str, sizeof(time_str), "%02d%02d", minutes, (int)(ms / 1000 % 60));
+        text_display(time_str);
+
+        TASK_AWAIT(t, STOPWATCH_EV_CHANGED, sw->running ? (int)(1000 - stopwatch_elapsed_ms(sw) % 1000) : -1);
+    }
+    TASK_END(t);
+}
+
+int stopwatch_tasks_spawn(task_sched_t *sched, stopwatch_tasks_t *sw)
+{
+    memset(sw, 0, sizeof(*sw));
+    if (task_spawn(sched, &sw->button, stopwatch_button_task, sw, "stopwatch_button") != 0) return -1;
+    return task_spawn(sched, &sw->display, stopwatch_display_task, sw, "stopwatch_display");
+}
+
 void stopwatch_button_control_mode(void) {
-    int running = 0;
-    int total_seconds = 0;
-    int start_time = 0;
+    task_sched_t sched;
+    stopwatch_tasks_t sw;
     
     printf("按钮控制模式：短按开始/暂停，长按重置\n");
     printf("按Ctrl+C退出此模式\n");
     
-    // 设置信号处理
-    stopwatch_setup_signal_handlers();
-    stopwatch_running = 1; // 重置运行标志
-    
-    while (stopwatch_running) {
-        if (running) {
-            total_seconds = time(NULL) - start_time;
-            // 确保时间值不为负数
-            if (total_seconds < 0) total_seconds = 0;
-            
-            char time_str[10]; // 增加缓冲区大小以防止溢出
-            int minutes = total_seconds / 60;
-            int seconds = total_seconds % 60;
-            
-            // 限制显示范围，防止溢出
-            if (minutes > 99) minutes = 99;
-            if (seconds < 0) seconds = 0;
-            if (seconds > 59) seconds = 59;
-            
-            sprintf(time_str, "%02d%02d", minutes, seconds);
-            text_display(time_str);
-        }
-        
-        if (botton_is_pressed()) {
-            // 简单的短按检测
-            usleep(50000); // 防抖
-            if (!running) {
-                running = 1;
-                start_time = time(NULL) - total_seconds;
-                set_rgb(0, 1, 0);
-                beep_on();
-                usleep(100000);
-                beep_off();
-            } else {
-                running = 0;
-                total_seconds = time(NULL) - start_time;
-                set_rgb(1, 1, 0);
-                beep_on();
-                usleep(200000);
-                beep_off();
-            }
-            
-            // 等待按钮释放
-            while (botton_is_pressed()) {
-                usleep(10000);
-            }
-        }
-        
-        usleep(100000); // 0.1秒延时
+    if (task_sched_init(&sched) != 0) return;
+    if (task_io_attach(&sched, TASK_IO_BUTTON) == 0 && stopwatch_tasks_spawn(&sched, &sw) == 0) {
+        cancel_token_t *cancel = cancel_begin();
+        task_sched_run(&sched, cancel);
+        cancel_end(cancel);
     }
+    task_io_detach();
+    task_sched_close(&sched);
     
     // 退出时清理
     stopwatch_cleanup();
@@ -5,12 +5,27 @@
 #include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
-#include <signal.h>
 #include <wiringPi.h>
 #include "../components/beep.h"
 #include "../components/botton.h"
 #include "../components/clock.h"
 #include "../components/rgb.h"
+#include "task.h"
+#include "task_io.h"
+
+#define STOPWATCH_DEBOUNCE_MS    50
+#define STOPWATCH_LONG_PRESS_MS  1000   // 按住超过此时间清零
+#define STOPWATCH_EV_CHANGED     TASK_EV_USER   // 秒表状态变化 (开始、暂停、清零)
+
+// 按键控制秒表的两个任务：按键处理和数码管刷新 (可与其他任务在同一调度器中运行)
+typedef struct {
+    task_t button;
+    task_t display;
+    int running;
+    uint64_t start_ns;             // 本次开始计时的时间
+    uint64_t elapsed_ns;           // 之前累计的时间
+    int beep_ms;
+} stopwatch_tasks_t;
 
 // 秒表功能函数声明
 void stopwatch_function(void);
@@ -18,11 +33,7 @@ void stopwatch_start_continue(int *running, int *start_time, int *total_seconds)
 void stopwatch_pause(int *running, int *start_time, int *total_seconds);
 void stopwatch_reset(int *running, int *total_seconds);
 void stopwatch_button_control_mode(void);
-
-// 信号处理函数声明
-void stopwatch_signal_handler(int signal);
-void stopwatch_setup_signal_handlers(void);
-int stopwatch_is_running(void);
+int stopwatch_tasks_spawn(task_sched_t *sched, stopwatch_tasks_t *sw);
 void stopwatch_cleanup(void);
 
 #endif // STOPWATCH_H
@@ -0,0 +1,319 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "task.h"
+#include "../components/trace.h"
+
+// 任务状态
+#define TASK_STATE_NEW      0
+#define TASK_STATE_READY    1
+#define TASK_STATE_RUNNING  2
+#define TASK_STATE_WAITING  3
+#define TASK_STATE_DONE     4
+
+#define TASK_HEAP_INIT      16
+
+uint64_t task_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------- 定时堆 ----------------
+
+static void heap_place(task_sched_t *s, int i, task_t *t)
+{
+    s->heap[i] = t;
+    t->heap_index = i;
+}
+
+static void heap_up(task_sched_t *s, int i)
+{
+    task_t *t = s->heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (s->heap[parent]->wake_ns <= t->wake_ns) break;
+        heap_place(s, i, s->heap[parent]);
+        i = parent;
+    }
+    heap_place(s, i, t);
+}
+
+static void heap_down(task_sched_t *s, int i)
+{
+    task_t *t = s->heap[i];
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= s->heap_len) break;
+        if (child + 1 < s->heap_len && s->heap[child + 1]->wake_ns < s->heap[child]->wake_ns) child++;
+        if (t->wake_ns <= s->heap[child]->wake_ns) break;
+        heap_place(s, i, s->heap[child]);
+        i = child;
+    }
+    heap_place(s, i, t);
+}
+
+// 堆容量在task_spawn中预留 (每个任务最多在堆中出现一次)，这里不会失败
+static void heap_push(task_sched_t *s, task_t *t)
+{
+    heap_place(s, s->heap_len++, t);
+    heap_up(s, s->heap_len - 1);
+}
+
+static void heap_remove(task_sched_t *s, task_t *t)
+{
+    int i = t->heap_index;
+    task_t *last = s->heap[--s->heap_len];
+
+    t->heap_index = -1;
+    if (i == s->heap_len) return;
+    heap_place(s, i, last);
+    if (i > 0 && s->heap[(i - 1) / 2]->wake_ns > last->wake_ns) heap_up(s, i);
+    else heap_down(s, i);
+}
+
+// ---------------- 就绪队列和事件等待 ----------------
+
+static void enqueue(task_sched_t *s, task_t *t)
+{
+    t->state = TASK_STATE_READY;
+    t->next = NULL;
+    if (s->ready_tail) s->ready_tail->next = t;
+    else s->ready_head = t;
+    s->ready_tail = t;
+}
+
+static void unlink_waiter(task_sched_t *s, task_t *t)
+{
+    if (t->ev_prev) t->ev_prev->ev_next = t->ev_next;
+    else s->waiters = t->ev_next;
+    if (t->ev_next) t->ev_next->ev_prev = t->ev_prev;
+    t->ev_prev = t->ev_next = NULL;
+}
+
+// 结束等待 (定时和事件只需其一)
+static void cancel_wait(task_sched_t *s, task_t *t)
+{
+    if (t->heap_index >= 0) heap_remove(s, t);
+    if (t->wait_mask) {
+        unlink_waiter(s, t);
+        t->wait_mask = 0;
+    }
+}
+
+static void wake(task_sched_t *s, task_t *t, uint32_t fired)
+{
+    cancel_wait(s, t);
+    t->fired = fired;
+    enqueue(s, t);
+}
+
+void task_wait(task_t *task, uint32_t mask, int timeout_ms)
+{
+    task_sched_t *s = task->sched;
+
+    task->fired = 0;
+    task->wait_mask = mask;
+    if (mask) {
+        task->ev_prev = NULL;
+        task->ev_next = s->waiters;
+        if (s->waiters) s->waiters->ev_prev = task;
+        s->waiters = task;
+    }
+    if (timeout_ms >= 0) {
+        task->wake_ns = task_now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+        heap_push(s, task);
+    } else {
+        task->wake_ns = 0;
+    }
+}
+
+int task_join(task_t *task, task_t *child)
+{
+    if (child->state == TASK_STATE_NEW || child->state == TASK_STATE_DONE) {
+        task->fired = TASK_EV_DONE;
+        return 0;
+    }
+    child->joiner = task;
+    task->fired = 0;
+    task->wait_mask = 0;
+    task->wake_ns = 0;
+    return 1;
+}
+
+void task_signal(task_sched_t *s, uint32_t events)
+{
+    task_t *t = s->waiters;
+    while (t != NULL) {
+        task_t *next = t->ev_next;
+        if (t->wait_mask & events) {
+            wake(s, t, t->wait_mask & events);
+            s->stats.event_wakes++;
+        }
+        t = next;
+    }
+}
+
+void task_post(task_sched_t *s, uint32_t events)
+{
+    uint64_t one = 1;
+
+    // 已有未分发的事件时调度器已被唤醒，不必再写eventfd
+    if (__atomic_fetch_or(&s->pending, events, __ATOMIC_ACQ_REL) == 0 &&
+        write(s->efd, &one, sizeof(one)) < 0) {
+        // 计数已满时仍然可读
+    }
+}
+
+// ---------------- 调度器 ----------------
+
+int task_sched_init(task_sched_t *sched)
+{
+    memset(sched, 0, sizeof(*sched));
+    sched->efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (sched->efd < 0) {
+        printf("任务调度器创建eventfd失败\n");
+        return -1;
+    }
+    return 0;
+}
+
+void task_sched_close(task_sched_t *sched)
+{
+    if (sched->efd >= 0) close(sched->efd);
+    sched->efd = -1;
+    free(sched->heap);
+    sched->heap = NULL;
+    sched->heap_len = sched->heap_cap = 0;
+}
+
+int task_spawn(task_sched_t *sched, task_t *task, task_fn_t fn, void *ctx, const char *name)
+{
+    if (sched->live >= sched->heap_cap) {
+        int cap = sched->heap_cap ? sched->heap_cap * 2 : TASK_HEAP_INIT;
+        task_t **heap = realloc(sched->heap, cap * sizeof(task_t *));
+        if (heap == NULL) {
+            printf("任务 %s 启动失败: 内存不足\n", name);
+            return -1;
+        }
+        sched->heap = heap;
+        sched->heap_cap = cap;
+    }
+
+    memset(task, 0, sizeof(*task));
+    task->fn = fn;
+    task->ctx = ctx;
+    task->name = name;
+    task->sched = sched;
+    task->heap_index = -1;
+    sched->live++;
+    enqueue(sched, task);
+    return 0;
+}
+
+int task_is_done(const task_t *task)
+{
+    return task->state == TASK_STATE_DONE;
+}
+
+void task_sched_stop(task_sched_t *sched)
+{
+    sched->stop = 1;
+}
+
+static void step(task_sched_t *s, task_t *t)
+{
+    t->state = TASK_STATE_RUNNING;
+    TRACE_BEGIN("task", t->name);
+    int ret = t->fn(t);
+    TRACE_END("task", t->name);
+    s->stats.switches++;
+
+    if (ret == TASK_DONE) {
+        cancel_wait(s, t);
+        t->state = TASK_STATE_DONE;
+        s->live--;
+        if (t->joiner != NULL) {
+            task_t *joiner = t->joiner;
+            t->joiner = NULL;
+            joiner->fired = TASK_EV_DONE;
+            enqueue(s, joiner);
+        }
+    } else if (ret == TASK_YIELDED) {
+        t->fired = 0;
+        enqueue(s, t);
+    } else {
+        t->state = TASK_STATE_WAITING;
+    }
+}
+
+// 运行本轮就绪的任务，本轮中被唤醒的任务留到下一轮
+static void run_ready(task_sched_t *s)
+{
+    task_t *t = s->ready_head;
+
+    s->ready_head = s->ready_tail = NULL;
+    while (t != NULL && !s->stop) {
+        task_t *next = t->next;
+        t->next = NULL;
+        step(s, t);
+        t = next;
+    }
+    // 停止时把没运行到的任务放回队列
+    while (t != NULL) {
+        task_t *next = t->next;
+        enqueue(s, t);
+        t = next;
+    }
+}
+
+void task_sched_run(task_sched_t *s, cancel_token_t *cancel)
+{
+    s->stop = 0;
+    while (s->live > 0 && !s->stop) {
+        if (cancel != NULL && cancel_requested(cancel)) break;
+
+        uint32_t pending = __atomic_exchange_n(&s->pending, 0, __ATOMIC_ACQ_REL);
+        if (pending) task_signal(s, pending);
+
+        uint64_t now = task_now_ns();
+        while (s->heap_len > 0 && s->heap[0]->wake_ns <= now) {
+            task_t *t = s->heap[0];
+            uint64_t late = now - t->wake_ns;
+            if (late > s->stats.late_max_ns) s->stats.late_max_ns = late;
+            wake(s, t, TASK_EV_TIMEOUT);
+            s->stats.timer_wakes++;
+        }
+
+        if (s->ready_head != NULL) {
+            run_ready(s);
+            continue;
+        }
+
+        // 没有就绪任务：睡到最近的定时，或被投递的事件和取消唤醒
+        struct pollfd fds[2] = {
+            { s->efd, POLLIN, 0 },
+            { cancel != NULL ? cancel->efd : -1, POLLIN, 0 },
+        };
+        struct timespec timeout, *tp = NULL;
+        if (s->heap_len > 0) {
+            uint64_t left = s->heap[0]->wake_ns - now;
+            timeout.tv_sec = left / 1000000000ULL;
+            timeout.tv_nsec = left % 1000000000ULL;
+            tp = &timeout;
+        }
+        s->stats.polls++;
+        if (ppoll(fds, 2, tp, NULL) > 0 && (fds[0].revents & POLLIN)) {
+            uint64_t value;
+            if (read(s->efd, &value, sizeof(value)) < 0) {
+                // 已被读空
+            }
+        }
+    }
+}
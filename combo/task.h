@@ -0,0 +1,133 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <stdint.h>
+#include "../components/cancel.h"
+
+// 无栈协程 (protothread) 任务调度
+// 组合演示中的行为 (闹钟、秒表、按键换色、状态灯) 写成任务函数，在同一个线程中交替运行：
+// 任务在 TASK_SLEEP_MS / TASK_AWAIT 处返回调度器，等待的定时到期或事件发生后从同一位置继续。
+// 任务没有自己的栈，切换只是一次函数返回和调用；每个任务只占一个task_t (不到100字节) 和定时堆中的一个指针。
+//
+// 写法限制 (与protothread相同)：
+// - 任务函数的局部变量在等待之后不保留，需要保留的状态放在ctx指向的结构中
+// - 等待宏只能写在任务函数本身中 (不能在它调用的函数里等待)，函数体中不能再使用switch包住等待宏
+// - 等待期间不要调用会阻塞的函数 (如DHT11读取)，改为等待传感器缓存的TASK_EV_SENSOR事件
+//
+//   static int blink(task_t *t)
+//   {
+//       blink_t *b = t->ctx;
+//       TASK_BEGIN(t);
+//       while (b->count-- > 0) {
+//           set_rgb(1, 0, 0);
+//           TASK_SLEEP_MS(t, 500);
+//           set_rgb(0, 0, 0);
+//           TASK_AWAIT(t, TASK_EV_BUTTON_DOWN, 500);
+//           if (t->fired & TASK_EV_BUTTON_DOWN) break;
+//       }
+//       TASK_END(t);
+//   }
+
+// 事件位 (TASK_EV_USER起为应用自定义事件)
+#define TASK_EV_TIMEOUT      0x01u   // 只出现在fired中：等待超时
+#define TASK_EV_DONE         0x02u   // 只出现在fired中：TASK_JOIN等待的任务结束
+#define TASK_EV_BUTTON_DOWN  0x04u   // 按键按下 (task_io)
+#define TASK_EV_BUTTON_UP    0x08u   // 按键释放 (task_io)
+#define TASK_EV_SENSOR       0x10u   // 传感器缓存有新读数 (task_io)
+#define TASK_EV_USER         0x100u
+
+// 任务函数返回值
+#define TASK_WAITING   0
+#define TASK_YIELDED   1
+#define TASK_DONE      2
+
+typedef struct task task_t;
+typedef struct task_sched task_sched_t;
+typedef int (*task_fn_t)(task_t *task);
+
+struct task {
+    task_fn_t fn;
+    void *ctx;
+    const char *name;
+    task_sched_t *sched;
+    uint64_t wake_ns;              // 等待的截止时间 (0表示不限时)
+    uint32_t wait_mask;            // 等待的事件
+    uint32_t fired;                // 本次唤醒的原因 (事件位或TASK_EV_TIMEOUT)
+    int32_t heap_index;            // 在定时堆中的位置，-1表示不在堆中
+    uint16_t pc;                   // 继续执行的位置 (行号)
+    uint8_t state;
+    task_t *next;                  // 就绪队列
+    task_t *ev_prev, *ev_next;     // 事件等待链表
+    task_t *joiner;                // 等待本任务结束的任务
+};
+
+typedef struct {
+    uint64_t switches;             // 任务函数被调用的次数
+    uint64_t timer_wakes;
+    uint64_t event_wakes;
+    uint64_t polls;                // 调度器进入等待的次数
+    uint64_t late_max_ns;          // 定时唤醒相对截止时间的最大延迟
+} task_stats_t;
+
+struct task_sched {
+    task_t *ready_head, *ready_tail;
+    task_t **heap;                 // 按wake_ns排列的最小堆
+    int heap_len, heap_cap;
+    task_t *waiters;               // 等待事件的任务
+    uint32_t pending;              // 其他线程投递、尚未分发的事件 (原子读写)
+    int efd;                       // 其他线程投递事件时唤醒调度器
+    int live;                      // 未结束的任务数
+    int stop;
+    task_stats_t stats;
+};
+
+// ---------------- 任务函数中使用的宏 ----------------
+
+#define TASK_BEGIN(t)   switch ((t)->pc) { case 0:
+#define TASK_END(t)     } (t)->pc = 0; return TASK_DONE
+
+// 让出一次，其他就绪任务运行后继续
+#define TASK_YIELD(t) \
+    do { (t)->pc = __LINE__; return TASK_YIELDED; case __LINE__:; } while (0)
+
+// 等待ms毫秒
+#define TASK_SLEEP_MS(t, ms) \
+    do { task_wait((t), 0, (int)(ms)); (t)->pc = __LINE__; return TASK_WAITING; case __LINE__:; } while (0)
+
+// 等待mask中的任一事件，timeout_ms<0表示不限时；返回后(t)->fired为唤醒原因
+#define TASK_AWAIT(t, mask, timeout_ms) \
+    do { task_wait((t), (mask), (timeout_ms)); (t)->pc = __LINE__; return TASK_WAITING; case __LINE__:; } while (0)
+
+// 等待另一个任务结束 (child需已由task_spawn启动)
+#define TASK_JOIN(t, child) \
+    do { if (task_join((t), (child))) { (t)->pc = __LINE__; return TASK_WAITING; case __LINE__:; } } while (0)
+
+// 结束任务
+#define TASK_EXIT(t) \
+    do { (t)->pc = 0; return TASK_DONE; } while (0)
+
+// ---------------- 调度器 ----------------
+
+int task_sched_init(task_sched_t *sched);
+void task_sched_close(task_sched_t *sched);
+
+// 启动任务 (task由调用者提供，任务结束前不能释放)，失败返回-1
+int task_spawn(task_sched_t *sched, task_t *task, task_fn_t fn, void *ctx, const char *name);
+
+// 运行到所有任务结束、task_sched_stop()或cancel被取消 (cancel可以为NULL)
+void task_sched_run(task_sched_t *sched, cancel_token_t *cancel);
+void task_sched_stop(task_sched_t *sched);
+
+// 唤醒等待这些事件的任务：task_signal只能在调度器线程 (任务函数中) 调用，
+// task_post可在任意线程 (包括中断回调) 调用，由调度器在下一轮分发
+void task_signal(task_sched_t *sched, uint32_t events);
+void task_post(task_sched_t *sched, uint32_t events);
+
+int task_is_done(const task_t *task);
+uint64_t task_now_ns(void);
+
+// 宏内部使用
+void task_wait(task_t *task, uint32_t mask, int timeout_ms);
+int task_join(task_t *task, task_t *child);
+
+#endif // TASK_H
@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <wiringPi.h>
+#include "task_io.h"
+#include "../components/botton.h"
+#include "../components/sensor_cache.h"
+#include "../components/metrics.h"
+
+static task_sched_t *g_sched = NULL;   // 接收事件的调度器 (原子读写)
+static int g_isr_registered = 0;       // wiringPi中断不能注销，只注册一次
+static int g_started_cache = 0;        // 传感器缓存由task_io_attach启动
+
+static metric_t m_button_presses = METRIC_COUNTER("rpi_button_presses_total", "mode=\"menu\"", "按键按下次数");
+
+// 按键边沿中断 (wiringPi中断线程)
+static void button_isr(void)
+{
+    task_sched_t *sched = __atomic_load_n(&g_sched, __ATOMIC_ACQUIRE);
+    if (sched == NULL) return;
+    int pressed = botton_is_pressed();
+    if (pressed) metric_inc(&m_button_presses);
+    task_post(sched, pressed ? TASK_EV_BUTTON_DOWN : TASK_EV_BUTTON_UP);
+}
+
+// 传感器缓存发布新读数 (采样线程)
+static void sensor_notify(void)
+{
+    task_sched_t *sched = __atomic_load_n(&g_sched, __ATOMIC_ACQUIRE);
+    if (sched != NULL) task_post(sched, TASK_EV_SENSOR);
+}
+
+int task_io_attach(task_sched_t *sched, unsigned int sources)
+{
+    __atomic_store_n(&g_sched, sched, __ATOMIC_RELEASE);
+
+    if ((sources & TASK_IO_BUTTON) && !g_isr_registered) {
+        if (wiringPiISR(KEY_PIN, INT_EDGE_BOTH, button_isr) < 0) {
+            printf("按键中断注册失败\n");
+            return -1;
+        }
+        g_isr_registered = 1;
+    }
+    if (sources & TASK_IO_SENSOR) {
+        sensor_cache_set_notify(sensor_notify);
+        if (!sensor_cache_is_running()) {
+            if (sensor_cache_start(SENSOR_CACHE_DHT) != 0) return -1;
+            g_started_cache = 1;
+        }
+    }
+    return 0;
+}
+
+void task_io_detach(void)
+{
+    sensor_cache_set_notify(NULL);
+    __atomic_store_n(&g_sched, NULL, __ATOMIC_RELEASE);
+    if (g_started_cache) {
+        sensor_cache_stop();
+        g_started_cache = 0;
+    }
+}
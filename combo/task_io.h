@@ -0,0 +1,18 @@
+#ifndef TASK_IO_H
+#define TASK_IO_H
+
+#include "task.h"
+
+// 任务事件来源：按键边沿中断 (wiringPiISR) 投递TASK_EV_BUTTON_DOWN/UP，
+// 传感器缓存每次发布新读数投递TASK_EV_SENSOR。同一时间只连接一个调度器。
+// 按键事件未去抖，任务收到按下事件后应等待一小段时间再确认按键状态。
+
+#define TASK_IO_BUTTON  0x01
+#define TASK_IO_SENSOR  0x02
+
+// 连接事件来源 (sources为TASK_IO_*的组合)；TASK_IO_SENSOR在传感器缓存未运行时启动温湿度采样
+int task_io_attach(task_sched_t *sched, unsigned int sources);
+// 断开，之后的中断和读数不再投递 (由attach启动的传感器缓存同时停止)
+void task_io_detach(void);
+
+#endif // TASK_IO_H
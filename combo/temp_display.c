@@ -2,12 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <signal.h>
 #include <wiringPi.h>
 #include "temp_display.h"
 
 // 全局变量
-static int running = 0;
+static cancel_token_t *running = NULL;   // 显示循环运行时的取消令牌
 static TempDisplayConfig current_config;
 
 // 初始化温度显示系统
@@ -98,22 +97,6 @@ void temp_display_set_mode(TempDisplayMode mode)
     printf("切换到%s模式\n", mode_names[mode]);
 }
 
-// 信号处理函数
-void temp_display_signal_handler(int signal)
-{
-    if (signal == SIGINT || signal == SIGTERM) {
-        printf("\n收到退出信号，正在清理资源...\n");
-        running = 0;
-    }
-}
-
-// 设置信号处理
-void temp_display_setup_signal_handlers(void)
-{
-    signal(SIGINT, temp_display_signal_handler);
-    signal(SIGTERM, temp_display_signal_handler);
-}
-
 // 主显示循环
 int temp_display_start(TempDisplayConfig *config)
 {
@@ -121,21 +104,19 @@ int temp_display_start(TempDisplayConfig *config)
         current_config = *config;
     }
     
-    temp_display_setup_signal_handlers();
-    
     DHT11_Data sensor_data;
     char display_buffer[5];
     unsigned char result;
     int success_count = 0;
     int total_count = 0;
     
-    running = 1;
+    running = cancel_begin();
     printf("温度显示系统启动 (按Ctrl+C退出)\n");
     printf("当前模式: %s\n", 
            current_config.mode == TEMP_MODE_CELSIUS ? "摄氏度" :
            current_config.mode == TEMP_MODE_FAHRENHEIT ? "华氏度" : "湿度");
     
-    while (running) {
+    while (!cancel_requested(running)) {
         total_count++;
         result = temp_display_read_sensor(&sensor_data);
         
@@ -185,8 +166,10 @@ int temp_display_start(TempDisplayConfig *config)
                    (float)success_count/total_count*100);
         }
         
-        sleep(current_config.update_interval);
+        cancel_sleep_ms(running, current_config.update_interval * 1000);
     }
+    cancel_end(running);
+    running = NULL;
     
     return 0;
 }
@@ -194,7 +177,8 @@ int temp_display_start(TempDisplayConfig *config)
 // 停止显示
 void temp_display_stop(void)
 {
-    running = 0;
+    cancel_token_t *token = running;
+    if (token != NULL) cancel_request(token);
 }
 
 // 清理资源
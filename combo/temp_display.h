@@ -30,8 +30,4 @@ void temp_display_format_humidity(float humidity, char *output, int show_decimal
 void temp_display_show_error(unsigned char error_code);
 void temp_display_cleanup(void);
 
-// 信号处理
-void temp_display_signal_handler(int signal);
-void temp_display_setup_signal_handlers(void);
-
 #endif // TEMP_DISPLAY_H
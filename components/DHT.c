@@ -4,6 +4,21 @@
 #include <time.h>
 #include <wiringPi.h>
 #include "DHT.h"
+#include "metrics.h"
+#include "trace.h"
+
+// 上电稳定的截止时刻 (millis，0表示未初始化)，dht11_init第一次调用时记录 (原子读写)
+static unsigned int g_ready_ms = 0;
+static int g_initialized = 0;
+
+static metric_t m_reads_ok = METRIC_COUNTER("rpi_dht_reads_total", "result=\"ok\"", "DHT11读取次数");
+static metric_t m_reads_checksum = METRIC_COUNTER("rpi_dht_reads_total", "result=\"checksum\"", "DHT11读取次数");
+static metric_t m_reads_no_response = METRIC_COUNTER("rpi_dht_reads_total", "result=\"no_response\"", "DHT11读取次数");
+static metric_t m_reads_timeout = METRIC_COUNTER("rpi_dht_reads_total", "result=\"timeout\"", "DHT11读取次数");
+static metric_t m_read_seconds = METRIC_HISTOGRAM("rpi_dht_read_duration_seconds", NULL,
+                                                  "DHT11一次读取的用时 (不含上电稳定等待)", METRICS_BUCKETS_MS);
+static metric_t m_temperature = METRIC_GAUGE("rpi_temperature_celsius", NULL, "最近一次读取的温度");
+static metric_t m_humidity = METRIC_GAUGE("rpi_humidity_percent", NULL, "最近一次读取的湿度");
 
 int dht11_scan()
 {
@@ -81,11 +96,11 @@ char read_byte()
     return data;
 }
 
-unsigned char dht11_read_data(char *buff)
+static unsigned char dht11_read_raw(char *buff)
 {
     int i = 0;  // 改为int类型
     int timeout = 0;
-    
+
     dht11_reset();
     
     // 等待传感器响应信号（应该拉低80微秒）
@@ -140,6 +155,26 @@ unsigned char dht11_read_data(char *buff)
     return DHT_SUCCESS; // 成功读取
 }
 
+unsigned char dht11_read_data(char *buff)
+{
+    // 第一次读取时等完剩余的稳定时间
+    unsigned int left = dht11_settle_left_ms();
+    if (left > 0) delay(left);
+
+    TRACE_BEGIN("sensor", "dht11_read_data");
+    uint64_t start = metrics_now_ns();
+    unsigned char result = dht11_read_raw(buff);
+    metric_observe_since(&m_read_seconds, start);
+    TRACE_END("sensor", "dht11_read_data");
+    switch (result) {
+        case DHT_SUCCESS:        metric_inc(&m_reads_ok); break;
+        case DHT_CHECKSUM_ERROR: metric_inc(&m_reads_checksum); break;
+        case DHT_NO_RESPONSE:    metric_inc(&m_reads_no_response); break;
+        default:                 metric_inc(&m_reads_timeout); break;
+    }
+    return result;
+}
+
 // 新增：带重试机制的读取函数
 unsigned char dht11_read_with_retry(DHT11_Data *data, int max_retry)
 {
@@ -158,6 +193,8 @@ unsigned char dht11_read_with_retry(DHT11_Data *data, int max_retry)
             // 解析数据
             data->humidity = buffer[0] + buffer[1] * 0.1;
             data->temperature = buffer[2] + buffer[3] * 0.1;
+            metric_set(&m_temperature, data->temperature);
+            metric_set(&m_humidity, data->humidity);
             
             // 保存原始数据
             for (int i = 0; i < 5; i++) {
@@ -176,13 +213,29 @@ unsigned char dht11_read_with_retry(DHT11_Data *data, int max_retry)
     return result; // 返回最后一次的错误码
 }
 
-// 新增：初始化DHT11
+// 新增：初始化DHT11 (只设置空闲电平并记录稳定截止时刻，不等待；重复调用直接返回)
 int dht11_init()
 {
+    if (__atomic_exchange_n(&g_initialized, 1, __ATOMIC_ACQ_REL)) return 0;
+
     // 设置初始状态
     pinMode(DHT_PIN, OUTPUT);
     digitalWrite(DHT_PIN, 1);
-    delay(1000); // 等待传感器稳定
+    // 各种结果在第一次读取之前就以0导出
+    metric_register(&m_reads_ok);
+    metric_register(&m_reads_checksum);
+    metric_register(&m_reads_no_response);
+    metric_register(&m_reads_timeout);
+    __atomic_store_n(&g_ready_ms, millis() + DHT_SETTLE_MS, __ATOMIC_RELEASE);
     
     return 0;
 }
+
+// 传感器稳定还需等待的毫秒数 (未初始化或已稳定时为0)
+unsigned int dht11_settle_left_ms(void)
+{
+    unsigned int ready_ms = __atomic_load_n(&g_ready_ms, __ATOMIC_ACQUIRE);
+    if (ready_ms == 0) return 0;
+    int left = (int)(ready_ms - millis());
+    return left > 0 ? (unsigned int)left : 0;
+}
@@ -4,6 +4,9 @@
 // DHT11传感器引脚定义
 #define DHT_PIN 13
 
+// 上电后到第一次读取需要的稳定时间 (毫秒)
+#define DHT_SETTLE_MS 1000
+
 // 返回值定义
 #define DHT_SUCCESS         1   // 成功读取数据
 #define DHT_CHECKSUM_ERROR  0   // 校验和错误
@@ -25,5 +28,6 @@ char read_byte(void);
 unsigned char dht11_read_data(char *buff);
 unsigned char dht11_read_with_retry(DHT11_Data *data, int max_retry);
 int dht11_init(void);
+unsigned int dht11_settle_left_ms(void);
 
 #endif // DHT_H
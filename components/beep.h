@@ -16,11 +16,6 @@ void beep_off(void);
 void beep_toggle(void);
 void beep_set_state(int state);
 int beep_get_state(void);
-
-// 信号处理函数声明
-void beep_signal_handler(int signal);
-void beep_setup_signal_handlers(void);
-int beep_is_running(void);
 void beep_cleanup(void);
 
 #endif
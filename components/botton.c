@@ -1,10 +1,11 @@
 #include "botton.h"
+#include "logger.h"
 
 // 初始化按键
 void botton_init(void)
 {
     pinMode(KEY_PIN, INPUT);
-    printf("按键初始化完成 (引脚 %d)\n", KEY_PIN);
+    log_info("按键初始化完成 (引脚 %d)", KEY_PIN);
 }
 
 // 读取按键状态
@@ -0,0 +1,143 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include "cancel.h"
+#include "logger.h"
+
+// 菜单同一时间只运行一个演示，全局只有一个令牌
+static cancel_token_t g_token = { -1, 0 };
+static int g_depth = 0;            // cancel_begin嵌套层数 (由g_lock保护)
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_sfd = -1;
+static pthread_t g_thread;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 没有正在进行的操作：恢复默认处理后在本线程重新发出信号，与未屏蔽时一样结束程序
+static void terminate_by(int sig)
+{
+    sigset_t set;
+
+    signal(sig, SIG_DFL);
+    sigemptyset(&set);
+    sigaddset(&set, sig);
+    pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+    raise(sig);
+}
+
+static void *signal_thread(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        struct signalfd_siginfo info;
+        if (read(g_sfd, &info, sizeof(info)) != sizeof(info)) {
+            if (errno == EINTR) continue;
+            return NULL;
+        }
+
+        pthread_mutex_lock(&g_lock);
+        int active = g_depth > 0;
+        if (active) cancel_request(&g_token);
+        pthread_mutex_unlock(&g_lock);
+
+        if (active) {
+            log_info("接收到信号 %d，停止当前操作，返回主菜单...", (int)info.ssi_signo);
+        } else {
+            log_info("接收到信号 %d，退出程序", (int)info.ssi_signo);
+            log_flush(); // 按信号的默认动作结束进程，不会执行atexit中的log_stop
+            fflush(stdout);
+            terminate_by((int)info.ssi_signo);
+        }
+    }
+}
+
+int cancel_init(void)
+{
+    sigset_t set;
+
+    if (g_sfd >= 0) return 0;
+
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    g_sfd = signalfd(-1, &set, SFD_CLOEXEC);
+    g_token.efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (g_sfd < 0 || g_token.efd < 0) {
+        log_error("取消处理初始化失败");
+        return -1;
+    }
+    if (pthread_create(&g_thread, NULL, signal_thread, NULL) != 0) {
+        log_error("信号线程创建失败");
+        return -1;
+    }
+    pthread_detach(g_thread);
+    return 0;
+}
+
+cancel_token_t *cancel_begin(void)
+{
+    pthread_mutex_lock(&g_lock);
+    if (g_depth++ == 0) {
+        uint64_t value;
+        __atomic_store_n(&g_token.cancelled, 0, __ATOMIC_RELEASE);
+        if (g_token.efd >= 0 && read(g_token.efd, &value, sizeof(value)) < 0) {
+            // 没有残留的取消通知
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return &g_token;
+}
+
+void cancel_end(cancel_token_t *token)
+{
+    (void)token;
+    pthread_mutex_lock(&g_lock);
+    if (g_depth > 0) g_depth--;
+    pthread_mutex_unlock(&g_lock);
+}
+
+void cancel_request(cancel_token_t *token)
+{
+    uint64_t one = 1;
+
+    if (__atomic_exchange_n(&token->cancelled, 1, __ATOMIC_ACQ_REL)) return;
+    if (token->efd >= 0 && write(token->efd, &one, sizeof(one)) < 0) {
+        // 计数已满时仍然可读
+    }
+}
+
+int cancel_requested(cancel_token_t *token)
+{
+    return __atomic_load_n(&token->cancelled, __ATOMIC_ACQUIRE);
+}
+
+int cancel_sleep_ms(cancel_token_t *token, unsigned int ms)
+{
+    uint64_t deadline = now_ns() + (uint64_t)ms * 1000000ULL;
+    struct pollfd pfd = { token->efd, POLLIN, 0 };
+
+    // efd为-1时poll忽略该项，只按超时睡眠
+    for (;;) {
+        if (cancel_requested(token)) return -1;
+        uint64_t now = now_ns();
+        if (now >= deadline) return 0;
+        uint64_t left = deadline - now;
+        struct timespec timeout = { left / 1000000000ULL, left % 1000000000ULL };
+        ppoll(&pfd, 1, &timeout, NULL);
+    }
+}
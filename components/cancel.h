@@ -0,0 +1,31 @@
+#ifndef CANCEL_H
+#define CANCEL_H
+
+// 统一的取消处理 (主程序菜单中的演示循环)
+// cancel_init() 在主线程屏蔽SIGINT/SIGTERM，由一个后台线程通过signalfd读取信号，
+// 不再由各组件各自安装信号处理函数 (互相覆盖，且在处理函数中调用printf并不安全)。
+// 演示循环用 cancel_begin() 取得当前操作的取消令牌，等待用 cancel_sleep_ms()：
+// 收到信号时令牌上的eventfd变为可读，正在进行的等待立即返回，不必等到下一次sleep(1)结束。
+// 没有正在进行的操作时 (如停在菜单)，信号按默认方式结束程序。
+
+typedef struct {
+    int efd;                       // 取消时可读的eventfd (未调用cancel_init时为-1，等待退化为普通睡眠)
+    int cancelled;                 // 已请求取消 (原子读写)
+} cancel_token_t;
+
+// 屏蔽SIGINT/SIGTERM并启动信号线程，需在创建其他线程之前调用
+int cancel_init(void);
+
+// 开始一个可取消的操作，返回其令牌 (嵌套调用返回同一个令牌，最外层开始时清除取消状态)
+cancel_token_t *cancel_begin(void);
+// 结束操作，与cancel_begin成对调用
+void cancel_end(cancel_token_t *token);
+
+// 请求取消 (可在任意线程调用)
+void cancel_request(cancel_token_t *token);
+int cancel_requested(cancel_token_t *token);
+
+// 睡眠ms毫秒，期间被取消则提前返回-1，否则返回0
+int cancel_sleep_ms(cancel_token_t *token, unsigned int ms);
+
+#endif // CANCEL_H
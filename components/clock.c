@@ -1,49 +1,19 @@
 #include "clock.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
 
-// 静态变量
-static volatile int clock_signal_received = 0;
-static volatile int clock_running = 1;
-
-// 信号处理函数
-void clock_signal_handler(int signal)
-{
-    clock_signal_received = signal;
-    printf("\n时钟组件接收到信号 %d\n", signal);
-
-    switch (signal)
-    {
-    case SIGINT: // Ctrl+C - 设置停止标志
-        printf("时钟组件: 接收到退出信号，准备返回主菜单...\n");
-        clock_running = 0;
-        break;
-    default:
-        printf("时钟组件: 未处理的信号 %d\n", signal);
-        break;
-    }
-}
-
-// 设置信号处理器
-void clock_setup_signal_handlers(void)
-{
-    signal(SIGINT, clock_signal_handler);
-    printf("时钟信号处理器设置完成 (仅SIGINT)\n");
-}
+// 当前显示的4位段码 (打包为一个32位值，其他线程可无锁读取)
+static uint32_t g_display_segments = 0;
 
 // 清理函数
 void clock_cleanup(void)
 {
-    printf("时钟组件清理中...\n");
+    log_debug("时钟组件清理中...");
     // 清空显示
     char blank[4] = {0x00, 0x00, 0x00, 0x00}; // 全部清空
     data_display(blank);
-    clock_running = 0; // 重置运行状态以便下次使用
-    printf("时钟组件清理完成\n");
-}
-
-// 获取运行状态
-int clock_is_running(void)
-{
-    return clock_running;
+    log_info("时钟组件清理完成");
 }
 
 char segdata[] = {
@@ -119,6 +89,7 @@ void write_bit(char bit)
 void write_byte(char data)
 {
     char i = 0;
+    TRACE_BEGIN("gpio", "write_byte");
     for (i = 0; i < 8; i++)
     {
         write_bit((data >> i) & 0x01);
@@ -133,6 +104,7 @@ void write_byte(char data)
     while (digitalRead(DIO))
         ;
     pinMode(DIO, OUTPUT);
+    TRACE_END("gpio", "write_byte");
 }
 
 void write_command(char cmd)
@@ -196,9 +168,18 @@ void num_display(int h_shi, int h_ge, int m_shi, int m_ge)
     data_display(time_data);
 }
 
+static metric_t m_write_seconds = METRIC_HISTOGRAM("rpi_display_write_duration_seconds", NULL,
+                                                   "TM1637数码管一次写入4位段码的用时", METRICS_BUCKETS_MS);
+
 // 基础显示函数 - 直接显示4个字节的段码数据
 void data_display(char *data)
 {
+    uint64_t start = metrics_now_ns();
+    TRACE_BEGIN("gpio", "data_display");
+    uint32_t packed = (uint32_t)(unsigned char)data[0] | ((uint32_t)(unsigned char)data[1] << 8) |
+                      ((uint32_t)(unsigned char)data[2] << 16) | ((uint32_t)(unsigned char)data[3] << 24);
+    __atomic_store_n(&g_display_segments, packed, __ATOMIC_RELAXED);
+
     write_command(0x40);       // 设置数据命令
     write_command(0x44);       // 设置显示模式
     write_data(0xc0, data[0]); // 位置0
@@ -206,6 +187,8 @@ void data_display(char *data)
     write_data(0xc2, data[2]); // 位置2
     write_data(0xc3, data[3]); // 位置3
     write_command(0x88);       // 开启显示，最大亮度
+    metric_observe_since(&m_write_seconds, start);
+    TRACE_END("gpio", "data_display");
 }
 
 // 文本显示函数 - 将ASCII文本转换后显示
@@ -251,20 +234,30 @@ void roll_display(char *input_data, int len)
 
     // 滚动显示
     int i = 0;
-    clock_running = 1; // 重置运行标志
-    while (clock_running)
+    cancel_token_t *cancel = cancel_begin();
+    do
     {
         data_display(temp + i);
 
         i = (i + 1) % (len + 4); // 使用模运算简化循环逻辑
-        sleep(1);
-    }
+    } while (cancel_sleep_ms(cancel, 1000) == 0);
+    cancel_end(cancel);
 
     // 退出时清理显示
     clock_cleanup();
     free(temp);
 }
 
+// 获取当前显示的段码 (segments[0]为最左一位)
+void clock_get_display(unsigned char segments[4])
+{
+    uint32_t packed = __atomic_load_n(&g_display_segments, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < 4; i++) {
+        segments[i] = (unsigned char)(packed >> (8 * i));
+    }
+}
+
 void tm1637_init()
 {
     // 不再重复初始化wiringPi，因为web_main.c中已经初始化过了
@@ -278,13 +271,13 @@ void tm1637_init()
     pinMode(CLK, OUTPUT);
     pinMode(DIO, OUTPUT);
 
-    printf("时钟组件初始化完成 (引脚 CLK:%d DIO:%d)\n", CLK, DIO);
+    log_info("时钟组件初始化完成 (引脚 CLK:%d DIO:%d)", CLK, DIO);
 }
 
 void clock_display()
 {
-    clock_running = 1; // 重置运行标志
-    while (clock_running)
+    cancel_token_t *cancel = cancel_begin();
+    do
     {
         time_t rawtime;
         struct tm *timeinfo;
@@ -299,10 +292,10 @@ void clock_display()
         int m_shi = timeinfo->tm_min / 10;
         int m_ge = timeinfo->tm_min % 10;
 
-        printf("显示时间: %02d:%02d\n", timeinfo->tm_hour, timeinfo->tm_min);
+        log_debug("显示时间: %02d:%02d", timeinfo->tm_hour, timeinfo->tm_min);
         num_display(h_shi, h_ge, m_shi, m_ge);
-        sleep(1); // 改为1秒更新一次，更容易响应信号
-    }
+    } while (cancel_sleep_ms(cancel, 1000) == 0); // 1秒更新一次，取消时立即返回
+    cancel_end(cancel);
     
     // 退出时清理显示
     clock_cleanup();
@@ -6,8 +6,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <signal.h>
 #include <time.h>
+#include <stdint.h>
+#include "cancel.h"
 
 // 引脚定义
 #define DIO 22
@@ -29,11 +30,7 @@ void data_display(char *data);
 void text_display(char *text);
 void roll_display(char *data, int len);
 void clock_display();
-
-// 信号处理函数声明
-void clock_signal_handler(int signal);
-void clock_setup_signal_handlers(void);
+void clock_get_display(unsigned char segments[4]); // 当前显示的段码 (可在任意线程调用)
 void clock_cleanup(void);
-int clock_is_running(void);
 
 #endif // CLOCK_H
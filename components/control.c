@@ -1,69 +1,100 @@
+#include <pthread.h>
 #include "control.h"
+#include "motion_exec.h"
+#include "seqlock.h"
+#include "speed_ctrl.h"
+#include "startup.h"
+#include "logger.h"
+#include "trace.h"
 
-// 全局运动状态
-static motion_state_t g_motion_state = {0, 0, MOTION_STOP, 0};
+// 全局运动状态：写者经g_state_writer串行后用seqlock发布，读者无锁读取快照
+static motion_state_t g_motion_state = {0, 0, MOTION_STOP, 0, 0, 0, 0};
+static seqlock_t g_state_lock = SEQLOCK_INIT;
+static pthread_mutex_t g_state_writer = PTHREAD_MUTEX_INITIALIZER;
 
-//初始化树莓派，初始化GPIO模式为OUTPUT，初始化软件PWM，初始化R，L的GPIO低电平和初始化软件PWM值为0
-void init_wheel(){
-    // 设置GPIO模式
-    pinMode(WHEEL_L, OUTPUT);
-    pinMode(WHEEL_R, OUTPUT);
+// 限制轮速范围
+static int clamp_wheel_speed(int speed)
+{
+    if (speed < -MAX_SPEED) return -MAX_SPEED;
+    if (speed > MAX_SPEED) return MAX_SPEED;
+    return speed;
+}
+
+// 按绝对值增减一级速度，方向不变 (减到0为止，不反向)
+static int step_wheel_speed(int speed, int step)
+{
+    int magnitude = abs(speed) + step;
+    if (magnitude < 0) magnitude = 0;
+    if (magnitude > MAX_SPEED) magnitude = MAX_SPEED;
+    return speed < 0 ? -magnitude : magnitude;
+}
 
-    // 创建软件PWM
-    softPwmCreate(WHEEL_L, 0, 100);
-    softPwmCreate(WHEEL_R, 0, 100);
+// 写入轮速：闭环模式下作为速度控制循环的目标，否则直接写入占空比
+static void write_wheel_speeds(int left_speed, int right_speed)
+{
+    if (speed_ctrl_closed_loop()) {
+        speed_ctrl_set_target(left_speed, right_speed);
+    } else {
+        motor_set_duty(left_speed, right_speed);
+    }
+}
 
-    // 初始设置
-    digitalWrite(WHEEL_R, LOW);
-    digitalWrite(WHEEL_L, LOW);
-    softPwmWrite(WHEEL_L, 0);
-    softPwmWrite(WHEEL_R, 0);
+// 发布新的运动状态，motion为NULL时保持当前运动类型
+static void publish_motion_state(int left_speed, int right_speed, const motion_type_t *motion)
+{
+    motion_state_t next;
+
+    pthread_mutex_lock(&g_state_writer);
+    next = g_motion_state; // 只有持有写锁的线程会修改，这里可以直接读取
+    next.left_speed = left_speed;
+    next.right_speed = right_speed;
+    if (motion != NULL) {
+        next.current_motion = *motion;
+        next.is_moving = (*motion != MOTION_STOP);
+    }
+    next.seq++;
+    next.timestamp_ns = motion_now_ns();
+    seqlock_write(&g_state_lock, &g_motion_state, &next, sizeof(next));
+    pthread_mutex_unlock(&g_state_writer);
+}
+
+// 电机引脚映射
+static motor_pinmap_t g_pinmap = CONTROL_PINMAP;
+
+//初始化电机驱动 (GPIO模式、软件PWM和初始低电平由motor模块按引脚映射设置)
+void init_wheel(){
+    motion_type_t stop = MOTION_STOP;
+    
+    motor_init(&g_pinmap);
     
     // 初始化状态
-    g_motion_state.left_speed = 0;
-    g_motion_state.right_speed = 0;
-    g_motion_state.current_motion = MOTION_STOP;
-    g_motion_state.is_moving = 0;
+    publish_motion_state(0, 0, &stop);
     
-    printf("轮子控制模块初始化完成 (左轮GPIO:%d 右轮GPIO:%d)\n", WHEEL_L, WHEEL_R);
+    log_info("轮子控制模块初始化完成 (左轮GPIO:%d 右轮GPIO:%d)", g_pinmap.left_fwd, g_pinmap.right_fwd);
 }
 
 //清理GPIO设置
 void clean_wheel(){
     control_stop(); // 先停止运动
-    digitalWrite(WHEEL_L, LOW);
-    digitalWrite(WHEEL_R, LOW);
-    pinMode(WHEEL_L, INPUT);
-    pinMode(WHEEL_R, INPUT);
+    motor_cleanup();
     
-    printf("轮子控制模块清理完成\n");
+    log_info("轮子控制模块清理完成");
 }
 
-//加速
+//加速 (两轮按斜坡加速到最大速度，立即返回)
 void ac(char cmd[10]){
     // 移除换行符
     cmd[strcspn(cmd, "\n")] = 0;
     if (strcmp(cmd, "ac") == 0) {
-        digitalWrite(WHEEL_R, LOW);
-        softPwmWrite(WHEEL_L, 0);
-            
-        for (int dc = 0; dc <= 100; dc += 5) {
-            softPwmWrite(WHEEL_L, dc);
-            delay(1000);
-        }
+        motion_exec_ramp(MOTION_ACCELERATE, MAX_SPEED, MAX_SPEED);
     }
 }
 
-//减速
+//减速 (两轮按斜坡减速到停止，立即返回)
 void dc(char cmd[10]){
+    cmd[strcspn(cmd, "\n")] = 0;
     if (strcmp(cmd, "dc") == 0) {
-        digitalWrite(WHEEL_R, LOW);
-        softPwmWrite(WHEEL_L, 100);
-
-        for (int dc = 100; dc >= 0; dc -= 5) {
-            softPwmWrite(WHEEL_L, dc);
-            delay(1000);
-        }
+        motion_exec_ramp(MOTION_DECELERATE, 0, 0);
     }
 }
 
@@ -78,7 +109,7 @@ void p(char cmd[10]){
 void turn_left(char cmd[10]){
     cmd[strcspn(cmd, "\n")] = 0; // 移除换行符
     if (strcmp(cmd, "tl") == 0) {
-        printf("执行左转动作\n");
+        log_debug("执行左转动作");
         control_turn_left(TURN_SPEED, TURN_DURATION);
     }
 }
@@ -87,7 +118,7 @@ void turn_left(char cmd[10]){
 void turn_right(char cmd[10]){
     cmd[strcspn(cmd, "\n")] = 0; // 移除换行符
     if (strcmp(cmd, "tr") == 0) {
-        printf("执行右转动作\n");
+        log_debug("执行右转动作");
         control_turn_right(TURN_SPEED, TURN_DURATION);
     }
 }
@@ -96,7 +127,7 @@ void turn_right(char cmd[10]){
 void move_forward(char cmd[10]){
     cmd[strcspn(cmd, "\n")] = 0; // 移除换行符
     if (strcmp(cmd, "fw") == 0) {
-        printf("执行前进动作\n");
+        log_debug("执行前进动作");
         control_move_forward(TURN_SPEED);
     }
 }
@@ -105,7 +136,7 @@ void move_forward(char cmd[10]){
 void move_backward(char cmd[10]){
     cmd[strcspn(cmd, "\n")] = 0; // 移除换行符
     if (strcmp(cmd, "bw") == 0) {
-        printf("执行后退动作\n");
+        log_debug("执行后退动作");
         control_move_backward(TURN_SPEED);
     }
 }
@@ -116,14 +147,8 @@ void control_turn_left(int speed, int duration) {
     if (speed > MAX_SPEED) speed = MAX_SPEED;
     
     // 左转：左轮慢，右轮快 (或左轮停，右轮转)
-    set_wheel_speeds(0, speed);
-    g_motion_state.current_motion = MOTION_LEFT;
-    g_motion_state.is_moving = 1;
-    
-    if (duration > 0) {
-        delay(duration);
-        control_stop();
-    }
+    // 持续时间由运动执行线程按截止时间计时，到期后自动停车
+    motion_exec_submit(MOTION_LEFT, 0, speed, duration);
 }
 
 // Web API兼容函数：右转
@@ -132,14 +157,7 @@ void control_turn_right(int speed, int duration) {
     if (speed > MAX_SPEED) speed = MAX_SPEED;
     
     // 右转：右轮慢，左轮快 (或右轮停，左轮转)
-    set_wheel_speeds(speed, 0);
-    g_motion_state.current_motion = MOTION_RIGHT;
-    g_motion_state.is_moving = 1;
-    
-    if (duration > 0) {
-        delay(duration);
-        control_stop();
-    }
+    motion_exec_submit(MOTION_RIGHT, speed, 0, duration);
 }
 
 // Web API兼容函数：前进
@@ -148,9 +166,7 @@ void control_move_forward(int speed) {
     if (speed > MAX_SPEED) speed = MAX_SPEED;
     
     // 前进：两轮同速
-    set_wheel_speeds(speed, speed);
-    g_motion_state.current_motion = MOTION_FORWARD;
-    g_motion_state.is_moving = 1;
+    motion_exec_submit(MOTION_FORWARD, speed, speed, 0);
 }
 
 // Web API兼容函数：后退
@@ -159,53 +175,69 @@ void control_move_backward(int speed) {
     if (speed > MAX_SPEED) speed = MAX_SPEED;
     
     // 后退：两轮反向同速 (这里简化为负速度，实际实现可能需要更改方向引脚)
-    set_wheel_speeds(-speed, -speed);
-    g_motion_state.current_motion = MOTION_BACKWARD;
-    g_motion_state.is_moving = 1;
+    motion_exec_submit(MOTION_BACKWARD, -speed, -speed, 0);
 }
 
-// Web API兼容函数：停止
+// Web API兼容函数：停止 (紧急停止，清空命令队列并立即停车)
 void control_stop(void) {
-    set_wheel_speeds(0, 0);
-    g_motion_state.current_motion = MOTION_STOP;
-    g_motion_state.is_moving = 0;
+    motion_exec_emergency_stop();
 }
 
-// 设置轮子速度
-void set_wheel_speeds(int left_speed, int right_speed) {
-    // 限制速度范围
-    if (left_speed < -MAX_SPEED) left_speed = -MAX_SPEED;
-    if (left_speed > MAX_SPEED) left_speed = MAX_SPEED;
-    if (right_speed < -MAX_SPEED) right_speed = -MAX_SPEED;
-    if (right_speed > MAX_SPEED) right_speed = MAX_SPEED;
+// 差速驱动：v为线速度，omega为角速度 (正数左转)，经运动执行线程一次写入两轮
+void control_drive(int v, int omega) {
+    int left, right;
+    motion_type_t motion;
     
-    // 处理负速度 (后退)
-    if (left_speed < 0) {
-        // 后退逻辑 - 这里需要根据实际硬件连接调整
-        digitalWrite(WHEEL_L, HIGH); // 反向
-        softPwmWrite(WHEEL_L, -left_speed);
-    } else {
-        digitalWrite(WHEEL_L, LOW);  // 正向
-        softPwmWrite(WHEEL_L, left_speed);
-    }
+    motor_drive_to_duty(v, omega, &left, &right);
     
-    if (right_speed < 0) {
-        // 后退逻辑 - 这里需要根据实际硬件连接调整
-        digitalWrite(WHEEL_R, HIGH); // 反向
-        softPwmWrite(WHEEL_R, -right_speed);
+    if (left == 0 && right == 0) {
+        motion = MOTION_STOP;
+    } else if (omega > 0) {
+        motion = MOTION_LEFT;
+    } else if (omega < 0) {
+        motion = MOTION_RIGHT;
     } else {
-        digitalWrite(WHEEL_R, LOW);  // 正向
-        softPwmWrite(WHEEL_R, right_speed);
+        motion = v > 0 ? MOTION_FORWARD : MOTION_BACKWARD;
     }
     
+    motion_exec_submit(motion, left, right, 0);
+}
+
+// 应用运动命令：写入PWM并更新运动状态 (由运动执行线程调用)
+void control_apply(motion_type_t motion, int left_speed, int right_speed) {
+    TRACE_BEGIN("motion", "control_apply");
+    // 限制速度范围
+    left_speed = clamp_wheel_speed(left_speed);
+    right_speed = clamp_wheel_speed(right_speed);
+    
+    write_wheel_speeds(left_speed, right_speed);
+    
+    // 轮速和运动类型作为一个快照发布
+    publish_motion_state(left_speed, right_speed, &motion);
+    TRACE_END("motion", "control_apply");
+    startup_first_command();
+}
+
+// 设置轮子速度 (负数为后退)
+void set_wheel_speeds(int left_speed, int right_speed) {
+    TRACE_BEGIN("motion", "set_wheel_speeds");
+    // 限制速度范围
+    left_speed = clamp_wheel_speed(left_speed);
+    right_speed = clamp_wheel_speed(right_speed);
+    
+    // 两轮占空比由电机驱动一次批量写入 (闭环时交给速度控制循环)
+    write_wheel_speeds(left_speed, right_speed);
+    
     // 更新状态
-    g_motion_state.left_speed = left_speed;
-    g_motion_state.right_speed = right_speed;
+    publish_motion_state(left_speed, right_speed, NULL);
+    TRACE_END("motion", "set_wheel_speeds");
 }
 
-// 获取运动状态
+// 获取运动状态快照 (不加锁，不会阻塞写者)
 motion_state_t get_motion_state(void) {
-    return g_motion_state;
+    motion_state_t state;
+    seqlock_read(&g_state_lock, &state, &g_motion_state, sizeof(state));
+    return state;
 }
 
 // 通用运动控制
@@ -227,30 +259,53 @@ void control_motion(motion_type_t motion, int speed, int duration) {
             control_stop();
             break;
         case MOTION_ACCELERATE:
-            // 加速当前运动
-            if (g_motion_state.is_moving) {
-                int new_speed = g_motion_state.left_speed + STEP_SIZE;
-                if (new_speed > MAX_SPEED) new_speed = MAX_SPEED;
-                set_wheel_speeds(new_speed, new_speed);
-            }
-            break;
-        case MOTION_DECELERATE:
-            // 减速当前运动
-            if (g_motion_state.is_moving) {
-                int new_speed = g_motion_state.left_speed - STEP_SIZE;
-                if (new_speed < 0) new_speed = 0;
-                set_wheel_speeds(new_speed, new_speed);
+        case MOTION_DECELERATE: {
+            // 加速/减速当前运动：在斜坡目标 (没有斜坡时为当前轮速) 上两轮增减一级 (STEP_SIZE)，保持方向
+            // 以目标为基准，斜坡进行中连续按键可以累加；停止 (或正减速到停止) 时不动作
+            int left, right;
+            if (!motion_exec_ramp_target(&left, &right)) {
+                motion_state_t state = get_motion_state();
+                left = state.left_speed;
+                right = state.right_speed;
             }
+            if (left == 0 && right == 0) break;
+            int step = (motion == MOTION_ACCELERATE) ? STEP_SIZE : -STEP_SIZE;
+            motion_exec_ramp(motion, step_wheel_speed(left, step), step_wheel_speed(right, step));
             break;
+        }
     }
 }
 
 // 初始化控制模块
 void control_init(void) {
     init_wheel();
+    motion_exec_start();
+}
+
+// 使用指定引脚映射初始化控制模块 (如H桥接线)
+void control_init_pinmap(const motor_pinmap_t *map) {
+    if (map != NULL) {
+        g_pinmap = *map;
+    }
+    control_init();
+}
+
+// 开启编码器闭环速度控制 (可选，需要安装轮速编码器)
+int control_enable_closed_loop(const speed_ctrl_config_t *config) {
+    if (encoder_init(ENC_L_PIN, ENC_R_PIN) != 0) {
+        return -1;
+    }
+    if (speed_ctrl_start(config) != 0) {
+        return -1;
+    }
+    speed_ctrl_set_closed_loop(1);
+    log_info("闭环速度控制已开启");
+    return 0;
 }
 
 // 清理控制模块
 void control_cleanup(void) {
+    motion_exec_stop();
+    speed_ctrl_stop();
     clean_wheel();
 }
@@ -6,17 +6,23 @@
 #include <stdlib.h>
 #include <string.h>
 #include <softPwm.h>
+#include <stdint.h>
+#include "motor.h"
+#include "speed_ctrl.h"
 
 // 引脚定义
 #define WHEEL_L 23  // 左轮引脚
 #define WHEEL_R 24  // 右轮引脚
 
+// 默认接线：每轮一个PWM引脚 (不支持反转)，H桥接线使用MOTOR_PINMAP_HBRIDGE
+#define CONTROL_PINMAP { WHEEL_L, MOTOR_PIN_NONE, WHEEL_R, MOTOR_PIN_NONE, MOTOR_PWM_RANGE, 0, 0 }
+
 // 运动参数
 #define MAX_SPEED 100
 #define MIN_SPEED 0
 #define STEP_SIZE 5
 #define TURN_SPEED 60
-#define TURN_DURATION 1000  // 转向持续时间(毫秒)
+#define TURN_DURATION 1000  // 转向持续时间(毫秒)，由运动执行线程计时
 
 // 运动方向枚举
 typedef enum {
@@ -29,12 +35,15 @@ typedef enum {
     MOTION_DECELERATE
 } motion_type_t;
 
-// 运动状态结构
+// 运动状态结构 (通过seqlock发布快照，大小需为4字节的倍数)
 typedef struct {
     int left_speed;
     int right_speed;
     motion_type_t current_motion;
     int is_moving;
+    uint32_t seq;          // 状态序号，每次更新加1
+    uint32_t reserved;
+    uint64_t timestamp_ns; // 更新时间 (CLOCK_MONOTONIC)
 } motion_state_t;
 
 // 函数声明
@@ -42,8 +51,8 @@ void init_wheel(void);
 void clean_wheel(void);
 
 // 基础运动控制
-void ac(char cmd[10]);                    // 加速 (原有)
-void dc(char cmd[10]);                    // 减速 (原有)
+void ac(char cmd[10]);                    // 加速 (斜坡，立即返回)
+void dc(char cmd[10]);                    // 减速 (斜坡，立即返回)
 void p(char cmd[10]);                     // 停止 (原有)
 
 // 新增转向控制
@@ -52,20 +61,24 @@ void turn_right(char cmd[10]);            // 右转
 void move_forward(char cmd[10]);          // 前进
 void move_backward(char cmd[10]);         // 后退
 
-// Web API兼容函数
+// Web API兼容函数 (立即返回，命令交由运动执行线程按时序执行)
 void control_motion(motion_type_t motion, int speed, int duration);
 void control_turn_left(int speed, int duration);
 void control_turn_right(int speed, int duration);
 void control_move_forward(int speed);
 void control_move_backward(int speed);
 void control_stop(void);
+void control_drive(int v, int omega);     // 差速驱动 (线速度, 角速度)
 
-// 状态查询
+// 状态查询 (无锁读取一致快照，可在任意线程调用)
 motion_state_t get_motion_state(void);
 void set_wheel_speeds(int left_speed, int right_speed);
+void control_apply(motion_type_t motion, int left_speed, int right_speed);
 
 // 初始化和清理
 void control_init(void);
+void control_init_pinmap(const motor_pinmap_t *map);
+int control_enable_closed_loop(const speed_ctrl_config_t *config);
 void control_cleanup(void);
 
 #endif // CONTROL_H
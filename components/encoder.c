@@ -0,0 +1,38 @@
+#include "encoder.h"
+#include "logger.h"
+
+// 边沿计数 (中断线程中原子递增)
+static unsigned long g_edges[2] = {0, 0};
+
+static void encoder_left_isr(void)
+{
+    __atomic_fetch_add(&g_edges[0], 1, __ATOMIC_RELAXED);
+}
+
+static void encoder_right_isr(void)
+{
+    __atomic_fetch_add(&g_edges[1], 1, __ATOMIC_RELAXED);
+}
+
+// 初始化编码器：双边沿中断计数
+int encoder_init(int left_pin, int right_pin)
+{
+    pinMode(left_pin, INPUT);
+    pinMode(right_pin, INPUT);
+
+    if (wiringPiISR(left_pin, INT_EDGE_BOTH, encoder_left_isr) < 0 ||
+        wiringPiISR(right_pin, INT_EDGE_BOTH, encoder_right_isr) < 0) {
+        log_error("编码器中断注册失败");
+        return -1;
+    }
+
+    log_info("编码器初始化完成 (左轮GPIO:%d 右轮GPIO:%d)", left_pin, right_pin);
+    return 0;
+}
+
+// 读取累计边沿数 (单相编码器不区分方向)
+void encoder_read(unsigned long *left, unsigned long *right)
+{
+    *left = __atomic_load_n(&g_edges[0], __ATOMIC_RELAXED);
+    *right = __atomic_load_n(&g_edges[1], __ATOMIC_RELAXED);
+}
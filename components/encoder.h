@@ -0,0 +1,18 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <wiringPi.h>
+#include <stdio.h>
+
+// 编码器引脚定义 (单相光电/霍尔编码器)
+#define ENC_L_PIN 5   // 左轮编码器
+#define ENC_R_PIN 6   // 右轮编码器
+
+// 20槽码盘，上升沿和下降沿都计数
+#define ENCODER_EDGES_PER_REV 40
+
+// 函数声明
+int encoder_init(int left_pin, int right_pin);
+void encoder_read(unsigned long *left, unsigned long *right);
+
+#endif // ENCODER_H
@@ -0,0 +1,538 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include "logger.h"
+
+// 参数类型 (调用点解析格式串得到)
+#define LOG_ARG_INT     0
+#define LOG_ARG_LONG    1
+#define LOG_ARG_LLONG   2
+#define LOG_ARG_SIZE    3
+#define LOG_ARG_DOUBLE  4
+#define LOG_ARG_STR     5
+#define LOG_ARG_PTR     6
+
+#define LOG_LINE_MAX    256
+
+typedef struct {
+    uint64_t t_ns;
+    union {
+        log_site_t *site;
+        uint64_t site_pad;         // 32位系统上也保持64字节
+    };
+    unsigned char payload[LOG_PAYLOAD_SIZE];
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == 64, "日志记录大小");
+
+// 每个线程一个单生产者单消费者环形缓冲区：线程是唯一写tail的一方，输出线程是唯一写head的一方
+typedef struct log_ring {
+    uint32_t tail __attribute__((aligned(64)));
+    unsigned long dropped;         // 原子读写
+    uint32_t head __attribute__((aligned(64)));
+    uint32_t snap;                 // 本轮输出到的位置 (只有输出方使用)
+    int in_use;                    // 属于一个存活的线程 (原子读写)
+    struct log_ring *next;
+    log_record_t records[LOG_RING_SIZE] __attribute__((aligned(64)));
+} log_ring_t;
+
+int g_log_level = LOG_LEVEL_INFO;
+
+static log_ring_t *g_rings = NULL; // 只增加，新缓冲区插在表头 (原子读写)
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;        // 分配缓冲区、解析调用点
+static pthread_mutex_t g_drain_lock = PTHREAD_MUTEX_INITIALIZER;  // 输出 (后台线程和log_flush)
+static pthread_key_t g_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static __thread log_ring_t *t_ring = NULL;
+
+static pthread_t g_thread;
+static int g_running = 0;          // 后台线程在运行 (原子读写)
+static FILE *g_out = NULL;
+static uint64_t g_start_ns = 0;
+static unsigned long g_records = 0;
+static unsigned long g_dropped_reported = 0;
+static int g_threads = 0;
+static int g_atexit = 0;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static FILE *out_file(void)
+{
+    return g_out != NULL ? g_out : stdout;
+}
+
+// ---------------- 调用点解析 ----------------
+
+// 跳过一个转换说明 (p指向'%'之后)，返回转换字符，不支持的写法返回0
+static char skip_conversion(const char **pp, int *length)
+{
+    const char *p = *pp;
+
+    *length = 0;
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') p++;
+    if (*p == '*') return 0;
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') return 0;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    while (*p == 'h') p++;
+    if (*p == 'l') {
+        p++;
+        *length = 1;
+        if (*p == 'l') {
+            p++;
+            *length = 2;
+        }
+    } else if (*p == 'z') {
+        p++;
+        *length = 3;
+    }
+    if (*p == '\0') return 0;
+    *pp = p + 1;
+    return *p;
+}
+
+static void parse_site(log_site_t *site)
+{
+    const char *p = site->fmt;
+    int nargs = 0, fixed = 0, sync = 0;
+
+    while (*p != '\0' && !sync) {
+        if (*p++ != '%') continue;
+        if (*p == '%') {
+            p++;
+            continue;
+        }
+
+        int length;
+        int type;
+        switch (skip_conversion(&p, &length)) {
+            case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+                type = length == 1 ? LOG_ARG_LONG : length == 2 ? LOG_ARG_LLONG :
+                       length == 3 ? LOG_ARG_SIZE : LOG_ARG_INT;
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+                type = LOG_ARG_DOUBLE;
+                break;
+            case 's':
+                type = LOG_ARG_STR;
+                break;
+            case 'p':
+                type = LOG_ARG_PTR;
+                break;
+            default:
+                type = -1;
+                break;
+        }
+        if (type < 0 || nargs == LOG_MAX_ARGS) {
+            sync = 1;
+            break;
+        }
+        site->types[nargs++] = (uint8_t)type;
+        fixed += type == LOG_ARG_STR ? 1 : 8;
+    }
+
+    site->fixed = fixed;
+    site->sync = sync;
+    __atomic_store_n(&site->nargs, nargs, __ATOMIC_RELEASE);
+}
+
+static void prepare_site(log_site_t *site)
+{
+    pthread_mutex_lock(&g_lock);
+    if (site->nargs < 0) parse_site(site);
+    pthread_mutex_unlock(&g_lock);
+}
+
+// ---------------- 记录 ----------------
+
+static void put_u64(unsigned char **p, uint64_t v)
+{
+    memcpy(*p, &v, sizeof(v));
+    *p += sizeof(v);
+}
+
+static uint64_t get_u64(const unsigned char **p)
+{
+    uint64_t v;
+    memcpy(&v, *p, sizeof(v));
+    *p += sizeof(v);
+    return v;
+}
+
+// 按调用点的参数类型把可变参数写入记录；字符串在留出其余参数的空间后截断 (不截断在UTF-8字符中间)
+static void pack_args(const log_site_t *site, unsigned char *payload, va_list ap)
+{
+    unsigned char *p = payload;
+    int reserved = site->fixed;    // 尚未写入的参数至少需要的字节数
+
+    for (int i = 0; i < site->nargs; i++) {
+        switch (site->types[i]) {
+            case LOG_ARG_INT:    put_u64(&p, (uint64_t)(int64_t)va_arg(ap, int)); break;
+            case LOG_ARG_LONG:   put_u64(&p, (uint64_t)(int64_t)va_arg(ap, long)); break;
+            case LOG_ARG_LLONG:  put_u64(&p, (uint64_t)va_arg(ap, long long)); break;
+            case LOG_ARG_SIZE:   put_u64(&p, (uint64_t)va_arg(ap, size_t)); break;
+            case LOG_ARG_PTR:    put_u64(&p, (uint64_t)(uintptr_t)va_arg(ap, void *)); break;
+            case LOG_ARG_DOUBLE: {
+                double d = va_arg(ap, double);
+                memcpy(p, &d, sizeof(d));
+                p += sizeof(d);
+                break;
+            }
+            case LOG_ARG_STR: {
+                const char *s = va_arg(ap, const char *);
+                size_t room = LOG_PAYLOAD_SIZE - (p - payload) - reserved;
+                size_t len = s != NULL ? strlen(s) : 0;
+                if (len > room) {
+                    len = room;
+                    while (len > 0 && ((unsigned char)s[len] & 0xC0) == 0x80) len--;
+                }
+                if (len > 0) memcpy(p, s, len);
+                p[len] = '\0';
+                p += len + 1;
+                reserved -= 1;
+                continue;
+            }
+        }
+        reserved -= 8;
+    }
+}
+
+// 时间戳和级别前缀
+static int format_prefix(const log_site_t *site, uint64_t t_ns, char *buf, int size)
+{
+    uint64_t t = t_ns > g_start_ns ? t_ns - g_start_ns : 0;
+    return snprintf(buf, size, "[%4lu.%06lu] %s", (unsigned long)(t / 1000000000ULL),
+                    (unsigned long)(t % 1000000000ULL / 1000),
+                    site->level == LOG_LEVEL_WARN ? "警告: " : site->level == LOG_LEVEL_ERROR ? "错误: " : "");
+}
+
+static int format_record(const log_record_t *rec, char *buf, int size)
+{
+    const log_site_t *site = rec->site;
+    const unsigned char *arg = rec->payload;
+    const char *p = site->fmt;
+    int argi = 0;
+    int len = format_prefix(site, rec->t_ns, buf, size);
+
+    while (*p != '\0' && len < size - 1) {
+        if (*p != '%') {
+            buf[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buf[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        const char *start = p++;
+        int length;
+        char spec[24];
+        skip_conversion(&p, &length);
+        int n = (int)(p - start);
+        if (n >= (int)sizeof(spec)) n = sizeof(spec) - 1;
+        memcpy(spec, start, n);
+        spec[n] = '\0';
+
+        int room = size - len;
+        int w = 0;
+        switch (site->types[argi++]) {
+            case LOG_ARG_INT:    w = snprintf(buf + len, room, spec, (int)get_u64(&arg)); break;
+            case LOG_ARG_LONG:   w = snprintf(buf + len, room, spec, (long)get_u64(&arg)); break;
+            case LOG_ARG_LLONG:  w = snprintf(buf + len, room, spec, (long long)get_u64(&arg)); break;
+            case LOG_ARG_SIZE:   w = snprintf(buf + len, room, spec, (size_t)get_u64(&arg)); break;
+            case LOG_ARG_PTR:    w = snprintf(buf + len, room, spec, (void *)(uintptr_t)get_u64(&arg)); break;
+            case LOG_ARG_DOUBLE: {
+                double d;
+                memcpy(&d, arg, sizeof(d));
+                arg += sizeof(d);
+                w = snprintf(buf + len, room, spec, d);
+                break;
+            }
+            case LOG_ARG_STR: {
+                const char *s = (const char *)arg;
+                w = snprintf(buf + len, room, spec, s);
+                arg += strlen(s) + 1;
+                break;
+            }
+        }
+        len += w < room ? w : room - 1;
+    }
+
+    // 格式串末尾的换行由这里统一加上
+    if (len > size - 2) len = size - 2;
+    while (len > 0 && buf[len - 1] == '\n') len--;
+    buf[len++] = '\n';
+    buf[len] = '\0';
+    return len;
+}
+
+// 在调用线程中直接输出 (未启动后台线程或格式不支持记录)
+static void emit_sync(log_site_t *site, va_list ap)
+{
+    char line[LOG_LINE_MAX];
+
+    if (g_start_ns == 0) g_start_ns = now_ns();
+    if (site->sync) {
+        int len = format_prefix(site, now_ns(), line, sizeof(line));
+        int w = vsnprintf(line + len, sizeof(line) - 1 - len, site->fmt, ap);
+        len = w < 0 ? len : len + w;
+        if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+        if (len == 0 || line[len - 1] != '\n') strcpy(line + len, "\n");
+    } else {
+        log_record_t rec;
+        rec.t_ns = now_ns();
+        rec.site = site;
+        pack_args(site, rec.payload, ap);
+        format_record(&rec, line, sizeof(line));
+    }
+    fputs(line, out_file());
+    fflush(out_file());
+}
+
+static void release_ring(void *arg)
+{
+    log_ring_t *ring = arg;
+    __atomic_store_n(&ring->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_key(void)
+{
+    pthread_key_create(&g_key, release_ring);
+}
+
+// 为当前线程分配环形缓冲区：优先复用已退出线程留下的、已输出完的缓冲区
+static log_ring_t *acquire_ring(void)
+{
+    log_ring_t *ring;
+
+    pthread_once(&g_key_once, create_key);
+    pthread_mutex_lock(&g_lock);
+    for (ring = g_rings; ring != NULL; ring = ring->next) {
+        if (!__atomic_load_n(&ring->in_use, __ATOMIC_ACQUIRE) &&
+            __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail) {
+            break;
+        }
+    }
+    if (ring == NULL) {
+        void *mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(log_ring_t)) == 0) {
+            ring = mem;
+            memset(ring, 0, sizeof(*ring));
+            ring->next = g_rings;
+            __atomic_store_n(&g_rings, ring, __ATOMIC_RELEASE);
+            g_threads++;
+        }
+    }
+    if (ring != NULL) {
+        __atomic_store_n(&ring->in_use, 1, __ATOMIC_RELEASE);
+        pthread_setspecific(g_key, ring);
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    t_ring = ring;
+    return ring;
+}
+
+void log_emit(log_site_t *site, ...)
+{
+    va_list ap;
+
+    if (__atomic_load_n(&site->nargs, __ATOMIC_ACQUIRE) < 0) prepare_site(site);
+
+    log_ring_t *ring = t_ring;
+    if (!site->sync && __atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+        if (ring == NULL) ring = acquire_ring();
+    } else {
+        ring = NULL;
+    }
+    if (ring == NULL) {
+        va_start(ap, site);
+        emit_sync(site, ap);
+        va_end(ap);
+        return;
+    }
+
+    uint32_t tail = ring->tail;
+    if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    log_record_t *rec = &ring->records[tail & (LOG_RING_SIZE - 1)];
+    rec->t_ns = now_ns();
+    rec->site = site;
+    va_start(ap, site);
+    pack_args(site, rec->payload, ap);
+    va_end(ap);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// ---------------- 输出 ----------------
+
+// 按时间戳合并各线程已写入的记录并输出 (持有g_drain_lock)
+static void drain(void)
+{
+    log_ring_t *rings = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE);
+    FILE *out = out_file();
+    unsigned long dropped = 0;
+    int written = 0;
+
+    // 只输出本轮开始时已写入的记录，生产者持续写入时也能结束
+    for (log_ring_t *r = rings; r != NULL; r = r->next) {
+        r->snap = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        dropped += __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+    }
+
+    for (;;) {
+        log_ring_t *best = NULL;
+        for (log_ring_t *r = rings; r != NULL; r = r->next) {
+            if (r->head == r->snap) continue;
+            if (best == NULL ||
+                r->records[r->head & (LOG_RING_SIZE - 1)].t_ns < best->records[best->head & (LOG_RING_SIZE - 1)].t_ns) {
+                best = r;
+            }
+        }
+        if (best == NULL) break;
+
+        char line[LOG_LINE_MAX];
+        format_record(&best->records[best->head & (LOG_RING_SIZE - 1)], line, sizeof(line));
+        __atomic_store_n(&best->head, best->head + 1, __ATOMIC_RELEASE);
+        fputs(line, out);
+        written++;
+    }
+
+    if (dropped != g_dropped_reported) {
+        fprintf(out, "[日志] 缓冲区满，丢弃 %lu 条记录\n", dropped - g_dropped_reported);
+        g_dropped_reported = dropped;
+        written++;
+    }
+    if (written > 0) {
+        __atomic_fetch_add(&g_records, (unsigned long)written, __ATOMIC_RELAXED);
+        fflush(out);
+    }
+}
+
+static void *log_thread(void *arg)
+{
+    (void)arg;
+    while (__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) {
+        sleep_ms(LOG_FLUSH_MS);
+        pthread_mutex_lock(&g_drain_lock);
+        drain();
+        pthread_mutex_unlock(&g_drain_lock);
+    }
+    return NULL;
+}
+
+int log_start(FILE *out)
+{
+    if (__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return 0;
+
+    const char *env = getenv("LOG_LEVEL");
+    if (env != NULL) {
+        int level = log_level_from_name(env);
+        if (level >= 0) log_set_level(level);
+        else printf("无法识别的LOG_LEVEL: %s\n", env);
+    }
+
+    g_out = out;
+    if (g_start_ns == 0) g_start_ns = now_ns();
+    // 正常退出 (包括出错返回) 时输出剩余记录
+    if (!g_atexit) {
+        atexit(log_stop);
+        g_atexit = 1;
+    }
+    __atomic_store_n(&g_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&g_thread, NULL, log_thread, NULL) != 0) {
+        printf("日志线程创建失败\n");
+        __atomic_store_n(&g_running, 0, __ATOMIC_RELEASE);
+        return -1;
+    }
+    return 0;
+}
+
+void log_stop(void)
+{
+    if (!__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return;
+
+    __atomic_store_n(&g_running, 0, __ATOMIC_RELEASE);
+    pthread_join(g_thread, NULL);
+    log_flush();
+}
+
+void log_flush(void)
+{
+    pthread_mutex_lock(&g_drain_lock);
+    drain();
+    pthread_mutex_unlock(&g_drain_lock);
+}
+
+void log_set_level(int level)
+{
+    if (level < LOG_LEVEL_DEBUG) level = LOG_LEVEL_DEBUG;
+    if (level > LOG_LEVEL_OFF) level = LOG_LEVEL_OFF;
+    __atomic_store_n(&g_log_level, level, __ATOMIC_RELAXED);
+}
+
+int log_get_level(void)
+{
+    return __atomic_load_n(&g_log_level, __ATOMIC_RELAXED);
+}
+
+static const char *g_level_names[] = { "debug", "info", "warn", "error", "off" };
+
+int log_level_from_name(const char *name)
+{
+    for (int i = LOG_LEVEL_DEBUG; i <= LOG_LEVEL_OFF; i++) {
+        if (strcmp(name, g_level_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char *log_level_name(int level)
+{
+    if (level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_OFF) return "?";
+    return g_level_names[level];
+}
+
+log_stats_t log_get_stats(void)
+{
+    log_stats_t stats;
+
+    stats.records = __atomic_load_n(&g_records, __ATOMIC_RELAXED);
+    stats.dropped = 0;
+    for (log_ring_t *r = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+        stats.dropped += __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_lock(&g_lock);
+    stats.threads = g_threads;
+    pthread_mutex_unlock(&g_lock);
+    return stats;
+}
+
+int log_format_stats(char *buf, int size)
+{
+    log_stats_t stats = log_get_stats();
+    int len = snprintf(buf, size, "log_level=%s log_records=%lu log_dropped=%lu log_threads=%d",
+                       log_level_name(log_get_level()), stats.records, stats.dropped, stats.threads);
+    if (len >= size) len = size - 1;
+    return len;
+}
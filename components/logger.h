@@ -0,0 +1,76 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// 异步日志
+// 组件中的状态输出 (设置RGB、蜂鸣器开关、舵机角度、数码管显示等) 原来直接printf，在树莓派的
+// 控制台上每条要几十到几百微秒，而且就在控制路径上。log_info()等宏只把一条固定大小的二进制记录
+// (级别、时间戳、调用点、参数) 写入本线程的无锁环形缓冲区，由后台线程格式化后批量输出。
+// - 格式串必须是字面量；调用点第一次执行时解析一次，记录中只保存参数
+// - %s参数在调用时复制到记录中 (可以是临时缓冲区)，过长时截断；不支持 * 宽度和 %n
+// - 级别低于当前级别的调用只有一次比较；环形缓冲区满时丢弃并计数，不阻塞调用者
+// - 未调用log_start()的程序 (工具、共享库) 在调用线程中直接输出
+// 运行时级别：环境变量LOG_LEVEL (debug/info/warn/error/off)，或log_set_level()
+
+#define LOG_LEVEL_DEBUG  0
+#define LOG_LEVEL_INFO   1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_ERROR  3
+#define LOG_LEVEL_OFF    4
+
+#define LOG_RING_SIZE     1024     // 每个线程的记录数 (2的幂)
+#define LOG_PAYLOAD_SIZE  48       // 每条记录的参数区 (记录共64字节)
+#define LOG_MAX_ARGS      6
+#define LOG_FLUSH_MS      10       // 后台线程的输出周期
+
+// 调用点 (每个宏展开处一个静态实例，其地址即格式ID)
+typedef struct {
+    const char *fmt;
+    int level;
+    int nargs;                     // -1: 尚未解析 (原子读写)
+    int fixed;                     // 参数至少占用的字节数 (字符串只计结尾的0)
+    int sync;                      // 格式不支持记录时在调用线程中格式化为文本
+    uint8_t types[LOG_MAX_ARGS];
+} log_site_t;
+
+typedef struct {
+    unsigned long records;         // 已输出的记录数
+    unsigned long dropped;         // 缓冲区满时丢弃的记录数
+    int threads;                   // 分配过环形缓冲区的线程数
+} log_stats_t;
+
+extern int g_log_level;            // 当前级别 (原子读写，宏中直接比较)
+
+#define log_write(lvl, fmt, ...) \
+    do { \
+        static log_site_t log_site_ = { fmt, lvl, -1, 0, 0, {0} }; \
+        if ((lvl) >= __atomic_load_n(&g_log_level, __ATOMIC_RELAXED)) log_emit(&log_site_, ##__VA_ARGS__); \
+    } while (0)
+
+#define log_debug(fmt, ...) log_write(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#define log_info(fmt, ...)  log_write(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define log_warn(fmt, ...)  log_write(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define log_error(fmt, ...) log_write(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+
+// 启动后台输出线程 (out为NULL时输出到stdout)，读取环境变量LOG_LEVEL
+int log_start(FILE *out);
+// 输出剩余记录并停止后台线程，之后的调用在调用线程中直接输出 (log_start注册为atexit)
+void log_stop(void);
+// 立即输出所有线程中已写入的记录 (如在打印菜单之前)
+void log_flush(void);
+
+void log_set_level(int level);
+int log_get_level(void);
+// 级别名称 (debug/info/warn/error/off) 转换为级别，无法识别返回-1
+int log_level_from_name(const char *name);
+const char *log_level_name(int level);
+
+log_stats_t log_get_stats(void);
+int log_format_stats(char *buf, int size);
+
+// 宏内部使用
+void log_emit(log_site_t *site, ...);
+
+#endif // LOGGER_H
@@ -0,0 +1,478 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include "metrics.h"
+#include "logger.h"
+#include "trace.h"
+
+#define METRICS_REQUEST_MAX  1024
+#define METRICS_BUF_INITIAL  16384
+
+const double METRICS_BUCKETS_US[12] = {
+    10e-6, 25e-6, 50e-6, 100e-6, 250e-6, 500e-6, 1e-3, 2.5e-3, 5e-3, 10e-3, 25e-3, 50e-3
+};
+const double METRICS_BUCKETS_MS[12] = {
+    100e-6, 250e-6, 500e-6, 1e-3, 2.5e-3, 5e-3, 10e-3, 25e-3, 50e-3, 100e-3, 250e-3, 1.0
+};
+
+// 每个线程的计数槽 (只有所属线程写入，导出线程读取)
+typedef struct metric_shard {
+    uint64_t slots[METRICS_MAX_SLOTS];
+    int in_use;                    // 线程退出后可由新线程继续使用 (计数保持单调)
+    struct metric_shard *next;
+} metric_shard_t;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;   // 注册和分配计数槽
+static metric_t *g_metrics = NULL;             // 同名指标相邻
+static int g_next_slot = 0;
+static metric_shard_t *g_shards = NULL;        // 原子读，只在表头插入
+static pthread_key_t g_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static __thread metric_shard_t *t_shard = NULL;
+
+static pthread_t g_thread;
+static int g_listen_fd = -1;
+static volatile int g_serving = 0;
+
+static int metric_slot_count(const metric_t *m)
+{
+    // 直方图：各档 + +Inf档 + 总和
+    return m->type == METRIC_TYPE_HISTOGRAM ? m->nbounds + 2 : 1;
+}
+
+// 注册 (持有g_lock)：插入到同名指标之后，使指标族连续输出
+static void register_locked(metric_t *m)
+{
+    if (__atomic_load_n(&m->slot, __ATOMIC_ACQUIRE) != -1) return;
+
+    int count = m->type == METRIC_TYPE_GAUGE ? 0 : metric_slot_count(m);
+    if (m->nbounds > METRICS_MAX_BUCKETS || g_next_slot + count > METRICS_MAX_SLOTS) {
+        log_warn("指标 %s 无法注册: 计数槽不足", m->name);
+        __atomic_store_n(&m->slot, -2, __ATOMIC_RELEASE);
+        return;
+    }
+
+    metric_t **pos = &g_metrics;
+    metric_t **after_same = NULL;
+    while (*pos != NULL) {
+        if (strcmp((*pos)->name, m->name) == 0) after_same = &(*pos)->next;
+        pos = &(*pos)->next;
+    }
+    if (after_same != NULL) pos = after_same;
+    m->next = *pos;
+    *pos = m;
+
+    int slot = g_next_slot;
+    g_next_slot += count;
+    __atomic_store_n(&m->slot, slot, __ATOMIC_RELEASE);
+}
+
+void metric_register(metric_t *m)
+{
+    pthread_mutex_lock(&g_lock);
+    register_locked(m);
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void release_shard(void *arg)
+{
+    metric_shard_t *shard = arg;
+    __atomic_store_n(&shard->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_key(void)
+{
+    pthread_key_create(&g_key, release_shard);
+}
+
+// 为当前线程分配计数槽：优先复用已退出线程留下的
+static metric_shard_t *acquire_shard(void)
+{
+    metric_shard_t *shard;
+
+    pthread_once(&g_key_once, create_key);
+    pthread_mutex_lock(&g_lock);
+    for (shard = g_shards; shard != NULL; shard = shard->next) {
+        if (!__atomic_load_n(&shard->in_use, __ATOMIC_ACQUIRE)) break;
+    }
+    if (shard == NULL) {
+        shard = calloc(1, sizeof(*shard));
+        if (shard != NULL) {
+            shard->next = g_shards;
+            __atomic_store_n(&g_shards, shard, __ATOMIC_RELEASE);
+        }
+    }
+    if (shard != NULL) {
+        __atomic_store_n(&shard->in_use, 1, __ATOMIC_RELEASE);
+        pthread_setspecific(g_key, shard);
+    }
+    pthread_mutex_unlock(&g_lock);
+    t_shard = shard;
+    return shard;
+}
+
+// 返回当前线程中该指标的计数槽，不可用时返回NULL
+static uint64_t *thread_slots(metric_t *m)
+{
+    int slot = __atomic_load_n(&m->slot, __ATOMIC_ACQUIRE);
+    if (slot == -1) {
+        metric_register(m);
+        slot = __atomic_load_n(&m->slot, __ATOMIC_ACQUIRE);
+    }
+    if (slot < 0) return NULL;
+
+    metric_shard_t *shard = t_shard;
+    if (shard == NULL && (shard = acquire_shard()) == NULL) return NULL;
+    return &shard->slots[slot];
+}
+
+// 只有本线程写入：普通加法，用原子存储保证导出线程读到完整的64位值
+static inline void slot_add(uint64_t *slot, uint64_t n)
+{
+    __atomic_store_n(slot, *slot + n, __ATOMIC_RELAXED);
+}
+
+void metric_add(metric_t *m, uint64_t n)
+{
+    uint64_t *slots = thread_slots(m);
+    if (slots != NULL) slot_add(slots, n);
+}
+
+void metric_inc(metric_t *m)
+{
+    metric_add(m, 1);
+}
+
+void metric_set(metric_t *m, double value)
+{
+    uint64_t bits;
+
+    if (__atomic_load_n(&m->slot, __ATOMIC_ACQUIRE) == -1) metric_register(m);
+    memcpy(&bits, &value, sizeof(bits));
+    __atomic_store_n(&m->gauge, bits, __ATOMIC_RELAXED);
+}
+
+void metric_observe(metric_t *m, double value)
+{
+    uint64_t *slots = thread_slots(m);
+    if (slots == NULL) return;
+
+    int bucket = 0;
+    while (bucket < m->nbounds && value > m->bounds[bucket]) bucket++;
+    slot_add(&slots[bucket], 1);
+
+    // 总和以double保存在最后一个计数槽
+    uint64_t *sum_slot = &slots[m->nbounds + 1];
+    double sum;
+    memcpy(&sum, sum_slot, sizeof(sum));
+    sum += value;
+    uint64_t bits;
+    memcpy(&bits, &sum, sizeof(bits));
+    __atomic_store_n(sum_slot, bits, __ATOMIC_RELAXED);
+}
+
+uint64_t metrics_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void metric_observe_since(metric_t *m, uint64_t start_ns)
+{
+    metric_observe(m, (metrics_now_ns() - start_ns) / 1e9);
+}
+
+// 所有线程中某个计数槽的和
+static uint64_t sum_slot(int slot)
+{
+    uint64_t total = 0;
+    for (metric_shard_t *s = __atomic_load_n(&g_shards, __ATOMIC_ACQUIRE); s != NULL; s = s->next) {
+        total += __atomic_load_n(&s->slots[slot], __ATOMIC_RELAXED);
+    }
+    return total;
+}
+
+static double sum_slot_double(int slot)
+{
+    double total = 0;
+    for (metric_shard_t *s = __atomic_load_n(&g_shards, __ATOMIC_ACQUIRE); s != NULL; s = s->next) {
+        uint64_t bits = __atomic_load_n(&s->slots[slot], __ATOMIC_RELAXED);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        total += value;
+    }
+    return total;
+}
+
+// 追加格式化文本，超出size时继续计算长度
+static int append(char *buf, int size, int len, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+static int append(char *buf, int size, int len, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(len < size ? buf + len : NULL, len < size ? size - len : 0, fmt, ap);
+    va_end(ap);
+    return n > 0 ? len + n : len;
+}
+
+// 标签：{labels} 或 {labels,extra}
+static int append_labels(char *buf, int size, int len, const metric_t *m, const char *extra)
+{
+    int has = m->labels != NULL && m->labels[0] != '\0';
+    if (!has && extra == NULL) return len;
+    return append(buf, size, len, "{%s%s%s}", has ? m->labels : "", has && extra ? "," : "", extra ? extra : "");
+}
+
+static int format_histogram(char *buf, int size, int len, const metric_t *m)
+{
+    uint64_t cumulative = 0;
+    char le[48];
+
+    for (int i = 0; i <= m->nbounds; i++) {
+        cumulative += sum_slot(m->slot + i);
+        if (i < m->nbounds) {
+            snprintf(le, sizeof(le), "le=\"%g\"", m->bounds[i]);
+        } else {
+            snprintf(le, sizeof(le), "le=\"+Inf\"");
+        }
+        len = append(buf, size, len, "%s_bucket", m->name);
+        len = append_labels(buf, size, len, m, le);
+        len = append(buf, size, len, " %llu\n", (unsigned long long)cumulative);
+    }
+    len = append(buf, size, len, "%s_sum", m->name);
+    len = append_labels(buf, size, len, m, NULL);
+    len = append(buf, size, len, " %.9g\n", sum_slot_double(m->slot + m->nbounds + 1));
+    len = append(buf, size, len, "%s_count", m->name);
+    len = append_labels(buf, size, len, m, NULL);
+    return append(buf, size, len, " %llu\n", (unsigned long long)cumulative);
+}
+
+int metrics_format(char *buf, int size)
+{
+    static const char *type_names[] = { "counter", "gauge", "histogram" };
+    const char *family = NULL;
+    int len = 0;
+
+    if (size > 0) buf[0] = '\0';
+    pthread_mutex_lock(&g_lock);
+    for (const metric_t *m = g_metrics; m != NULL; m = m->next) {
+        if (family == NULL || strcmp(family, m->name) != 0) {
+            family = m->name;
+            len = append(buf, size, len, "# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, type_names[m->type]);
+        }
+        if (m->type == METRIC_TYPE_HISTOGRAM) {
+            len = format_histogram(buf, size, len, m);
+            continue;
+        }
+
+        len = append(buf, size, len, "%s", m->name);
+        len = append_labels(buf, size, len, m, NULL);
+        if (m->type == METRIC_TYPE_COUNTER) {
+            len = append(buf, size, len, " %llu\n", (unsigned long long)sum_slot(m->slot));
+        } else {
+            uint64_t bits = __atomic_load_n(&m->gauge, __ATOMIC_RELAXED);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            len = append(buf, size, len, " %.9g\n", value);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+    return len;
+}
+
+// 导出端口的路径
+enum { ROUTE_NOT_FOUND, ROUTE_METRICS, ROUTE_TRACE, ROUTE_TRACE_START, ROUTE_TRACE_STOP };
+
+// 请求行是否为 GET path (后面是空格或查询字符串)
+static int is_get(const char *req, const char *path)
+{
+    size_t len = strlen(path);
+    return strncmp(req, "GET ", 4) == 0 && strncmp(req + 4, path, len) == 0 &&
+           (req[4 + len] == ' ' || req[4 + len] == '?');
+}
+
+// 读取请求头 (到空行为止)，返回ROUTE_*，连接出错返回-1
+static int read_request(int fd)
+{
+    char req[METRICS_REQUEST_MAX];
+    int len = 0;
+
+    while (len < (int)sizeof(req) - 1) {
+        ssize_t n = recv(fd, req + len, sizeof(req) - 1 - len, 0);
+        if (n <= 0) return -1;
+        len += n;
+        req[len] = '\0';
+        if (strstr(req, "\r\n\r\n") != NULL || strstr(req, "\n\n") != NULL) break;
+    }
+    if (is_get(req, "/metrics")) return ROUTE_METRICS;
+    if (is_get(req, "/trace")) return ROUTE_TRACE;
+    if (is_get(req, "/trace/start")) return ROUTE_TRACE_START;
+    if (is_get(req, "/trace/stop")) return ROUTE_TRACE_STOP;
+    return ROUTE_NOT_FOUND;
+}
+
+static void send_all(int fd, const char *data, int len)
+{
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        data += n;
+        len -= n;
+    }
+}
+
+static void send_text(int fd, const char *status, const char *text)
+{
+    char header[160];
+    int len = strlen(text);
+    int hlen = snprintf(header, sizeof(header),
+                        "HTTP/1.1 %s\r\nContent-Type: text/plain; charset=utf-8\r\n"
+                        "Content-Length: %d\r\nConnection: close\r\n\r\n", status, len);
+    send_all(fd, header, hlen);
+    send_all(fd, text, len);
+}
+
+// 追踪事件较多，边格式化边发送，以关闭连接结束响应
+static void send_trace(int fd)
+{
+    int out_fd = dup(fd);
+    FILE *out = out_fd >= 0 ? fdopen(out_fd, "w") : NULL;
+
+    if (out == NULL) {
+        if (out_fd >= 0) close(out_fd);
+        return;
+    }
+    fputs("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\n\r\n", out);
+    trace_write_json(out);
+    fclose(out);
+}
+
+static void serve_client(int fd, char **buf, int *size)
+{
+    char header[160];
+
+    switch (read_request(fd)) {
+        case ROUTE_METRICS:
+            break;
+        case ROUTE_TRACE:
+            send_trace(fd);
+            return;
+        case ROUTE_TRACE_START:
+            trace_set_enabled(1);
+            send_text(fd, "200 OK", "trace on\n");
+            return;
+        case ROUTE_TRACE_STOP:
+            trace_set_enabled(0);
+            send_text(fd, "200 OK", "trace off\n");
+            return;
+        case ROUTE_NOT_FOUND:
+            send_text(fd, "404 Not Found", "");
+            return;
+        default:
+            return;
+    }
+
+    int len = metrics_format(*buf, *size);
+    if (len >= *size) {
+        // 缓冲区不够时扩大后重新格式化 (只在导出线程中分配)
+        char *bigger = realloc(*buf, len + 1024);
+        if (bigger == NULL) return;
+        *buf = bigger;
+        *size = len + 1024;
+        len = metrics_format(*buf, *size);
+        if (len >= *size) len = *size - 1;
+    }
+
+    int hlen = snprintf(header, sizeof(header),
+                        "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: %d\r\nConnection: close\r\n\r\n", len);
+    send_all(fd, header, hlen);
+    send_all(fd, *buf, len);
+}
+
+static void *metrics_thread(void *arg)
+{
+    struct sched_param param = { 0 };
+    int size = METRICS_BUF_INITIAL;
+    char *buf = malloc(size);
+    sigset_t set;
+
+    (void)arg;
+    // 信号留给主线程 (可能在取消处理或事件循环屏蔽信号之前启动)
+    sigfillset(&set);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+    while (g_serving && buf != NULL) {
+        int fd = accept(g_listen_fd, NULL, NULL);
+        if (fd < 0) continue;
+
+        struct timeval tv = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        serve_client(fd, &buf, &size);
+        close(fd);
+    }
+    free(buf);
+    return NULL;
+}
+
+int metrics_serve_start(int port)
+{
+    struct sockaddr_in addr;
+    int opt = 1;
+
+    if (port <= 0 || g_serving) return 0;
+
+    g_listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (g_listen_fd < 0) {
+        perror("指标导出 socket");
+        return -1;
+    }
+    setsockopt(g_listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(g_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(g_listen_fd, 4) < 0) {
+        perror("指标导出 bind/listen");
+        close(g_listen_fd);
+        g_listen_fd = -1;
+        return -1;
+    }
+
+    g_serving = 1;
+    if (pthread_create(&g_thread, NULL, metrics_thread, NULL) != 0) {
+        log_error("指标导出线程创建失败");
+        g_serving = 0;
+        close(g_listen_fd);
+        g_listen_fd = -1;
+        return -1;
+    }
+    log_info("指标导出: http://0.0.0.0:%d/metrics", port);
+    return 0;
+}
+
+void metrics_serve_stop(void)
+{
+    if (!g_serving) return;
+
+    g_serving = 0;
+    // 关闭监听socket使accept返回
+    shutdown(g_listen_fd, SHUT_RDWR);
+    pthread_join(g_thread, NULL);
+    close(g_listen_fd);
+    g_listen_fd = -1;
+}
@@ -0,0 +1,65 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+// 运行指标 (计数器、仪表和直方图)，以Prometheus文本格式从HTTP /metrics 导出
+// 每个指标是使用处的一个静态metric_t，第一次更新时注册 (只有这一次加锁)。
+// 计数器和直方图的值按线程分开存放：每个线程只写自己的计数槽 (普通的读-加-写，没有原子指令和锁)，
+// 导出时把所有线程的计数槽相加，因此抓取不会与控制路径竞争缓存行或锁。
+// 仪表 (当前温度等) 只保存最新值。同名、不同标签的指标输出为同一个指标族。
+// 导出线程以SCHED_IDLE运行，格式化和发送只使用空闲的CPU。
+
+#define METRICS_PORT         9180
+#define METRICS_MAX_SLOTS    256   // 每个线程的计数槽数 (计数器1个，直方图为档数+2个)
+#define METRICS_MAX_BUCKETS  16
+
+#define METRIC_TYPE_COUNTER   0
+#define METRIC_TYPE_GAUGE     1
+#define METRIC_TYPE_HISTOGRAM 2
+
+typedef struct metric {
+    const char *name;
+    const char *labels;            // 如 "result=\"ok\""，没有标签时为NULL
+    const char *help;
+    int type;
+    const double *bounds;          // 直方图各档的上界 (递增，最后还有+Inf档)
+    int nbounds;
+    int slot;                      // 第一个计数槽，-1: 尚未注册，-2: 计数槽用完 (原子读写)
+    uint64_t gauge;                // 仪表的值 (double的位表示，原子读写)
+    struct metric *next;
+} metric_t;
+
+#define METRIC_COUNTER(name, labels, help) \
+    { name, labels, help, METRIC_TYPE_COUNTER, NULL, 0, -1, 0, NULL }
+#define METRIC_GAUGE(name, labels, help) \
+    { name, labels, help, METRIC_TYPE_GAUGE, NULL, 0, -1, 0, NULL }
+#define METRIC_HISTOGRAM(name, labels, help, bounds) \
+    { name, labels, help, METRIC_TYPE_HISTOGRAM, bounds, (int)(sizeof(bounds) / sizeof((bounds)[0])), -1, 0, NULL }
+
+// 常用的直方图分档 (秒)
+extern const double METRICS_BUCKETS_US[12];    // 10us ~ 50ms，命令延迟、PWM写入
+extern const double METRICS_BUCKETS_MS[12];    // 0.1ms ~ 1s，传感器读取、数码管刷新
+
+void metric_add(metric_t *m, uint64_t n);
+void metric_inc(metric_t *m);
+void metric_set(metric_t *m, double value);
+void metric_observe(metric_t *m, double value);
+// 计时辅助 (CLOCK_MONOTONIC)，metric_observe_since记录从start_ns到现在的秒数
+uint64_t metrics_now_ns(void);
+void metric_observe_since(metric_t *m, uint64_t start_ns);
+
+// 在使用前注册指标，使其在第一次更新之前就以0导出
+void metric_register(metric_t *m);
+
+// 格式化所有指标 (Prometheus文本格式0.0.4)，返回需要的长度；大于等于size时输出被截断
+int metrics_format(char *buf, int size);
+
+// 在port上启动HTTP导出线程，0表示不启用：
+//   GET /metrics        所有指标
+//   GET /trace          追踪事件 (trace-event JSON，见trace.h)
+//   GET /trace/start    开启追踪，/trace/stop 关闭
+int metrics_serve_start(int port);
+void metrics_serve_stop(void);
+
+#endif // METRICS_H
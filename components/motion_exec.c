@@ -0,0 +1,479 @@
+#include <pthread.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include "motion_exec.h"
+#include "recorder.h"
+#include "logger.h"
+#include "metrics.h"
+
+// 命令队列 (环形缓冲区)，由g_lock保护
+static motion_cmd_t g_queue[MOTION_QUEUE_SIZE];
+static int g_head = 0;
+static int g_count = 0;
+
+// 执行线程状态
+static pthread_t g_thread;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond;
+static int g_running = 0;
+
+static metric_t m_command_latency = METRIC_HISTOGRAM("rpi_command_latency_seconds", NULL,
+                                                     "运动命令可以执行到写入PWM的延迟", METRICS_BUCKETS_US);
+static metric_t m_queue_full = METRIC_COUNTER("rpi_motion_queue_full_total", NULL, "命令队列已满而丢弃的运动命令");
+
+// 当前正在执行的命令
+static int g_active = 0;
+static uint64_t g_deadline_ns = 0;       // 当前命令截止时间，0表示持续执行
+static uint64_t g_last_deadline_ns = 0;  // 上一条定时命令的截止时间
+
+// 速度斜坡 (运动执行线程按节拍驱动)
+static speed_ramp_t g_ramp;
+static motion_type_t g_ramp_motion = MOTION_STOP;
+static uint64_t g_next_tick_ns = 0;
+
+// 最近一次写入的轮速，作为斜坡起点
+static int g_applied_left = 0;
+static int g_applied_right = 0;
+
+// 延迟统计
+static motion_latency_t g_latency = {0, 0, 0, 0};
+
+// 命令编号和执行记录 (环形，由g_lock保护)
+static uint32_t g_next_id = 1;
+static uint32_t g_last_id = 0;
+static motion_applied_t g_applied[MOTION_APPLIED_HISTORY];
+static int g_applied_pos = 0;
+static motion_apply_hook_t g_apply_hook = NULL;
+
+// 获取单调时钟时间(纳秒)
+uint64_t motion_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void ns_to_timespec(uint64_t ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+// 写入轮速并记录 (调用时持有g_lock)
+static void motion_exec_write(motion_type_t motion, int left_speed, int right_speed)
+{
+    control_apply(motion, left_speed, right_speed);
+    recorder_log(REC_WRITE, motion, 0, left_speed, right_speed, 0);
+    g_applied_left = left_speed;
+    g_applied_right = right_speed;
+}
+
+// 记录命令执行结果并通知 (调用时持有g_lock)
+static void motion_exec_record(uint32_t id, uint64_t applied_ns)
+{
+    g_applied[g_applied_pos].id = id;
+    g_applied[g_applied_pos].applied_ns = applied_ns;
+    g_applied_pos = (g_applied_pos + 1) % MOTION_APPLIED_HISTORY;
+    if (g_apply_hook != NULL) g_apply_hook();
+}
+
+// 斜坡结束后根据最终轮速确定运动状态
+static motion_type_t motion_from_speeds(int left_speed, int right_speed)
+{
+    if (left_speed == 0 && right_speed == 0) return MOTION_STOP;
+    if (left_speed > 0 && right_speed > 0) return MOTION_FORWARD;
+    if (left_speed < 0 && right_speed < 0) return MOTION_BACKWARD;
+    return left_speed < right_speed ? MOTION_LEFT : MOTION_RIGHT;
+}
+
+// 推进一个斜坡节拍并写入PWM (调用时持有g_lock)
+static void motion_exec_ramp_tick(uint64_t now)
+{
+    int left, right;
+    uint64_t period = 1000000000ULL / g_ramp.tick_hz;
+
+    ramp_step(&g_ramp);
+    ramp_output(&g_ramp, &left, &right);
+    motion_exec_write(g_ramp.active ? g_ramp_motion : motion_from_speeds(left, right),
+                      left, right);
+
+    // 节拍按绝对时间推进，落后太多时重新对齐
+    g_next_tick_ns += period;
+    if (g_next_tick_ns <= now) {
+        g_next_tick_ns = now + period;
+    }
+}
+
+// 执行一条命令并记录命令到PWM的延迟 (调用时持有g_lock)
+// ready_ns为命令可以开始执行的时间，排队等待前一条定时命令的时间不计入延迟
+static void motion_exec_apply(const motion_cmd_t *cmd, uint64_t ready_ns)
+{
+    if (cmd->ramp) {
+        // 没有进行中的斜坡时从当前实际轮速开始
+        if (!g_ramp.active) {
+            ramp_reset(&g_ramp, g_applied_left, g_applied_right);
+        }
+        ramp_set_target(&g_ramp, cmd->left_speed, cmd->right_speed);
+        g_ramp_motion = cmd->motion;
+        g_next_tick_ns = motion_now_ns();
+        motion_exec_ramp_tick(g_next_tick_ns);
+    } else {
+        g_ramp.active = 0;
+        motion_exec_write(cmd->motion, cmd->left_speed, cmd->right_speed);
+    }
+
+    uint64_t now = motion_now_ns();
+    uint64_t latency = now - ready_ns;
+    motion_exec_record(cmd->id, now);
+    g_latency.count++;
+    g_latency.total_ns += latency;
+    g_latency.last_ns = latency;
+    if (latency > g_latency.max_ns) g_latency.max_ns = latency;
+    metric_observe(&m_command_latency, latency / 1e9);
+}
+
+// 运动执行线程：按绝对截止时间调度队列中的定时命令
+static void *motion_exec_thread(void *arg)
+{
+    (void)arg;
+    prctl(PR_SET_NAME, "motion_exec");   // 追踪和top中显示的线程名
+
+    pthread_mutex_lock(&g_lock);
+    while (g_running) {
+        uint64_t now = motion_now_ns();
+
+        // 定时命令到期：队列为空则停车
+        if (g_active && g_deadline_ns != 0 && now >= g_deadline_ns) {
+            g_active = 0;
+            g_last_deadline_ns = g_deadline_ns;
+            g_deadline_ns = 0;
+            if (g_count == 0) {
+                motion_exec_write(MOTION_STOP, 0, 0);
+            }
+        }
+
+        // 斜坡节拍到期
+        if (g_ramp.active && now >= g_next_tick_ns) {
+            motion_exec_ramp_tick(now);
+        }
+
+        // 没有定时命令在执行时取出下一条命令 (持续命令会被新命令直接替换)
+        if ((!g_active || g_deadline_ns == 0) && g_count > 0) {
+            motion_cmd_t cmd = g_queue[g_head];
+            g_head = (g_head + 1) % MOTION_QUEUE_SIZE;
+            g_count--;
+
+            // 紧接上一条定时命令的命令从上一个截止时间开始计时，避免误差累积
+            uint64_t start = cmd.enqueue_ns;
+            if (g_last_deadline_ns != 0 && cmd.enqueue_ns <= g_last_deadline_ns) {
+                start = g_last_deadline_ns;
+            }
+
+            motion_exec_apply(&cmd, start);
+            g_active = 1;
+
+            if (cmd.duration > 0) {
+                g_deadline_ns = start + (uint64_t)cmd.duration * 1000000ULL;
+            } else {
+                g_deadline_ns = 0;
+                g_last_deadline_ns = 0;
+            }
+            continue;
+        }
+
+        // 等待到下一个截止时间或斜坡节拍
+        uint64_t wake_ns = 0;
+        if (g_active && g_deadline_ns != 0) {
+            wake_ns = g_deadline_ns;
+        }
+        if (g_ramp.active && (wake_ns == 0 || g_next_tick_ns < wake_ns)) {
+            wake_ns = g_next_tick_ns;
+        }
+
+        if (wake_ns != 0) {
+            struct timespec ts;
+            ns_to_timespec(wake_ns, &ts);
+            pthread_cond_timedwait(&g_cond, &g_lock, &ts);
+        } else {
+            pthread_cond_wait(&g_cond, &g_lock);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return NULL;
+}
+
+// 启动运动执行线程
+int motion_exec_start(void)
+{
+    pthread_condattr_t attr;
+
+    if (g_running) return 0;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    g_head = 0;
+    g_count = 0;
+    g_active = 0;
+    g_deadline_ns = 0;
+    g_last_deadline_ns = 0;
+    if (g_ramp.tick_hz == 0) {
+        ramp_config(&g_ramp, RAMP_DEFAULT_TICK_HZ, RAMP_DEFAULT_SLEW);
+    }
+    g_ramp.active = 0;
+    g_running = 1;
+
+    if (pthread_create(&g_thread, NULL, motion_exec_thread, NULL) != 0) {
+        log_error("运动执行线程创建失败");
+        g_running = 0;
+        pthread_cond_destroy(&g_cond);
+        return -1;
+    }
+
+    log_info("运动执行线程已启动 (队列容量: %d)", MOTION_QUEUE_SIZE);
+    return 0;
+}
+
+// 停止运动执行线程 (会先紧急停车)
+void motion_exec_stop(void)
+{
+    if (!g_running) return;
+
+    motion_exec_emergency_stop();
+
+    pthread_mutex_lock(&g_lock);
+    g_running = 0;
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_join(g_thread, NULL);
+    pthread_cond_destroy(&g_cond);
+}
+
+int motion_exec_is_running(void)
+{
+    return g_running;
+}
+
+// 命令入队 (分配命令编号)
+static int motion_exec_enqueue(motion_cmd_t *cmd)
+{
+    pthread_mutex_lock(&g_lock);
+
+    cmd->id = g_next_id++;
+    g_last_id = cmd->id;
+
+    // 执行线程未启动时直接写入目标速度 (不支持定时和斜坡)
+    if (!g_running) {
+        motion_exec_write(cmd->ramp ? motion_from_speeds(cmd->left_speed, cmd->right_speed)
+                                    : cmd->motion,
+                          cmd->left_speed, cmd->right_speed);
+        motion_exec_record(cmd->id, motion_now_ns());
+        pthread_mutex_unlock(&g_lock);
+        return 0;
+    }
+
+    // 队尾的持续命令在执行时也会被新的持续命令立即替换，直接覆盖以免高频客户端占满队列
+    if (g_count > 0 && cmd->duration == 0) {
+        motion_cmd_t *tail = &g_queue[(g_head + g_count - 1) % MOTION_QUEUE_SIZE];
+        if (tail->duration == 0 && tail->ramp == cmd->ramp) {
+            motion_exec_record(tail->id, 0);
+            *tail = *cmd;
+            pthread_cond_signal(&g_cond);
+            pthread_mutex_unlock(&g_lock);
+            return 0;
+        }
+    }
+
+    if (g_count >= MOTION_QUEUE_SIZE) {
+        motion_exec_record(cmd->id, 0);
+        pthread_mutex_unlock(&g_lock);
+        metric_inc(&m_queue_full);
+        log_warn("运动命令队列已满，丢弃命令");
+        return -1;
+    }
+
+    g_queue[(g_head + g_count) % MOTION_QUEUE_SIZE] = *cmd;
+    g_count++;
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+
+    return 0;
+}
+
+// 提交运动命令，立即返回
+int motion_exec_submit(motion_type_t motion, int left_speed, int right_speed, int duration)
+{
+    motion_cmd_t cmd;
+
+    cmd.motion = motion;
+    cmd.left_speed = left_speed;
+    cmd.right_speed = right_speed;
+    cmd.duration = duration < 0 ? 0 : duration;
+    cmd.ramp = 0;
+    cmd.enqueue_ns = motion_now_ns();
+    recorder_log(REC_SUBMIT, motion, 0, left_speed, right_speed, cmd.duration);
+
+    return motion_exec_enqueue(&cmd);
+}
+
+// 提交斜坡命令，立即返回
+int motion_exec_ramp(motion_type_t motion, int left_target, int right_target)
+{
+    motion_cmd_t cmd;
+
+    cmd.motion = motion;
+    cmd.left_speed = left_target;
+    cmd.right_speed = right_target;
+    cmd.duration = 0;
+    cmd.ramp = 1;
+    cmd.enqueue_ns = motion_now_ns();
+    recorder_log(REC_RAMP, motion, 0, left_target, right_target, 0);
+
+    return motion_exec_enqueue(&cmd);
+}
+
+// 配置斜坡节拍频率和最大变化率 (%/秒)，对进行中的斜坡立即生效
+void motion_exec_set_ramp(int tick_hz, float slew_rate)
+{
+    pthread_mutex_lock(&g_lock);
+    ramp_config(&g_ramp, tick_hz, slew_rate);
+    pthread_cond_signal(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+void motion_exec_get_ramp(int *tick_hz, float *slew_rate)
+{
+    pthread_mutex_lock(&g_lock);
+    if (g_ramp.tick_hz == 0) {
+        ramp_config(&g_ramp, RAMP_DEFAULT_TICK_HZ, RAMP_DEFAULT_SLEW);
+    }
+    *tick_hz = g_ramp.tick_hz;
+    *slew_rate = g_ramp.slew_rate;
+    pthread_mutex_unlock(&g_lock);
+}
+
+// 斜坡目标速度：以最后提交的命令为准，队尾是普通命令时斜坡会被它取消
+int motion_exec_ramp_target(int *left_target, int *right_target)
+{
+    int found = 0;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_count > 0) {
+        const motion_cmd_t *tail = &g_queue[(g_head + g_count - 1) % MOTION_QUEUE_SIZE];
+        if (tail->ramp) {
+            *left_target = tail->left_speed;
+            *right_target = tail->right_speed;
+            found = 1;
+        }
+    } else if (g_ramp.active) {
+        *left_target = g_ramp.target[0];
+        *right_target = g_ramp.target[1];
+        found = 1;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return found;
+}
+
+// 紧急停止：不经过队列，在调用线程中直接停车
+void motion_exec_emergency_stop(void)
+{
+    recorder_log(REC_STOP, MOTION_STOP, 0, 0, 0, 0);
+    pthread_mutex_lock(&g_lock);
+
+    // 清空的待执行命令记为被取代
+    for (int i = 0; i < g_count; i++) {
+        motion_exec_record(g_queue[(g_head + i) % MOTION_QUEUE_SIZE].id, 0);
+    }
+
+    g_head = 0;
+    g_count = 0;
+    g_active = 0;
+    g_deadline_ns = 0;
+    g_last_deadline_ns = 0;
+    g_ramp.active = 0;
+    motion_exec_write(MOTION_STOP, 0, 0);
+    g_last_id = g_next_id++;
+    motion_exec_record(g_last_id, motion_now_ns());
+
+    if (g_running) {
+        pthread_cond_signal(&g_cond);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+// 获取待执行命令数
+int motion_exec_pending(void)
+{
+    int count;
+
+    pthread_mutex_lock(&g_lock);
+    count = g_count;
+    pthread_mutex_unlock(&g_lock);
+
+    return count;
+}
+
+// 获取命令到PWM的延迟统计
+motion_latency_t motion_exec_get_latency(void)
+{
+    motion_latency_t latency;
+
+    pthread_mutex_lock(&g_lock);
+    latency = g_latency;
+    pthread_mutex_unlock(&g_lock);
+
+    return latency;
+}
+
+// 最近提交的命令编号 (包括紧急停止)
+uint32_t motion_exec_last_id(void)
+{
+    uint32_t id;
+
+    pthread_mutex_lock(&g_lock);
+    id = g_last_id;
+    pthread_mutex_unlock(&g_lock);
+
+    return id;
+}
+
+// 查询命令执行时间：已执行返回1并写入applied_ns，仍在队列中返回0，
+// 被取代或执行记录已被覆盖返回-1
+int motion_exec_applied(uint32_t id, uint64_t *applied_ns)
+{
+    int result = -1;
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 1; i <= MOTION_APPLIED_HISTORY; i++) {
+        const motion_applied_t *rec = &g_applied[(g_applied_pos - i + MOTION_APPLIED_HISTORY) % MOTION_APPLIED_HISTORY];
+        if (rec->id == id) {
+            if (rec->applied_ns != 0) {
+                *applied_ns = rec->applied_ns;
+                result = 1;
+            }
+            pthread_mutex_unlock(&g_lock);
+            return result;
+        }
+    }
+    for (int i = 0; i < g_count; i++) {
+        if (g_queue[(g_head + i) % MOTION_QUEUE_SIZE].id == id) {
+            result = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return result;
+}
+
+void motion_exec_set_apply_hook(motion_apply_hook_t hook)
+{
+    pthread_mutex_lock(&g_lock);
+    g_apply_hook = hook;
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,70 @@
+#ifndef MOTION_EXEC_H
+#define MOTION_EXEC_H
+
+#include <stdint.h>
+#include "control.h"
+#include "ramp.h"
+
+// 命令队列容量
+#define MOTION_QUEUE_SIZE 32
+
+// 保留的命令执行记录条数
+#define MOTION_APPLIED_HISTORY 128
+
+// 定时运动命令
+typedef struct {
+    motion_type_t motion;
+    int left_speed;
+    int right_speed;
+    int duration;          // 持续时间(毫秒)，0表示一直执行到下一条命令
+    int ramp;              // 1表示按斜坡逐步逼近目标速度
+    uint64_t enqueue_ns;   // 入队时间 (CLOCK_MONOTONIC)
+    uint32_t id;           // 命令编号 (入队时分配)
+} motion_cmd_t;
+
+// 命令执行记录
+typedef struct {
+    uint32_t id;
+    uint64_t applied_ns;   // 写入PWM的时间，0表示被后续命令取代而未执行
+} motion_applied_t;
+
+// 命令执行通知：每条命令执行 (或被取代) 后调用，调用时持有执行器内部锁，只能做唤醒等简单操作
+typedef void (*motion_apply_hook_t)(void);
+
+// 命令到PWM的延迟统计
+typedef struct {
+    unsigned long count;   // 已执行命令数
+    uint64_t total_ns;     // 累计延迟
+    uint64_t max_ns;       // 最大延迟
+    uint64_t last_ns;      // 最近一次延迟
+} motion_latency_t;
+
+// 执行线程的启动和停止
+int motion_exec_start(void);
+void motion_exec_stop(void);
+int motion_exec_is_running(void);
+
+// 提交命令 (立即返回)，队列满时返回-1
+int motion_exec_submit(motion_type_t motion, int left_speed, int right_speed, int duration);
+
+// 提交斜坡命令：两轮按配置的变化率逼近目标速度，新目标会接管进行中的斜坡
+int motion_exec_ramp(motion_type_t motion, int left_target, int right_target);
+void motion_exec_set_ramp(int tick_hz, float slew_rate);
+void motion_exec_get_ramp(int *tick_hz, float *slew_rate);
+// 查询斜坡目标速度 (含已提交未执行的斜坡命令)，没有进行中的斜坡时返回0
+int motion_exec_ramp_target(int *left_target, int *right_target);
+
+// 紧急停止：绕过队列，清空待执行命令并立即停车
+void motion_exec_emergency_stop(void);
+
+// 状态查询
+int motion_exec_pending(void);
+motion_latency_t motion_exec_get_latency(void);
+uint64_t motion_now_ns(void);
+
+// 命令执行跟踪
+uint32_t motion_exec_last_id(void);                          // 最近提交的命令编号
+int motion_exec_applied(uint32_t id, uint64_t *applied_ns);  // 1已执行，0等待执行，-1被取代或记录已覆盖
+void motion_exec_set_apply_hook(motion_apply_hook_t hook);
+
+#endif // MOTION_EXEC_H
@@ -0,0 +1,641 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include "motion_program.h"
+#include "motion_exec.h"
+#include "control.h"
+#include "sensor_cache.h"
+#include "rgb.h"
+#include "beep.h"
+#include "servo.h"
+#include "logger.h"
+
+#define PROGRAM_MAX_TOKENS  6
+#define PROGRAM_TOKEN_SIZE  16
+
+// 距离读数超过采样周期的3倍没有更新时视为无效
+#define PROGRAM_DISTANCE_STALE_MS (SENSOR_DISTANCE_PERIOD_MS * 3)
+
+// 停止请求
+#define PROGRAM_ABORT_NONE      0
+#define PROGRAM_ABORT_STOP      1  // 停止并停车
+#define PROGRAM_ABORT_TAKEOVER  2  // 手动命令接管，保留手动命令的动作
+
+// 编译时的嵌套块
+typedef enum {
+    BLOCK_LOOP = 0,
+    BLOCK_IF,
+    BLOCK_ELSE
+} block_type_t;
+
+typedef struct {
+    block_type_t type;
+    int index;                     // LOOP/IF_DISTANCE/JUMP指令的位置
+    int line;
+    int timed;                     // 循环体中有定时步骤
+} block_t;
+
+// 编译器状态
+typedef struct {
+    motion_program_t *prog;
+    block_t blocks[PROGRAM_MAX_DEPTH];
+    int depth;
+    int line;
+    char *err;
+    size_t err_size;
+} compiler_t;
+
+// 执行线程状态 (g_lock保护g_status和g_abort)
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond;
+static int g_cond_ready = 0;
+static pthread_t g_thread;
+static int g_thread_valid = 0;
+static int g_abort = 0;            // PROGRAM_ABORT_*
+static int g_active = 0;           // 有程序在运行 (无锁读取，手动命令路径上的快速判断)
+static motion_program_t g_prog;
+static motion_program_status_t g_status;
+static unsigned int g_devices = 0;
+static unsigned int g_ready = 0;   // 已初始化的设备
+static motion_program_hook_t g_finish_hook = NULL;
+
+// ---------------- 编译 ----------------
+
+static int compile_error(compiler_t *c, const char *fmt, ...)
+{
+    va_list ap;
+    int len = snprintf(c->err, c->err_size, "第%d行: ", c->line);
+
+    if (len < 0 || (size_t)len >= c->err_size) return -1;
+    va_start(ap, fmt);
+    vsnprintf(c->err + len, c->err_size - len, fmt, ap);
+    va_end(ap);
+    return -1;
+}
+
+static int parse_int(compiler_t *c, const char *token, const char *name, long min, long max, long *out)
+{
+    char *end;
+    long value = strtol(token, &end, 10);
+
+    if (*token == '\0' || *end != '\0') return compile_error(c, "%s不是整数: %s", name, token);
+    if (value < min || value > max) return compile_error(c, "%s超出范围 (%ld~%ld): %ld", name, min, max, value);
+    *out = value;
+    return 0;
+}
+
+static program_insn_t *emit(compiler_t *c, program_op_t op)
+{
+    motion_program_t *prog = c->prog;
+
+    if (prog->count >= PROGRAM_MAX_INSNS) {
+        compile_error(c, "指令超过%d条", PROGRAM_MAX_INSNS);
+        return NULL;
+    }
+    program_insn_t *insn = &prog->insns[prog->count++];
+    memset(insn, 0, sizeof(*insn));
+    insn->op = (uint8_t)op;
+    insn->line = (uint16_t)c->line;
+    return insn;
+}
+
+// 可选的时长参数：定时步骤使所在的循环体不会空转
+static int parse_ms(compiler_t *c, char tokens[][PROGRAM_TOKEN_SIZE], int count, int pos, int required,
+                    uint32_t *ms)
+{
+    long value = 0;
+
+    if (pos >= count) {
+        if (required) return compile_error(c, "缺少毫秒数");
+        *ms = 0;
+        return 0;
+    }
+    if (pos + 1 < count) return compile_error(c, "多余的参数: %s", tokens[pos + 1]);
+    if (parse_int(c, tokens[pos], "毫秒数", required ? 1 : 0, PROGRAM_MAX_MS, &value) != 0) return -1;
+    *ms = (uint32_t)value;
+    if (*ms > 0 && c->depth > 0 && c->blocks[c->depth - 1].type == BLOCK_LOOP) {
+        c->blocks[c->depth - 1].timed = 1;
+    }
+    return 0;
+}
+
+static int need_device(compiler_t *c, unsigned int device, const char *name)
+{
+    if (!(g_devices & device)) return compile_error(c, "%s不可用 (未接线或引脚与电机冲突)", name);
+    c->prog->devices |= device;
+    // 蜂鸣器和舵机共用GPIO18
+    if (BEEP_PIN == SERVO_PIN &&
+        (c->prog->devices & (PROGRAM_DEV_BEEP | PROGRAM_DEV_SERVO)) == (PROGRAM_DEV_BEEP | PROGRAM_DEV_SERVO)) {
+        return compile_error(c, "beep和servo共用GPIO%d，不能在同一程序中使用", SERVO_PIN);
+    }
+    return 0;
+}
+
+static int push_block(compiler_t *c, block_type_t type, int index)
+{
+    if (c->depth >= PROGRAM_MAX_DEPTH) return compile_error(c, "嵌套超过%d层", PROGRAM_MAX_DEPTH);
+    block_t *block = &c->blocks[c->depth++];
+    block->type = type;
+    block->index = index;
+    block->line = c->line;
+    block->timed = 0;
+    return 0;
+}
+
+static int compile_end(compiler_t *c)
+{
+    program_insn_t *insn;
+
+    if (c->depth == 0) return compile_error(c, "end没有对应的loop或if");
+    block_t block = c->blocks[--c->depth];
+
+    switch (block.type) {
+        case BLOCK_LOOP:
+            // 没有定时步骤的循环会占满CPU，且一直重复时无法从外部观察到进展
+            if (!block.timed) return compile_error(c, "第%d行的循环体中没有定时步骤 (wait或带毫秒的动作)", block.line);
+            if ((insn = emit(c, PROGRAM_OP_NEXT)) == NULL) return -1;
+            insn->target = (uint16_t)(block.index + 1);
+            c->prog->insns[block.index].target = (uint16_t)c->prog->count;
+            // 内层循环每轮至少耗时1毫秒，外层循环也不会空转
+            if (c->depth > 0 && c->blocks[c->depth - 1].type == BLOCK_LOOP) c->blocks[c->depth - 1].timed = 1;
+            return 0;
+        case BLOCK_IF:
+        case BLOCK_ELSE:
+            c->prog->insns[block.index].target = (uint16_t)c->prog->count;
+            return 0;
+    }
+    return -1;
+}
+
+// 编译一条语句
+static int compile_statement(compiler_t *c, char tokens[][PROGRAM_TOKEN_SIZE], int count)
+{
+    const char *cmd = tokens[0];
+    program_insn_t *insn;
+    long value;
+
+    if (strcmp(cmd, "move") == 0) {
+        if (count < 2) return compile_error(c, "用法: move <速度> [毫秒]");
+        if (parse_int(c, tokens[1], "速度", -MAX_SPEED, MAX_SPEED, &value) != 0) return -1;
+        if ((insn = emit(c, PROGRAM_OP_MOVE)) == NULL) return -1;
+        insn->a = (int32_t)value;
+        return parse_ms(c, tokens, count, 2, 0, &insn->ms);
+    }
+    if (strcmp(cmd, "turn") == 0) {
+        if (count < 3 || (strcmp(tokens[1], "left") != 0 && strcmp(tokens[1], "right") != 0)) {
+            return compile_error(c, "用法: turn left|right <速度> [毫秒]");
+        }
+        if (parse_int(c, tokens[2], "速度", 0, MAX_SPEED, &value) != 0) return -1;
+        if ((insn = emit(c, PROGRAM_OP_TURN)) == NULL) return -1;
+        insn->arg = strcmp(tokens[1], "right") == 0;
+        insn->a = (int32_t)value;
+        return parse_ms(c, tokens, count, 3, 0, &insn->ms);
+    }
+    if (strcmp(cmd, "stop") == 0) {
+        if ((insn = emit(c, PROGRAM_OP_STOP)) == NULL) return -1;
+        return parse_ms(c, tokens, count, 1, 0, &insn->ms);
+    }
+    if (strcmp(cmd, "wait") == 0) {
+        if ((insn = emit(c, PROGRAM_OP_WAIT)) == NULL) return -1;
+        return parse_ms(c, tokens, count, 1, 1, &insn->ms);
+    }
+    if (strcmp(cmd, "rgb") == 0) {
+        long red, green, blue;
+        if (count != 4) return compile_error(c, "用法: rgb <红> <绿> <蓝>");
+        if (need_device(c, PROGRAM_DEV_RGB, "RGB灯") != 0 ||
+            parse_int(c, tokens[1], "红", 0, 1, &red) != 0 ||
+            parse_int(c, tokens[2], "绿", 0, 1, &green) != 0 ||
+            parse_int(c, tokens[3], "蓝", 0, 1, &blue) != 0) {
+            return -1;
+        }
+        if ((insn = emit(c, PROGRAM_OP_RGB)) == NULL) return -1;
+        insn->a = (int32_t)(red | (green << 1) | (blue << 2));
+        return 0;
+    }
+    if (strcmp(cmd, "beep") == 0) {
+        if (need_device(c, PROGRAM_DEV_BEEP, "蜂鸣器") != 0) return -1;
+        // 展开为 开 + 保持 + 关
+        if ((insn = emit(c, PROGRAM_OP_BEEP)) == NULL) return -1;
+        insn->a = 1;
+        if (parse_ms(c, tokens, count, 1, 1, &insn->ms) != 0) return -1;
+        if ((insn = emit(c, PROGRAM_OP_BEEP)) == NULL) return -1;
+        insn->a = 0;
+        return 0;
+    }
+    if (strcmp(cmd, "servo") == 0) {
+        if (count != 2) return compile_error(c, "用法: servo <角度>");
+        if (need_device(c, PROGRAM_DEV_SERVO, "舵机") != 0 ||
+            parse_int(c, tokens[1], "角度", SERVO_MIN_ANGLE, SERVO_MAX_ANGLE, &value) != 0) {
+            return -1;
+        }
+        if ((insn = emit(c, PROGRAM_OP_SERVO)) == NULL) return -1;
+        insn->a = (int32_t)value;
+        return 0;
+    }
+    if (strcmp(cmd, "loop") == 0) {
+        value = 0;
+        if (count > 2) return compile_error(c, "用法: loop [次数]");
+        if (count == 2 && parse_int(c, tokens[1], "循环次数", 1, PROGRAM_MAX_LOOPS, &value) != 0) return -1;
+        if ((insn = emit(c, PROGRAM_OP_LOOP)) == NULL) return -1;
+        insn->a = (int32_t)value;
+        return push_block(c, BLOCK_LOOP, c->prog->count - 1);
+    }
+    if (strcmp(cmd, "if") == 0) {
+        if (count != 4 || strcmp(tokens[1], "distance") != 0 ||
+            (strcmp(tokens[2], "<") != 0 && strcmp(tokens[2], ">") != 0)) {
+            return compile_error(c, "用法: if distance <|> <厘米>");
+        }
+        if (need_device(c, PROGRAM_DEV_DISTANCE, "超声波距离") != 0 ||
+            parse_int(c, tokens[3], "距离", 2, 400, &value) != 0) {
+            return -1;
+        }
+        if ((insn = emit(c, PROGRAM_OP_IF_DISTANCE)) == NULL) return -1;
+        insn->arg = strcmp(tokens[2], ">") == 0;
+        insn->a = (int32_t)value;
+        return push_block(c, BLOCK_IF, c->prog->count - 1);
+    }
+    if (strcmp(cmd, "else") == 0) {
+        if (count != 1) return compile_error(c, "else后面不能有参数");
+        if (c->depth == 0 || c->blocks[c->depth - 1].type != BLOCK_IF) return compile_error(c, "else没有对应的if");
+        if ((insn = emit(c, PROGRAM_OP_JUMP)) == NULL) return -1;
+        block_t *block = &c->blocks[c->depth - 1];
+        c->prog->insns[block->index].target = (uint16_t)c->prog->count;
+        block->type = BLOCK_ELSE;
+        block->index = c->prog->count - 1;
+        return 0;
+    }
+    if (strcmp(cmd, "end") == 0) {
+        if (count != 1) return compile_error(c, "end后面不能有参数");
+        return compile_end(c);
+    }
+    return compile_error(c, "未知语句: %s", cmd);
+}
+
+int motion_program_compile(const char *src, size_t len, motion_program_t *prog, char *err, size_t err_size)
+{
+    compiler_t c;
+    size_t pos = 0;
+
+    memset(prog, 0, sizeof(*prog));
+    memset(&c, 0, sizeof(c));
+    c.prog = prog;
+    c.line = 1;
+    c.err = err;
+    c.err_size = err_size;
+    if (err_size > 0) err[0] = '\0';
+
+    while (pos < len) {
+        char tokens[PROGRAM_MAX_TOKENS][PROGRAM_TOKEN_SIZE];
+        int count = 0;
+        int line = c.line;
+
+        // 读取一条语句：到换行或';'为止，'#'之后到行尾为注释
+        while (pos < len && src[pos] != '\n' && src[pos] != ';') {
+            char ch = src[pos];
+            if (ch == '#') {
+                while (pos < len && src[pos] != '\n') pos++;
+                break;
+            }
+            if (ch == ' ' || ch == '\t' || ch == '\r') {
+                pos++;
+                continue;
+            }
+            size_t start = pos;
+            while (pos < len && strchr(" \t\r\n;#", src[pos]) == NULL) pos++;
+            size_t n = pos - start;
+            if (count >= PROGRAM_MAX_TOKENS) return compile_error(&c, "参数过多");
+            if (n >= PROGRAM_TOKEN_SIZE) return compile_error(&c, "参数过长");
+            memcpy(tokens[count], src + start, n);
+            tokens[count][n] = '\0';
+            count++;
+        }
+        if (pos < len && src[pos] == '\n') c.line++;
+        pos++;
+
+        if (count == 0) continue;
+        int next_line = c.line;
+        c.line = line;
+        if (compile_statement(&c, tokens, count) != 0) return -1;
+        c.line = next_line;
+    }
+
+    if (c.depth > 0) {
+        block_t *block = &c.blocks[c.depth - 1];
+        c.line = block->line;
+        return compile_error(&c, "%s缺少end", block->type == BLOCK_LOOP ? "loop" : "if");
+    }
+    if (prog->count == 0) {
+        c.line = 1;
+        return compile_error(&c, "程序为空");
+    }
+    return 0;
+}
+
+// ---------------- 执行 ----------------
+
+static uint64_t ns_add_ms(uint64_t ns, uint32_t ms)
+{
+    return ns + (uint64_t)ms * 1000000ULL;
+}
+
+// 初始化程序用到的设备 (在开始计时之前)，失败时返回错误信息
+static const char *prepare_devices(unsigned int devices)
+{
+    if ((devices & PROGRAM_DEV_RGB) && !(g_ready & PROGRAM_DEV_RGB)) {
+        rgb_init();
+        g_ready |= PROGRAM_DEV_RGB;
+    }
+    if ((devices & PROGRAM_DEV_SERVO) && !(g_ready & PROGRAM_DEV_SERVO)) {
+        // 不调用servo_init (会阻塞1秒等待舵机回中，失败时退出进程)
+        if (softPwmCreate(SERVO_PIN, 0, SERVO_PWM_RANGE) != 0) return "舵机软件PWM创建失败";
+        g_ready = (g_ready & ~PROGRAM_DEV_BEEP) | PROGRAM_DEV_SERVO;
+    }
+    if ((devices & PROGRAM_DEV_BEEP) && !(g_ready & PROGRAM_DEV_BEEP)) {
+        // GPIO18由舵机的软件PWM占用时先停止PWM
+        if (g_ready & PROGRAM_DEV_SERVO) softPwmStop(SERVO_PIN);
+        beep_init();
+        g_ready = (g_ready & ~PROGRAM_DEV_SERVO) | PROGRAM_DEV_BEEP;
+    }
+    return NULL;
+}
+
+// 读取前方距离，读数无效或过旧时返回-1
+static int read_distance(uint64_t now)
+{
+    sensor_reading_t reading;
+
+    sensor_cache_get(&reading);
+    if (!(reading.valid & SENSOR_VALID_DISTANCE)) return -1;
+    if (now - reading.distance_ns > (uint64_t)PROGRAM_DISTANCE_STALE_MS * 1000000ULL) return -1;
+    return reading.distance_cm;
+}
+
+// 执行一条动作指令 (调用时持有g_lock)
+static void execute(const program_insn_t *insn)
+{
+    switch (insn->op) {
+        case PROGRAM_OP_MOVE:
+            if (insn->a > 0) {
+                control_motion(MOTION_FORWARD, insn->a, 0);
+            } else if (insn->a < 0) {
+                control_motion(MOTION_BACKWARD, -insn->a, 0);
+            } else {
+                control_motion(MOTION_STOP, 0, 0);
+            }
+            break;
+        case PROGRAM_OP_TURN:
+            // 时长由解释器计时 (持续命令，下一步直接接替)，到期不会先停车再执行下一步
+            control_motion(insn->arg ? MOTION_RIGHT : MOTION_LEFT, insn->a, 0);
+            break;
+        case PROGRAM_OP_STOP:
+            control_motion(MOTION_STOP, 0, 0);
+            break;
+        case PROGRAM_OP_RGB:
+            set_rgb(insn->a & 1, (insn->a >> 1) & 1, (insn->a >> 2) & 1);
+            break;
+        case PROGRAM_OP_BEEP:
+            if (insn->a) {
+                beep_on();
+            } else {
+                beep_off();
+            }
+            break;
+        case PROGRAM_OP_SERVO:
+            servo_set_angle(insn->a);
+            break;
+        default:
+            break;
+    }
+}
+
+// 等待到截止时间，被停止时提前返回 (调用时持有g_lock)
+static void wait_until(uint64_t deadline)
+{
+    struct timespec ts;
+
+    ts.tv_sec = deadline / 1000000000ULL;
+    ts.tv_nsec = deadline % 1000000000ULL;
+    while (!g_abort && motion_now_ns() < deadline) {
+        pthread_cond_timedwait(&g_cond, &g_lock, &ts);
+    }
+}
+
+static void finish(program_state_t state, const char *error)
+{
+    g_status.state = state;
+    g_status.end_ns = motion_now_ns();
+    if (error != NULL && g_status.error[0] == '\0') {
+        snprintf(g_status.error, sizeof(g_status.error), "%s", error);
+    }
+}
+
+static void *program_thread(void *arg)
+{
+    const motion_program_t *prog = &g_prog;
+    uint32_t loops[PROGRAM_MAX_DEPTH];
+    int depth = 0;
+    int pc = 0;
+
+    (void)arg;
+    const char *error = prepare_devices(prog->devices);
+
+    pthread_mutex_lock(&g_lock);
+    uint64_t deadline = motion_now_ns();
+    g_status.start_ns = deadline;
+    if (error != NULL) {
+        finish(PROGRAM_FAILED, error);
+        goto out;
+    }
+
+    while (pc < prog->count && !g_abort) {
+        const program_insn_t *insn = &prog->insns[pc];
+        int next = pc + 1;
+
+        g_status.pc = pc;
+        g_status.line = insn->line;
+        g_status.steps++;
+
+        switch (insn->op) {
+            case PROGRAM_OP_LOOP:
+                loops[depth++] = (uint32_t)insn->a;
+                break;
+            case PROGRAM_OP_NEXT:
+                // 计数为0表示一直重复
+                if (loops[depth - 1] == 0 || --loops[depth - 1] > 0) {
+                    next = insn->target;
+                } else {
+                    depth--;
+                }
+                break;
+            case PROGRAM_OP_JUMP:
+                next = insn->target;
+                break;
+            case PROGRAM_OP_IF_DISTANCE: {
+                int distance = read_distance(motion_now_ns());
+                if (distance < 0) {
+                    finish(PROGRAM_FAILED, "距离读数无效");
+                    goto out;
+                }
+                int hit = insn->arg ? distance > insn->a : distance < insn->a;
+                if (!hit) next = insn->target;
+                break;
+            }
+            default:
+                // 持有锁执行：停止请求返回后不会再有程序发出的动作覆盖手动命令
+                execute(insn);
+                break;
+        }
+
+        // 定时步骤从上一步的截止时间开始计时
+        if (insn->ms > 0) {
+            deadline = ns_add_ms(deadline, insn->ms);
+            wait_until(deadline);
+            if (g_abort) break;
+            uint64_t late = motion_now_ns() - deadline;
+            g_status.timed_steps++;
+            g_status.late_total_ns += late;
+            if (late > g_status.late_max_ns) g_status.late_max_ns = late;
+        }
+        pc = next;
+    }
+
+    if (g_abort) {
+        finish(PROGRAM_STOPPED, "已停止");
+    } else {
+        finish(PROGRAM_DONE, NULL);
+    }
+
+out:
+    g_status.pc = pc;
+    int takeover = (g_abort == PROGRAM_ABORT_TAKEOVER);
+    pthread_mutex_unlock(&g_lock);
+
+    // 结束时停车 (手动命令接管时由手动命令决定) 并关闭蜂鸣器
+    if (!takeover) control_stop();
+    if (prog->devices & PROGRAM_DEV_BEEP) beep_off();
+    if (g_finish_hook != NULL) g_finish_hook();
+    __atomic_store_n(&g_active, 0, __ATOMIC_RELEASE);
+
+    log_info("运动程序 #%u %s: %lu 步, 定时误差最大 %.1fus%s%s", g_status.run_id,
+           motion_program_state_name(g_status.state), g_status.steps, g_status.late_max_ns / 1000.0,
+           g_status.error[0] ? ", " : "", g_status.error);
+    return NULL;
+}
+
+void motion_program_init(unsigned int devices)
+{
+    g_devices = devices;
+}
+
+void motion_program_set_finish_hook(motion_program_hook_t hook)
+{
+    g_finish_hook = hook;
+}
+
+int motion_program_start(const motion_program_t *prog)
+{
+    pthread_mutex_lock(&g_lock);
+    if (!g_cond_ready) {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&g_cond, &attr);
+        pthread_condattr_destroy(&attr);
+        g_cond_ready = 1;
+    }
+    if (__atomic_load_n(&g_active, __ATOMIC_ACQUIRE)) {
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    // 上一个执行线程已经结束，回收它
+    if (g_thread_valid) {
+        pthread_join(g_thread, NULL);
+        g_thread_valid = 0;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    g_prog = *prog;
+    uint32_t run_id = g_status.run_id + 1;
+    memset(&g_status, 0, sizeof(g_status));
+    g_status.state = PROGRAM_RUNNING;
+    g_status.run_id = run_id;
+    g_status.count = prog->count;
+    g_status.line = prog->insns[0].line;
+    g_abort = PROGRAM_ABORT_NONE;
+    __atomic_store_n(&g_active, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&g_thread, NULL, program_thread, NULL) != 0) {
+        finish(PROGRAM_FAILED, "无法创建执行线程");
+        __atomic_store_n(&g_active, 0, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    g_thread_valid = 1;
+    pthread_mutex_unlock(&g_lock);
+
+    log_info("运动程序 #%u 开始执行 (%d 条指令)", run_id, prog->count);
+    return 0;
+}
+
+static void request_abort(int mode, const char *reason)
+{
+    if (!__atomic_load_n(&g_active, __ATOMIC_ACQUIRE)) return;
+
+    pthread_mutex_lock(&g_lock);
+    if (g_status.state == PROGRAM_RUNNING && g_abort == PROGRAM_ABORT_NONE) {
+        g_abort = mode;
+        if (reason != NULL) snprintf(g_status.error, sizeof(g_status.error), "%s", reason);
+        pthread_cond_signal(&g_cond);
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+void motion_program_abort(const char *reason)
+{
+    request_abort(PROGRAM_ABORT_STOP, reason);
+}
+
+void motion_program_takeover(const char *reason)
+{
+    request_abort(PROGRAM_ABORT_TAKEOVER, reason);
+}
+
+int motion_program_running(void)
+{
+    return __atomic_load_n(&g_active, __ATOMIC_ACQUIRE);
+}
+
+motion_program_status_t motion_program_get_status(void)
+{
+    motion_program_status_t status;
+
+    pthread_mutex_lock(&g_lock);
+    status = g_status;
+    pthread_mutex_unlock(&g_lock);
+    return status;
+}
+
+const char *motion_program_state_name(program_state_t state)
+{
+    switch (state) {
+        case PROGRAM_IDLE: return "idle";
+        case PROGRAM_RUNNING: return "running";
+        case PROGRAM_DONE: return "done";
+        case PROGRAM_STOPPED: return "stopped";
+        case PROGRAM_FAILED: return "failed";
+    }
+    return "unknown";
+}
+
+void motion_program_close(void)
+{
+    motion_program_abort("服务器退出");
+    if (g_thread_valid) {
+        pthread_join(g_thread, NULL);
+        g_thread_valid = 0;
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef MOTION_PROGRAM_H
+#define MOTION_PROGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 运动程序解释器
+// 客户端一次上传整段动作脚本，在小车上编译校验为指令表后由独立线程按本地时钟执行，
+// 各步骤之间不再经过网络，定时步骤按绝对截止时间衔接 (上一步的截止时间 + 本步时长)，误差不累积。
+//
+// 脚本每行 (或用';'分隔) 一条语句，'#'之后为注释：
+//   move <速度> [毫秒]            前进 (速度为负数时后退，0停车)，指定毫秒时保持该时长
+//   turn left|right <速度> [毫秒] 转向
+//   stop                          停车
+//   wait <毫秒>                   保持当前动作
+//   rgb <红> <绿> <蓝>             RGB灯 (0/1)
+//   beep <毫秒>                   蜂鸣器响指定时长
+//   servo <角度>                  舵机角度 (0~180)
+//   loop [次数] ... end           重复执行，省略次数时一直重复直到停止
+//   if distance <|> <厘米> ... [else ...] end   按前方距离选择分支
+// 程序结束、出错或被停止时停车。
+
+#define PROGRAM_MAX_INSNS    128
+#define PROGRAM_MAX_DEPTH    8      // loop/if嵌套层数
+#define PROGRAM_MAX_MS       60000  // 单步时长上限
+#define PROGRAM_MAX_LOOPS    10000  // 循环次数上限
+#define PROGRAM_ERROR_SIZE   96
+
+// 可用的设备 (与电机接线冲突的设备不可用，使用它们的程序在校验时被拒绝)
+#define PROGRAM_DEV_RGB       0x01
+#define PROGRAM_DEV_BEEP      0x02
+#define PROGRAM_DEV_SERVO     0x04
+#define PROGRAM_DEV_DISTANCE  0x08
+
+typedef enum {
+    PROGRAM_OP_MOVE = 0,           // a=速度 (负数后退)
+    PROGRAM_OP_TURN,               // arg=0左/1右, a=速度
+    PROGRAM_OP_STOP,
+    PROGRAM_OP_WAIT,               // ms=时长
+    PROGRAM_OP_RGB,                // a=bit0红 bit1绿 bit2蓝
+    PROGRAM_OP_BEEP,               // a=1开/0关
+    PROGRAM_OP_SERVO,              // a=角度
+    PROGRAM_OP_LOOP,               // a=次数 (0表示一直重复)，target=循环结束后的指令
+    PROGRAM_OP_NEXT,               // 循环体结束，target=循环体第一条指令
+    PROGRAM_OP_IF_DISTANCE,        // arg=0小于/1大于, a=厘米，条件不成立时跳到target
+    PROGRAM_OP_JUMP                // else分支之前跳过else部分
+} program_op_t;
+
+// 一条指令 (编译后的脚本语句)
+typedef struct {
+    uint8_t op;                    // program_op_t
+    uint8_t arg;
+    uint16_t line;                 // 脚本行号 (状态报告用)
+    int32_t a;
+    uint32_t ms;                   // 执行后保持的时长
+    uint16_t target;               // 跳转目标
+} program_insn_t;
+
+typedef struct {
+    program_insn_t insns[PROGRAM_MAX_INSNS];
+    int count;
+    unsigned int devices;          // 程序用到的设备 (PROGRAM_DEV_*)
+} motion_program_t;
+
+typedef enum {
+    PROGRAM_IDLE = 0,
+    PROGRAM_RUNNING,
+    PROGRAM_DONE,                  // 正常结束
+    PROGRAM_STOPPED,               // 被停止 (停止请求或手动命令接管)
+    PROGRAM_FAILED                 // 运行时错误 (如距离读数无效)
+} program_state_t;
+
+// 执行状态
+typedef struct {
+    program_state_t state;
+    uint32_t run_id;               // 每次启动加1
+    int pc;                        // 当前指令
+    int line;                      // 当前指令的脚本行号
+    int count;                     // 指令数
+    unsigned long steps;           // 已执行的指令数
+    uint64_t start_ns;
+    uint64_t end_ns;               // 结束时间，运行中为0
+    uint64_t late_max_ns;          // 定时步骤实际开始时间晚于截止时间的最大值
+    uint64_t late_total_ns;
+    unsigned long timed_steps;
+    char error[PROGRAM_ERROR_SIZE];
+} motion_program_status_t;
+
+// 设置可用设备 (启动前调用)
+void motion_program_init(unsigned int devices);
+
+// 编译并校验脚本：成功返回0；失败返回-1，err中为带行号的错误信息
+int motion_program_compile(const char *src, size_t len, motion_program_t *prog, char *err, size_t err_size);
+
+// 启动执行 (立即返回)：已有程序在运行时返回-1
+int motion_program_start(const motion_program_t *prog);
+
+// 请求停止正在运行的程序 (立即返回，执行线程停车后退出)，reason写入状态
+void motion_program_abort(const char *reason);
+// 手动命令接管：停止程序但不停车 (调用者随后发出自己的运动命令)，调用返回后程序不会再发出动作
+void motion_program_takeover(const char *reason);
+int motion_program_running(void);
+motion_program_status_t motion_program_get_status(void);
+const char *motion_program_state_name(program_state_t state);
+
+// 程序结束 (执行线程不再发出动作) 时在执行线程中调用，之后才能启动下一个程序
+typedef void (*motion_program_hook_t)(void);
+void motion_program_set_finish_hook(motion_program_hook_t hook);
+
+// 停止程序并等待执行线程退出
+void motion_program_close(void);
+
+#endif // MOTION_PROGRAM_H
@@ -0,0 +1,192 @@
+#include <pthread.h>
+#include "motor.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
+
+// 当前引脚映射和占空比
+static motor_pinmap_t g_map = MOTOR_PINMAP_HBRIDGE;
+static int g_initialized = 0;
+static int g_duty_left = 0;
+static int g_duty_right = 0;
+
+// 最近一次写入各引脚的PWM值，未变化的引脚不重复写入
+static int g_pwm_cache[4] = {0, 0, 0, 0};
+
+// 批量更新锁：保证四个引脚作为一个整体更新
+static pthread_mutex_t g_motor_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static metric_t m_pwm_writes = METRIC_COUNTER("rpi_pwm_writes_total", "device=\"motor\"", "软件PWM占空比的写入次数 (电机跳过值未变化的写入，舵机每次设置都写入)");
+
+static int motor_clamp(int value, int limit)
+{
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+// 占空比百分比转换为PWM值
+static int motor_duty_to_pwm(int duty)
+{
+    return duty * g_map.pwm_range / 100;
+}
+
+static void motor_init_pin(int pin)
+{
+    if (pin == MOTOR_PIN_NONE) return;
+
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    if (softPwmCreate(pin, 0, g_map.pwm_range) != 0) {
+        log_error("电机: GPIO %d 软件PWM创建失败", pin);
+    }
+}
+
+static void motor_write_pin(int index, int pin, int value)
+{
+    if (pin == MOTOR_PIN_NONE || g_pwm_cache[index] == value) return;
+
+    TRACE_BEGIN("pwm", "motor_pwm_write");
+    softPwmWrite(pin, value);
+    TRACE_END("pwm", "motor_pwm_write");
+    g_pwm_cache[index] = value;
+    metric_inc(&m_pwm_writes);
+}
+
+// 计算单个轮子两个引脚的PWM值
+static void motor_wheel_pwm(int duty, int invert, int has_rev, int *fwd, int *rev)
+{
+    if (invert) duty = -duty;
+
+    if (duty >= 0) {
+        *fwd = motor_duty_to_pwm(duty);
+        *rev = 0;
+    } else if (has_rev) {
+        *fwd = 0;
+        *rev = motor_duty_to_pwm(-duty);
+    } else {
+        // 单引脚驱动无法反转，停止该轮
+        *fwd = 0;
+        *rev = 0;
+    }
+}
+
+// 初始化电机驱动
+int motor_init(const motor_pinmap_t *map)
+{
+    if (map != NULL) {
+        g_map = *map;
+    }
+    if (g_map.pwm_range <= 0) {
+        g_map.pwm_range = MOTOR_PWM_RANGE;
+    }
+
+    motor_init_pin(g_map.left_fwd);
+    motor_init_pin(g_map.left_rev);
+    motor_init_pin(g_map.right_fwd);
+    motor_init_pin(g_map.right_rev);
+
+    pthread_mutex_lock(&g_motor_lock);
+    for (int i = 0; i < 4; i++) {
+        g_pwm_cache[i] = 0;
+    }
+    g_duty_left = 0;
+    g_duty_right = 0;
+    g_initialized = 1;
+    pthread_mutex_unlock(&g_motor_lock);
+
+    log_info("电机驱动初始化完成 (左轮 %d/%d 右轮 %d/%d)",
+           g_map.left_fwd, g_map.left_rev, g_map.right_fwd, g_map.right_rev);
+    return 0;
+}
+
+// 停止并释放引脚
+void motor_cleanup(void)
+{
+    int pins[4] = {g_map.left_fwd, g_map.left_rev, g_map.right_fwd, g_map.right_rev};
+
+    motor_set_duty(0, 0);
+
+    pthread_mutex_lock(&g_motor_lock);
+    for (int i = 0; i < 4; i++) {
+        if (pins[i] == MOTOR_PIN_NONE) continue;
+        digitalWrite(pins[i], LOW);
+        pinMode(pins[i], INPUT);
+    }
+    g_initialized = 0;
+    pthread_mutex_unlock(&g_motor_lock);
+
+    log_info("电机驱动清理完成");
+}
+
+const motor_pinmap_t *motor_get_pinmap(void)
+{
+    return &g_map;
+}
+
+// 设置两轮占空比：先计算全部引脚的值，再在一次加锁中写入
+void motor_set_duty(int left, int right)
+{
+    int pwm[4];
+
+    left = motor_clamp(left, 100);
+    right = motor_clamp(right, 100);
+
+    motor_wheel_pwm(left, g_map.left_invert, g_map.left_rev != MOTOR_PIN_NONE, &pwm[0], &pwm[1]);
+    motor_wheel_pwm(right, g_map.right_invert, g_map.right_rev != MOTOR_PIN_NONE, &pwm[2], &pwm[3]);
+
+    pthread_mutex_lock(&g_motor_lock);
+    if (g_initialized) {
+        // 先关闭反向引脚再打开正向引脚，避免H桥两侧同时导通
+        if (pwm[0] == 0) motor_write_pin(0, g_map.left_fwd, 0);
+        if (pwm[1] == 0) motor_write_pin(1, g_map.left_rev, 0);
+        if (pwm[2] == 0) motor_write_pin(2, g_map.right_fwd, 0);
+        if (pwm[3] == 0) motor_write_pin(3, g_map.right_rev, 0);
+        motor_write_pin(0, g_map.left_fwd, pwm[0]);
+        motor_write_pin(1, g_map.left_rev, pwm[1]);
+        motor_write_pin(2, g_map.right_fwd, pwm[2]);
+        motor_write_pin(3, g_map.right_rev, pwm[3]);
+    }
+    g_duty_left = left;
+    g_duty_right = right;
+    pthread_mutex_unlock(&g_motor_lock);
+}
+
+void motor_get_duty(int *left, int *right)
+{
+    pthread_mutex_lock(&g_motor_lock);
+    *left = g_duty_left;
+    *right = g_duty_right;
+    pthread_mutex_unlock(&g_motor_lock);
+}
+
+// 差速运动学：左轮 = v - omega，右轮 = v + omega
+void motor_drive_to_duty(int v, int omega, int *left, int *right)
+{
+    int l, r, peak;
+
+    v = motor_clamp(v, 100);
+    omega = motor_clamp(omega, 100);
+
+    l = v - omega;
+    r = v + omega;
+
+    // 饱和时等比例缩小两轮，保持两轮速度比
+    peak = l < 0 ? -l : l;
+    if ((r < 0 ? -r : r) > peak) peak = r < 0 ? -r : r;
+    if (peak > 100) {
+        l = l * 100 / peak;
+        r = r * 100 / peak;
+    }
+
+    *left = l;
+    *right = r;
+}
+
+void motor_drive(int v, int omega)
+{
+    int left, right;
+
+    motor_drive_to_duty(v, omega, &left, &right);
+    motor_set_duty(left, right);
+}
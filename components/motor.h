@@ -0,0 +1,44 @@
+#ifndef MOTOR_H
+#define MOTOR_H
+
+#include <wiringPi.h>
+#include <softPwm.h>
+#include <stdio.h>
+
+// 未使用的引脚
+#define MOTOR_PIN_NONE -1
+
+// 默认PWM范围 (占空比百分比)
+#define MOTOR_PWM_RANGE 100
+
+// 电机引脚映射
+// 每个轮子一对H桥输入引脚：正转引脚输出PWM时反转引脚为0，反之亦然。
+// 反转引脚为MOTOR_PIN_NONE时为单引脚驱动，只能正转。
+typedef struct {
+    int left_fwd;      // 左轮正转引脚 (LP)
+    int left_rev;      // 左轮反转引脚 (LN)
+    int right_fwd;     // 右轮正转引脚 (RP)
+    int right_rev;     // 右轮反转引脚 (RN)
+    int pwm_range;     // 软件PWM范围
+    int left_invert;   // 左轮接线反向
+    int right_invert;  // 右轮接线反向
+} motor_pinmap_t;
+
+// H桥接线 (L298N等: LP/LN/RP/RN)
+#define MOTOR_PINMAP_HBRIDGE { 18, 23, 25, 12, MOTOR_PWM_RANGE, 0, 0 }
+
+// 初始化和清理
+int motor_init(const motor_pinmap_t *map);
+void motor_cleanup(void);
+const motor_pinmap_t *motor_get_pinmap(void);
+
+// 设置两轮占空比 (-100 ~ 100，负数为反转)，一次批量更新全部引脚
+void motor_set_duty(int left, int right);
+void motor_get_duty(int *left, int *right);
+
+// 差速驱动：v为线速度，omega为角速度 (正数左转)，范围均为-100 ~ 100
+// 两轮占空比超出范围时按比例缩小，保持转弯半径不变
+void motor_drive(int v, int omega);
+void motor_drive_to_duty(int v, int omega, int *left, int *right);
+
+#endif // MOTOR_H
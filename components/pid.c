@@ -0,0 +1,53 @@
+#include "pid.h"
+
+void pid_init(pid_ctrl_t *pid, float kp, float ki, float kd, float out_min, float out_max)
+{
+    pid->out_min = out_min;
+    pid->out_max = out_max;
+    pid_set_gains(pid, kp, ki, kd);
+    pid_reset(pid);
+}
+
+void pid_set_gains(pid_ctrl_t *pid, float kp, float ki, float kd)
+{
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+}
+
+void pid_reset(pid_ctrl_t *pid)
+{
+    pid->integral = 0.0f;
+    pid->prev_measured = 0.0f;
+    pid->first = 1;
+}
+
+// 计算一次控制输出
+float pid_update(pid_ctrl_t *pid, float setpoint, float measured, float dt)
+{
+    float error = setpoint - measured;
+    float derivative = 0.0f;
+    float output;
+
+    // 微分作用于测量值，避免目标突变时的微分冲击
+    if (!pid->first && dt > 0) {
+        derivative = -(measured - pid->prev_measured) / dt;
+    }
+    pid->prev_measured = measured;
+    pid->first = 0;
+
+    output = pid->kp * error + pid->integral + pid->kd * derivative;
+
+    // 输出未饱和或误差使输出退出饱和时才累加积分
+    if ((output < pid->out_max || error < 0) && (output > pid->out_min || error > 0)) {
+        pid->integral += pid->ki * error * dt;
+        if (pid->integral > pid->out_max) pid->integral = pid->out_max;
+        if (pid->integral < pid->out_min) pid->integral = pid->out_min;
+    }
+
+    output = pid->kp * error + pid->integral + pid->kd * derivative;
+    if (output > pid->out_max) output = pid->out_max;
+    if (output < pid->out_min) output = pid->out_min;
+
+    return output;
+}
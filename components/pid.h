@@ -0,0 +1,22 @@
+#ifndef PID_H
+#define PID_H
+
+// PID控制器 (微分作用于测量值，积分带抗饱和)
+typedef struct {
+    float kp;
+    float ki;
+    float kd;
+    float integral;
+    float prev_measured;
+    float out_min;
+    float out_max;
+    int first;
+} pid_ctrl_t;
+
+// 函数声明
+void pid_init(pid_ctrl_t *pid, float kp, float ki, float kd, float out_min, float out_max);
+void pid_set_gains(pid_ctrl_t *pid, float kp, float ki, float kd);
+void pid_reset(pid_ctrl_t *pid);
+float pid_update(pid_ctrl_t *pid, float setpoint, float measured, float dt);
+
+#endif // PID_H
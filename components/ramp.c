@@ -0,0 +1,75 @@
+#include "ramp.h"
+
+// 四舍五入到整数百分比
+static int ramp_round(float value)
+{
+    return (int)(value >= 0 ? value + 0.5f : value - 0.5f);
+}
+
+// 单轮向目标逼近一个节拍，返回1表示尚未到达
+static int ramp_approach(float *current, int target, float step)
+{
+    float diff = (float)target - *current;
+
+    if (diff > step) {
+        *current += step;
+        return 1;
+    }
+    if (diff < -step) {
+        *current -= step;
+        return 1;
+    }
+    *current = (float)target;
+    return 0;
+}
+
+// 配置节拍频率和最大变化率
+void ramp_config(speed_ramp_t *ramp, int tick_hz, float slew_rate)
+{
+    if (tick_hz < 1) tick_hz = 1;
+    if (tick_hz > RAMP_MAX_TICK_HZ) tick_hz = RAMP_MAX_TICK_HZ;
+    if (slew_rate <= 0) slew_rate = RAMP_DEFAULT_SLEW;
+
+    ramp->tick_hz = tick_hz;
+    ramp->slew_rate = slew_rate;
+    ramp->step = slew_rate / tick_hz;
+}
+
+// 以当前实际速度作为斜坡起点
+void ramp_reset(speed_ramp_t *ramp, int left, int right)
+{
+    ramp->current[0] = (float)left;
+    ramp->current[1] = (float)right;
+    ramp->target[0] = left;
+    ramp->target[1] = right;
+    ramp->active = 0;
+}
+
+// 设置新目标：保留当前输出，正在进行的斜坡直接转向新目标
+void ramp_set_target(speed_ramp_t *ramp, int left, int right)
+{
+    ramp->target[0] = left;
+    ramp->target[1] = right;
+    ramp->active = 1;
+}
+
+// 推进一个节拍，返回1表示尚未到达目标
+int ramp_step(speed_ramp_t *ramp)
+{
+    int left_busy, right_busy;
+
+    if (!ramp->active) return 0;
+
+    left_busy = ramp_approach(&ramp->current[0], ramp->target[0], ramp->step);
+    right_busy = ramp_approach(&ramp->current[1], ramp->target[1], ramp->step);
+    ramp->active = left_busy || right_busy;
+
+    return ramp->active;
+}
+
+// 获取当前输出速度
+void ramp_output(const speed_ramp_t *ramp, int *left, int *right)
+{
+    *left = ramp_round(ramp->current[0]);
+    *right = ramp_round(ramp->current[1]);
+}
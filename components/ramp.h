@@ -0,0 +1,26 @@
+#ifndef RAMP_H
+#define RAMP_H
+
+// 斜坡默认参数
+#define RAMP_DEFAULT_TICK_HZ 50    // 节拍频率 (Hz)
+#define RAMP_DEFAULT_SLEW    25.0f // 最大变化率 (%/秒)
+#define RAMP_MAX_TICK_HZ     1000
+
+// 双轮速度斜坡发生器 (纯计算，由运动执行线程按节拍驱动)
+typedef struct {
+    float current[2];   // 当前输出速度 (左, 右)
+    int target[2];      // 目标速度 (左, 右)
+    float step;         // 每个节拍允许的最大变化量
+    int tick_hz;        // 节拍频率
+    float slew_rate;    // 最大变化率 (%/秒)
+    int active;         // 是否尚未到达目标
+} speed_ramp_t;
+
+// 函数声明
+void ramp_config(speed_ramp_t *ramp, int tick_hz, float slew_rate);
+void ramp_reset(speed_ramp_t *ramp, int left, int right);
+void ramp_set_target(speed_ramp_t *ramp, int left, int right);
+int ramp_step(speed_ramp_t *ramp);
+void ramp_output(const speed_ramp_t *ramp, int *left, int *right);
+
+#endif // RAMP_H
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "recorder.h"
+#include "logger.h"
+
+// 环形缓冲区 (由g_lock保护)，后台线程整批取出后写入文件
+static recorder_event_t g_ring[RECORDER_RING_SIZE];
+static uint32_t g_head = 0;
+static uint32_t g_tail = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t g_thread;
+static volatile int g_running = 0;
+static int g_enabled = 0;          // 记录函数的开关 (原子读写)
+static int g_fd = -1;
+static uint64_t g_start_ns = 0;
+static recorder_sample_t g_sample = NULL;
+static recorder_stats_t g_stats;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int16_t clamp16(int v)
+{
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+void recorder_log(recorder_type_t type, int motion, int source, int left, int right, int value)
+{
+    if (!__atomic_load_n(&g_enabled, __ATOMIC_ACQUIRE)) return;
+
+    recorder_event_t ev;
+    ev.type = (uint8_t)type;
+    ev.motion = (uint8_t)motion;
+    ev.source = clamp16(source);
+    ev.left = clamp16(left);
+    ev.right = clamp16(right);
+    ev.value = value;
+    ev.reserved = 0;
+
+    // 时间戳在锁内获取，文件中的事件按时间排序
+    pthread_mutex_lock(&g_lock);
+    ev.t_ns = now_ns() - g_start_ns;
+    if (g_tail - g_head >= RECORDER_RING_SIZE) {
+        g_stats.dropped++;
+    } else {
+        g_ring[g_tail % RECORDER_RING_SIZE] = ev;
+        g_tail++;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+// 取出缓冲区中的事件写入文件 (只在记录线程和停止时调用)
+static void flush_events(void)
+{
+    static recorder_event_t batch[RECORDER_RING_SIZE];
+    uint32_t n = 0;
+
+    pthread_mutex_lock(&g_lock);
+    while (g_head != g_tail) {
+        batch[n++] = g_ring[g_head % RECORDER_RING_SIZE];
+        g_head++;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    if (n == 0) return;
+    size_t len = n * sizeof(recorder_event_t);
+    if (write(g_fd, batch, len) != (ssize_t)len) {
+        log_error("记录文件写入失败");
+        return;
+    }
+    __atomic_fetch_add(&g_stats.events, n, __ATOMIC_RELAXED);
+}
+
+static void *recorder_thread(void *arg)
+{
+    (void)arg;
+    while (g_running) {
+        sleep_ms(RECORDER_FLUSH_MS);
+        if (g_sample != NULL) g_sample();
+        flush_events();
+    }
+    return NULL;
+}
+
+int recorder_start(const char *path, recorder_sample_t sample)
+{
+    if (g_running) return 0;
+
+    g_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (g_fd < 0) {
+        log_error("无法创建记录文件 %s", path);
+        return -1;
+    }
+
+    recorder_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = RECORDER_MAGIC;
+    header.version = RECORDER_VERSION;
+    header.event_size = sizeof(recorder_event_t);
+    header.start_ns = now_ns();
+    if (write(g_fd, &header, sizeof(header)) != sizeof(header)) {
+        log_error("记录文件写入失败");
+        close(g_fd);
+        g_fd = -1;
+        return -1;
+    }
+
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_head = g_tail = 0;
+    g_start_ns = header.start_ns;
+    g_sample = sample;
+    g_running = 1;
+    if (pthread_create(&g_thread, NULL, recorder_thread, NULL) != 0) {
+        log_error("记录线程创建失败");
+        g_running = 0;
+        close(g_fd);
+        g_fd = -1;
+        return -1;
+    }
+    __atomic_store_n(&g_enabled, 1, __ATOMIC_RELEASE);
+
+    log_info("正在记录控制路径到 %s", path);
+    return 0;
+}
+
+void recorder_stop(void)
+{
+    if (!g_running) return;
+
+    __atomic_store_n(&g_enabled, 0, __ATOMIC_RELEASE);
+    g_running = 0;
+    pthread_join(g_thread, NULL);
+    flush_events();
+    close(g_fd);
+    g_fd = -1;
+}
+
+int recorder_is_running(void)
+{
+    return g_running;
+}
+
+uint64_t recorder_start_ns(void)
+{
+    return g_start_ns;
+}
+
+recorder_stats_t recorder_get_stats(void)
+{
+    recorder_stats_t stats;
+
+    pthread_mutex_lock(&g_lock);
+    stats.dropped = g_stats.dropped;
+    pthread_mutex_unlock(&g_lock);
+    stats.events = __atomic_load_n(&g_stats.events, __ATOMIC_RELAXED);
+    return stats;
+}
+
+int recorder_format_stats(char *buf, int size)
+{
+    recorder_stats_t stats = recorder_get_stats();
+    int len = snprintf(buf, size, "rec_events=%lu rec_dropped=%lu", stats.events, stats.dropped);
+    if (len >= size) len = size - 1;
+    return len;
+}
+
+recorder_event_t *recorder_load(const char *path, recorder_header_t *header, int *count)
+{
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        log_error("无法打开记录文件 %s", path);
+        return NULL;
+    }
+    if (fread(header, sizeof(*header), 1, fp) != 1 || header->magic != RECORDER_MAGIC ||
+        header->version != RECORDER_VERSION || header->event_size != sizeof(recorder_event_t)) {
+        log_error("%s 不是记录文件或版本不匹配", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long bytes = ftell(fp) - (long)sizeof(*header);
+    fseek(fp, sizeof(*header), SEEK_SET);
+
+    // 末尾不完整的事件 (记录进程异常退出) 忽略
+    int n = (int)(bytes / (long)sizeof(recorder_event_t));
+    recorder_event_t *events = malloc((n > 0 ? n : 1) * sizeof(recorder_event_t));
+    if (events == NULL || (n > 0 && fread(events, sizeof(recorder_event_t), n, fp) != (size_t)n)) {
+        log_error("读取记录文件 %s 失败", path);
+        free(events);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *count = n;
+    return events;
+}
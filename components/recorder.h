@@ -0,0 +1,75 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+
+// 控制路径记录 (记录和回放，见bench/replay.c)
+// 启用后把收到的运动命令、运动执行器的输入、写入PWM的轮速和传感器读数按单调时钟时间戳
+// 追加到二进制日志。记录函数只把事件放入内存环形缓冲区，由后台线程定期写入文件，
+// 不在控制路径上做I/O；缓冲区满时丢弃事件并计数，不阻塞调用者。未启用时记录函数立即返回。
+//
+// 日志格式：recorder_header_t之后是连续的recorder_event_t (都是小端固定大小)。
+
+#define RECORDER_MAGIC      0x31434552u   // "REC1"
+#define RECORDER_VERSION    1
+#define RECORDER_RING_SIZE  8192          // 2的幂
+#define RECORDER_FLUSH_MS   20            // 写入文件和调用采样函数的周期
+
+// 事件类型
+typedef enum {
+    REC_COMMAND = 1,   // 通道收到的运动命令：source=来源, motion=PROTO_MOTION_*, left=速度, right=转弯减速比例
+    REC_SUBMIT,        // 运动执行器输入 (motion_exec_submit)：value=持续时间(毫秒)
+    REC_RAMP,          // 运动执行器输入 (motion_exec_ramp)：left/right=目标速度
+    REC_STOP,          // 紧急停止
+    REC_WRITE,         // 写入PWM的轮速 (执行器输出)
+    REC_SENSOR         // 传感器读数：motion=SENSOR_VALID_*, left=距离cm, right=湿度x10, value=温度x10
+} recorder_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t event_size;           // sizeof(recorder_event_t)
+    uint32_t reserved;
+    uint64_t start_ns;             // 开始记录的时间 (CLOCK_MONOTONIC)
+    uint64_t reserved2;
+} recorder_header_t;
+
+typedef struct {
+    uint64_t t_ns;                 // 相对start_ns的时间
+    uint8_t type;                  // recorder_type_t
+    uint8_t motion;                // motion_type_t (REC_COMMAND为PROTO_MOTION_*)
+    int16_t source;
+    int16_t left;
+    int16_t right;
+    int32_t value;
+    uint32_t reserved;
+} recorder_event_t;
+
+_Static_assert(sizeof(recorder_header_t) == 32, "记录格式");
+_Static_assert(sizeof(recorder_event_t) == 24, "记录格式");
+
+typedef struct {
+    unsigned long events;          // 已写入文件的事件数
+    unsigned long dropped;         // 缓冲区满时丢弃的事件数
+} recorder_stats_t;
+
+// 记录线程每个周期调用一次 (如采样传感器缓存后调用recorder_log)
+typedef void (*recorder_sample_t)(void);
+
+// 开始记录到文件 (覆盖已有文件)，sample可以为NULL
+int recorder_start(const char *path, recorder_sample_t sample);
+// 停止记录，写入剩余事件并关闭文件
+void recorder_stop(void);
+int recorder_is_running(void);
+uint64_t recorder_start_ns(void);  // 事件时间戳的起点 (CLOCK_MONOTONIC)
+
+// 记录一个事件 (可在任意线程调用)
+void recorder_log(recorder_type_t type, int motion, int source, int left, int right, int value);
+
+recorder_stats_t recorder_get_stats(void);
+int recorder_format_stats(char *buf, int size);
+
+// 读取整个日志 (调用者free返回的数组)，失败返回NULL
+recorder_event_t *recorder_load(const char *path, recorder_header_t *header, int *count);
+
+#endif // RECORDER_H
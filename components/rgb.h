@@ -5,7 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <signal.h>
+#include "cancel.h"
 
 // 引脚定义
 #define R 16
@@ -17,11 +17,7 @@ void rgb_init(void);
 void rgb_sequence(void);
 void set_rgb(int red, int green, int blue);
 void rgb_set_color(int red, int green, int blue); // Web API兼容函数
-
-// 信号处理函数声明
-void rgb_signal_handler(int signal);
-void rgb_setup_signal_handlers(void);
+void rgb_get_state(int *red, int *green, int *blue); // 当前LED状态 (可在任意线程调用)
 void rgb_cleanup(void);
-int rgb_is_running(void);
 
 #endif // RGB_H
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include <wiringPi.h>
+#include "sensor_cache.h"
+#include "DHT.h"
+#include "usonic.h"
+#include "seqlock.h"
+#include "logger.h"
+
+static pthread_t g_thread;
+static volatile int g_running = 0;
+static unsigned int g_sensors = 0;
+
+// 采样线程是唯一写者
+static sensor_reading_t g_reading;
+static seqlock_t g_lock = SEQLOCK_INIT;
+static void (*g_notify)(void) = NULL;   // 原子读写
+
+// 与motion_now_ns相同的时钟，不依赖运动控制模块 (Web服务器不链接电机控制)
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ms(unsigned int ms)
+{
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void *sensor_cache_thread(void *arg)
+{
+    sensor_reading_t reading = g_reading;
+    uint64_t next_dht = 0;
+
+    (void)arg;
+    prctl(PR_SET_NAME, "sensor_cache");  // 追踪和top中显示的线程名
+
+    // DHT11上电后需要稳定1秒：第一次温湿度读取排在稳定之后，期间距离照常采样
+    if (g_sensors & SENSOR_CACHE_DHT) {
+        dht11_init();
+        next_dht = now_ns() + (uint64_t)dht11_settle_left_ms() * 1000000ULL;
+    }
+    if (g_sensors & SENSOR_CACHE_DISTANCE) usonic_init();
+
+    while (g_running) {
+        uint64_t now = now_ns();
+        int changed = 0;
+
+        if ((g_sensors & SENSOR_CACHE_DHT) && now >= next_dht) {
+            DHT11_Data data;
+            if (dht11_read_with_retry(&data, 1) == DHT_SUCCESS) {
+                reading.temperature = data.temperature;
+                reading.humidity = data.humidity;
+                reading.env_ns = now_ns();
+                reading.valid |= SENSOR_VALID_ENV;
+            } else {
+                reading.errors++;
+            }
+            next_dht = now + (uint64_t)SENSOR_DHT_PERIOD_MS * 1000000ULL;
+            changed = 1;
+        }
+
+        if (g_sensors & SENSOR_CACHE_DISTANCE) {
+            int cm = usonic_measure_cm(USONIC_TIMEOUT_US);
+            if (cm >= 0) {
+                reading.distance_cm = cm;
+                reading.distance_ns = now_ns();
+                reading.valid |= SENSOR_VALID_DISTANCE;
+            } else {
+                reading.errors++;
+            }
+            changed = 1;
+        }
+
+        if (changed) {
+            reading.seq++;
+            seqlock_write(&g_lock, &g_reading, &reading, sizeof(reading));
+            void (*notify)(void) = __atomic_load_n(&g_notify, __ATOMIC_ACQUIRE);
+            if (notify != NULL) notify();
+        }
+
+        sleep_ms((g_sensors & SENSOR_CACHE_DISTANCE) ? SENSOR_DISTANCE_PERIOD_MS : 200);
+    }
+    return NULL;
+}
+
+// 启动后台采样 (sensors为SENSOR_CACHE_*的组合)
+int sensor_cache_start(unsigned int sensors)
+{
+    if (g_running) return 0;
+    if (sensors == 0) return 0;
+
+    g_sensors = sensors;
+    g_running = 1;
+    if (pthread_create(&g_thread, NULL, sensor_cache_thread, NULL) != 0) {
+        log_error("传感器采样线程创建失败");
+        g_running = 0;
+        return -1;
+    }
+
+    log_info("传感器缓存已启动 (%s%s)",
+           (sensors & SENSOR_CACHE_DHT) ? "温湿度 " : "",
+           (sensors & SENSOR_CACHE_DISTANCE) ? "距离" : "");
+    return 0;
+}
+
+void sensor_cache_stop(void)
+{
+    if (!g_running) return;
+
+    g_running = 0;
+    pthread_join(g_thread, NULL);
+}
+
+int sensor_cache_is_running(void)
+{
+    return g_running;
+}
+
+void sensor_cache_get(sensor_reading_t *reading)
+{
+    seqlock_read(&g_lock, reading, &g_reading, sizeof(*reading));
+}
+
+void sensor_cache_set_notify(void (*notify)(void))
+{
+    __atomic_store_n(&g_notify, notify, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,44 @@
+#ifndef SENSOR_CACHE_H
+#define SENSOR_CACHE_H
+
+#include <stdint.h>
+
+// 传感器缓存
+// 后台线程按各传感器允许的频率采样DHT11和超声波，最新读数通过seqlock发布，
+// 网络服务等读者直接取缓存，不会在请求路径上等待传感器时序。
+
+// 需要采样的传感器
+#define SENSOR_CACHE_DHT       0x01
+#define SENSOR_CACHE_DISTANCE  0x02
+
+// 采样周期 (DHT11两次读取至少间隔1秒)
+#define SENSOR_DHT_PERIOD_MS       2000
+#define SENSOR_DISTANCE_PERIOD_MS  100
+
+// 读数有效标志：至少成功读取过一次，之后读取失败时保留上一次的值
+#define SENSOR_VALID_ENV       0x01
+#define SENSOR_VALID_DISTANCE  0x02
+
+// 传感器读数快照 (大小需为4字节的倍数)
+typedef struct {
+    float temperature;       // 温度 (°C)
+    float humidity;          // 湿度 (%)
+    int distance_cm;         // 前方距离 (cm)
+    uint32_t valid;          // SENSOR_VALID_*
+    uint32_t seq;            // 更新序号
+    uint32_t errors;         // 累计读取失败次数
+    uint64_t env_ns;         // 温湿度读取时间 (CLOCK_MONOTONIC)
+    uint64_t distance_ns;    // 距离读取时间
+} sensor_reading_t;
+
+int sensor_cache_start(unsigned int sensors);
+void sensor_cache_stop(void);
+int sensor_cache_is_running(void);
+
+// 获取最新读数 (无锁，可在任意线程调用)
+void sensor_cache_get(sensor_reading_t *reading);
+
+// 每次发布新读数后在采样线程中调用notify (只应做通知，不能阻塞)，NULL表示取消
+void sensor_cache_set_notify(void (*notify)(void));
+
+#endif // SENSOR_CACHE_H
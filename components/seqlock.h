@@ -0,0 +1,105 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 顺序锁 (seqlock)
+// 写者递增序号为奇数后写数据，写完再递增为偶数；读者读取前后序号一致且为偶数时数据有效，
+// 否则重试。读者从不阻塞写者，写者之间需要由调用者自行串行。
+// 被保护的数据按32位字用原子操作拷贝，大小必须是4的倍数并按4字节对齐。
+typedef struct {
+    uint32_t seq;
+} seqlock_t;
+
+#define SEQLOCK_INIT { 0 }
+
+static inline void seqlock_cpu_relax(void)
+{
+#if defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield" ::: "memory");
+#elif defined(__x86_64__) || defined(__i386__)
+    __asm__ __volatile__("pause" ::: "memory");
+#endif
+}
+
+// 读者：获取起始序号 (写入进行中时自旋等待)
+static inline uint32_t seqlock_read_begin(const seqlock_t *lock)
+{
+    uint32_t seq;
+
+    while ((seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE)) & 1) {
+        seqlock_cpu_relax();
+    }
+    return seq;
+}
+
+// 读者：数据读取完成后检查是否需要重试
+static inline int seqlock_read_retry(const seqlock_t *lock, uint32_t start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != start;
+}
+
+// 写者：开始写入
+static inline void seqlock_write_begin(seqlock_t *lock)
+{
+    uint32_t seq = __atomic_load_n(&lock->seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// 写者：结束写入
+static inline void seqlock_write_end(seqlock_t *lock)
+{
+    uint32_t seq = __atomic_load_n(&lock->seq, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&lock->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+// 按32位字原子拷贝，避免与并发读写构成数据竞争
+static inline void seqlock_copy_in(void *shared, const void *value, size_t size)
+{
+    uint32_t *dst = (uint32_t *)shared;
+    const uint32_t *src = (const uint32_t *)value;
+
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+        __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+    }
+}
+
+static inline void seqlock_copy_out(void *value, const void *shared, size_t size)
+{
+    uint32_t *dst = (uint32_t *)value;
+    const uint32_t *src = (const uint32_t *)shared;
+
+    for (size_t i = 0; i < size / sizeof(uint32_t); i++) {
+        dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+    }
+}
+
+// 写入一份完整快照
+static inline void seqlock_write(seqlock_t *lock, void *shared, const void *value, size_t size)
+{
+    seqlock_write_begin(lock);
+    seqlock_copy_in(shared, value, size);
+    seqlock_write_end(lock);
+}
+
+// 读取一份一致的快照，返回重试次数
+static inline unsigned seqlock_read(const seqlock_t *lock, void *value, const void *shared, size_t size)
+{
+    unsigned retries = 0;
+    uint32_t start;
+
+    for (;;) {
+        start = seqlock_read_begin(lock);
+        seqlock_copy_out(value, shared, size);
+        if (!seqlock_read_retry(lock, start)) break;
+        retries++;
+    }
+    return retries;
+}
+
+#endif // SEQLOCK_H
@@ -1,51 +1,20 @@
 #include "servo.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
 
-// 静态变量
-static volatile int servo_signal_received = 0;
-static volatile int servo_running = 1;
-
-// 信号处理函数
-void servo_signal_handler(int signal)
-{
-    servo_signal_received = signal;
-    printf("\n舵机组件接收到信号 %d\n", signal);
-    
-    switch (signal)
-    {
-        case SIGINT:  // Ctrl+C - 设置停止标志
-            printf("舵机组件: 接收到退出信号，准备返回主菜单...\n");
-            servo_running = 0;
-            break;
-        default:
-            printf("舵机组件: 未处理的信号 %d\n", signal);
-            break;
-    }
-}
-
-// 设置信号处理器
-void servo_setup_signal_handlers(void)
-{
-    signal(SIGINT, servo_signal_handler);
-    printf("舵机信号处理器设置完成 (仅SIGINT)\n");
-}
+static int g_pwm_created = 0;  // 软件PWM已创建 (重复创建会失败)
 
 // 清理函数
 void servo_cleanup(void)
 {
-    printf("舵机组件清理中...\n");
+    log_debug("舵机组件清理中...");
     servo_set_angle(90); // 回到中位
     delay(500);
-    servo_running = 1; // 重置运行状态以便下次使用
-    printf("舵机组件清理完成\n");
+    log_info("舵机组件清理完成");
 }
 
-// 获取运行状态
-int servo_is_running(void)
-{
-    return servo_running;
-}
-
-// 舵机初始化
+// 舵机初始化 (软件PWM线程只创建一次，之后调用只回到中位)
 void servo_init(void)
 {
     // 不再重复初始化wiringPi，因为web_main.c中已经初始化过了
@@ -57,22 +26,25 @@ void servo_init(void)
     }
     */
     
-    // 设置引脚为输出模式
-    pinMode(SERVO_PIN, OUTPUT);
-    digitalWrite(SERVO_PIN, LOW);
-    
-    // 创建软件PWM
-    if (softPwmCreate(SERVO_PIN, 0, SERVO_PWM_RANGE) != 0)
+    if (!g_pwm_created)
     {
-        printf("舵机: 软件PWM创建失败\n");
-        exit(1);
+        // 设置引脚为输出模式
+        pinMode(SERVO_PIN, OUTPUT);
+        digitalWrite(SERVO_PIN, LOW);
+        
+        // 创建软件PWM
+        if (softPwmCreate(SERVO_PIN, 0, SERVO_PWM_RANGE) != 0)
+        {
+            log_error("舵机: 软件PWM创建失败");
+            log_flush();
+            exit(1);
+        }
+        g_pwm_created = 1;
+        log_info("舵机初始化完成，使用GPIO %d引脚", SERVO_PIN);
     }
     
-    printf("舵机初始化完成，使用GPIO %d引脚\n", SERVO_PIN);
-    
-    // 初始化到中位(90度)
+    // 初始化到中位(90度)：舵机自行转到位，不必等待，之后的角度命令直接覆盖
     servo_set_angle(90);
-    delay(1000);
 }
 
 // 角度转换为PWM值
@@ -89,28 +61,33 @@ int angle_to_pwm(int angle)
     return pwm_value;
 }
 
+static metric_t m_pwm_writes = METRIC_COUNTER("rpi_pwm_writes_total", "device=\"servo\"", "软件PWM占空比的写入次数 (电机跳过值未变化的写入，舵机每次设置都写入)");
+
 // 设置舵机角度
 void servo_set_angle(int angle)
 {
     int pwm_value = angle_to_pwm(angle);
+    TRACE_BEGIN("pwm", "servo_pwm_write");
     softPwmWrite(SERVO_PIN, pwm_value);
-    printf("舵机设置角度: %d° (PWM值: %d)\n", angle, pwm_value);
+    TRACE_END("pwm", "servo_pwm_write");
+    metric_inc(&m_pwm_writes);
+    log_debug("舵机设置角度: %d° (PWM值: %d)", angle, pwm_value);
 }
 
 // 舵机扫描演示 (0度到180度来回扫描)
 void servo_sweep(void)
 {
     printf("开始舵机扫描演示 (按Ctrl+C停止)\n");
-    servo_setup_signal_handlers();
+    cancel_token_t *cancel = cancel_begin();
     
     int angle = 0;
     int direction = 1; // 1为正向，-1为反向
     int step = 5; // 每次移动5度
     
-    while (servo_running)
+    while (!cancel_requested(cancel))
     {
         servo_set_angle(angle);
-        delay(100); // 延时100ms
+        if (cancel_sleep_ms(cancel, 100) != 0) break; // 延时100ms
         
         angle += direction * step;
         
@@ -119,15 +96,16 @@ void servo_sweep(void)
         {
             angle = SERVO_MAX_ANGLE;
             direction = -1;
-            printf("到达180度，开始反向扫描\n");
+            log_debug("到达180度，开始反向扫描");
         }
         else if (angle <= SERVO_MIN_ANGLE)
         {
             angle = SERVO_MIN_ANGLE;
             direction = 1;
-            printf("到达0度，开始正向扫描\n");
+            log_debug("到达0度，开始正向扫描");
         }
     }
+    cancel_end(cancel);
     
     servo_cleanup();
 }
@@ -142,7 +120,7 @@ void servo_demo(void)
     printf("脉宽范围: %d - %d (对应0° - 180°)\n", SERVO_MIN_PULSE, SERVO_MAX_PULSE);
     
     servo_init();
-    servo_setup_signal_handlers();
+    cancel_token_t *cancel = cancel_begin();
     
     printf("\n开始舵机测试序列...\n");
     
@@ -150,18 +128,19 @@ void servo_demo(void)
     int test_angles[] = {0, 45, 90, 135, 180, 90};
     int num_angles = sizeof(test_angles) / sizeof(test_angles[0]);
     
-    for (int i = 0; i < num_angles && servo_running; i++)
+    for (int i = 0; i < num_angles && !cancel_requested(cancel); i++)
     {
         printf("移动到 %d°...\n", test_angles[i]);
         servo_set_angle(test_angles[i]);
-        delay(1500); // 等待1.5秒
+        cancel_sleep_ms(cancel, 1500); // 等待1.5秒
     }
     
-    if (servo_running)
+    if (!cancel_requested(cancel))
     {
         printf("\n现在开始连续扫描演示...\n");
         servo_sweep();
     }
+    cancel_end(cancel);
     
     servo_cleanup();
     printf("舵机演示结束\n");
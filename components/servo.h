@@ -6,7 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <signal.h>
+#include "cancel.h"
 
 // 舵机引脚定义
 #define SERVO_PIN 18  // GPIO 18引脚
@@ -27,11 +27,6 @@ void servo_set_angle(int angle);
 void servo_sweep(void);
 void servo_demo(void);
 int angle_to_pwm(int angle);
-
-// 信号处理函数声明
-void servo_signal_handler(int signal);
-void servo_setup_signal_handlers(void);
 void servo_cleanup(void);
-int servo_is_running(void);
 
 #endif // SERVO_H
@@ -0,0 +1,281 @@
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/prctl.h>
+#include "speed_ctrl.h"
+#include "motor.h"
+#include "motion_exec.h"
+#include "seqlock.h"
+#include "logger.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static speed_ctrl_config_t g_config = SPEED_CTRL_CONFIG_DEFAULT;
+static pthread_t g_thread;
+static volatile int g_running = 0;
+
+// 闭环开关和目标速度 (原子访问)
+static int g_closed_loop = 0;
+static int g_target[2] = {0, 0};
+static int g_reset_odometry = 0;
+
+// 闭环输出锁：控制线程读取目标、计算并写入占空比的整个过程持有，
+// 调用者线程直接停车时也持有，停车不会被按旧目标算出的输出覆盖
+static pthread_mutex_t g_output_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// PID控制器 (只在控制线程中使用，参数修改经g_gain_lock)
+static pid_ctrl_t g_pid[2];
+static pthread_mutex_t g_gain_lock = PTHREAD_MUTEX_INITIALIZER;
+static int g_gains_changed = 0;
+
+// 里程计：控制线程是唯一写者
+static odometry_t g_odometry;
+static seqlock_t g_odom_lock = SEQLOCK_INIT;
+
+// 时序统计 (由g_gain_lock保护)
+static speed_ctrl_stats_t g_stats = {0, 0, 0, 0};
+
+static void timespec_add_ns(struct timespec *ts, long ns)
+{
+    ts->tv_nsec += ns;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ts->tv_sec++;
+    }
+}
+
+static float clamp_duty(float duty)
+{
+    if (duty > 100.0f) return 100.0f;
+    if (duty < -100.0f) return -100.0f;
+    return duty;
+}
+
+// 单轮闭环：前馈 (目标占空比) + PID修正
+static int speed_ctrl_wheel(int wheel, int target, float measured, float dt)
+{
+    if (target == 0) {
+        pid_reset(&g_pid[wheel]);
+        return 0;
+    }
+    float duty = (float)target + pid_update(&g_pid[wheel], (float)target, measured, dt);
+    duty = clamp_duty(duty);
+
+    // 修正不能让车轮反转
+    if ((target > 0 && duty < 0) || (target < 0 && duty > 0)) duty = 0;
+    return (int)(duty >= 0 ? duty + 0.5f : duty - 0.5f);
+}
+
+// 固定频率控制循环
+static void *speed_ctrl_thread(void *arg)
+{
+    const long period_ns = 1000000000L / g_config.rate_hz;
+    const float dt = 1.0f / g_config.rate_hz;
+    const float metres_per_edge = (float)(M_PI * g_config.wheel_diameter / g_config.edges_per_rev);
+    const float edges_per_pct = g_config.max_rps * g_config.edges_per_rev / 100.0f;
+
+    long history[2][SPEED_CTRL_WINDOW] = {{0}};
+    long window_sum[2] = {0, 0};
+    int slot = 0;
+    int direction[2] = {1, 1};
+    unsigned long prev[2];
+    odometry_t odom = g_odometry;
+    struct timespec next;
+
+    (void)arg;
+    prctl(PR_SET_NAME, "speed_ctrl");    // 追踪和top中显示的线程名
+    encoder_read(&prev[0], &prev[1]);
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (g_running) {
+        timespec_add_ns(&next, period_ns);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        uint64_t deadline = (uint64_t)next.tv_sec * 1000000000ULL + (uint64_t)next.tv_nsec;
+        uint64_t wake = motion_now_ns();
+
+        // 单相编码器没有方向信息，按上一周期输出的占空比符号确定方向
+        int duty[2];
+        motor_get_duty(&duty[0], &duty[1]);
+        for (int w = 0; w < 2; w++) {
+            if (duty[w] > 0) direction[w] = 1;
+            if (duty[w] < 0) direction[w] = -1;
+        }
+
+        unsigned long count[2];
+        long edges[2];
+        encoder_read(&count[0], &count[1]);
+        for (int w = 0; w < 2; w++) {
+            edges[w] = (long)(count[w] - prev[w]) * direction[w];
+            prev[w] = count[w];
+
+            // 滑动窗口测速
+            window_sum[w] += edges[w] - history[w][slot];
+            history[w][slot] = edges[w];
+        }
+        slot = (slot + 1) % SPEED_CTRL_WINDOW;
+
+        float measured[2];
+        for (int w = 0; w < 2; w++) {
+            measured[w] = window_sum[w] / (SPEED_CTRL_WINDOW * dt) / edges_per_pct;
+        }
+
+        // 闭环输出
+        pthread_mutex_lock(&g_gain_lock);
+        if (g_gains_changed) {
+            for (int w = 0; w < 2; w++) {
+                pid_set_gains(&g_pid[w], g_config.kp, g_config.ki, g_config.kd);
+            }
+            g_gains_changed = 0;
+        }
+        pthread_mutex_unlock(&g_gain_lock);
+
+        pthread_mutex_lock(&g_output_lock);
+        if (__atomic_load_n(&g_closed_loop, __ATOMIC_ACQUIRE)) {
+            int left = speed_ctrl_wheel(0, __atomic_load_n(&g_target[0], __ATOMIC_RELAXED), measured[0], dt);
+            int right = speed_ctrl_wheel(1, __atomic_load_n(&g_target[1], __ATOMIC_RELAXED), measured[1], dt);
+            motor_set_duty(left, right);
+        }
+        pthread_mutex_unlock(&g_output_lock);
+
+        // 里程计 (差速运动学，中点航向积分)
+        if (__atomic_exchange_n(&g_reset_odometry, 0, __ATOMIC_ACQUIRE)) {
+            odom.x = odom.y = odom.heading = odom.distance = 0.0f;
+        }
+        float d_left = edges[0] * metres_per_edge;
+        float d_right = edges[1] * metres_per_edge;
+        float d_center = (d_left + d_right) / 2.0f;
+        float d_theta = (d_right - d_left) / g_config.track_width;
+        float mid = odom.heading + d_theta / 2.0f;
+
+        odom.x += d_center * cosf(mid);
+        odom.y += d_center * sinf(mid);
+        odom.heading = remainderf(odom.heading + d_theta, (float)(2.0 * M_PI));
+        odom.distance += fabsf(d_center);
+        odom.left_speed = measured[0];
+        odom.right_speed = measured[1];
+        odom.seq++;
+        odom.timestamp_ns = wake;
+        seqlock_write(&g_odom_lock, &g_odometry, &odom, sizeof(odom));
+
+        // 时序统计
+        uint64_t late = wake > deadline ? wake - deadline : 0;
+        uint64_t exec = motion_now_ns() - wake;
+        pthread_mutex_lock(&g_gain_lock);
+        g_stats.cycles++;
+        g_stats.total_late_ns += late;
+        if (late > g_stats.max_late_ns) g_stats.max_late_ns = late;
+        if (exec > g_stats.max_exec_ns) g_stats.max_exec_ns = exec;
+        pthread_mutex_unlock(&g_gain_lock);
+
+        // 落后超过一个周期时重新对齐，不追赶丢失的周期
+        if (late > (uint64_t)period_ns) {
+            clock_gettime(CLOCK_MONOTONIC, &next);
+        }
+    }
+    return NULL;
+}
+
+// 启动控制循环
+int speed_ctrl_start(const speed_ctrl_config_t *config)
+{
+    if (g_running) return 0;
+
+    if (config != NULL) {
+        g_config = *config;
+    }
+    if (g_config.rate_hz < SPEED_CTRL_MIN_HZ) g_config.rate_hz = SPEED_CTRL_MIN_HZ;
+    if (g_config.rate_hz > SPEED_CTRL_MAX_HZ) g_config.rate_hz = SPEED_CTRL_MAX_HZ;
+    if (g_config.edges_per_rev <= 0) g_config.edges_per_rev = ENCODER_EDGES_PER_REV;
+    if (g_config.max_rps <= 0) g_config.max_rps = 3.0f;
+
+    for (int w = 0; w < 2; w++) {
+        pid_init(&g_pid[w], g_config.kp, g_config.ki, g_config.kd, -100.0f, 100.0f);
+    }
+
+    g_running = 1;
+    if (pthread_create(&g_thread, NULL, speed_ctrl_thread, NULL) != 0) {
+        log_error("速度控制线程创建失败");
+        g_running = 0;
+        return -1;
+    }
+
+    log_info("速度控制循环已启动 (%d Hz, Kp=%.2f Ki=%.2f Kd=%.3f)",
+           g_config.rate_hz, g_config.kp, g_config.ki, g_config.kd);
+    return 0;
+}
+
+void speed_ctrl_stop(void)
+{
+    if (!g_running) return;
+
+    speed_ctrl_set_closed_loop(0);
+    g_running = 0;
+    pthread_join(g_thread, NULL);
+}
+
+int speed_ctrl_is_running(void)
+{
+    return g_running;
+}
+
+void speed_ctrl_set_closed_loop(int enable)
+{
+    pthread_mutex_lock(&g_output_lock);
+    __atomic_store_n(&g_closed_loop, enable ? 1 : 0, __ATOMIC_RELEASE);
+    if (!enable) {
+        motor_set_duty(0, 0);
+    }
+    pthread_mutex_unlock(&g_output_lock);
+}
+
+int speed_ctrl_closed_loop(void)
+{
+    return __atomic_load_n(&g_closed_loop, __ATOMIC_ACQUIRE);
+}
+
+// 设置目标速度 (%)，两轮都为0时立即停车而不等下一个控制周期
+// (持有输出锁：控制线程之后的周期读到的目标为0，清零积分并保持停车)
+void speed_ctrl_set_target(int left, int right)
+{
+    pthread_mutex_lock(&g_output_lock);
+    __atomic_store_n(&g_target[0], left, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_target[1], right, __ATOMIC_RELAXED);
+    if (left == 0 && right == 0) {
+        motor_set_duty(0, 0);
+    }
+    pthread_mutex_unlock(&g_output_lock);
+}
+
+void speed_ctrl_set_gains(float kp, float ki, float kd)
+{
+    pthread_mutex_lock(&g_gain_lock);
+    g_config.kp = kp;
+    g_config.ki = ki;
+    g_config.kd = kd;
+    g_gains_changed = 1;
+    pthread_mutex_unlock(&g_gain_lock);
+}
+
+void speed_ctrl_get_odometry(odometry_t *odom)
+{
+    seqlock_read(&g_odom_lock, odom, &g_odometry, sizeof(*odom));
+}
+
+void speed_ctrl_reset_odometry(void)
+{
+    __atomic_store_n(&g_reset_odometry, 1, __ATOMIC_RELEASE);
+}
+
+speed_ctrl_stats_t speed_ctrl_get_stats(void)
+{
+    speed_ctrl_stats_t stats;
+
+    pthread_mutex_lock(&g_gain_lock);
+    stats = g_stats;
+    pthread_mutex_unlock(&g_gain_lock);
+
+    return stats;
+}
@@ -0,0 +1,65 @@
+#ifndef SPEED_CTRL_H
+#define SPEED_CTRL_H
+
+#include <stdint.h>
+#include "encoder.h"
+#include "pid.h"
+
+// 控制参数
+#define SPEED_CTRL_MIN_HZ 100      // 最低控制频率
+#define SPEED_CTRL_MAX_HZ 1000     // 最高控制频率 (更高时控制线程接近忙等，软件PWM也跟不上)
+#define SPEED_CTRL_WINDOW 8        // 测速窗口 (控制周期数)
+
+// 闭环速度控制配置
+typedef struct {
+    int rate_hz;            // 控制频率 (限制在SPEED_CTRL_MIN_HZ ~ SPEED_CTRL_MAX_HZ)
+    int edges_per_rev;      // 每转编码器边沿数
+    float max_rps;          // 满占空比时的标称转速 (转/秒)，用于前馈和百分比换算
+    float wheel_diameter;   // 轮径 (米)
+    float track_width;      // 轮距 (米)
+    float kp;               // PID参数 (输入输出单位均为%)
+    float ki;
+    float kd;
+} speed_ctrl_config_t;
+
+#define SPEED_CTRL_CONFIG_DEFAULT \
+    { 100, ENCODER_EDGES_PER_REV, 3.0f, 0.065f, 0.13f, 0.6f, 4.0f, 0.0f }
+
+// 里程计 (通过seqlock发布，大小需为4字节的倍数)
+typedef struct {
+    float x;                // 位置 (米)
+    float y;
+    float heading;          // 航向 (弧度，逆时针为正)
+    float left_speed;       // 实测轮速 (%，相对max_rps)
+    float right_speed;
+    float distance;         // 累计行驶距离 (米)
+    uint32_t seq;           // 更新序号
+    uint32_t reserved;
+    uint64_t timestamp_ns;  // 更新时间 (CLOCK_MONOTONIC)
+} odometry_t;
+
+// 控制循环时序统计
+typedef struct {
+    unsigned long cycles;   // 已执行周期数
+    uint64_t max_late_ns;   // 最大唤醒延迟
+    uint64_t total_late_ns; // 累计唤醒延迟
+    uint64_t max_exec_ns;   // 单周期最长执行时间
+} speed_ctrl_stats_t;
+
+// 启动和停止控制循环 (不开启闭环时只计算里程计)
+int speed_ctrl_start(const speed_ctrl_config_t *config);
+void speed_ctrl_stop(void);
+int speed_ctrl_is_running(void);
+
+// 闭环开关和目标速度 (%)
+void speed_ctrl_set_closed_loop(int enable);
+int speed_ctrl_closed_loop(void);
+void speed_ctrl_set_target(int left, int right);
+void speed_ctrl_set_gains(float kp, float ki, float kd);
+
+// 里程计和统计
+void speed_ctrl_get_odometry(odometry_t *odom);
+void speed_ctrl_reset_odometry(void);
+speed_ctrl_stats_t speed_ctrl_get_stats(void);
+
+#endif // SPEED_CTRL_H
@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include "startup.h"
+#include "logger.h"
+
+static uint64_t g_start_ns = 0;
+static int g_first_command = 0;    // 已打印第一条运动命令 (原子读写)
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void startup_mark(void)
+{
+    g_start_ns = now_ns();
+}
+
+double startup_elapsed_ms(void)
+{
+    if (g_start_ns == 0) return -1;
+    return (now_ns() - g_start_ns) / 1e6;
+}
+
+// 先初始化依赖再初始化本项 (持有g_lock)
+static int init_node(startup_node_t *nodes, int count, int index)
+{
+    startup_node_t *node = &nodes[index];
+
+    if (node->state == STARTUP_READY) return 0;
+    if (node->state == STARTUP_FAILED) return -1;
+    if (node->state == STARTUP_INITIALIZING) {
+        log_error("组件 %s 的依赖存在循环", node->name);
+        return -1;
+    }
+
+    node->state = STARTUP_INITIALIZING;
+    for (int i = 0; i < count; i++) {
+        if (!(node->deps & (1u << i))) continue;
+        if (init_node(nodes, count, i) != 0) {
+            log_error("组件 %s 依赖的 %s 初始化失败", node->name, nodes[i].name);
+            node->state = STARTUP_FAILED;
+            return -1;
+        }
+    }
+
+    uint64_t start = now_ns();
+    int ret = node->init != NULL ? node->init() : 0;
+    uint64_t end = now_ns();
+    node->init_ns = end - start;
+    node->ready_ns = g_start_ns != 0 ? end - g_start_ns : 0;
+    __atomic_store_n(&node->state, ret == 0 ? STARTUP_READY : STARTUP_FAILED, __ATOMIC_RELEASE);
+    return ret == 0 ? 0 : -1;
+}
+
+int startup_run(startup_node_t *nodes, int count)
+{
+    int failed = 0;
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < count; i++) {
+        if (!nodes[i].lazy && init_node(nodes, count, i) != 0) failed++;
+    }
+    pthread_mutex_unlock(&g_lock);
+    return failed;
+}
+
+int startup_require(startup_node_t *nodes, int count, int index)
+{
+    // 已就绪时不加锁
+    if (__atomic_load_n(&nodes[index].state, __ATOMIC_ACQUIRE) == STARTUP_READY) return 0;
+
+    pthread_mutex_lock(&g_lock);
+    int ret = init_node(nodes, count, index);
+    pthread_mutex_unlock(&g_lock);
+    return ret;
+}
+
+int startup_is_ready(const startup_node_t *node)
+{
+    return __atomic_load_n(&node->state, __ATOMIC_ACQUIRE) == STARTUP_READY;
+}
+
+void startup_report(const startup_node_t *nodes, int count)
+{
+    static const char *state_names[] = { "延迟初始化", "初始化中", "就绪", "失败" };
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < count; i++) {
+        const startup_node_t *node = &nodes[i];
+        if (node->state == STARTUP_READY || node->state == STARTUP_FAILED) {
+            log_info("  %s: %s, 用时 %.2fms, 启动后 %.2fms 完成", node->name, state_names[node->state],
+                   node->init_ns / 1e6, node->ready_ns / 1e6);
+        } else {
+            log_info("  %s: %s", node->name, state_names[node->state]);
+        }
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+void startup_log(const char *what)
+{
+    double ms = startup_elapsed_ms();
+    if (ms >= 0) log_info("启动到%s: %.1fms", what, ms);
+}
+
+void startup_first_command(void)
+{
+    if (g_start_ns == 0 || __atomic_load_n(&g_first_command, __ATOMIC_RELAXED)) return;
+    if (__atomic_exchange_n(&g_first_command, 1, __ATOMIC_ACQ_REL)) return;
+    startup_log("执行第一条运动命令");
+}
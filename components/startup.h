@@ -0,0 +1,49 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <stdint.h>
+
+// 组件初始化图
+// 程序把用到的组件列成一张表，每项给出初始化函数和依赖 (deps第i位表示依赖表中第i项)：
+// startup_run() 按依赖顺序初始化所有非延迟组件，lazy的组件 (创建线程或很少使用的) 在第一次
+// startup_require() 时才初始化。初始化函数只配置引脚，不再用sleep等器件稳定：需要稳定时间的器件
+// (如DHT11) 自己记录就绪时刻，第一次读取时才等待剩余的时间，各器件的稳定时间因此互相重叠。
+// 初始化函数在调用线程中依次执行：wiringPi的pinMode对同一个功能选择寄存器读-改-写，不能并发调用。
+
+// 组件状态
+#define STARTUP_PENDING      0     // 尚未初始化
+#define STARTUP_INITIALIZING 1
+#define STARTUP_READY        2
+#define STARTUP_FAILED       3
+
+typedef struct {
+    const char *name;
+    int (*init)(void);             // 返回0成功
+    unsigned int deps;             // 依赖的组件 (表中序号的位)
+    int lazy;                      // 1: 第一次使用时才初始化
+    // 以下由startup维护
+    int state;
+    uint64_t init_ns;              // 初始化用时
+    uint64_t ready_ns;             // 就绪时刻 (相对启动)
+} startup_node_t;
+
+// 记录启动时刻 (main开始时调用)，之后的计时都相对这一时刻
+void startup_mark(void);
+// 距启动的毫秒数 (未调用startup_mark时返回-1)
+double startup_elapsed_ms(void);
+
+// 按依赖顺序初始化所有非延迟组件，返回失败的组件数
+int startup_run(startup_node_t *nodes, int count);
+// 确保第index项 (及其依赖) 已初始化，失败返回-1 (可在任意线程调用)
+int startup_require(startup_node_t *nodes, int count, int index);
+int startup_is_ready(const startup_node_t *node);
+
+// 打印各组件的状态和初始化用时
+void startup_report(const startup_node_t *nodes, int count);
+
+// 打印 "启动到<what>" 的时间
+void startup_log(const char *what);
+// 第一条运动命令执行时调用，只打印第一次 (未调用startup_mark的程序不打印)
+void startup_first_command(void);
+
+#endif // STARTUP_H
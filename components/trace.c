@@ -0,0 +1,182 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "trace.h"
+
+typedef struct {
+    uint64_t t_ns;
+    const char *cat;
+    const char *name;
+    char phase;                    // 'B' 开始, 'E' 结束
+} trace_rec_t;
+
+// 每个线程的环形缓冲区 (只有所属线程写入)
+typedef struct trace_ring {
+    uint64_t head;                 // 已写入的事件总数 (原子读写，事件写完后发布)
+    uint64_t start;                // 复用时之前线程的事件不再导出
+    int tid;
+    int in_use;
+    struct trace_ring *next;
+    trace_rec_t recs[TRACE_RING_SIZE];
+} trace_ring_t;
+
+int g_trace_enabled = 0;
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static trace_ring_t *g_rings = NULL;           // 原子读，只在表头插入
+static pthread_key_t g_key;
+static pthread_once_t g_key_once = PTHREAD_ONCE_INIT;
+static __thread trace_ring_t *t_ring = NULL;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void trace_set_enabled(int on)
+{
+    __atomic_store_n(&g_trace_enabled, on ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+int trace_is_enabled(void)
+{
+    return __atomic_load_n(&g_trace_enabled, __ATOMIC_RELAXED);
+}
+
+static void release_ring(void *arg)
+{
+    trace_ring_t *ring = arg;
+    __atomic_store_n(&ring->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void create_key(void)
+{
+    pthread_key_create(&g_key, release_ring);
+}
+
+// 为当前线程分配环形缓冲区：优先复用已退出线程留下的
+static trace_ring_t *acquire_ring(void)
+{
+    trace_ring_t *ring;
+
+    pthread_once(&g_key_once, create_key);
+    pthread_mutex_lock(&g_lock);
+    for (ring = g_rings; ring != NULL; ring = ring->next) {
+        if (!__atomic_load_n(&ring->in_use, __ATOMIC_ACQUIRE)) break;
+    }
+    if (ring == NULL) {
+        ring = calloc(1, sizeof(*ring));
+        if (ring != NULL) {
+            ring->next = g_rings;
+            __atomic_store_n(&g_rings, ring, __ATOMIC_RELEASE);
+        }
+    }
+    if (ring != NULL) {
+        ring->start = ring->head;
+        ring->tid = (int)syscall(SYS_gettid);
+        __atomic_store_n(&ring->in_use, 1, __ATOMIC_RELEASE);
+        pthread_setspecific(g_key, ring);
+    }
+    pthread_mutex_unlock(&g_lock);
+    t_ring = ring;
+    return ring;
+}
+
+void trace_event(const char *cat, const char *name, char phase)
+{
+    trace_ring_t *ring = t_ring;
+    if (ring == NULL && (ring = acquire_ring()) == NULL) return;
+
+    uint64_t head = ring->head;
+    trace_rec_t *rec = &ring->recs[head & (TRACE_RING_SIZE - 1)];
+    rec->t_ns = now_ns();
+    rec->cat = cat;
+    rec->name = name;
+    rec->phase = phase;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// 线程名 (/proc/self/task/<tid>/comm)，线程已退出时为空
+static void thread_name(int tid, char *buf, size_t size)
+{
+    char path[64];
+    FILE *f;
+
+    buf[0] = '\0';
+    snprintf(path, sizeof(path), "/proc/self/task/%d/comm", tid);
+    f = fopen(path, "r");
+    if (f == NULL) return;
+    if (fgets(buf, size, f) != NULL) buf[strcspn(buf, "\n")] = '\0';
+    fclose(f);
+}
+
+// 复制一个缓冲区中仍然有效的事件，返回复制的数量
+// 复制期间所属线程可能继续写入：复制后重新读取head，丢弃可能已被覆盖的事件
+static int copy_ring(trace_ring_t *ring, trace_rec_t *out, uint64_t *first)
+{
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t start = ring->start;
+    uint64_t from = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+    if (from < start) from = start;
+
+    for (uint64_t i = from; i < head; i++) out[i - from] = ring->recs[i & (TRACE_RING_SIZE - 1)];
+
+    uint64_t now = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    // 正在写入的是第now个事件，它覆盖第now - TRACE_RING_SIZE个
+    uint64_t valid = now >= TRACE_RING_SIZE ? now - TRACE_RING_SIZE + 1 : 0;
+    uint64_t skip = valid > from ? valid - from : 0;
+    if (skip > head - from) skip = head - from;
+    *first = skip;
+    return (int)(head - from - skip);
+}
+
+int trace_write_json(FILE *out)
+{
+    trace_rec_t *recs = malloc(sizeof(trace_rec_t) * TRACE_RING_SIZE);
+    int pid = (int)getpid();
+    int total = 0;
+    int first_item = 1;
+
+    if (recs == NULL) return -1;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (trace_ring_t *ring = __atomic_load_n(&g_rings, __ATOMIC_ACQUIRE); ring != NULL; ring = ring->next) {
+        uint64_t first;
+        int count = copy_ring(ring, recs, &first);
+        if (count == 0) continue;
+
+        char name[32];
+        thread_name(ring->tid, name, sizeof(name));
+        fprintf(out, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first_item ? "" : ",", pid, ring->tid, name[0] ? name : "exited");
+        first_item = 0;
+
+        for (int i = 0; i < count; i++) {
+            const trace_rec_t *rec = &recs[first + i];
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d}",
+                    rec->name ? rec->name : "?", rec->cat, rec->phase, (unsigned long long)(rec->t_ns / 1000),
+                    (unsigned int)(rec->t_ns % 1000), pid, ring->tid);
+        }
+        total += count;
+    }
+    fprintf(out, "\n]}\n");
+    free(recs);
+    return total;
+}
+
+int trace_dump(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (f == NULL) return -1;
+
+    int count = trace_write_json(f);
+    if (fclose(f) != 0) return -1;
+    return count;
+}
@@ -0,0 +1,38 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// 执行追踪 (Chrome/Perfetto trace-event格式)
+// 数码管写入、DHT11读取这类偶尔变慢的操作用TRACE_BEGIN/TRACE_END标出开始和结束。开启追踪后，
+// 每个线程把事件 (时间戳、类别、名称) 写入自己的环形缓冲区，满时覆盖最旧的事件，始终保留最近的一段；
+// 关闭时每处只有一次读取和分支。导出的JSON可以在 chrome://tracing 或 ui.perfetto.dev 中打开。
+// - 类别和名称必须是字面量或长期有效的字符串 (记录中只保存指针)
+// - 开关：trace_set_enabled()，控制服务器的文本命令traceon/traceoff，指标端口的 /trace/start、/trace/stop
+// - 导出：指标端口的 GET /trace (见metrics.h)，或trace_dump()
+
+#define TRACE_RING_SIZE  8192      // 每个线程保留的事件数 (2的幂)
+
+extern int g_trace_enabled;        // 原子读写，宏中直接判断
+
+#define trace_mark(cat, name, phase) \
+    do { \
+        if (__builtin_expect(__atomic_load_n(&g_trace_enabled, __ATOMIC_RELAXED), 0)) trace_event(cat, name, phase); \
+    } while (0)
+
+#define TRACE_BEGIN(cat, name) trace_mark(cat, name, 'B')
+#define TRACE_END(cat, name)   trace_mark(cat, name, 'E')
+
+void trace_set_enabled(int on);
+int trace_is_enabled(void);
+
+// 以trace-event JSON输出所有线程缓冲区中的事件，返回事件数 (导出期间可以继续记录)
+int trace_write_json(FILE *out);
+// 写入文件，失败返回-1
+int trace_dump(const char *path);
+
+// 宏内部使用
+void trace_event(const char *cat, const char *name, char phase);
+
+#endif // TRACE_H
@@ -3,29 +3,60 @@
 #include <string.h>
 #include <wiringPi.h>
 #include <time.h>
+#include <unistd.h>
 #include "usonic.h"
+#include "logger.h"
+#include "metrics.h"
+#include "trace.h"
 
-int read_dist() {
-    time_t t1, t2;
+static metric_t m_measure_ok = METRIC_COUNTER("rpi_usonic_measurements_total", "result=\"ok\"", "超声波测距次数");
+static metric_t m_measure_timeout = METRIC_COUNTER("rpi_usonic_measurements_total", "result=\"timeout\"", "超声波测距次数");
+static metric_t m_measure_seconds = METRIC_HISTOGRAM("rpi_usonic_measure_duration_seconds", NULL,
+                                                     "超声波一次测距的用时 (含回波超时)", METRICS_BUCKETS_MS);
+
+// 测量一次距离(cm)，回波超时返回-1 (不打印、不休眠，可在后台线程周期调用)
+int usonic_measure_cm(unsigned int timeout_us) {
+    unsigned int start, t1, t2;
+    uint64_t start_ns = metrics_now_ns();
+    int cm = -1;
+
+    TRACE_BEGIN("sensor", "usonic_measure_cm");
     digitalWrite(TRIG, 1);
-    usleep(10);
+    delayMicroseconds(10);
     digitalWrite(TRIG, 0);
-    while (digitalRead(ECHO) == 0);
+
+    start = micros();
+    while (digitalRead(ECHO) == 0) {
+        if (micros() - start > timeout_us) goto out;
+    }
     t1 = micros();
-    printf("t1=%ld\n", t1);
-    while (digitalRead(ECHO) == 1);
+    while (digitalRead(ECHO) == 1) {
+        if (micros() - t1 > timeout_us) goto out;
+    }
     t2 = micros();
-    printf("t2=%ld\n", t2);
-    digitalWrite(TRIG, 0);
+    cm = (int)((t2 - t1) * 340 / 20000);
+
+out:
+    TRACE_END("sensor", "usonic_measure_cm");
+    metric_observe_since(&m_measure_seconds, start_ns);
+    metric_inc(cm < 0 ? &m_measure_timeout : &m_measure_ok);
+    return cm;
+}
+
+// 测量一次距离并等待1秒 (菜单测距用)，回波超时返回-1
+int read_dist() {
+    int cm = usonic_measure_cm(USONIC_TIMEOUT_US);
+    log_debug("测距结果: %d cm", cm);
     sleep(1);
-    return (t2 - t1) * 340 / 20000;
+    return cm;
 }
 
 void usonic_init() {
     pinMode(TRIG, OUTPUT);
     pinMode(ECHO, INPUT);
     digitalWrite(TRIG, 0);
-    printf("超声波传感器初始化完成 (引脚 Trig:%d Echo:%d)\n", TRIG, ECHO);
-    sleep(1);
+    metric_register(&m_measure_ok);
+    metric_register(&m_measure_timeout);
+    log_info("超声波传感器初始化完成 (引脚 Trig:%d Echo:%d)", TRIG, ECHO);
 }
 
@@ -7,6 +7,10 @@
 
 // 函数声明
 void usonic_init();
-int read_dist();
+int read_dist();                                 // 单次测量后等待1秒，超时返回-1
+int usonic_measure_cm(unsigned int timeout_us);  // 带超时的单次测量，超时返回-1
+
+// 回波超时 (约4米量程)
+#define USONIC_TIMEOUT_US 25000
 
 #endif // USONIC_H
@@ -11,11 +11,18 @@
 #include "components/DHT.h"
 #include "components/usonic.h"
 #include "components/servo.h"
+#include "components/cancel.h"
+#include "components/startup.h"
+#include "components/logger.h"
+#include "components/metrics.h"
 #include "components/control.h"  // 新增运动控制
+#include "components/motion_exec.h"
 #include "combo/alarm_clock.h"
 #include "combo/stopwatch.h"
 #include "combo/rgb_control.h"
 #include "combo/temp_display.h"
+#include "combo/multitask.h"
+#include "combo/daemon.h"
 
 // 函数声明
 void show_main_menu(void);
@@ -33,32 +40,126 @@ void test_temp_display(void);
 void clear_screen(void);
 void wait_for_input(void);
 
-int main(void) {
+// 组件初始化图 (枚举值即依赖位的序号)
+enum {
+    COMP_CANCEL, COMP_LOG, COMP_METRICS, COMP_BEEP, COMP_BUTTON, COMP_CLOCK, COMP_RGB, COMP_DHT,
+    COMP_USONIC, COMP_SERVO, COMP_CONTROL, COMP_COUNT
+};
+#define COMP_DEP(c) (1u << (c))
+
+static int g_metrics_port = METRICS_PORT;
+
+static int init_log(void) { return log_start(NULL); }
+static int init_metrics(void) { return metrics_serve_start(g_metrics_port); }
+static int init_beep(void) { beep_init(); return 0; }
+static int init_button(void) { botton_init(); return 0; }
+static int init_clock(void) { tm1637_init(); return 0; }
+static int init_rgb(void) { rgb_init(); return 0; }
+static int init_usonic(void) { usonic_init(); return 0; }
+static int init_servo(void) { servo_init(); return 0; }
+static int init_control(void) { control_init(); return 0; }
+
+// 创建线程的组件 (日志输出和指标导出线程、舵机软件PWM、运动执行线程) 依赖取消处理：信号需在创建线程之前屏蔽；
+// 舵机、运动控制和超声波只在对应的测试中使用，第一次进入测试时才初始化。
+// DHT11启动时就初始化，它的1秒稳定时间与菜单操作重叠，第一次读取时通常已经就绪。
+static startup_node_t g_components[COMP_COUNT] = {
+    [COMP_CANCEL]  = { "取消处理", cancel_init, 0, 0 },
+    [COMP_LOG]     = { "日志", init_log, COMP_DEP(COMP_CANCEL), 0 },
+    [COMP_METRICS] = { "指标导出", init_metrics, COMP_DEP(COMP_LOG), 0 },
+    [COMP_BEEP]    = { "蜂鸣器", init_beep, 0, 0 },
+    [COMP_BUTTON]  = { "按键", init_button, 0, 0 },
+    [COMP_CLOCK]   = { "数码管", init_clock, 0, 0 },
+    [COMP_RGB]     = { "RGB灯", init_rgb, 0, 0 },
+    [COMP_DHT]     = { "温湿度传感器", dht11_init, 0, 0 },
+    [COMP_USONIC]  = { "超声波", init_usonic, 0, 1 },
+    [COMP_SERVO]   = { "舵机", init_servo, COMP_DEP(COMP_CANCEL), 1 },
+    [COMP_CONTROL] = { "运动控制", init_control, COMP_DEP(COMP_CANCEL), 1 },
+};
+
+// 使用延迟初始化的组件之前调用
+static int require_component(int comp) {
+    if (startup_require(g_components, COMP_COUNT, comp) != 0) {
+        printf("%s初始化失败\n", g_components[comp].name);
+        return -1;
+    }
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    printf("用法: %s [-M 指标端口]              交互菜单\n", prog);
+    printf("      %s -d [-a 时:分] [-p UDP命令端口，0表示不启用] [-M 指标端口，0表示不启用]  无界面守护模式\n", prog);
+}
+
+int main(int argc, char *argv[]) {
     int choice;
+    int first_menu = 1;
+    int daemon_mode = 0;
+    daemon_config_t daemon_config = { -1, 0, DAEMON_PORT };
+    int opt;
+
+    startup_mark();
+    while ((opt = getopt(argc, argv, "da:p:M:h")) != -1) {
+        switch (opt) {
+            case 'd':
+                daemon_mode = 1;
+                break;
+            case 'a':
+                if (sscanf(optarg, "%d:%d", &daemon_config.alarm_hour, &daemon_config.alarm_minute) != 2 ||
+                    daemon_config.alarm_hour < 0 || daemon_config.alarm_hour > 23 ||
+                    daemon_config.alarm_minute < 0 || daemon_config.alarm_minute > 59) {
+                    printf("闹钟时间格式错误: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'p':
+                daemon_config.port = atoi(optarg);
+                break;
+            case 'M':
+                g_metrics_port = atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
     
     // 初始化 wiringPi
     if (wiringPiSetupGpio() == -1) {
         printf("初始化 wiringPi 失败!\n");
         return 1;
     }
+
+    // 守护模式：各功能在同一个事件循环中同时运行，不进入菜单
+    if (daemon_mode) {
+        metrics_serve_start(g_metrics_port);
+        int ret = daemon_run(&daemon_config);
+        metrics_serve_stop();
+        return ret;
+    }
     
     printf("=== 树莓派B3项目控制系统 ===\n");
     printf("系统初始化中...\n");
     
-    // 初始化各个组件
-    beep_init();
-    botton_init();
-    tm1637_init();
-    rgb_init();
-    usonic_init();
-    control_init();  // 新增运动控制初始化
+    // 初始化各个组件 (取消处理使Ctrl+C只停止正在运行的演示并返回菜单)
+    startup_run(g_components, COMP_COUNT);
+    if (!startup_is_ready(&g_components[COMP_CANCEL])) {
+        return 1;
+    }
     
+    log_flush();
     printf("系统初始化完成!\n");
-    sleep(1);
+    startup_report(g_components, COMP_COUNT);
+    log_flush();
     
     while (1) {
-        clear_screen();
+        // 第一次显示菜单时不清屏，保留初始化信息
+        if (!first_menu) clear_screen();
         show_main_menu();
+        if (first_menu) {
+            startup_log("菜单就绪");
+            log_flush();
+        }
+        first_menu = 0;
         
         printf("请选择功能 (1-3): ");
         scanf("%d", &choice);
@@ -173,11 +274,12 @@ void show_combo_component_menu(void) {
         printf("║  3. 按键控制RGB灯颜色切换            ║\n");
         printf("║  4. 温度显示功能                     ║\n");
         printf("║  5. 系统状态指示                     ║\n");
-        printf("║  6. 返回主菜单                       ║\n");
+        printf("║  6. 多任务同时运行                   ║\n");
+        printf("║  7. 返回主菜单                       ║\n");
         printf("╚══════════════════════════════════════╝\n");
         printf("\n");
         
-        printf("请选择演示项目 (1-6): ");
+        printf("请选择演示项目 (1-7): ");
         scanf("%d", &choice);
         
         switch (choice) {
@@ -197,6 +299,10 @@ void show_combo_component_menu(void) {
                 system_status_indicator();
                 break;
             case 6:
+                multitask_demo();
+                wait_for_input();
+                break;
+            case 7:
                 return; // 返回主菜单
             default:
                 printf("无效选择，请重新输入！\n");
@@ -234,11 +340,11 @@ void test_beep(void) {
             break;
         case 3:
             printf("蜂鸣器切换测试 (按Ctrl+C返回菜单)...\n");
-            beep_setup_signal_handlers();
-            while (beep_is_running()) {
+            cancel_token_t *cancel = cancel_begin();
+            do {
                 beep_toggle();
-                usleep(500000); // 0.5秒
-            }
+            } while (cancel_sleep_ms(cancel, 500) == 0); // 0.5秒
+            cancel_end(cancel);
             beep_cleanup();
             break;
         case 4:
@@ -256,10 +362,9 @@ void test_button(void) {
     printf("请按下按键进行测试 (按Ctrl+C返回菜单)\n");
     printf("按键状态监测中...\n\n");
     
-    // 设置信号处理
-    beep_setup_signal_handlers();
+    cancel_token_t *cancel = cancel_begin();
     
-    while (beep_is_running()) {
+    while (!cancel_requested(cancel)) {
         if (botton_is_pressed()) {
             printf("按键被按下！\n");
             beep_on(); // 按键按下时蜂鸣器响
@@ -270,8 +375,9 @@ void test_button(void) {
             beep_off(); // 按键释放时蜂鸣器停
         }
         
-        usleep(50000); // 50ms延时
+        cancel_sleep_ms(cancel, 50); // 50ms延时
     }
+    cancel_end(cancel);
     
     // 退出时清理
     beep_cleanup();
@@ -293,8 +399,7 @@ void test_clock(void) {
     switch (choice) {
         case 1:
             printf("显示当前时间 (按Ctrl+C返回菜单)...\n");
-            clock_setup_signal_handlers();
-            clock_display(); // 函数会在接收到信号时自动返回
+            clock_display(); // 函数在取消时返回
             break;
         case 2:
             printf("请输入要显示的文本 (最多4个字符): ");
@@ -310,8 +415,7 @@ void test_clock(void) {
             fgets(text, sizeof(text), stdin);
             text[strlen(text)-1] = '\0'; // 移除换行符
             printf("滚动显示文本: %s (按Ctrl+C返回菜单)...\n", text);
-            clock_setup_signal_handlers();
-            roll_display(text, strlen(text)); // 函数会在接收到信号时自动返回
+            roll_display(text, strlen(text)); // 函数在取消时返回
             break;
         case 4:
             return;
@@ -338,8 +442,7 @@ void test_rgb(void) {
     switch (choice) {
         case 1:
             printf("RGB序列演示 (按Ctrl+C返回菜单)...\n");
-            rgb_setup_signal_handlers();
-            rgb_sequence(); // 函数会在接收到信号时自动返回
+            rgb_sequence(); // 函数在取消时返回
             break;
         case 2:
             printf("请输入RGB值 (0-1):\n");
@@ -374,6 +477,7 @@ void clear_screen(void) {
 }
 
 void wait_for_input(void) {
+    log_flush(); // 本次操作的日志先于提示输出
     printf("按回车键继续...");
     getchar(); // 清除输入缓冲
     getchar(); // 等待用户输入
@@ -425,8 +529,9 @@ void test_dht_sensor(void) {
             
             int count = 0;
             int success = 0;
+            cancel_token_t *cancel = cancel_begin();
             
-            while (count < 10) { // 读取10次后自动退出
+            while (count < 10 && !cancel_requested(cancel)) { // 读取10次后自动退出
                 result = dht11_read_with_retry(&sensor_data, 3);
                 count++;
                 
@@ -440,8 +545,9 @@ void test_dht_sensor(void) {
                            count, result, (float)success/count*100);
                 }
                 
-                if (count < 10) sleep(2);
+                if (count < 10) cancel_sleep_ms(cancel, 2000);
             }
+            cancel_end(cancel);
             
             printf("\n监测完成！总成功率: %.1f%%\n", (float)success/count*100);
             wait_for_input();
@@ -461,6 +567,11 @@ void test_usonic_sensor(void) {
     int choice;
     int distance;
     
+    if (require_component(COMP_USONIC) != 0) {
+        wait_for_input();
+        return;
+    }
+    
     while (1) {
         clear_screen();
         printf("\n=== 超声波距离传感器测试 ===\n");
@@ -485,15 +596,16 @@ void test_usonic_sensor(void) {
             case 2:
                 printf("\n连续测量模式 (按Ctrl+C停止)\n");
                 printf("每2秒测量一次距离...\n");
-                while (1) {
+                cancel_token_t *cancel = cancel_begin();
+                do {
                     distance = read_dist();
                     if (distance > 0) {
                         printf("距离: %d cm\n", distance);
                     } else {
                         printf("测量失败\n");
                     }
-                    sleep(2);
-                }
+                } while (cancel_sleep_ms(cancel, 2000) == 0);
+                cancel_end(cancel);
                 break;
 
             case 3:
@@ -527,11 +639,11 @@ void test_servo(void) {
                 printf("\n请输入目标角度 (0-180): ");
                 scanf("%d", &angle);
                 if (angle >= 0 && angle <= 180) {
-                    printf("正在初始化舵机...\n");
-                    servo_init();
-                    printf("设置舵机角度为 %d 度...\n", angle);
-                    servo_set_angle(angle);
-                    printf("舵机角度设置完成\n");
+                    if (require_component(COMP_SERVO) == 0) {
+                        printf("设置舵机角度为 %d 度...\n", angle);
+                        servo_set_angle(angle);
+                        printf("舵机角度设置完成\n");
+                    }
                 } else {
                     printf("角度范围错误！请输入0-180之间的角度\n");
                 }
@@ -542,15 +654,14 @@ void test_servo(void) {
                 printf("\n开始舵机扫描演示...\n");
                 printf("舵机将在0-180度之间来回扫描\n");
                 printf("按Ctrl+C停止演示\n");
-                servo_init();
-                servo_sweep();
+                if (require_component(COMP_SERVO) == 0) servo_sweep();
                 break;
 
             case 3:
                 printf("\n开始舵机完整演示...\n");
                 printf("包含角度测试和扫描演示\n");
                 printf("按Ctrl+C中断演示\n");
-                servo_demo();
+                if (require_component(COMP_SERVO) == 0) servo_demo();
                 break;
 
             case 4:
@@ -671,6 +782,11 @@ void test_motion_control(void) {
     int choice;
     int speed = 50; // 默认速度50%
     
+    if (require_component(COMP_CONTROL) != 0) {
+        wait_for_input();
+        return;
+    }
+    
     printf("\n");
     printf("╔══════════════════════════════════════╗\n");
     printf("║          运动控制测试                ║\n");
@@ -765,6 +881,18 @@ void test_motion_control(void) {
                 printf("左轮速度: %d%%\n", state.left_speed);
                 printf("右轮速度: %d%%\n", state.right_speed);
                 printf("运动状态: %s\n", state.is_moving ? "运动中" : "静止");
+                printf("状态序号: %u (%.3f秒前更新)\n", state.seq,
+                       (motion_now_ns() - state.timestamp_ns) / 1e9);
+                
+                motion_latency_t latency = motion_exec_get_latency();
+                printf("待执行命令: %d\n", motion_exec_pending());
+                if (latency.count > 0) {
+                    printf("命令到PWM延迟: 最近 %.1fus, 平均 %.1fus, 最大 %.1fus (共%lu条)\n",
+                           latency.last_ns / 1000.0,
+                           latency.total_ns / 1000.0 / latency.count,
+                           latency.max_ns / 1000.0,
+                           latency.count);
+                }
                 printf("-------------------\n");
                 wait_for_input();
                 break;
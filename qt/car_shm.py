@@ -0,0 +1,191 @@
+# 控制服务器共享内存状态块的Python客户端 (布局见server/shm_status.h，修改时两边同步)
+# 与控制服务器在同一台树莓派上运行的脚本可以直接读取运动状态、传感器读数、数码管和RGB灯状态，
+# 并通过命令邮箱提交运动命令，不经过TCP。
+# 用法: python3 car_shm.py                    打印当前状态
+#       python3 car_shm.py forward|back|left|right|stop [速度]
+import ctypes
+import mmap
+import os
+import sys
+import time
+
+SHM_STATUS_NAME = "/rpi_car_status"
+SHM_STATUS_MAGIC = 0x43495052
+SHM_STATUS_VERSION = 1
+SHM_MAILBOX_SLOTS = 64
+SHM_CMD_SALT = 0x5a17c0de
+
+SHM_CMD_MOTION = 1
+SHM_CMD_DRIVE = 2
+
+# PROTO_MOTION_* (server/protocol.h)
+MOTIONS = {"stop": 0, "forward": 1, "back": 2, "left": 3, "right": 4}
+MOTION_NAMES = ["stop", "forward", "backward", "left", "right", "accelerate", "decelerate"]
+
+
+class Header(ctypes.Structure):
+    _fields_ = [("magic", ctypes.c_uint32), ("version", ctypes.c_uint32), ("size", ctypes.c_uint32),
+                ("daemon_pid", ctypes.c_uint32), ("start_ns", ctypes.c_uint64), ("heartbeat_ns", ctypes.c_uint64)]
+
+
+class Motion(ctypes.Structure):
+    _fields_ = [("seq", ctypes.c_uint32), ("updates", ctypes.c_uint32), ("updated_ns", ctypes.c_uint64),
+                ("left_speed", ctypes.c_int32), ("right_speed", ctypes.c_int32), ("motion", ctypes.c_uint32),
+                ("moving", ctypes.c_uint32), ("motion_seq", ctypes.c_uint32), ("commander", ctypes.c_int32),
+                ("motion_ns", ctypes.c_uint64)]
+
+
+class Sensors(ctypes.Structure):
+    _fields_ = [("seq", ctypes.c_uint32), ("updates", ctypes.c_uint32), ("updated_ns", ctypes.c_uint64),
+                ("temperature_x10", ctypes.c_int32), ("humidity_x10", ctypes.c_uint32),
+                ("distance_cm", ctypes.c_int32), ("valid", ctypes.c_uint32),
+                ("env_ns", ctypes.c_uint64), ("distance_ns", ctypes.c_uint64)]
+
+
+class Panel(ctypes.Structure):
+    _fields_ = [("seq", ctypes.c_uint32), ("updates", ctypes.c_uint32), ("updated_ns", ctypes.c_uint64),
+                ("display", ctypes.c_uint8 * 4), ("rgb", ctypes.c_uint8 * 4)]
+
+
+class Command(ctypes.Structure):
+    _fields_ = [("seq", ctypes.c_uint32), ("type", ctypes.c_uint16), ("reserved", ctypes.c_uint16),
+                ("arg", ctypes.c_int32 * 3), ("check", ctypes.c_uint32)]
+
+
+class Mailbox(ctypes.Structure):
+    _fields_ = [("producer_pid", ctypes.c_uint32), ("tail", ctypes.c_uint32), ("producer_pad", ctypes.c_uint8 * 56),
+                ("head", ctypes.c_uint32), ("applied", ctypes.c_uint32), ("superseded", ctypes.c_uint32),
+                ("rejected", ctypes.c_uint32), ("denied", ctypes.c_uint32), ("consumer_pad", ctypes.c_uint8 * 44),
+                ("slots", Command * SHM_MAILBOX_SLOTS)]
+
+
+class Status(ctypes.Structure):
+    _fields_ = [("header", Header), ("motion", Motion), ("sensors", Sensors), ("panel", Panel),
+                ("pad", ctypes.c_uint8 * 104), ("mailbox", Mailbox)]
+
+
+def cmd_check(seq, type_, a0, a1, a2):
+    a0 &= 0xffffffff
+    a1 &= 0xffffffff
+    a2 &= 0xffffffff
+    rot1 = ((a1 << 8) | (a1 >> 24)) & 0xffffffff
+    rot2 = ((a2 << 16) | (a2 >> 16)) & 0xffffffff
+    return seq ^ type_ ^ a0 ^ rot1 ^ rot2 ^ SHM_CMD_SALT
+
+
+class CarShm:
+    def __init__(self, name=SHM_STATUS_NAME):
+        fd = os.open("/dev/shm" + name, os.O_RDWR)
+        try:
+            self._map = mmap.mmap(fd, ctypes.sizeof(Status))
+        finally:
+            os.close(fd)
+        self.status = Status.from_buffer(self._map)
+        header = self.status.header
+        if header.magic != SHM_STATUS_MAGIC or header.version != SHM_STATUS_VERSION or \
+                header.size != ctypes.sizeof(Status):
+            raise RuntimeError("共享内存的版本或大小不匹配")
+        self._claimed = False
+
+    # 读取一份一致的快照：seq为奇数 (正在写入) 或读取前后不同时重试
+    def _read(self, section):
+        while True:
+            start = section.seq
+            if start & 1:
+                continue
+            copy = type(section).from_buffer_copy(section)
+            if section.seq == start:
+                return copy
+
+    def motion(self):
+        return self._read(self.status.motion)
+
+    def sensors(self):
+        return self._read(self.status.sensors)
+
+    def panel(self):
+        return self._read(self.status.panel)
+
+    # 距上一次心跳的时间 (秒)，持续增大说明服务器已退出
+    def heartbeat_age(self):
+        return time.clock_gettime(time.CLOCK_MONOTONIC) - self.status.header.heartbeat_ns / 1e9
+
+    # 邮箱同一时间只有一个生产者；Python没有原子比较交换，只在空闲时占用并再次确认
+    def claim(self):
+        mailbox = self.status.mailbox
+        pid = os.getpid()
+        if mailbox.producer_pid not in (0, pid):
+            return False
+        mailbox.producer_pid = pid
+        time.sleep(0.001)
+        self._claimed = mailbox.producer_pid == pid
+        return self._claimed
+
+    def release(self):
+        if self._claimed and self.status.mailbox.producer_pid == os.getpid():
+            self.status.mailbox.producer_pid = 0
+        self._claimed = False
+
+    # 提交一条命令 (不进入内核)，邮箱满时返回None，成功返回命令序号
+    def push(self, type_, a0=0, a1=0, a2=0):
+        if not self._claimed and not self.claim():
+            raise RuntimeError(f"邮箱已被进程{self.status.mailbox.producer_pid}占用")
+        mailbox = self.status.mailbox
+        tail = mailbox.tail
+        if (tail - mailbox.head) & 0xffffffff >= SHM_MAILBOX_SLOTS:
+            return None
+        slot = mailbox.slots[tail % SHM_MAILBOX_SLOTS]
+        seq = (tail + 1) & 0xffffffff
+        slot.type = type_
+        slot.arg[0], slot.arg[1], slot.arg[2] = a0, a1, a2
+        slot.check = cmd_check(seq, type_, a0, a1, a2)
+        slot.seq = seq
+        mailbox.tail = seq
+        return seq
+
+    # 等待服务器取出并执行命令
+    def wait(self, seq, timeout=1.0):
+        deadline = time.monotonic() + timeout
+        while ((self.status.mailbox.head - seq) & 0xffffffff) >= 0x80000000:
+            if time.monotonic() > deadline:
+                return False
+            time.sleep(0.001)
+        return True
+
+    def close(self):
+        self.release()
+        del self.status
+        self._map.close()
+
+
+def main():
+    car = CarShm()
+    try:
+        if len(sys.argv) > 1:
+            motion = MOTIONS.get(sys.argv[1])
+            if motion is None:
+                print(f"未知命令 ： {sys.argv[1]}")
+                return 1
+            speed = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+            seq = car.push(SHM_CMD_MOTION, motion, speed, 50)
+            print(f"已提交命令 {sys.argv[1]} (序号 {seq})，{'已执行' if seq and car.wait(seq) else '未执行'}")
+            return 0
+
+        m = car.motion()
+        s = car.sensors()
+        p = car.panel()
+        name = MOTION_NAMES[m.motion] if m.motion < len(MOTION_NAMES) else str(m.motion)
+        print(f"服务器进程 {car.status.header.daemon_pid}，心跳 {car.heartbeat_age() * 1000:.0f}ms 前")
+        print(f"运动: {name} 左 {m.left_speed} 右 {m.right_speed} (序号 {m.motion_seq}，来源 {m.commander})")
+        if s.valid & 0x01:
+            print(f"温度 {s.temperature_x10 / 10:.1f}°C 湿度 {s.humidity_x10 / 10:.1f}%")
+        if s.valid & 0x02:
+            print(f"距离 {s.distance_cm}cm")
+        print(f"数码管 {bytes(p.display).hex()} RGB {list(p.rgb[:3])}")
+        return 0
+    finally:
+        car.close()
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -4,7 +4,10 @@
 #include <string.h>
 #include <softPwm.h>
 #include <unistd.h>
+#include "../../components/motor.h"
+#include "../../components/logger.h"
 
+// H桥引脚 (与MOTOR_PINMAP_HBRIDGE一致)
 #define LP 18
 #define LN 23
 #define RP 25
@@ -32,154 +35,123 @@ void setBCM(){
     }
 }
 
-void createPwm(int pin){
-    if(softPwmCreate(pin, 0, 100) == 0)printf("%d针脚初始化软件PWM成功\n", pin);
+// 引脚模式和软件PWM由电机驱动统一初始化
+void init(){
+    motor_pinmap_t map = { LP, LN, RP, RN, MOTOR_PWM_RANGE, 0, 0 };
+
+    setBCM();
+    motor_init(&map);
 }
 
-void initSoftPWM(){
-    createPwm(LP);
-    createPwm(LN);
-    createPwm(RP);
-    createPwm(RN);
+// 差速驱动入口
+void drive(int v, int omega) {
+    motor_drive(v, omega);
 }
 
-void setPinModeOutput(){
-    pinMode(LP, OUTPUT);
-    pinMode(LN, OUTPUT);
-    pinMode(RP, OUTPUT);
-    pinMode(RN, OUTPUT);
-    printf("引脚模式OUTPUT设置完成\n");
+// 方向转换为带符号占空比
+static int signedSpeed(int speed, int direction) {
+    if (direction == 1) return speed;
+    if (direction == -1) return -speed;
+    return 0;
 }
 
-void init(){
-    setBCM();
-    setPinModeOutput();
-    initSoftPWM();
-}
-
-// void stop() {
-//     softPwmWrite(LP, 0);
-//     softPwmWrite(LN, 0);
-//     softPwmWrite(RP, 0);
-//     softPwmWrite(RN, 0);
-//     printf("停止\n");
-// }
-    
-// void forward(){
-//     softPwmWrite(LP, SPEED); 
-//     softPwmWrite(LN, 0);
-//     softPwmWrite(RP, SPEED);
-//     softPwmWrite(RN, 0);
-//     printf("前进\n");
-// }
-
-// void back(){
-//     softPwmWrite(LP, 0);
-//     softPwmWrite(LN, SPEED);
-//     softPwmWrite(RP, 0);
-//     softPwmWrite(RN, SPEED);
-//     printf("后退\n");
-// }
-
-// 设置单侧电机的速度和方向
-void setMotor(int pin1, int pin2, int speed, int direction) {
-    if (direction == 1) {  // 正转
-        softPwmWrite(pin1, speed);
-        softPwmWrite(pin2, 0);
-    } else if (direction == -1) {  // 反转
-        softPwmWrite(pin1, 0);
-        softPwmWrite(pin2, speed);
-    } else {  // 停止
-        softPwmWrite(pin1, 0);
-        softPwmWrite(pin2, 0);
-    }
+// 设置两侧电机的速度和方向 (一次批量更新)
+void setMotors(int leftSpeed, int rightSpeed, int leftDir, int rightDir) {
+    motor_set_duty(signedSpeed(leftSpeed, leftDir), signedSpeed(rightSpeed, rightDir));
 }
 
 // 设置左侧轮子
 void setLeftMotor(int speed, int direction) {
-    setMotor(LP, LN, speed, direction);
+    int left, right;
+    motor_get_duty(&left, &right);
+    motor_set_duty(signedSpeed(speed, direction), right);
 }
 
 // 设置右侧轮子
 void setRightMotor(int speed, int direction) {
-    setMotor(RP, RN, speed, direction);
+    int left, right;
+    motor_get_duty(&left, &right);
+    motor_set_duty(left, signedSpeed(speed, direction));
 }
 
-// 设置速度和转向比例
-void setMotors(int leftSpeed, int rightSpeed, int leftDir, int rightDir) {
-    setLeftMotor(leftSpeed, leftDir);
-    setRightMotor(rightSpeed, rightDir);
+// 按引脚设置单侧电机 (兼容旧接口)
+void setMotor(int pin1, int pin2, int speed, int direction) {
+    if (pin1 == LP && pin2 == LN) {
+        setLeftMotor(speed, direction);
+    } else if (pin1 == RP && pin2 == RN) {
+        setRightMotor(speed, direction);
+    }
 }
 
 // 停止
 void stop() {
-    setMotors(0, 0, 0, 0);
+    motor_set_duty(0, 0);
     current_mode = STOP;
-    printf("停止\n");
+    log_debug("停止");
 }
 
 // 前进
 void forward(int speed) {
-    setMotors(speed, speed, 1, 1);
+    motor_drive(speed, 0);
     current_mode = FORWARD;
     current_speed = speed;
-    printf("前进 - 速度: %d\n", speed);
+    log_debug("前进 - 速度: %d", speed);
 }
 
 // 后退
 void backward(int speed) {
-    setMotors(speed, speed, -1, -1);
+    motor_drive(-speed, 0);
     current_mode = BACKWARD;
     current_speed = speed;
-    printf("后退 - 速度: %d\n", speed);
+    log_debug("后退 - 速度: %d", speed);
 }
 
-// 原地左转
+// 原地左转 (左轮后退，右轮前进)
 void spinleft(int speed) {
-    setMotors(speed, speed, -1, 1);  // 左轮后退，右轮前进
+    motor_drive(0, speed);
     current_mode = SPINLEFT;
-    printf("原地左转 - 速度: %d\n", speed);
+    log_debug("原地左转 - 速度: %d", speed);
 }
 
-// 原地右转
+// 原地右转 (左轮前进，右轮后退)
 void spinright(int speed) {
-    setMotors(speed, speed, 1, -1);  // 左轮前进，右轮后退
+    motor_drive(0, -speed);
     current_mode = SPINRIGHT;
-    printf("原地右转 - 速度: %d\n", speed);
+    log_debug("原地右转 - 速度: %d", speed);
 }
 
 // 前进左转（弧线）
 void forwardleft(int speed, int turnRatio) {
     int rightSpeed = speed;
     int leftSpeed = speed * (100 - turnRatio) / 100;
-    setMotors(leftSpeed, rightSpeed, 1, 1);
+    motor_set_duty(leftSpeed, rightSpeed);
     current_mode = FORWARDLEFT;
-    printf("前进左转 - 速度: %d, 转向比: %d%%\n", speed, turnRatio);
+    log_debug("前进左转 - 速度: %d, 转向比: %d%%", speed, turnRatio);
 }
 
 // 前进右转（弧线）
 void forwardright(int speed, int turnRatio) {
     int leftSpeed = speed;
     int rightSpeed = speed * (100 - turnRatio) / 100;
-    setMotors(leftSpeed, rightSpeed, 1, 1);
+    motor_set_duty(leftSpeed, rightSpeed);
     current_mode = FORWARDRIGHT;
-    printf("前进右转 - 速度: %d, 转向比: %d%%\n", speed, turnRatio);
+    log_debug("前进右转 - 速度: %d, 转向比: %d%%", speed, turnRatio);
 }
 
 // 后退左转
 void backwardleft(int speed, int turnRatio) {
     int rightSpeed = speed;
     int leftSpeed = speed * (100 - turnRatio) / 100;
-    setMotors(leftSpeed, rightSpeed, -1, -1);
+    motor_set_duty(-leftSpeed, -rightSpeed);
     current_mode = BACKWARDLEFT;
-    printf("后退左转 - 速度: %d, 转向比: %d%%\n", speed, turnRatio);
+    log_debug("后退左转 - 速度: %d, 转向比: %d%%", speed, turnRatio);
 }
 
 // 后退右转
 void backwardright(int speed, int turnRatio) {
     int leftSpeed = speed;
     int rightSpeed = speed * (100 - turnRatio) / 100;
-    setMotors(leftSpeed, rightSpeed, -1, -1);
+    motor_set_duty(-leftSpeed, -rightSpeed);
     current_mode = BACKWARDRIGHT;
-    printf("后退右转 - 速度: %d, 转向比: %d%%\n", speed, turnRatio);
-}
\ No newline at end of file
+    log_debug("后退右转 - 速度: %d, 转向比: %d%%", speed, turnRatio);
+}
@@ -0,0 +1,77 @@
+#include "joystick.h"
+#include <QPainter>
+#include <QMouseEvent>
+#include <QtMath>
+
+Joystick::Joystick(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(120, 120);
+}
+
+double Joystick::radius() const
+{
+    return qMin(width(), height()) / 2.0 - 12.0;
+}
+
+void Joystick::reset()
+{
+    dragging = false;
+    knobPos = QPointF(0, 0);
+    update();
+    emit moved(0, 0);
+}
+
+// 将控件坐标换算为摇杆位置，超出底盘的部分按方向截断到单位圆上
+void Joystick::setFromPoint(const QPointF &point)
+{
+    QPointF center(width() / 2.0, height() / 2.0);
+    double r = radius();
+    double x = (point.x() - center.x()) / r;
+    double y = (center.y() - point.y()) / r;
+    double len = qSqrt(x * x + y * y);
+
+    if(len > 1.0){
+        x /= len;
+        y /= len;
+    }
+    knobPos = QPointF(x, y);
+    update();
+    emit moved(x, y);
+}
+
+void Joystick::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+    QPointF center(width() / 2.0, height() / 2.0);
+    double r = radius();
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(Qt::gray, 2));
+    painter.setBrush(QColor(230, 230, 230));
+    painter.drawEllipse(center, r, r);
+    painter.drawLine(QPointF(center.x() - r, center.y()), QPointF(center.x() + r, center.y()));
+    painter.drawLine(QPointF(center.x(), center.y() - r), QPointF(center.x(), center.y() + r));
+
+    QPointF knob(center.x() + knobPos.x() * r, center.y() - knobPos.y() * r);
+    painter.setBrush(dragging ? QColor(0, 120, 215) : QColor(120, 120, 120));
+    painter.drawEllipse(knob, 12, 12);
+}
+
+void Joystick::mousePressEvent(QMouseEvent *event)
+{
+    dragging = true;
+    setFromPoint(event -> pos());
+}
+
+void Joystick::mouseMoveEvent(QMouseEvent *event)
+{
+    if(dragging) setFromPoint(event -> pos());
+}
+
+void Joystick::mouseReleaseEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    reset();
+}
@@ -0,0 +1,37 @@
+#ifndef JOYSTICK_H
+#define JOYSTICK_H
+
+#include <QWidget>
+#include <QPointF>
+
+// 虚拟摇杆：鼠标拖动摇杆头，松开后自动回中
+// 位置x/y范围为-1~1 (x向右为正，y向上为正)，只记录位置，由使用者按固定频率取样
+class Joystick : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Joystick(QWidget *parent = nullptr);
+
+    QPointF position() const { return knobPos; }
+    bool isActive() const { return dragging; }
+    void reset();
+
+signals:
+    void moved(double x, double y);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    QPointF knobPos;               // 当前位置 (-1~1)
+    bool dragging = false;
+
+    double radius() const;
+    void setFromPoint(const QPointF &point);
+};
+
+#endif // JOYSTICK_H
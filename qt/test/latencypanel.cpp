@@ -0,0 +1,138 @@
+#include "latencypanel.h"
+#include <QPainter>
+#include <QPushButton>
+#include <QTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDateTime>
+#include <algorithm>
+#include <cstring>
+
+// 百分位按最近RECENT_SAMPLES个采样计算，导出最多保留LOG_SAMPLES个采样
+static const int RECENT_SAMPLES = 1000;
+static const int LOG_SAMPLES = 100000;
+static const int REFRESH_INTERVAL_MS = 500;
+static const char* KIND_NAMES[] = { "往返 (PING)", "命令到PWM (APPLIED)" };
+static const char* KIND_CSV[] = { "rtt", "apply" };
+
+LatencyPanel::LatencyPanel(QWidget *parent)
+    : QWidget(parent)
+    , startMs(QDateTime::currentMSecsSinceEpoch())
+    , exportButton(new QPushButton("导出CSV", this))
+    , refreshTimer(new QTimer(this))
+{
+    setMinimumSize(260, 200);
+    clear();
+
+    connect(exportButton, &QPushButton::clicked, this, &LatencyPanel::onExportClicked);
+    // 采样可能很密集，按固定周期重绘
+    connect(refreshTimer, &QTimer::timeout, this, [this](){ update(); });
+    refreshTimer -> start(REFRESH_INTERVAL_MS);
+}
+
+void LatencyPanel::clear(){
+    for(int k = 0; k < KindCount; k++){
+        std::memset(&series[k].hist, 0, sizeof(series[k].hist));
+        series[k].recent.clear();
+        series[k].recentPos = 0;
+        series[k].log.clear();
+    }
+}
+
+void LatencyPanel::addSample(Kind kind, quint64 us){
+    Series& s = series[kind];
+    quint32 value = static_cast<quint32>(qMin<quint64>(us, 0xffffffffu));
+
+    latency_record(&s.hist, static_cast<uint64_t>(value) * 1000);
+
+    if(s.recent.size() < RECENT_SAMPLES){
+        s.recent.append(value);
+    }else{
+        s.recent[s.recentPos] = value;
+        s.recentPos = (s.recentPos + 1) % RECENT_SAMPLES;
+    }
+
+    if(s.log.size() < LOG_SAMPLES){
+        s.log.append(Sample{QDateTime::currentMSecsSinceEpoch() - startMs, value});
+    }
+}
+
+// 最近采样的精确百分位 (微秒)
+double LatencyPanel::percentile(Kind kind, double pct) const{
+    QVector<quint32> sorted = series[kind].recent;
+
+    if(sorted.isEmpty()) return 0.0;
+    int index = qBound(0, static_cast<int>(pct / 100.0 * sorted.size()), sorted.size() - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void LatencyPanel::drawSeries(QPainter& painter, const QRect& area, Kind kind) const{
+    const latency_stats_t& hist = series[kind].hist;
+    QString title = QString("%1  p50 %2us  p99 %3us  最大 %4us  (%5 次)")
+                    .arg(KIND_NAMES[kind])
+                    .arg(percentile(kind, 50.0), 0, 'f', 0)
+                    .arg(percentile(kind, 99.0), 0, 'f', 0)
+                    .arg(hist.max_ns / 1000.0, 0, 'f', 0)
+                    .arg(hist.count);
+    int textHeight = painter.fontMetrics().height();
+
+    painter.setPen(Qt::black);
+    painter.drawText(area.left(), area.top() + textHeight, title);
+
+    // 直方图：第i档为 [2^i, 2^(i+1)) 微秒
+    QRect bars(area.left(), area.top() + textHeight + 4, area.width(), area.height() - 2 * textHeight - 8);
+    unsigned long peak = 1;
+    for(int i = 0; i < LATENCY_BUCKETS; i++) peak = qMax(peak, hist.hist[i]);
+
+    double barWidth = static_cast<double>(bars.width()) / LATENCY_BUCKETS;
+    for(int i = 0; i < LATENCY_BUCKETS; i++){
+        int h = static_cast<int>(static_cast<double>(hist.hist[i]) / peak * bars.height());
+        QRectF bar(bars.left() + i * barWidth + 1, bars.bottom() - h, barWidth - 2, h);
+        painter.fillRect(bar, kind == Rtt ? QColor(0, 120, 215) : QColor(230, 120, 0));
+    }
+
+    // 横轴标注: 1us, 32us, 1ms, 32ms
+    painter.setPen(Qt::darkGray);
+    const int marks[] = { 0, 5, 10, 15 };
+    const char* labels[] = { "1us", "32us", "1ms", "32ms" };
+    for(int m = 0; m < 4; m++){
+        painter.drawText(QPointF(bars.left() + marks[m] * barWidth, bars.bottom() + textHeight), labels[m]);
+    }
+}
+
+void LatencyPanel::paintEvent(QPaintEvent *event){
+    Q_UNUSED(event);
+    QPainter painter(this);
+    int buttonHeight = exportButton -> sizeHint().height();
+    int half = (height() - buttonHeight - 4) / KindCount;
+
+    exportButton -> move(width() - exportButton -> sizeHint().width(), height() - buttonHeight);
+    for(int k = 0; k < KindCount; k++){
+        drawSeries(painter, QRect(0, k * half, width(), half), static_cast<Kind>(k));
+    }
+}
+
+// 导出格式: kind,time_ms,latency_us (time_ms为面板启动后的毫秒数)
+bool LatencyPanel::exportCsv(const QString& path) const{
+    QFile file(path);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    QTextStream out(&file);
+    out << "kind,time_ms,latency_us\n";
+    for(int k = 0; k < KindCount; k++){
+        for(const Sample& sample : series[k].log){
+            out << KIND_CSV[k] << ',' << sample.timeMs << ',' << sample.us << '\n';
+        }
+    }
+    return true;
+}
+
+void LatencyPanel::onExportClicked(){
+    QString path = QFileDialog::getSaveFileName(this, "导出延迟采样", "latency.csv", "CSV (*.csv)");
+
+    if(path.isEmpty()) return;
+    if(!exportCsv(path)) QMessageBox::warning(this, "导出失败", "无法写入文件: " + path);
+}
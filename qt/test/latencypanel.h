@@ -0,0 +1,55 @@
+#ifndef LATENCYPANEL_H
+#define LATENCYPANEL_H
+
+#include <QWidget>
+#include <QVector>
+#include <QString>
+#include "latency_stats.h"
+
+class QPushButton;
+class QTimer;
+
+// 延迟面板：实时显示网络往返 (PING/PONG) 和命令到PWM (APPLIED) 两组延迟的直方图和p50/p99，
+// 可导出全部采样为CSV
+class LatencyPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    enum Kind { Rtt = 0, Apply, KindCount };
+
+    explicit LatencyPanel(QWidget *parent = nullptr);
+
+    void addSample(Kind kind, quint64 us);
+    bool exportCsv(const QString& path) const;
+    void clear();
+
+public slots:
+    void onExportClicked();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Sample {
+        qint64 timeMs;             // 面板启动后的时间
+        quint32 us;
+    };
+
+    struct Series {
+        latency_stats_t hist;      // log2直方图 (与服务器统计相同的分档)
+        QVector<quint32> recent;   // 最近的采样，用于精确计算百分位
+        int recentPos = 0;
+        QVector<Sample> log;       // 导出用的全部采样 (有上限)
+    };
+
+    Series series[KindCount];
+    qint64 startMs;
+    QPushButton* exportButton;
+    QTimer* refreshTimer;
+
+    double percentile(Kind kind, double pct) const;
+    void drawSeries(QPainter& painter, const QRect& area, Kind kind) const;
+};
+
+#endif // LATENCYPANEL_H
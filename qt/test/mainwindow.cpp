@@ -1,19 +1,50 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <QDataStream>
+#include <QApplication>
 #include <QDebug>
+#include <QHostAddress>
+#include <QKeyEvent>
+#include <QAbstractSpinBox>
+#include <QtMath>
+
+// 小车控制服务器地址 (TCP和UDP使用相同端口)
+static const char* SERVER_HOST = "192.168.5.17";
+static const quint16 SERVER_PORT = 25500;
+// 默认发送频率 (界面上可调)：每个周期取样一次输入，命令变化时才发送
+static const int DEFAULT_SEND_RATE_HZ = 20;
+// UDP模式下命令不变时的重发周期，丢一帧后仍小于服务器的死人开关时间 (UDP_DEADMAN_MS)
+static const int KEEPALIVE_INTERVAL_MS = 100;
+// 摇杆死区和量化步长(%)：手抖产生的微小变化不会产生新命令
+static const int AXIS_DEADZONE = 10;
+static const int AXIS_STEP = 5;
+// 界面速度为0时摇杆满偏对应的速度 (与服务器默认速度一致)
+static const int DEFAULT_MAX_SPEED = 60;
+// 键盘方向键
+enum { KEY_FORWARD = 0x01, KEY_BACKWARD = 0x02, KEY_LEFT = 0x04, KEY_RIGHT = 0x08 };
+// 遥测订阅：界面只显示运动状态和传感器读数
+static const quint32 TELEMETRY_FIELDS = PROTO_TLM_MOTION | PROTO_TLM_ENV | PROTO_TLM_DISTANCE;
+static const quint16 TELEMETRY_RATE_HZ = 10;
+// 延迟探测周期
+static const int PING_INTERVAL_MS = 200;
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , timer(new QTimer(this))
     , socket(new QTcpSocket(this))
-    // , timer(new QTimer(this))
+    , udpSocket(new QUdpSocket(this))
 {
     ui->setupUi(this);
+    clock.start();
     connectToServer();
-    // timer -> setInterval(100);
+    ui -> sendRate -> setValue(DEFAULT_SEND_RATE_HZ);
+    timer -> setInterval(1000 / DEFAULT_SEND_RATE_HZ);
+    timer -> setTimerType(Qt::PreciseTimer);
 
     connect(socket, &QTcpSocket::connected, this, &MainWindow::onConnected);
+    connect(socket, &QTcpSocket::disconnected, this, &MainWindow::onDisconnected);
+    connect(socket, &QTcpSocket::readyRead, this, &MainWindow::onReadyRead);
+    connect(ui -> pushButton_5, &QPushButton::clicked, this, &MainWindow::onstopButton_clicked);
     connect(ui -> forwardButton, &QPushButton::pressed, this, &MainWindow::onforwardButton_pressed);
     connect(ui -> forwardButton, &QPushButton::released, this, &MainWindow::onforwardButton_released);
     connect(ui -> backwardButton, &QPushButton::pressed, this, &MainWindow::onbackwardButton_pressed);
@@ -22,7 +53,17 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui -> leftButton, &QPushButton::released, this, &MainWindow::onleftButton_released);
     connect(ui -> rightButton, &QPushButton::pressed, this, &MainWindow::onrightButton_pressed);
     connect(ui -> rightButton, &QPushButton::released, this, &MainWindow::onrightButton_released);
-    // connect(timer, &QTimer::timeout, this, &MainWindow::on_forwardButton_pressing);
+    connect(timer, &QTimer::timeout, this, &MainWindow::onSendTimer);
+    connect(ui -> sendRate, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::onSendRateChanged);
+    connect(udpSocket, &QUdpSocket::readyRead, this, &MainWindow::onUdpReadyRead);
+
+    // 键盘驾驶：WASD或方向键，空格停车 (焦点在数值输入框时不拦截)
+    qApp -> installEventFilter(this);
+
+    if(useUdp){
+        udpSocket -> connectToHost(QHostAddress(SERVER_HOST), SERVER_PORT);
+    }
+    timer -> start();
 
 }
 
@@ -34,12 +75,17 @@ MainWindow::~MainWindow()
 void MainWindow::connectToServer()
 {
     qDebug() << "尝试连接到服务器...";
-    socket->connectToHost("192.168.5.17", 25500);
+    socket->connectToHost(SERVER_HOST, SERVER_PORT);
 }
 
+// 连接后订阅遥测，服务器按TELEMETRY_RATE_HZ主动推送
 void MainWindow::onConnected()
 {
+    uint8_t frame[PROTO_MAX_FRAME];
+    size_t len = proto_encode_subscribe(frame, txSeq++, nowUs(), TELEMETRY_FIELDS, TELEMETRY_RATE_HZ);
+
     qDebug() << "成功连接到服务器";
+    socket -> write(reinterpret_cast<const char*>(frame), static_cast<qint64>(len));
 }
 
 void MainWindow::onDisconnected()
@@ -59,74 +105,298 @@ void MainWindow::socketSendMessage(char* message){
     }
 }
 
+quint64 MainWindow::nowUs() const{
+    return static_cast<quint64>(clock.nsecsElapsed() / 1000);
+}
+
+// 按钮只记录运动状态，由定时器取样发送
+void MainWindow::setButtonMotion(quint8 motion){
+    buttonMotion = motion;
+}
+
+static int quantize(int value){
+    return (value + AXIS_STEP / 2) / AXIS_STEP * AXIS_STEP;
+}
+
+// 油门/转向 (-1~1，转向向右为正) 换算为运动命令，满偏对应界面上的速度
+//   只有转向：原地旋转；油门加转向：前进/后退转弯，转向量作为内侧轮减速比例
+DriveCommand MainWindow::commandFromAxes(double throttle, double steer) const{
+    DriveCommand cmd;
+    int maxSpeed = ui -> speed -> value() > 0 ? ui -> speed -> value() : DEFAULT_MAX_SPEED;
+    int t = qRound(throttle * 100);
+    int s = qRound(steer * 100);
+
+    if(qAbs(t) < AXIS_DEADZONE) t = 0;
+    if(qAbs(s) < AXIS_DEADZONE) s = 0;
+    if(t == 0 && s == 0) return cmd;
+
+    // 速度0在协议中表示服务器默认速度，最小取一个量化步长
+    int speed = quantize(qAbs(t == 0 ? s : t) * maxSpeed / 100);
+    cmd.speed = static_cast<quint8>(qMax(speed, AXIS_STEP));
+
+    if(t == 0){
+        cmd.motion = s < 0 ? PROTO_MOTION_SPINLEFT : PROTO_MOTION_SPINRIGHT;
+    }else if(s == 0){
+        cmd.motion = t > 0 ? PROTO_MOTION_FORWARD : PROTO_MOTION_BACKWARD;
+    }else{
+        if(t > 0) cmd.motion = s < 0 ? PROTO_MOTION_FORWARDLEFT : PROTO_MOTION_FORWARDRIGHT;
+        else cmd.motion = s < 0 ? PROTO_MOTION_BACKWARDLEFT : PROTO_MOTION_BACKWARDRIGHT;
+        cmd.turnRatio = static_cast<quint8>(quantize(qAbs(s)));
+    }
+    return cmd;
+}
+
+// 取样当前输入：正在拖动的摇杆优先，其次是键盘，最后是按钮
+DriveCommand MainWindow::sampleInput() const{
+    if(ui -> joystick -> isActive()){
+        QPointF pos = ui -> joystick -> position();
+        return commandFromAxes(pos.y(), pos.x());
+    }
+    if(keysDown != 0){
+        int throttle = ((keysDown & KEY_FORWARD) ? 1 : 0) - ((keysDown & KEY_BACKWARD) ? 1 : 0);
+        int steer = ((keysDown & KEY_RIGHT) ? 1 : 0) - ((keysDown & KEY_LEFT) ? 1 : 0);
+        return commandFromAxes(throttle, steer);
+    }
+    switch(buttonMotion){
+        case PROTO_MOTION_FORWARD:   return commandFromAxes(1, 0);
+        case PROTO_MOTION_BACKWARD:  return commandFromAxes(-1, 0);
+        case PROTO_MOTION_SPINLEFT:  return commandFromAxes(0, -1);
+        case PROTO_MOTION_SPINRIGHT: return commandFromAxes(0, 1);
+        default:                     return DriveCommand();
+    }
+}
+
+// 键盘按下/松开，已处理时返回true
+bool MainWindow::handleKey(int key, bool pressed){
+    quint8 bit;
+
+    switch(key){
+        case Qt::Key_W: case Qt::Key_Up:    bit = KEY_FORWARD;  break;
+        case Qt::Key_S: case Qt::Key_Down:  bit = KEY_BACKWARD; break;
+        case Qt::Key_A: case Qt::Key_Left:  bit = KEY_LEFT;     break;
+        case Qt::Key_D: case Qt::Key_Right: bit = KEY_RIGHT;    break;
+        case Qt::Key_Space:
+            if(pressed) onstopButton_clicked();
+            return true;
+        default:
+            return false;
+    }
+    if(pressed) keysDown |= bit;
+    else keysDown &= static_cast<quint8>(~bit);
+    return true;
+}
+
+bool MainWindow::eventFilter(QObject* watched, QEvent* event){
+    // 窗口失去焦点时收不到松开事件，清除按键避免一直行驶
+    if(watched == this && event -> type() == QEvent::WindowDeactivate) keysDown = 0;
+
+    if((event -> type() == QEvent::KeyPress || event -> type() == QEvent::KeyRelease) && isActiveWindow() &&
+       !qobject_cast<QAbstractSpinBox*>(QApplication::focusWidget())){
+        QKeyEvent* keyEvent = static_cast<QKeyEvent*>(event);
+        if(keyEvent -> isAutoRepeat()) return true;
+        if(handleKey(keyEvent -> key(), event -> type() == QEvent::KeyPress)) return true;
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::onSendRateChanged(int hz){
+    if(hz > 0) timer -> setInterval(1000 / hz);
+}
+
+// 发送运动命令帧，请求服务器回复ACK，并在命令写入PWM后回复APPLIED
+void MainWindow::sendFrame(const DriveCommand& cmd){
+    uint8_t frame[PROTO_MAX_FRAME];
+    size_t len = proto_encode_drive(frame, txSeq++, nowUs(), PROTO_FLAG_ACK_REQ | PROTO_FLAG_APPLIED_REQ,
+                                    cmd.motion, cmd.speed, cmd.turnRatio);
+    const char* data = reinterpret_cast<const char*>(frame);
+
+    lastSent = cmd;
+    hasSent = true;
+    lastSendUs = nowUs();
+
+    if(useUdp){
+        if(udpSocket -> write(data, static_cast<qint64>(len)) == static_cast<qint64>(len)) udpSent++;
+        return;
+    }
+
+    if(!socket || socket -> state() != QAbstractSocket::ConnectedState){
+        qDebug() << "未连接服务器，命令未发送";
+        return;
+    }
+    if(socket -> write(data, static_cast<qint64>(len)) != static_cast<qint64>(len))
+        qDebug() << "发送命令失败";
+}
+
+// 发送延迟探测：走与运动命令相同的通道，服务器收到后立即回复PONG
+void MainWindow::sendPing(){
+    uint8_t frame[PROTO_MAX_FRAME];
+    size_t len = proto_encode_ping(frame, pingSeq++, nowUs());
+    const char* data = reinterpret_cast<const char*>(frame);
+
+    lastPingUs = nowUs();
+    if(useUdp) udpSocket -> write(data, static_cast<qint64>(len));
+    else if(socket -> state() == QAbstractSocket::ConnectedState) socket -> write(data, static_cast<qint64>(len));
+}
+
+// 按固定频率取样输入：命令变化时立即发送，不变时省略；
+// UDP模式下不变的命令每KEEPALIVE_INTERVAL_MS重发一次，丢包后自动补上，停止发送后服务器死人开关停车
+void MainWindow::onSendTimer(){
+    DriveCommand cmd = sampleInput();
+    quint64 now = nowUs();
+    bool keepalive = useUdp && now - lastSendUs >= static_cast<quint64>(KEEPALIVE_INTERVAL_MS) * 1000;
+
+    if(!hasSent || cmd != lastSent || keepalive) sendFrame(cmd);
+    else suppressed++;
+
+    if(now - lastPingUs >= static_cast<quint64>(PING_INTERVAL_MS) * 1000) sendPing();
+
+    // 每秒在状态栏显示一次链路统计
+    if(now - lastStatusUs >= 1000000 && udpSent > 0){
+        lastStatusUs = now;
+        double loss = 100.0 * static_cast<double>(udpSent - qMin(udpAcked, udpSent)) / static_cast<double>(udpSent);
+        ui -> statusbar -> showMessage(QString("UDP 已发送 %1  省略 %2  丢失 %3%  旧命令 %4  往返 平均 %5us 最大 %6us")
+                                       .arg(udpSent).arg(suppressed).arg(loss, 0, 'f', 1).arg(udpStale)
+                                       .arg(udpAcked ? rttTotalUs / udpAcked : 0).arg(rttMaxUs));
+    }
+}
+
+void MainWindow::handleAck(const proto_ack_t& ack){
+    quint64 rtt = nowUs() - ack.echo_us;
+
+    udpAcked++;
+    if(ack.status == PROTO_STATUS_STALE) udpStale++;
+    rttTotalUs += rtt;
+    if(rtt > rttMaxUs) rttMaxUs = rtt;
+}
+
+// 处理延迟探测回复和APPLIED (TCP和UDP共用)，已处理时返回true
+//   PONG：网络往返时间；APPLIED：服务器读入命令到写入PWM的时间
+bool MainWindow::handleLatencyFrame(const proto_frame_t& frame){
+    proto_pong_t pong;
+    proto_ack_t applied;
+
+    if(proto_decode_pong(&frame, &pong) == 0){
+        ui -> latencyPanel -> addSample(LatencyPanel::Rtt, nowUs() - pong.echo_us);
+        return true;
+    }
+    if(proto_decode_applied(&frame, &applied) == 0){
+        if(applied.status == PROTO_STATUS_OK) ui -> latencyPanel -> addSample(LatencyPanel::Apply, applied.latency_us);
+        return true;
+    }
+    return false;
+}
+
+// UDP回复：每个数据报一帧
+void MainWindow::onUdpReadyRead(){
+    while(udpSocket -> hasPendingDatagrams()){
+        QByteArray datagram;
+        datagram.resize(static_cast<int>(udpSocket -> pendingDatagramSize()));
+        udpSocket -> readDatagram(datagram.data(), datagram.size());
+
+        proto_frame_t frame;
+        proto_ack_t ack;
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(datagram.constData());
+        if(proto_parse(data, static_cast<size_t>(datagram.size()), &frame) != datagram.size()) continue;
+        if(handleLatencyFrame(frame)) continue;
+        if(proto_decode_ack(&frame, &ack) == 0) handleAck(ack);
+    }
+}
+
+// 显示遥测：没有有效读数的传感器保持原值
+void MainWindow::handleTelemetry(const proto_telemetry_t& tlm){
+    if(tlm.fields & PROTO_TLM_ENV){
+        ui -> temperature -> setValue(tlm.temperature_x10 / 10.0);
+        ui -> humidity -> setValue(tlm.humidity_x10 / 10.0);
+    }
+    if(tlm.fields & PROTO_TLM_DISTANCE){
+        ui -> distance -> setValue(tlm.distance_cm);
+    }
+}
+
+// 解析服务器发来的ACK、遥测和延迟帧 (可能一次收到多帧或半帧)
 void MainWindow::onReadyRead()
 {
-    while(socket->bytesAvailable() > 0)
-    {
-        QString string;
-        QDataStream reader(socket);
-        reader >> string;
+    rxBuffer.append(socket -> readAll());
 
-        qDebug() << string;
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(rxBuffer.constData());
+    size_t len = static_cast<size_t>(rxBuffer.size());
+    size_t pos = 0;
 
-        if(string == "forward")
-        {
-            //功能处理
+    while(pos < len){
+        proto_frame_t frame;
+        int used = proto_parse(data + pos, len - pos, &frame);
+        if(used == 0) break;
+        if(used < 0){
+            pos++;
+            continue;
         }
+        pos += static_cast<size_t>(used);
 
+        proto_ack_t ack;
+        proto_telemetry_t tlm;
+        if(handleLatencyFrame(frame)){
+            continue;
+        }else if(proto_decode_telemetry(&frame, &tlm) == 0){
+            handleTelemetry(tlm);
+        }else if(proto_decode_ack(&frame, &ack) == 0){
+            qDebug() << "ACK 序号:" << ack.ack_seq << "状态:" << static_cast<int>(ack.status)
+                     << "往返:" << (nowUs() - ack.echo_us) << "us 服务器处理:" << ack.latency_us << "us";
+        }
     }
+    rxBuffer.remove(0, static_cast<int>(pos));
 }
 
 void MainWindow::onforwardButton_pressed(){
     qDebug() << "前进按键触发";
     // timer -> start();
 
-    char* cmd = "forward";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_FORWARD);
 }
 
 void MainWindow::onforwardButton_released(){
     qDebug() << "前进按键释放";
     // if(timer -> isActive())timer -> stop();
 
-    char* cmd = "stop";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_STOP);
 }
 
 void MainWindow::onbackwardButton_pressed(){
     qDebug() << "后退按键触发";
-    char* cmd = "backward";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_BACKWARD);
 }
 
 void MainWindow::onbackwardButton_released(){
     qDebug() << "后退按键释放";
-    char* cmd = "stop";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_STOP);
 }
 
 void MainWindow::onleftButton_pressed(){
     qDebug() << "左转按键触发";
-    char* cmd = "spinleft";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_SPINLEFT);
 }
 
 void MainWindow::onleftButton_released(){
     qDebug() << "左转按键释放";
-    char* cmd = "stop";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_STOP);
 }
 
 void MainWindow::onrightButton_pressed(){
     qDebug() << "右转按键触发";
-    char* cmd = "spinright";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_SPINRIGHT);
 }
 
 void MainWindow::onrightButton_released(){
     qDebug() << "右转按键释放";
-    char* cmd = "stop";
-    socketSendMessage(cmd);
+    setButtonMotion(PROTO_MOTION_STOP);
+}
+
+// 停车不等待定时器，清除所有输入后立即发送
+void MainWindow::onstopButton_clicked(){
+    qDebug() << "停止按键触发";
+    buttonMotion = PROTO_MOTION_STOP;
+    keysDown = 0;
+    ui -> joystick -> reset();
+    sendFrame(DriveCommand());
 }
 
 
@@ -3,12 +3,30 @@
 
 #include <QMainWindow>
 #include <QTcpSocket>
+#include <QUdpSocket>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include "protocol.h"
+#include "latencypanel.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
+// 一条运动命令 (DRIVE帧负载)
+struct DriveCommand
+{
+    quint8 motion = PROTO_MOTION_STOP;
+    quint8 speed = 0;              // 0~100，停止时为0
+    quint8 turnRatio = 0;          // 转弯时内侧轮减速比例(%)
+
+    bool operator==(const DriveCommand& other) const {
+        return motion == other.motion && speed == other.speed && turnRatio == other.turnRatio;
+    }
+    bool operator!=(const DriveCommand& other) const { return !(*this == other); }
+};
+
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -22,6 +40,11 @@ public slots:
     void onDisconnected();
     void onReadyRead();
     void socketSendMessage(char*);
+    void setButtonMotion(quint8 motion);
+    void onstopButton_clicked();
+    void onSendTimer();
+    void onSendRateChanged(int hz);
+    void onUdpReadyRead();
 
     void onforwardButton_pressed();
     void onforwardButton_released();
@@ -42,9 +65,47 @@ public slots:
 
     // void on_forwardButton_pressing();
 
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
 private:
     Ui::MainWindow *ui;
     QTimer* timer;
     QTcpSocket* socket = nullptr;
+
+    // 二进制协议 (server/protocol.h)
+    quint32 txSeq = 1;             // 命令帧序号
+    QElapsedTimer clock;           // 帧时间戳 (微秒)
+    QByteArray rxBuffer;           // 未解析完的接收数据
+
+    // 输入状态：按钮、键盘和摇杆只更新状态，由定时器按固定频率取样发送
+    quint8 buttonMotion = PROTO_MOTION_STOP;
+    quint8 keysDown = 0;           // 按下的方向键 (KEY_*)
+    DriveCommand lastSent;         // 上一次发送的命令，未变化时不重复发送
+    bool hasSent = false;
+    quint64 lastSendUs = 0;
+    quint64 lastStatusUs = 0;
+    quint64 suppressed = 0;        // 未变化而省略的发送次数
+
+    // UDP遥控：服务器只执行最新命令，超时自动停车
+    bool useUdp = true;
+    QUdpSocket* udpSocket = nullptr;
+    quint64 udpSent = 0;           // 已发送命令
+    quint64 udpAcked = 0;          // 收到ACK的命令
+    quint64 udpStale = 0;          // 被服务器判定为旧命令
+    quint64 rttTotalUs = 0;
+    quint64 rttMaxUs = 0;
+    quint32 pingSeq = 1;           // PING单独编号，不占用命令序号 (UDP服务器按序号间隔推算丢包)
+    quint64 lastPingUs = 0;
+
+    quint64 nowUs() const;
+    DriveCommand sampleInput() const;
+    DriveCommand commandFromAxes(double throttle, double steer) const;
+    bool handleKey(int key, bool pressed);
+    void sendFrame(const DriveCommand& cmd);
+    void handleAck(const proto_ack_t& ack);
+    void handleTelemetry(const proto_telemetry_t& tlm);
+    bool handleLatencyFrame(const proto_frame_t& frame);
+    void sendPing();
 };
 #endif // MAINWINDOW_H
@@ -9,11 +9,20 @@ CONFIG += c++11
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    joystick.cpp \
+    latencypanel.cpp \
     main.cpp \
     mainwindow.cpp
 
+# 与控制服务器共用的二进制协议头文件
+INCLUDEPATH += ../../server
+
 HEADERS += \
-    mainwindow.h
+    joystick.h \
+    latencypanel.h \
+    mainwindow.h \
+    ../../server/latency_stats.h \
+    ../../server/protocol.h
 
 FORMS += \
     mainwindow.ui
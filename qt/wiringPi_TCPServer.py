@@ -3,6 +3,19 @@ import RPi.GPIO as GPIO
 import ctypes
 import platform
 import time
+import os
+import queue
+import logging
+import logging.handlers
+
+# 日志由后台线程输出，命令循环中只把记录放入队列 (级别由环境变量LOG_LEVEL设置，与C程序相同)
+log_queue = queue.SimpleQueue()
+log_listener = logging.handlers.QueueListener(log_queue, logging.StreamHandler())
+log = logging.getLogger("tcp_server")
+log.addHandler(logging.handlers.QueueHandler(log_queue))
+log_level = os.environ.get("LOG_LEVEL", "info").upper()
+log.setLevel(logging.CRITICAL + 1 if log_level == "OFF" else log_level)
+log_listener.start()
 
 #加载共享库
 controlLib = ctypes.CDLL('./lib/control.so')
@@ -15,12 +28,12 @@ server_socket.bind(('0.0.0.0', 25500))
 
 # 开始监听，最多允许一个客户端连接
 server_socket.listen(1)
-print("树莓派TCP服务器正在所有网口的25500端口监听中")
+log.info("树莓派TCP服务器正在所有网口的25500端口监听中")
 
 try:
     # 等待客户端连接
     client_socket, client_address = server_socket.accept()
-    print(f"已连接IP ： {client_address}")
+    log.info("已连接IP ： %s", client_address)
 
     controlLib.init()
 
@@ -28,9 +41,9 @@ try:
         # 接收客户端发来的数据
         data = client_socket.recv(1024).decode('utf-8').strip()
         if not data:
-            print("停止接受数据")
+            log.info("停止接受数据")
             break
-        print(f"收到命令 ： {data}")
+        log.debug("收到命令 ： %s", data)
 
         # # 解析并执行命令
         if data == "forward":
@@ -46,6 +59,7 @@ try:
         #     response = f"未知命令 ： {data}"
 
 finally:
-    print("正在清理GPIO端口")
+    log.info("正在清理GPIO端口")
     GPIO.cleanup()
     server_socket.close()
+    log_listener.stop()
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "apply_tracker.h"
+#include "motion_exec.h"
+
+typedef struct {
+    void *ctx;                     // NULL表示空闲
+    apply_reply_t reply;
+    uint32_t cmd_id;
+    uint32_t seq;
+    uint64_t echo_us;
+    uint64_t recv_ns;
+} apply_entry_t;
+
+static event_source_t g_notify = { -1, NULL, NULL, NULL };
+static apply_entry_t g_entries[APPLY_TRACKER_MAX];
+static int g_pending = 0;          // 执行线程只在有登记时写eventfd
+static unsigned long g_dropped = 0;
+
+// 运动执行线程回调 (持有执行器锁)：只在有登记时唤醒事件循环
+static void on_applied(void)
+{
+    uint64_t one = 1;
+
+    if (__atomic_load_n(&g_pending, __ATOMIC_RELAXED) > 0 && g_notify.fd >= 0) {
+        ssize_t n = write(g_notify.fd, &one, sizeof(one));
+        (void)n;
+    }
+}
+
+// 先释放登记再回复：回调中发送失败可能关闭连接并调用apply_tracker_cancel
+static void entry_complete(apply_entry_t *entry, int applied, uint64_t applied_ns)
+{
+    proto_ack_t ack;
+    void *ctx = entry->ctx;
+
+    ack.ack_seq = entry->seq;
+    ack.echo_us = entry->echo_us;
+    if (applied) {
+        ack.latency_us = (uint32_t)((applied_ns - entry->recv_ns) / 1000);
+        ack.status = PROTO_STATUS_OK;
+    } else {
+        ack.latency_us = 0;
+        ack.status = PROTO_STATUS_SUPERSEDED;
+    }
+    entry->ctx = NULL;
+    __atomic_sub_fetch(&g_pending, 1, __ATOMIC_RELAXED);
+    entry->reply(ctx, &ack);
+}
+
+static void notify_on_event(event_source_t *src, uint32_t events)
+{
+    uint64_t count;
+
+    (void)events;
+    if (read(src->fd, &count, sizeof(count)) < 0) return;
+
+    for (int i = 0; i < APPLY_TRACKER_MAX && g_pending > 0; i++) {
+        apply_entry_t *entry = &g_entries[i];
+        uint64_t applied_ns;
+
+        if (entry->ctx == NULL) continue;
+        int result = motion_exec_applied(entry->cmd_id, &applied_ns);
+        if (result != 0) entry_complete(entry, result > 0, applied_ns);
+    }
+}
+
+int apply_tracker_init(event_loop_t *loop)
+{
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (fd < 0) {
+        perror("创建eventfd失败");
+        return -1;
+    }
+    for (int i = 0; i < APPLY_TRACKER_MAX; i++) g_entries[i].ctx = NULL;
+    g_pending = 0;
+    g_dropped = 0;
+
+    g_notify.fd = fd;
+    g_notify.handler = notify_on_event;
+    g_notify.ctx = NULL;
+    if (event_loop_add(loop, &g_notify, EPOLLIN) != 0) {
+        close(fd);
+        g_notify.fd = -1;
+        return -1;
+    }
+    motion_exec_set_apply_hook(on_applied);
+    return 0;
+}
+
+void apply_tracker_close(void)
+{
+    motion_exec_set_apply_hook(NULL);
+    event_loop_remove(&g_notify);
+}
+
+void apply_tracker_add(void *ctx, apply_reply_t reply, uint32_t cmd_id, const proto_frame_t *frame,
+                       uint64_t recv_ns)
+{
+    apply_entry_t *entry = NULL;
+
+    for (int i = 0; i < APPLY_TRACKER_MAX; i++) {
+        if (g_entries[i].ctx == NULL) {
+            entry = &g_entries[i];
+            break;
+        }
+    }
+    if (entry == NULL) {
+        g_dropped++;
+        return;
+    }
+
+    entry->reply = reply;
+    entry->cmd_id = cmd_id;
+    entry->seq = frame->header.seq;
+    entry->echo_us = frame->header.timestamp_us;
+    entry->recv_ns = recv_ns;
+    entry->ctx = ctx;
+    __atomic_add_fetch(&g_pending, 1, __ATOMIC_RELAXED);
+
+    // 停车等命令在分发时已同步执行，不会再有通知
+    uint64_t applied_ns;
+    int result = motion_exec_applied(cmd_id, &applied_ns);
+    if (result != 0) entry_complete(entry, result > 0, applied_ns);
+}
+
+void apply_tracker_cancel(void *ctx)
+{
+    for (int i = 0; i < APPLY_TRACKER_MAX; i++) {
+        if (g_entries[i].ctx == ctx) {
+            g_entries[i].ctx = NULL;
+            __atomic_sub_fetch(&g_pending, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+unsigned long apply_tracker_dropped(void)
+{
+    return g_dropped;
+}
@@ -0,0 +1,29 @@
+#ifndef APPLY_TRACKER_H
+#define APPLY_TRACKER_H
+
+#include <stdint.h>
+#include "event_loop.h"
+#include "protocol.h"
+
+// 命令执行跟踪：带PROTO_FLAG_APPLIED_REQ的命令分发后登记，运动执行线程写入PWM后
+// 通过eventfd唤醒事件循环，由登记时提供的回调向发送方回复APPLIED帧 (TCP和UDP通道共用)
+
+#define APPLY_TRACKER_MAX 128
+
+// 回复回调：ctx为登记时提供的发送方 (TCP连接或UDP发送方)
+typedef void (*apply_reply_t)(void *ctx, const proto_ack_t *applied);
+
+int apply_tracker_init(event_loop_t *loop);
+void apply_tracker_close(void);
+
+// 登记一条刚分发的命令：cmd_id为motion_exec_last_id()，recv_ns为读入命令的时间
+void apply_tracker_add(void *ctx, apply_reply_t reply, uint32_t cmd_id, const proto_frame_t *frame,
+                       uint64_t recv_ns);
+
+// 发送方断开时取消其未完成的登记
+void apply_tracker_cancel(void *ctx);
+
+// 登记已满而丢弃的请求数
+unsigned long apply_tracker_dropped(void);
+
+#endif // APPLY_TRACKER_H
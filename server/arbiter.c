@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <string.h>
+#include "arbiter.h"
+#include "control.h"
+#include "control_server.h"
+#include "motion_exec.h"
+#include "logger.h"
+
+// 租约状态字：位0-31持有者, 位32-35优先级, 位36-37租约类型, 位38-63截止时间
+// 截止时间为毫秒时钟的低26位 (约18.6小时循环)，按序号算术比较；
+// 空闲租约到期后由定时器改为LAPSED，不会因为时钟循环重新变为有效
+#define LEASE_LAPSED      3
+#define DEADLINE_BITS     26
+#define DEADLINE_MASK     ((1u << DEADLINE_BITS) - 1)
+
+typedef struct {
+    int holder;
+    int priority;
+    int type;
+    uint32_t deadline;
+} lease_t;
+
+static uint64_t g_lease;           // 0表示没有持有者
+static arbiter_stats_t g_stats;    // 各字段用原子操作计数
+static event_source_t g_timer = { -1, NULL, NULL, NULL };
+
+static uint64_t pack(const lease_t *l)
+{
+    return (uint64_t)(uint32_t)l->holder | (uint64_t)(l->priority & 0xf) << 32 |
+           (uint64_t)(l->type & 0x3) << 36 | (uint64_t)(l->deadline & DEADLINE_MASK) << 38;
+}
+
+static lease_t unpack(uint64_t word)
+{
+    lease_t l;
+    l.holder = (int)(uint32_t)word;
+    l.priority = (int)(word >> 32) & 0xf;
+    l.type = (int)(word >> 36) & 0x3;
+    l.deadline = (uint32_t)(word >> 38) & DEADLINE_MASK;
+    return l;
+}
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(motion_now_ns() / 1000000ULL) & DEADLINE_MASK;
+}
+
+// 截止时间已过 (差值在半个循环以内视为已过)
+static int past(uint32_t deadline, uint32_t now)
+{
+    return ((now - deadline) & DEADLINE_MASK) < (1u << (DEADLINE_BITS - 1));
+}
+
+// 租约已不再有效 (其他来源可以直接获得)
+static int lapsed(const lease_t *l, uint32_t now)
+{
+    if (l->type == LEASE_LAPSED) return 1;
+    if (l->type == ARBITER_LEASE_HOLD) return 0;
+    return past(l->deadline, now);
+}
+
+static void count(unsigned long *counter)
+{
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+}
+
+arbiter_result_t arbiter_acquire(int source, int priority, arbiter_lease_t lease, unsigned int lease_ms)
+{
+    arbiter_result_t result;
+    uint32_t now = now_ms();
+    lease_t want;
+
+    if (priority <= ARBITER_PRIO_OBSERVER) {
+        count(&g_stats.denied);
+        return ARBITER_DENIED;
+    }
+    if (priority > ARBITER_PRIO_MAX) priority = ARBITER_PRIO_MAX;
+    if (lease_ms == 0) lease_ms = ARBITER_IDLE_MS;
+    if (lease_ms > ARBITER_MAX_LEASE_MS) lease_ms = ARBITER_MAX_LEASE_MS;
+
+    want.holder = source;
+    want.priority = priority;
+    want.type = lease;
+    want.deadline = lease == ARBITER_LEASE_HOLD ? 0 : (now + lease_ms) & DEADLINE_MASK;
+    uint64_t desired = pack(&want);
+
+    uint64_t word = __atomic_load_n(&g_lease, __ATOMIC_ACQUIRE);
+    for (;;) {
+        lease_t cur = unpack(word);
+
+        if (word != 0 && cur.holder == source) {
+            result = ARBITER_RENEWED;
+        } else if (word == 0 || lapsed(&cur, now)) {
+            result = ARBITER_GRANTED;
+        } else if (priority > cur.priority) {
+            result = ARBITER_PREEMPTED;
+        } else {
+            count(&g_stats.denied);
+            return ARBITER_DENIED;
+        }
+        // 同一毫秒内的续约不需要写入
+        if (word == desired) break;
+        if (__atomic_compare_exchange_n(&g_lease, &word, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) break;
+    }
+
+    switch (result) {
+        case ARBITER_GRANTED: count(&g_stats.granted); break;
+        case ARBITER_RENEWED: count(&g_stats.renewed); break;
+        case ARBITER_PREEMPTED: count(&g_stats.preempted); break;
+        default: break;
+    }
+    return result;
+}
+
+int arbiter_release(int source)
+{
+    uint64_t word = __atomic_load_n(&g_lease, __ATOMIC_ACQUIRE);
+
+    while (word != 0 && unpack(word).holder == source) {
+        if (__atomic_compare_exchange_n(&g_lease, &word, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            count(&g_stats.released);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int arbiter_holder(void)
+{
+    uint64_t word = __atomic_load_n(&g_lease, __ATOMIC_ACQUIRE);
+    return word ? unpack(word).holder : CONTROL_COMMANDER_NONE;
+}
+
+int arbiter_holder_priority(void)
+{
+    uint64_t word = __atomic_load_n(&g_lease, __ATOMIC_ACQUIRE);
+    return word ? unpack(word).priority : ARBITER_PRIO_OBSERVER;
+}
+
+// 到期检查：限时租约到期时停车并释放，空闲租约到期时标记为失效
+static void timer_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+
+    uint64_t word = __atomic_load_n(&g_lease, __ATOMIC_ACQUIRE);
+    lease_t cur = unpack(word);
+    uint32_t now = now_ms();
+
+    if (word == 0 || cur.type == LEASE_LAPSED || cur.type == ARBITER_LEASE_HOLD || !past(cur.deadline, now)) return;
+
+    if (cur.type == ARBITER_LEASE_TIMED) {
+        // CAS失败说明持有者刚好续约或被抢占，下一周期再检查
+        if (!__atomic_compare_exchange_n(&g_lease, &word, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) return;
+        control_stop();
+        count(&g_stats.expired);
+        log_warn("控制者 %d 的租约到期，已停车", cur.holder);
+    } else {
+        cur.type = LEASE_LAPSED;
+        if (__atomic_compare_exchange_n(&g_lease, &word, pack(&cur), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            count(&g_stats.lapsed);
+        }
+    }
+}
+
+int arbiter_start(event_loop_t *loop)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+    __atomic_store_n(&g_lease, 0, __ATOMIC_RELEASE);
+
+    if (event_timer_create(loop, &g_timer, timer_on_event, NULL) != 0 ||
+        event_timer_set(&g_timer, ARBITER_TICK_MS, ARBITER_TICK_MS) != 0) {
+        event_loop_remove(&g_timer);
+        return -1;
+    }
+    return 0;
+}
+
+void arbiter_stop(void)
+{
+    event_loop_remove(&g_timer);
+    __atomic_store_n(&g_lease, 0, __ATOMIC_RELEASE);
+}
+
+arbiter_stats_t arbiter_get_stats(void)
+{
+    arbiter_stats_t stats;
+    stats.granted = __atomic_load_n(&g_stats.granted, __ATOMIC_RELAXED);
+    stats.renewed = __atomic_load_n(&g_stats.renewed, __ATOMIC_RELAXED);
+    stats.preempted = __atomic_load_n(&g_stats.preempted, __ATOMIC_RELAXED);
+    stats.denied = __atomic_load_n(&g_stats.denied, __ATOMIC_RELAXED);
+    stats.expired = __atomic_load_n(&g_stats.expired, __ATOMIC_RELAXED);
+    stats.lapsed = __atomic_load_n(&g_stats.lapsed, __ATOMIC_RELAXED);
+    stats.released = __atomic_load_n(&g_stats.released, __ATOMIC_RELAXED);
+    return stats;
+}
+
+int arbiter_format_stats(char *buf, int size)
+{
+    arbiter_stats_t stats = arbiter_get_stats();
+    int len = snprintf(buf, size,
+                       "arb_holder=%d arb_priority=%d arb_granted=%lu arb_renewed=%lu arb_preempted=%lu "
+                       "arb_denied=%lu arb_expired=%lu arb_lapsed=%lu arb_released=%lu",
+                       arbiter_holder(), arbiter_holder_priority(), stats.granted, stats.renewed,
+                       stats.preempted, stats.denied, stats.expired, stats.lapsed, stats.released);
+    if (len >= size) len = size - 1;
+    return len;
+}
@@ -0,0 +1,75 @@
+#ifndef ARBITER_H
+#define ARBITER_H
+
+#include <stdint.h>
+#include "event_loop.h"
+
+// 控制权仲裁
+// 同一时间只有一个来源 (租约持有者) 能控制小车，各通道执行运动命令前先申请：
+//   - 没有持有者、租约已失效或申请者就是持有者：授予/续约
+//   - 申请者优先级高于持有者：抢占，原持有者之后的命令被拒绝
+//   - 否则拒绝，命令不执行
+// 优先级为ARBITER_PRIO_OBSERVER的来源是只读观察者，运动命令总是被拒绝。
+//
+// 租约类型：
+//   ARBITER_LEASE_IDLE   每条命令续约，空闲超过时长后失效 (不停车)，其他来源可以接管；
+//                        持有者仍被记录，断线等情况下由通道自己停车
+//   ARBITER_LEASE_TIMED  持有者显式申请的限时租约，到期没有续约时停车并释放
+//   ARBITER_LEASE_HOLD   一直有效直到释放或被抢占 (运动程序)
+//
+// 持有者、优先级、租约类型和截止时间打包在一个64位字中用CAS更新，
+// 命令路径上不加锁，可在任意线程调用；到期检查由事件循环中的定时器完成。
+
+#define ARBITER_PRIO_OBSERVER  0   // 只读
+#define ARBITER_PRIO_AUTONOMY  1   // 本地自主程序 (共享内存邮箱)
+#define ARBITER_PRIO_PROGRAM   2   // 上传的运动程序
+#define ARBITER_PRIO_REMOTE    3   // 遥控 (TCP/UDP客户端默认)
+#define ARBITER_PRIO_OVERRIDE  4   // 需要显式申请 (如安全员)
+#define ARBITER_PRIO_MAX       15
+
+#define ARBITER_IDLE_MS        1000   // 空闲租约的默认时长
+#define ARBITER_MAX_LEASE_MS   60000
+#define ARBITER_TICK_MS        20     // 到期检查周期
+
+typedef enum {
+    ARBITER_LEASE_IDLE = 0,
+    ARBITER_LEASE_TIMED,
+    ARBITER_LEASE_HOLD
+} arbiter_lease_t;
+
+typedef enum {
+    ARBITER_GRANTED = 0,           // 新获得控制权
+    ARBITER_RENEWED,               // 已是持有者
+    ARBITER_PREEMPTED,             // 抢占了优先级较低的持有者
+    ARBITER_DENIED                 // 被拒绝，不能执行命令
+} arbiter_result_t;
+
+typedef struct {
+    unsigned long granted;
+    unsigned long renewed;
+    unsigned long preempted;
+    unsigned long denied;
+    unsigned long expired;         // 限时租约到期停车
+    unsigned long lapsed;          // 空闲租约失效
+    unsigned long released;
+} arbiter_stats_t;
+
+// 在事件循环中启动到期检查
+int arbiter_start(event_loop_t *loop);
+void arbiter_stop(void);
+
+// 申请控制权 (执行运动命令前调用)，source为CONTROL_COMMANDER_*或TCP连接编号；
+// lease_ms为0时IDLE租约使用ARBITER_IDLE_MS，HOLD租约忽略lease_ms
+arbiter_result_t arbiter_acquire(int source, int priority, arbiter_lease_t lease, unsigned int lease_ms);
+
+// 释放控制权：source是持有者时返回1 (调用者决定是否停车)
+int arbiter_release(int source);
+
+// 当前持有者 (CONTROL_COMMANDER_NONE表示没有) 和优先级
+int arbiter_holder(void);
+int arbiter_holder_priority(void);
+
+arbiter_stats_t arbiter_get_stats(void);
+int arbiter_format_stats(char *buf, int size);
+
+#endif // ARBITER_H
@@ -0,0 +1,774 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "control_server.h"
+#include "control.h"
+#include "motion_exec.h"
+#include "protocol.h"
+#include "telemetry.h"
+#include "apply_tracker.h"
+#include "motion_program.h"
+#include "arbiter.h"
+#include "recorder.h"
+#include "logger.h"
+#include "trace.h"
+
+// 连接使用的协议 (由收到的第一个字节确定)
+typedef enum {
+    CLIENT_PROTO_UNKNOWN = 0,
+    CLIENT_PROTO_TEXT,             // 旧版文本命令
+    CLIENT_PROTO_BINARY            // protocol.h定义的二进制帧
+} client_proto_t;
+
+// 发送队列中的一帧
+typedef struct {
+    uint8_t len;
+    uint8_t data[PROTO_MAX_FRAME];
+} tx_slot_t;
+
+// 单个客户端连接
+typedef struct {
+    event_source_t src;
+    int id;
+    client_proto_t proto;
+    uint32_t last_seq;             // 已执行的最大命令序号 (二进制协议)
+    int has_seq;
+    uint32_t tx_seq;               // 发往客户端的帧序号
+    int priority;                  // 申请控制权的优先级 (ARBITER_PRIO_*)
+    arbiter_lease_t lease;
+    unsigned int lease_ms;
+    size_t len;                    // 接收缓冲区中未解析的字节数
+    char buf[CONTROL_RECV_BUF];
+    char addr[INET_ADDRSTRLEN];
+
+    // 二进制协议的发送队列：socket写不进去时帧留在环形队列中，队列满时丢弃最旧的帧
+    tx_slot_t tx[CONTROL_TX_SLOTS];
+    int tx_head;
+    int tx_count;
+    size_t tx_offset;              // 队首帧已发送的字节数
+    int tx_waiting;                // 已注册EPOLLOUT
+
+    // 遥测订阅
+    uint32_t tlm_fields;           // PROTO_TLM_*，0表示未订阅
+    uint64_t tlm_period_ns;
+    uint64_t tlm_next_ns;
+} control_client_t;
+
+// 文本命令表：前缀相同的命令中较长的排在前面，保证最长匹配
+#define TEXT_CMD_STATS   (-1)
+#define TEXT_CMD_OBSERVE (-2)      // 切换为只读观察者
+#define TEXT_CMD_RELEASE (-3)      // 释放控制权
+#define TEXT_CMD_TRACE_ON  (-4)    // 开启执行追踪
+#define TEXT_CMD_TRACE_OFF (-5)
+#define TEXT_CMD_LOG_BASE (-10)    // 设置日志级别：TEXT_CMD_LOG_BASE - LOG_LEVEL_*
+
+typedef struct {
+    const char *name;
+    size_t len;
+    int motion;                    // proto_motion_t，或TEXT_CMD_*
+} command_t;
+
+static event_source_t g_listener = { -1, NULL, NULL, NULL };
+static event_source_t g_tlm_timer = { -1, NULL, NULL, NULL };
+static int g_tlm_subscribers = 0;
+static control_client_t g_clients[CONTROL_MAX_CLIENTS];
+static int g_next_id = 1;
+static int g_speed = CONTROL_DEFAULT_SPEED;
+static control_stats_hook_t g_stats_hook = NULL;
+static control_server_stats_t g_stats;
+
+#define COMMAND(name, motion) { name, sizeof(name) - 1, motion }
+
+static const command_t g_commands[] = {
+    COMMAND("forwardleft", PROTO_MOTION_FORWARDLEFT),
+    COMMAND("forwardright", PROTO_MOTION_FORWARDRIGHT),
+    COMMAND("forward", PROTO_MOTION_FORWARD),
+    COMMAND("backwardleft", PROTO_MOTION_BACKWARDLEFT),
+    COMMAND("backwardright", PROTO_MOTION_BACKWARDRIGHT),
+    COMMAND("backward", PROTO_MOTION_BACKWARD),
+    COMMAND("back", PROTO_MOTION_BACKWARD),
+    COMMAND("spinleft", PROTO_MOTION_SPINLEFT),
+    COMMAND("spinright", PROTO_MOTION_SPINRIGHT),
+    COMMAND("stop", PROTO_MOTION_STOP),
+    COMMAND("stats", TEXT_CMD_STATS),
+    COMMAND("observe", TEXT_CMD_OBSERVE),
+    COMMAND("release", TEXT_CMD_RELEASE),
+    COMMAND("logdebug", TEXT_CMD_LOG_BASE - LOG_LEVEL_DEBUG),
+    COMMAND("loginfo", TEXT_CMD_LOG_BASE - LOG_LEVEL_INFO),
+    COMMAND("logwarn", TEXT_CMD_LOG_BASE - LOG_LEVEL_WARN),
+    COMMAND("logerror", TEXT_CMD_LOG_BASE - LOG_LEVEL_ERROR),
+    COMMAND("logoff", TEXT_CMD_LOG_BASE - LOG_LEVEL_OFF),
+    COMMAND("traceon", TEXT_CMD_TRACE_ON),
+    COMMAND("traceoff", TEXT_CMD_TRACE_OFF),
+};
+
+#define COMMAND_COUNT (sizeof(g_commands) / sizeof(g_commands[0]))
+
+// ---------------- 命令执行 ----------------
+
+// 执行运动命令，转弯时内侧轮按turn_ratio(%)减速 (与qt/lib/control.c的forwardleft等一致)
+int control_server_dispatch(int motion, int speed, int turn_ratio)
+{
+    if (speed <= 0) speed = g_speed;
+    if (speed > MAX_SPEED) speed = MAX_SPEED;
+    if (turn_ratio < 0) turn_ratio = 0;
+    if (turn_ratio > 100) turn_ratio = 100;
+    int inner = speed * (100 - turn_ratio) / 100;
+
+    recorder_log(REC_COMMAND, motion, arbiter_holder(), speed, turn_ratio, 0);
+    if (motion >= 0 && motion < PROTO_MOTION_COUNT) motion_program_takeover("手动命令接管");
+    switch (motion) {
+        case PROTO_MOTION_STOP:
+            control_stop();
+            return 0;
+        case PROTO_MOTION_FORWARD:
+            control_move_forward(speed);
+            return 0;
+        case PROTO_MOTION_BACKWARD:
+            control_move_backward(speed);
+            return 0;
+        case PROTO_MOTION_SPINLEFT:
+            control_drive(0, speed);
+            return 0;
+        case PROTO_MOTION_SPINRIGHT:
+            control_drive(0, -speed);
+            return 0;
+        case PROTO_MOTION_FORWARDLEFT:
+            return motion_exec_submit(MOTION_LEFT, inner, speed, 0);
+        case PROTO_MOTION_FORWARDRIGHT:
+            return motion_exec_submit(MOTION_RIGHT, speed, inner, 0);
+        case PROTO_MOTION_BACKWARDLEFT:
+            return motion_exec_submit(MOTION_BACKWARD, -inner, -speed, 0);
+        case PROTO_MOTION_BACKWARDRIGHT:
+            return motion_exec_submit(MOTION_BACKWARD, -speed, -inner, 0);
+        default:
+            return -1;
+    }
+}
+
+// ---------------- 发送队列 ----------------
+
+// 帧放入发送队列；队列满时丢弃最旧的一帧 (已发送一部分的队首帧必须发完，丢弃它后面的一帧)
+static void tx_push(control_client_t *client, const uint8_t *data, size_t len)
+{
+    if (client->tx_count == CONTROL_TX_SLOTS) {
+        if (client->tx_offset > 0) {
+            int next = (client->tx_head + 1) % CONTROL_TX_SLOTS;
+            client->tx[next] = client->tx[client->tx_head];
+            client->tx_head = next;
+        } else {
+            client->tx_head = (client->tx_head + 1) % CONTROL_TX_SLOTS;
+        }
+        client->tx_count--;
+        g_stats.frames_dropped++;
+    }
+
+    tx_slot_t *slot = &client->tx[(client->tx_head + client->tx_count) % CONTROL_TX_SLOTS];
+    memcpy(slot->data, data, len);
+    slot->len = (uint8_t)len;
+    client->tx_count++;
+}
+
+// 尽量发送队列中的帧 (一次writev)，写不完时等待EPOLLOUT；连接出错时返回-1
+static int tx_flush(control_client_t *client)
+{
+    while (client->tx_count > 0) {
+        struct iovec iov[CONTROL_TX_SLOTS];
+        struct msghdr msg;
+
+        for (int i = 0; i < client->tx_count; i++) {
+            tx_slot_t *slot = &client->tx[(client->tx_head + i) % CONTROL_TX_SLOTS];
+            size_t skip = (i == 0) ? client->tx_offset : 0;
+            iov[i].iov_base = slot->data + skip;
+            iov[i].iov_len = slot->len - skip;
+        }
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = client->tx_count;
+
+        ssize_t n = sendmsg(client->src.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return -1;
+            if (!client->tx_waiting) {
+                event_loop_modify(&client->src, EPOLLIN | EPOLLRDHUP | EPOLLOUT);
+                client->tx_waiting = 1;
+            }
+            return 0;
+        }
+
+        // 按已发送字节数出队
+        while (n > 0) {
+            tx_slot_t *slot = &client->tx[client->tx_head];
+            size_t remain = slot->len - client->tx_offset;
+            if ((size_t)n < remain) {
+                client->tx_offset += n;
+                break;
+            }
+            n -= remain;
+            client->tx_offset = 0;
+            client->tx_head = (client->tx_head + 1) % CONTROL_TX_SLOTS;
+            client->tx_count--;
+        }
+    }
+
+    if (client->tx_waiting) {
+        event_loop_modify(&client->src, EPOLLIN | EPOLLRDHUP);
+        client->tx_waiting = 0;
+    }
+    return 0;
+}
+
+// 非阻塞发送，缓冲区满时丢弃 (文本协议的回复都是可丢弃的统计)
+static void client_send(control_client_t *client, const void *data, size_t len)
+{
+    if (send(client->src.fd, data, len, MSG_NOSIGNAL) < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            g_stats.replies_dropped++;
+        }
+    }
+}
+
+// 回复统计信息 (一行文本)
+static void reply_stats(control_client_t *client)
+{
+    char reply[2048];
+    int len = control_server_format_stats(&g_stats, reply, sizeof(reply) - 1);
+
+    if (g_stats_hook != NULL && len < (int)sizeof(reply) - 2) {
+        reply[len++] = ' ';
+        len += g_stats_hook(reply + len, sizeof(reply) - 1 - len);
+    }
+
+    reply[len++] = '\n';
+    client_send(client, reply, len);
+}
+
+// ---------------- 统计 ----------------
+
+int control_server_format_stats(const control_server_stats_t *stats, char *buf, int size)
+{
+    int len = snprintf(buf, size,
+                       "stats commands=%lu denied=%lu errors=%lu stale=%lu clients=%d total_clients=%lu "
+                       "telemetry_sent=%lu frames_dropped=%lu "
+                       "avg_us=%.2f p50_us=%.0f p99_us=%.0f max_us=%.2f",
+                       stats->latency.count, stats->denied, stats->errors, stats->stale, stats->clients_active,
+                       stats->clients_total, stats->telemetry_sent, stats->frames_dropped,
+                       latency_avg_us(&stats->latency),
+                       latency_percentile_us(&stats->latency, 50.0),
+                       latency_percentile_us(&stats->latency, 99.0),
+                       stats->latency.max_ns / 1000.0);
+    if (len >= size) len = size - 1;
+    return len;
+}
+
+control_server_stats_t control_server_get_stats(void)
+{
+    return g_stats;
+}
+
+void control_server_set_stats_hook(control_stats_hook_t hook)
+{
+    g_stats_hook = hook;
+}
+
+// 释放控制权，持有时停车
+static void client_release(control_client_t *client)
+{
+    if (arbiter_release(client->id)) control_stop();
+}
+
+// 按连接的优先级和租约申请控制权
+static int client_acquire(control_client_t *client)
+{
+    return arbiter_acquire(client->id, client->priority, client->lease, client->lease_ms) != ARBITER_DENIED;
+}
+
+// ---------------- 命令解析 ----------------
+
+static int is_delimiter(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ';' || c == ',' || c == '\0';
+}
+
+// 在data开头匹配命令；数据是某条更长命令的前缀时设置*partial
+static const command_t *match_command(const char *data, size_t len, int *partial)
+{
+    *partial = 0;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        const command_t *cmd = &g_commands[i];
+        if (len >= cmd->len) {
+            if (memcmp(data, cmd->name, cmd->len) == 0) return cmd;
+        } else if (memcmp(data, cmd->name, len) == 0) {
+            *partial = 1;
+        }
+    }
+    return NULL;
+}
+
+// 解析并执行缓冲区中的文本命令，返回已消费的字节数
+// 完整的命令立即执行 (Qt客户端不发送分隔符，不能等待后续数据)，
+// 末尾不完整的命令前缀保留到下次读取。more表示socket中可能还有未读数据。
+static size_t parse_text(control_client_t *client, uint64_t recv_ns, int more)
+{
+    const char *data = client->buf;
+    size_t len = client->len;
+    size_t pos = 0;
+
+    while (pos < len) {
+        int partial;
+
+        if (is_delimiter(data[pos])) {
+            pos++;
+            continue;
+        }
+
+        const command_t *cmd = match_command(data + pos, len - pos, &partial);
+        if (cmd != NULL) {
+            // 剩余数据同时是更长命令的前缀 (如"forwardl"可能是"forwardleft")，
+            // 本次读取填满了缓冲区说明还有数据未读，等待后续数据再决定
+            if (partial && more) break;
+
+            pos += cmd->len;
+            if (cmd->motion == TEXT_CMD_STATS) {
+                reply_stats(client);
+                continue;
+            }
+            if (cmd->motion == TEXT_CMD_OBSERVE || cmd->motion == TEXT_CMD_RELEASE) {
+                if (cmd->motion == TEXT_CMD_OBSERVE) client->priority = ARBITER_PRIO_OBSERVER;
+                client_release(client);
+                continue;
+            }
+            if (cmd->motion <= TEXT_CMD_LOG_BASE) {
+                log_set_level(TEXT_CMD_LOG_BASE - cmd->motion);
+                continue;
+            }
+            if (cmd->motion == TEXT_CMD_TRACE_ON || cmd->motion == TEXT_CMD_TRACE_OFF) {
+                trace_set_enabled(cmd->motion == TEXT_CMD_TRACE_ON);
+                continue;
+            }
+            // 没有控制权的命令不执行 (文本协议没有回复，只计数)
+            if (!client_acquire(client)) {
+                g_stats.denied++;
+                continue;
+            }
+            control_server_dispatch(cmd->motion, g_speed, CONTROL_TURN_RATIO);
+            latency_record(&g_stats.latency, motion_now_ns() - recv_ns);
+            continue;
+        }
+
+        if (partial) break;
+
+        // 无法识别：跳过到下一个分隔符
+        g_stats.errors++;
+        while (pos < len && !is_delimiter(data[pos])) pos++;
+    }
+    return pos;
+}
+
+// ---------------- 遥测 ----------------
+
+static void client_close(control_client_t *client);
+
+// 有订阅者时以最高订阅频率运行定时器，各客户端按自己的周期取样
+static void update_tlm_timer(void)
+{
+    unsigned int tick_ms = 1000 / PROTO_TLM_MAX_HZ;
+
+    event_timer_set(&g_tlm_timer, g_tlm_subscribers > 0 ? tick_ms : 0, g_tlm_subscribers > 0 ? tick_ms : 0);
+}
+
+static void client_unsubscribe(control_client_t *client)
+{
+    if (client->tlm_fields == 0) return;
+    client->tlm_fields = 0;
+    g_tlm_subscribers--;
+    update_tlm_timer();
+}
+
+static void handle_subscribe(control_client_t *client, const proto_subscribe_t *sub)
+{
+    uint32_t fields = sub->fields & PROTO_TLM_ALL;
+    unsigned int rate = sub->rate_hz;
+
+    if (fields == 0 || rate == 0) {
+        client_unsubscribe(client);
+        return;
+    }
+    if (rate > PROTO_TLM_MAX_HZ) rate = PROTO_TLM_MAX_HZ;
+
+    if (client->tlm_fields == 0) {
+        // 遥测只关心最新状态：缩小内核发送缓冲区，慢客户端积压的旧帧在发送队列中被丢弃
+        int sndbuf = CONTROL_TLM_SNDBUF;
+        setsockopt(client->src.fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        g_tlm_subscribers++;
+        update_tlm_timer();
+    }
+    client->tlm_fields = fields;
+    client->tlm_period_ns = 1000000000ULL / rate;
+    client->tlm_next_ns = motion_now_ns();
+    log_info("客户端 #%d 订阅遥测: 字段0x%02x, %uHz", client->id, fields, rate);
+}
+
+static void tlm_on_event(event_source_t *src, uint32_t events)
+{
+    proto_telemetry_t tlm;
+    int collected = 0;
+
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+
+    uint64_t now = motion_now_ns();
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        control_client_t *client = &g_clients[i];
+        if (client->id == 0 || client->tlm_fields == 0 || now < client->tlm_next_ns) continue;
+
+        // 所有到期的客户端共用同一份快照
+        if (!collected) {
+            telemetry_collect(&tlm, now);
+            collected = 1;
+        }
+
+        proto_telemetry_t out = tlm;
+        uint8_t frame[PROTO_MAX_FRAME];
+        out.fields &= client->tlm_fields;
+        size_t len = proto_encode_telemetry(frame, client->tx_seq++, now / 1000, &out);
+        tx_push(client, frame, len);
+        g_stats.telemetry_sent++;
+
+        client->tlm_next_ns += client->tlm_period_ns;
+        if (client->tlm_next_ns <= now) client->tlm_next_ns = now + client->tlm_period_ns;
+
+        if (tx_flush(client) != 0) client_close(client);
+    }
+}
+
+// ---------------- 二进制命令 ----------------
+
+// 命令写入PWM后回复APPLIED (由apply_tracker回调)
+static void reply_applied(void *ctx, const proto_ack_t *applied)
+{
+    control_client_t *client = (control_client_t *)ctx;
+    uint8_t out[PROTO_MAX_FRAME];
+    size_t len = proto_encode_applied(out, client->tx_seq++, motion_now_ns() / 1000, applied);
+
+    tx_push(client, out, len);
+    if (!client->tx_waiting && tx_flush(client) != 0) client_close(client);
+}
+
+// 延迟探测：立即回复PONG
+static void reply_pong(control_client_t *client, const proto_frame_t *frame, uint64_t recv_ns)
+{
+    uint8_t out[PROTO_MAX_FRAME];
+    proto_pong_t pong;
+
+    pong.echo_us = frame->header.timestamp_us;
+    pong.rx_us = recv_ns / 1000;
+    size_t len = proto_encode_pong(out, client->tx_seq++, motion_now_ns() / 1000, &pong);
+    tx_push(client, out, len);
+}
+
+// 执行一帧二进制命令
+static void handle_frame(control_client_t *client, const proto_frame_t *frame, uint64_t recv_ns)
+{
+    proto_drive_t drive;
+    proto_ack_t ack;
+
+    if (frame->header.type == PROTO_MSG_SUBSCRIBE) {
+        proto_subscribe_t sub;
+        if (proto_decode_subscribe(frame, &sub) != 0) {
+            g_stats.errors++;
+            return;
+        }
+        handle_subscribe(client, &sub);
+        return;
+    }
+    if (frame->header.type == PROTO_MSG_PING) {
+        reply_pong(client, frame, recv_ns);
+        return;
+    }
+
+    ack.ack_seq = frame->header.seq;
+    ack.echo_us = frame->header.timestamp_us;
+    ack.latency_us = 0;
+
+    if (frame->header.type == PROTO_MSG_LEASE) {
+        proto_lease_t lease;
+        if (proto_decode_lease(frame, &lease) != 0) {
+            g_stats.errors++;
+            ack.status = PROTO_STATUS_INVALID;
+        } else {
+            client->priority = lease.priority > ARBITER_PRIO_MAX ? ARBITER_PRIO_MAX : lease.priority;
+            client->lease = lease.lease_ms ? ARBITER_LEASE_TIMED : ARBITER_LEASE_IDLE;
+            client->lease_ms = lease.lease_ms;
+            if ((lease.flags & PROTO_LEASE_RELEASE) || client->priority == ARBITER_PRIO_OBSERVER) {
+                client_release(client);
+                ack.status = PROTO_STATUS_OK;
+            } else {
+                ack.status = client_acquire(client) ? PROTO_STATUS_OK : PROTO_STATUS_DENIED;
+            }
+        }
+    } else if (proto_decode_drive(frame, &drive) != 0 || drive.motion >= PROTO_MOTION_COUNT) {
+        g_stats.errors++;
+        ack.status = PROTO_STATUS_INVALID;
+    } else if (client->has_seq && (int32_t)(frame->header.seq - client->last_seq) <= 0) {
+        // TCP不会乱序，序号回退说明客户端重发了旧命令
+        g_stats.stale++;
+        ack.status = PROTO_STATUS_STALE;
+    } else if (!client_acquire(client)) {
+        client->last_seq = frame->header.seq;
+        client->has_seq = 1;
+        g_stats.denied++;
+        ack.status = PROTO_STATUS_DENIED;
+    } else {
+        client->last_seq = frame->header.seq;
+        client->has_seq = 1;
+        control_server_dispatch(drive.motion, drive.speed, drive.turn_ratio);
+        if (frame->header.flags & PROTO_FLAG_APPLIED_REQ) {
+            apply_tracker_add(client, reply_applied, motion_exec_last_id(), frame, recv_ns);
+        }
+
+        uint64_t latency = motion_now_ns() - recv_ns;
+        latency_record(&g_stats.latency, latency);
+        ack.latency_us = (uint32_t)(latency / 1000);
+        ack.status = PROTO_STATUS_OK;
+    }
+
+    if (frame->header.flags & PROTO_FLAG_ACK_REQ) {
+        uint8_t out[PROTO_MAX_FRAME];
+        size_t len = proto_encode_ack(out, client->tx_seq++, motion_now_ns() / 1000, &ack);
+        tx_push(client, out, len);
+    }
+}
+
+// 解析并执行缓冲区中的二进制帧，返回已消费的字节数 (帧在缓冲区中原地解码)
+static size_t parse_binary(control_client_t *client, uint64_t recv_ns)
+{
+    const uint8_t *data = (const uint8_t *)client->buf;
+    size_t len = client->len;
+    size_t pos = 0;
+
+    while (pos < len) {
+        proto_frame_t frame;
+        int n = proto_parse(data + pos, len - pos, &frame);
+
+        if (n == 0) break;
+        if (n < 0) {
+            // 帧头损坏：丢弃到下一个magic字节重新同步
+            g_stats.errors++;
+            pos++;
+            while (pos < len && data[pos] != PROTO_MAGIC) pos++;
+            continue;
+        }
+
+        handle_frame(client, &frame, recv_ns);
+        pos += n;
+    }
+    return pos;
+}
+
+// ---------------- 连接管理 ----------------
+
+static void client_close(control_client_t *client)
+{
+    log_info("客户端 #%d (%s) 已断开", client->id, client->addr);
+    client_unsubscribe(client);
+    apply_tracker_cancel(client);
+    event_loop_remove(&client->src);
+    g_stats.clients_active--;
+
+    // 正在控制小车的客户端断开时停车
+    client_release(client);
+    client->id = 0;
+}
+
+static void client_on_event(event_source_t *src, uint32_t events)
+{
+    control_client_t *client = (control_client_t *)src->ctx;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        client_close(client);
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        if (tx_flush(client) != 0) {
+            client_close(client);
+            return;
+        }
+        if (!(events & (EPOLLIN | EPOLLRDHUP))) return;
+    }
+
+    // 水平触发：每次事件只读一次，多个客户端之间保持公平
+    size_t space = sizeof(client->buf) - client->len;
+    ssize_t n = recv(src->fd, client->buf + client->len, space, 0);
+    if (n == 0) {
+        client_close(client);
+        return;
+    }
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR) return;
+        client_close(client);
+        return;
+    }
+
+    uint64_t recv_ns = motion_now_ns();
+    client->len += n;
+
+    // 第一个字节是PROTO_MAGIC的连接使用二进制协议，否则按文本命令处理
+    if (client->proto == CLIENT_PROTO_UNKNOWN) {
+        client->proto = ((uint8_t)client->buf[0] == PROTO_MAGIC) ? CLIENT_PROTO_BINARY : CLIENT_PROTO_TEXT;
+    }
+
+    size_t used;
+    TRACE_BEGIN("net", "tcp_commands");
+    if (client->proto == CLIENT_PROTO_BINARY) {
+        used = parse_binary(client, recv_ns);
+        // 本次读取产生的ACK合并为一次发送
+        if (client->tx_count > 0 && !client->tx_waiting && tx_flush(client) != 0) {
+            TRACE_END("net", "tcp_commands");
+            client_close(client);
+            return;
+        }
+    } else {
+        used = parse_text(client, recv_ns, (size_t)n == space);
+    }
+    TRACE_END("net", "tcp_commands");
+    if (used > 0) {
+        client->len -= used;
+        memmove(client->buf, client->buf + used, client->len);
+    }
+}
+
+static control_client_t *client_alloc(void)
+{
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        if (g_clients[i].id == 0) return &g_clients[i];
+    }
+    return NULL;
+}
+
+static void listener_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept4(src->fd, (struct sockaddr *)&addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EINTR) perror("accept失败");
+            return;
+        }
+
+        control_client_t *client = client_alloc();
+        if (client == NULL) {
+            g_stats.clients_rejected++;
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        client->id = g_next_id++;
+        client->proto = CLIENT_PROTO_UNKNOWN;
+        client->has_seq = 0;
+        client->last_seq = 0;
+        client->tx_seq = 0;
+        client->priority = ARBITER_PRIO_REMOTE;
+        client->lease = ARBITER_LEASE_IDLE;
+        client->lease_ms = 0;
+        client->len = 0;
+        client->tx_head = 0;
+        client->tx_count = 0;
+        client->tx_offset = 0;
+        client->tx_waiting = 0;
+        client->tlm_fields = 0;
+        inet_ntop(AF_INET, &addr.sin_addr, client->addr, sizeof(client->addr));
+        client->src.fd = fd;
+        client->src.handler = client_on_event;
+        client->src.ctx = client;
+        if (event_loop_add(src->loop, &client->src, EPOLLIN | EPOLLRDHUP) != 0) {
+            close(fd);
+            client->id = 0;
+            continue;
+        }
+
+        g_stats.clients_total++;
+        g_stats.clients_active++;
+        log_info("已连接客户端 #%d : %s:%d", client->id, client->addr, ntohs(addr.sin_port));
+    }
+}
+
+// 启动服务器：在loop上监听port，运动命令使用speed(%)
+int control_server_start(event_loop_t *loop, int port, int speed)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+
+    if (speed > 0 && speed <= MAX_SPEED) g_speed = speed;
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_tlm_subscribers = 0;
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        g_clients[i].id = 0;
+        g_clients[i].src.fd = -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("创建socket失败");
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        perror("绑定端口失败");
+        close(fd);
+        return -1;
+    }
+
+    g_listener.fd = fd;
+    g_listener.handler = listener_on_event;
+    g_listener.ctx = NULL;
+    if (event_loop_add(loop, &g_listener, EPOLLIN) != 0) {
+        close(fd);
+        g_listener.fd = -1;
+        return -1;
+    }
+
+    if (event_timer_create(loop, &g_tlm_timer, tlm_on_event, NULL) != 0) {
+        event_loop_remove(&g_listener);
+        return -1;
+    }
+
+    printf("小车控制服务器正在所有网口的%d端口监听中 (最多%d个客户端，速度%d%%)\n",
+           port, CONTROL_MAX_CLIENTS, g_speed);
+    return 0;
+}
+
+// 关闭所有连接和监听socket
+void control_server_stop(void)
+{
+    for (int i = 0; i < CONTROL_MAX_CLIENTS; i++) {
+        if (g_clients[i].id != 0) {
+            event_loop_remove(&g_clients[i].src);
+            g_clients[i].id = 0;
+        }
+    }
+    g_stats.clients_active = 0;
+    g_tlm_subscribers = 0;
+    event_loop_remove(&g_tlm_timer);
+    event_loop_remove(&g_listener);
+}
@@ -0,0 +1,65 @@
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include <stdint.h>
+#include "event_loop.h"
+#include "latency_stats.h"
+
+// 小车TCP控制服务器 (替代qt/wiringPi_TCPServer.py)
+// 单个epoll循环服务多个客户端，命令直接调用电机控制函数。
+// 每个连接按第一个字节自动识别协议：
+//   - protocol.h定义的二进制帧 (带序号和时间戳，可请求ACK)
+//   - 旧版文本命令 ("forward"、"stop"等)，命令之间可以没有分隔符
+// 两种协议下多条命令合并在一次读取中或一条命令被拆成多次读取都能正确解析。
+// 二进制连接可以订阅遥测 (PROTO_MSG_SUBSCRIBE)，服务器按各自的字段和频率主动推送；
+// 发往每个客户端的帧先进入环形发送队列，慢客户端的队列满时丢弃最旧的帧，不阻塞事件循环。
+// 多个客户端同时发送运动命令时由arbiter仲裁：连接默认以遥控优先级申请空闲租约，
+// 二进制连接可以用PROTO_MSG_LEASE设置优先级和限时租约，文本连接发送"observe"成为只读观察者、
+// "release"释放控制权；没有控制权的命令不执行 (二进制ACK状态为DENIED)。
+// 文本命令"logdebug"/"loginfo"/"logwarn"/"logerror"/"logoff"在运行时调整日志级别，"traceon"/"traceoff"开关执行追踪。
+
+#define CONTROL_SERVER_PORT     25500
+#define CONTROL_MAX_CLIENTS     64
+#define CONTROL_RECV_BUF        1024
+#define CONTROL_DEFAULT_SPEED   60
+#define CONTROL_TURN_RATIO      50    // 前进/后退转弯时内侧轮减速比例(%)
+#define CONTROL_TX_SLOTS        8     // 每个客户端发送队列的帧数
+#define CONTROL_TLM_SNDBUF      4096  // 订阅遥测的连接使用的内核发送缓冲区
+
+// 命令来源 (控制权仲裁中的持有者编号，见arbiter.h)：TCP客户端使用正数连接编号
+#define CONTROL_COMMANDER_NONE  0
+#define CONTROL_COMMANDER_UDP   (-1)
+#define CONTROL_COMMANDER_PROGRAM (-2)
+#define CONTROL_COMMANDER_SHM   (-3)
+
+// 服务器统计 (命令处理延迟为数据读入到电机函数返回的时间)
+typedef struct {
+    latency_stats_t latency;       // 已执行命令数和处理延迟
+    unsigned long denied;          // 没有控制权而未执行的运动命令 (不计入延迟)
+    unsigned long errors;          // 无法识别的命令或损坏的帧
+    unsigned long stale;           // 序号回退而丢弃的二进制命令
+    unsigned long replies_dropped; // 发送缓冲区满时丢弃的文本回复
+    unsigned long telemetry_sent;  // 已推送的遥测帧
+    unsigned long frames_dropped;  // 发送队列满时丢弃的旧帧 (遥测和ACK)
+    unsigned long clients_total;   // 累计连接数
+    unsigned long clients_rejected;// 连接数满时拒绝的连接
+    int clients_active;            // 当前连接数
+} control_server_stats_t;
+
+// 附加统计：格式化其他通道的统计信息，追加在"stats"回复之后
+typedef int (*control_stats_hook_t)(char *buf, int size);
+
+int control_server_start(event_loop_t *loop, int port, int speed);
+void control_server_stop(void);
+control_server_stats_t control_server_get_stats(void);
+
+void control_server_set_stats_hook(control_stats_hook_t hook);
+
+// 执行运动命令 (PROTO_MOTION_*)，speed为0时使用服务器默认速度；TCP、UDP和共享内存通道共用
+// 调用前由调用者向arbiter申请控制权；正在运行的运动程序由手动命令接管
+int control_server_dispatch(int motion, int speed, int turn_ratio);
+
+// 格式化统计信息，返回写入长度
+int control_server_format_stats(const control_server_stats_t *stats, char *buf, int size);
+
+#endif // CONTROL_SERVER_H
@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dashboard.h"
+#include "http_server.h"
+#include "websocket.h"
+#include "json.h"
+#include "protocol.h"
+#include "telemetry.h"
+#include "motion_exec.h"
+
+// 单个仪表盘连接
+typedef struct {
+    http_ws_t *ws;                 // NULL表示空闲
+    int binary;
+    uint32_t fields;               // 订阅的字段组 (PROTO_TLM_*)
+    uint64_t period_ns;
+    uint64_t next_ns;
+    uint32_t sent_fields;          // 已发送过的字段组，之后只在变化时发送
+    proto_telemetry_t last;        // 各字段组上次发出的值
+    uint16_t seq;
+} dash_client_t;
+
+static event_source_t g_timer = { -1, NULL, NULL, NULL };
+static dash_client_t g_clients[HTTP_MAX_CLIENTS];
+static dashboard_stats_t g_stats;
+
+// 与上次发出的值比较，返回需要发送的字段组
+static uint32_t changed_fields(const dash_client_t *client, const proto_telemetry_t *tlm)
+{
+    const proto_telemetry_t *last = &client->last;
+    uint32_t avail = tlm->fields & client->fields;
+    uint32_t changed = avail & ~client->sent_fields;
+    uint32_t sent = avail & client->sent_fields;
+
+    if ((sent & PROTO_TLM_MOTION) &&
+        (tlm->left_speed != last->left_speed || tlm->right_speed != last->right_speed ||
+         tlm->motion != last->motion || tlm->moving != last->moving)) {
+        changed |= PROTO_TLM_MOTION;
+    }
+    if ((sent & PROTO_TLM_ENV) &&
+        (tlm->temperature_x10 != last->temperature_x10 || tlm->humidity_x10 != last->humidity_x10)) {
+        changed |= PROTO_TLM_ENV;
+    }
+    if ((sent & PROTO_TLM_DISTANCE) && tlm->distance_cm != last->distance_cm) {
+        changed |= PROTO_TLM_DISTANCE;
+    }
+    if ((sent & PROTO_TLM_DISPLAY) && memcmp(tlm->display, last->display, sizeof(tlm->display)) != 0) {
+        changed |= PROTO_TLM_DISPLAY;
+    }
+    if ((sent & PROTO_TLM_RGB) && memcmp(tlm->rgb, last->rgb, sizeof(tlm->rgb)) != 0) {
+        changed |= PROTO_TLM_RGB;
+    }
+    return changed;
+}
+
+static size_t encode_binary(uint8_t *buf, uint32_t changed, uint16_t seq, uint32_t t_ms,
+                            const proto_telemetry_t *tlm)
+{
+    uint8_t *p = buf;
+
+    *p++ = (uint8_t)changed;
+    *p++ = 0;
+    proto_put_u16(p, seq);
+    proto_put_u32(p + 2, t_ms);
+    p += 6;
+    if (changed & PROTO_TLM_MOTION) {
+        proto_put_u16(p, (uint16_t)tlm->left_speed);
+        proto_put_u16(p + 2, (uint16_t)tlm->right_speed);
+        p[4] = tlm->motion;
+        p[5] = tlm->moving;
+        p += 6;
+    }
+    if (changed & PROTO_TLM_ENV) {
+        proto_put_u16(p, (uint16_t)tlm->temperature_x10);
+        proto_put_u16(p + 2, tlm->humidity_x10);
+        p += 4;
+    }
+    if (changed & PROTO_TLM_DISTANCE) {
+        proto_put_u16(p, (uint16_t)tlm->distance_cm);
+        p += 2;
+    }
+    if (changed & PROTO_TLM_DISPLAY) {
+        memcpy(p, tlm->display, 4);
+        p += 4;
+    }
+    if (changed & PROTO_TLM_RGB) {
+        *p++ = (uint8_t)((tlm->rgb[0] ? 1 : 0) | (tlm->rgb[1] ? 2 : 0) | (tlm->rgb[2] ? 4 : 0));
+    }
+    return (size_t)(p - buf);
+}
+
+static void write_u8_array(json_writer_t *w, const char *key, const uint8_t *values, int count)
+{
+    json_array_begin(w, key);
+    for (int i = 0; i < count; i++) json_int(w, NULL, values[i]);
+    json_array_end(w);
+}
+
+static int encode_json(char *buf, size_t size, uint32_t changed, uint16_t seq, uint32_t t_ms,
+                       const proto_telemetry_t *tlm)
+{
+    json_writer_t w;
+
+    json_init(&w, buf, size);
+    json_object_begin(&w, NULL);
+    json_int(&w, "seq", seq);
+    json_int(&w, "t", (long)t_ms);
+    if (changed & PROTO_TLM_MOTION) {
+        json_object_begin(&w, "motion");
+        json_int(&w, "left", tlm->left_speed);
+        json_int(&w, "right", tlm->right_speed);
+        json_int(&w, "motion", tlm->motion);
+        json_int(&w, "moving", tlm->moving);
+        json_object_end(&w);
+    }
+    if (changed & PROTO_TLM_ENV) {
+        json_object_begin(&w, "env");
+        json_double(&w, "temperature", tlm->temperature_x10 / 10.0, 1);
+        json_double(&w, "humidity", tlm->humidity_x10 / 10.0, 1);
+        json_object_end(&w);
+    }
+    if (changed & PROTO_TLM_DISTANCE) {
+        json_int(&w, "distance", tlm->distance_cm);
+    }
+    if (changed & PROTO_TLM_DISPLAY) {
+        write_u8_array(&w, "display", tlm->display, 4);
+    }
+    if (changed & PROTO_TLM_RGB) {
+        write_u8_array(&w, "rgb", tlm->rgb, 3);
+    }
+    json_object_end(&w);
+    return json_finish(&w);
+}
+
+// 记录已发出的字段组的值
+static void remember(dash_client_t *client, uint32_t changed, const proto_telemetry_t *tlm)
+{
+    proto_telemetry_t *last = &client->last;
+
+    if (changed & PROTO_TLM_MOTION) {
+        last->left_speed = tlm->left_speed;
+        last->right_speed = tlm->right_speed;
+        last->motion = tlm->motion;
+        last->moving = tlm->moving;
+    }
+    if (changed & PROTO_TLM_ENV) {
+        last->temperature_x10 = tlm->temperature_x10;
+        last->humidity_x10 = tlm->humidity_x10;
+    }
+    if (changed & PROTO_TLM_DISTANCE) last->distance_cm = tlm->distance_cm;
+    if (changed & PROTO_TLM_DISPLAY) memcpy(last->display, tlm->display, sizeof(last->display));
+    if (changed & PROTO_TLM_RGB) memcpy(last->rgb, tlm->rgb, sizeof(last->rgb));
+    client->sent_fields |= changed;
+}
+
+static void push(dash_client_t *client, const proto_telemetry_t *tlm, uint64_t now)
+{
+    // 上次的消息还没写入socket：跳过，变化留到下次合并发送
+    if (http_ws_pending(client->ws) > 0) {
+        g_stats.skipped++;
+        return;
+    }
+
+    uint32_t changed = changed_fields(client, tlm);
+    if (changed == 0) {
+        g_stats.unchanged++;
+        return;
+    }
+
+    char buf[256];
+    uint32_t t_ms = (uint32_t)(now / 1000000ULL);
+    int len;
+    int opcode;
+    if (client->binary) {
+        len = (int)encode_binary((uint8_t *)buf, changed, client->seq, t_ms, tlm);
+        opcode = WS_OP_BINARY;
+    } else {
+        len = encode_json(buf, sizeof(buf), changed, client->seq, t_ms, tlm);
+        opcode = WS_OP_TEXT;
+    }
+    if (len < 0 || http_ws_send(client->ws, opcode, buf, len) != 0) {
+        g_stats.skipped++;
+        return;
+    }
+
+    remember(client, changed, tlm);
+    client->seq++;
+    g_stats.messages++;
+    g_stats.bytes += len;
+}
+
+static void timer_on_event(event_source_t *src, uint32_t events)
+{
+    proto_telemetry_t tlm;
+    int collected = 0;
+
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+
+    uint64_t now = motion_now_ns();
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        dash_client_t *client = &g_clients[i];
+        if (client->ws == NULL || now < client->next_ns) continue;
+
+        // 所有到期的连接共用同一份快照
+        if (!collected) {
+            telemetry_collect(&tlm, now);
+            collected = 1;
+        }
+        client->next_ns += client->period_ns;
+        if (client->next_ns <= now) client->next_ns = now + client->period_ns;
+
+        // push可能因发送失败关闭连接 (on_close清除client->ws)
+        push(client, &tlm, now);
+    }
+}
+
+static void update_timer(void)
+{
+    unsigned int tick_ms = 1000 / PROTO_TLM_MAX_HZ;
+
+    event_timer_set(&g_timer, g_stats.clients > 0 ? tick_ms : 0, g_stats.clients > 0 ? tick_ms : 0);
+}
+
+static void set_rate(dash_client_t *client, long rate)
+{
+    if (rate < 1) rate = 1;
+    if (rate > PROTO_TLM_MAX_HZ) rate = PROTO_TLM_MAX_HZ;
+    client->period_ns = 1000000000ULL / (uint64_t)rate;
+    client->next_ns = motion_now_ns();
+}
+
+// 在查询字符串中查找 key=value
+static int query_value(const char *query, const char *key, char *out, size_t size)
+{
+    size_t key_len = strlen(key);
+    const char *p = query;
+
+    while (*p) {
+        const char *end = strchr(p, '&');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > key_len && p[key_len] == '=' && strncmp(p, key, key_len) == 0) {
+            size_t n = len - key_len - 1;
+            if (n >= size) return -1;
+            memcpy(out, p + key_len + 1, n);
+            out[n] = '\0';
+            return 0;
+        }
+        p += len;
+        if (*p == '&') p++;
+    }
+    return -1;
+}
+
+static int on_open(http_ws_t *ws, const http_request_t *req)
+{
+    dash_client_t *client = NULL;
+    char value[16];
+
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        if (g_clients[i].ws == NULL) {
+            client = &g_clients[i];
+            break;
+        }
+    }
+    if (client == NULL) return -1;
+
+    memset(client, 0, sizeof(*client));
+    client->ws = ws;
+    client->fields = PROTO_TLM_ALL;
+    set_rate(client, DASHBOARD_DEFAULT_HZ);
+    if (query_value(req->query, "format", value, sizeof(value)) == 0) {
+        client->binary = (strcmp(value, "binary") == 0);
+    }
+    if (query_value(req->query, "fields", value, sizeof(value)) == 0) {
+        client->fields = (uint32_t)strtoul(value, NULL, 0) & PROTO_TLM_ALL;
+    }
+    if (query_value(req->query, "rate", value, sizeof(value)) == 0) {
+        set_rate(client, atol(value));
+    }
+    http_ws_set_ctx(ws, client);
+
+    g_stats.clients++;
+    update_timer();
+    return 0;
+}
+
+// 修改订阅：{"format":"binary","fields":31,"rate":20}，之后重新发送完整状态
+static void on_message(http_ws_t *ws, int opcode, const char *data, size_t len)
+{
+    dash_client_t *client = (dash_client_t *)http_ws_get_ctx(ws);
+    char format[16];
+    long value;
+
+    if (opcode != WS_OP_TEXT) return;
+    if (json_get_string(data, len, "format", format, sizeof(format)) == 0) {
+        client->binary = (strcmp(format, "binary") == 0);
+    }
+    if (json_get_int(data, len, "fields", &value) == 0) {
+        client->fields = (uint32_t)value & PROTO_TLM_ALL;
+    }
+    if (json_get_int(data, len, "rate", &value) == 0) {
+        set_rate(client, value);
+    }
+    client->sent_fields = 0;
+}
+
+static void on_close(http_ws_t *ws)
+{
+    dash_client_t *client = (dash_client_t *)http_ws_get_ctx(ws);
+
+    if (client == NULL) return;
+    client->ws = NULL;
+    g_stats.clients--;
+    update_timer();
+}
+
+static const http_ws_handler_t g_handler = {
+    DASHBOARD_PATH, on_open, on_message, on_close
+};
+
+int dashboard_start(event_loop_t *loop)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+    memset(g_clients, 0, sizeof(g_clients));
+
+    if (event_timer_create(loop, &g_timer, timer_on_event, NULL) != 0) {
+        return -1;
+    }
+    if (http_server_add_websocket(&g_handler) != 0) {
+        event_loop_remove(&g_timer);
+        return -1;
+    }
+    printf("实时数据推送: ws://<地址>:<端口>%s\n", DASHBOARD_PATH);
+    return 0;
+}
+
+void dashboard_stop(void)
+{
+    event_loop_remove(&g_timer);
+}
+
+dashboard_stats_t dashboard_get_stats(void)
+{
+    return g_stats;
+}
+
+int dashboard_format_stats(char *buf, int size)
+{
+    int len = snprintf(buf, size, "ws_clients=%d ws_sent=%lu ws_bytes=%lu ws_unchanged=%lu ws_skipped=%lu",
+                       g_stats.clients, g_stats.messages, g_stats.bytes, g_stats.unchanged, g_stats.skipped);
+    if (len >= size) len = size - 1;
+    return len;
+}
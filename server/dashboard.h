@@ -0,0 +1,46 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <stdint.h>
+#include "event_loop.h"
+
+// 实时数据推送 (WebSocket，供网页仪表盘使用)
+// 控制服务器的HTTP端口上提供DASHBOARD_PATH：按订阅频率取遥测快照 (telemetry_collect)，
+// 与每个连接上次发出的内容比较，只发送变化的字段组，没有变化时不发送。
+// 连接还有未写入socket的数据时跳过本次推送，期间的变化在下次推送时合并为一条 (只发送最新值)。
+//
+// 订阅参数 (URL查询字符串，或连接后发送JSON文本消息修改，修改后重新发送完整状态)：
+//   /ws/live?format=json|binary&fields=<PROTO_TLM_*掩码>&rate=<Hz>
+//   {"format":"binary","fields":31,"rate":20}
+//
+// JSON消息 (只包含变化的字段组):
+//   {"seq":1,"t":12345,"motion":{"left":60,"right":60,"motion":1,"moving":1},
+//    "env":{"temperature":23.5,"humidity":60.2},"distance":15,"display":[63,6,91,79],"rgb":[1,0,0]}
+// 二进制消息 (小端，字段组按PROTO_TLM_*位顺序排列):
+//   u8 changed (PROTO_TLM_*), u8 保留, u16 seq, u32 t (服务器毫秒)
+//   MOTION   i16 left, i16 right, u8 motion, u8 moving
+//   ENV      i16 temperature (0.1°C), u16 humidity (0.1%)
+//   DISTANCE i16 distance_cm
+//   DISPLAY  u8[4] 数码管段码
+//   RGB      u8 (bit0红 bit1绿 bit2蓝)
+
+#define DASHBOARD_PORT        8081
+#define DASHBOARD_PATH        "/ws/live"
+#define DASHBOARD_DEFAULT_HZ  20
+#define DASHBOARD_BINARY_MAX  25
+
+typedef struct {
+    unsigned long messages;        // 已发送的增量消息
+    unsigned long bytes;           // 消息负载字节数
+    unsigned long unchanged;       // 没有变化而不发送的次数
+    unsigned long skipped;         // 连接积压而跳过的次数
+    int clients;
+} dashboard_stats_t;
+
+// 在已启动的http_server上注册WebSocket路由
+int dashboard_start(event_loop_t *loop);
+void dashboard_stop(void);
+dashboard_stats_t dashboard_get_stats(void);
+int dashboard_format_stats(char *buf, int size);
+
+#endif // DASHBOARD_H
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "event_loop.h"
+
+int event_set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// 唤醒事件：清空eventfd计数
+static void event_loop_on_wakeup(event_source_t *src, uint32_t events)
+{
+    uint64_t value;
+    (void)events;
+    while (read(src->fd, &value, sizeof(value)) > 0)
+        ;
+}
+
+int event_loop_init(event_loop_t *loop)
+{
+    loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (loop->epfd < 0) {
+        perror("epoll_create1失败");
+        return -1;
+    }
+
+    loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->wakeup_fd < 0) {
+        perror("eventfd创建失败");
+        close(loop->epfd);
+        return -1;
+    }
+
+    loop->wakeup.fd = loop->wakeup_fd;
+    loop->wakeup.handler = event_loop_on_wakeup;
+    loop->wakeup.ctx = NULL;
+    loop->running = 0;
+    return event_loop_add(loop, &loop->wakeup, EPOLLIN);
+}
+
+void event_loop_close(event_loop_t *loop)
+{
+    if (loop->wakeup_fd >= 0) close(loop->wakeup_fd);
+    if (loop->epfd >= 0) close(loop->epfd);
+    loop->wakeup_fd = -1;
+    loop->epfd = -1;
+}
+
+int event_loop_add(event_loop_t *loop, event_source_t *src, uint32_t events)
+{
+    struct epoll_event ev;
+
+    ev.events = events;
+    ev.data.ptr = src;
+    src->loop = loop;
+    if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, src->fd, &ev) < 0) {
+        perror("epoll_ctl添加失败");
+        return -1;
+    }
+    return 0;
+}
+
+int event_loop_modify(event_source_t *src, uint32_t events)
+{
+    struct epoll_event ev;
+
+    ev.events = events;
+    ev.data.ptr = src;
+    return epoll_ctl(src->loop->epfd, EPOLL_CTL_MOD, src->fd, &ev);
+}
+
+// 移除并关闭事件源
+void event_loop_remove(event_source_t *src)
+{
+    if (src->fd < 0) return;
+    epoll_ctl(src->loop->epfd, EPOLL_CTL_DEL, src->fd, NULL);
+    close(src->fd);
+    src->fd = -1;
+}
+
+// 运行事件循环，直到event_loop_stop被调用
+int event_loop_run(event_loop_t *loop)
+{
+    struct epoll_event events[EVENT_LOOP_MAX_EVENTS];
+
+    loop->running = 1;
+    while (loop->running) {
+        int n = epoll_wait(loop->epfd, events, EVENT_LOOP_MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait失败");
+            return -1;
+        }
+
+        for (int i = 0; i < n; i++) {
+            event_source_t *src = (event_source_t *)events[i].data.ptr;
+            // 本批次中已被前面的回调移除
+            if (src->fd < 0) continue;
+            src->handler(src, events[i].events);
+        }
+    }
+    return 0;
+}
+
+// 停止事件循环 (异步信号安全，可在信号处理函数中调用)
+void event_loop_stop(event_loop_t *loop)
+{
+    uint64_t one = 1;
+    ssize_t ret;
+
+    loop->running = 0;
+    ret = write(loop->wakeup_fd, &one, sizeof(one));
+    (void)ret;
+}
+
+int event_timer_create(event_loop_t *loop, event_source_t *src, event_handler_t handler, void *ctx)
+{
+    src->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (src->fd < 0) {
+        perror("timerfd创建失败");
+        return -1;
+    }
+    src->handler = handler;
+    src->ctx = ctx;
+    return event_loop_add(loop, src, EPOLLIN);
+}
+
+int event_timer_set(event_source_t *src, unsigned int first_ms, unsigned int interval_ms)
+{
+    struct itimerspec spec;
+
+    spec.it_value.tv_sec = first_ms / 1000;
+    spec.it_value.tv_nsec = (long)(first_ms % 1000) * 1000000L;
+    spec.it_interval.tv_sec = interval_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(interval_ms % 1000) * 1000000L;
+    return timerfd_settime(src->fd, 0, &spec, NULL);
+}
+
+// 读取到期次数 (必须在回调中调用以清除就绪状态)
+uint64_t event_timer_read(event_source_t *src)
+{
+    uint64_t expirations = 0;
+
+    if (read(src->fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return 0;
+    }
+    return expirations;
+}
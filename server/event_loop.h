@@ -0,0 +1,52 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+// 单线程epoll事件循环
+// 事件源的内存由调用者持有 (通常是静态数组中的元素)，移除后fd置为-1，
+// 同一批就绪事件中已被移除的事件源会被跳过。
+
+typedef struct event_loop event_loop_t;
+typedef struct event_source event_source_t;
+
+// 事件回调：events为EPOLLIN/EPOLLOUT/EPOLLERR等
+typedef void (*event_handler_t)(event_source_t *src, uint32_t events);
+
+struct event_source {
+    int fd;
+    event_handler_t handler;
+    void *ctx;
+    event_loop_t *loop;
+};
+
+struct event_loop {
+    int epfd;
+    int wakeup_fd;             // eventfd，用于从信号处理函数或其他线程唤醒
+    volatile int running;
+    event_source_t wakeup;
+};
+
+// 每次epoll_wait最多处理的事件数
+#define EVENT_LOOP_MAX_EVENTS 64
+
+int event_loop_init(event_loop_t *loop);
+void event_loop_close(event_loop_t *loop);
+int event_loop_run(event_loop_t *loop);
+void event_loop_stop(event_loop_t *loop);
+
+// 事件源注册
+int event_loop_add(event_loop_t *loop, event_source_t *src, uint32_t events);
+int event_loop_modify(event_source_t *src, uint32_t events);
+void event_loop_remove(event_source_t *src);
+
+// 定时器 (timerfd)：first_ms后首次触发，之后每interval_ms触发一次 (0表示单次)
+int event_timer_create(event_loop_t *loop, event_source_t *src, event_handler_t handler, void *ctx);
+int event_timer_set(event_source_t *src, unsigned int first_ms, unsigned int interval_ms);
+uint64_t event_timer_read(event_source_t *src);
+
+// 把fd设置为非阻塞
+int event_set_nonblocking(int fd);
+
+#endif // EVENT_LOOP_H
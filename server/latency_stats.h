@@ -0,0 +1,52 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <stdint.h>
+
+// 延迟统计：计数、平均、最大值和log2直方图 (第i档为 [2^i, 2^(i+1)) 微秒)
+#define LATENCY_BUCKETS 16
+
+typedef struct {
+    unsigned long count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    unsigned long hist[LATENCY_BUCKETS];
+} latency_stats_t;
+
+static inline void latency_record(latency_stats_t *stats, uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    int bucket = 0;
+
+    while (us > 1 && bucket < LATENCY_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+
+    stats->count++;
+    stats->total_ns += ns;
+    if (ns > stats->max_ns) stats->max_ns = ns;
+    stats->hist[bucket]++;
+}
+
+static inline double latency_avg_us(const latency_stats_t *stats)
+{
+    return stats->count ? stats->total_ns / 1000.0 / stats->count : 0.0;
+}
+
+// 由直方图估算百分位延迟 (微秒，取所在档的上界)
+static inline double latency_percentile_us(const latency_stats_t *stats, double pct)
+{
+    unsigned long seen = 0;
+
+    if (stats->count == 0) return 0.0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += stats->hist[i];
+        if (seen * 100.0 >= pct * stats->count) {
+            return (double)(2UL << i);
+        }
+    }
+    return (double)(2UL << (LATENCY_BUCKETS - 1));
+}
+
+#endif // LATENCY_STATS_H
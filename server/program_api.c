@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string.h>
+#include "program_api.h"
+#include "json.h"
+#include "motion_program.h"
+#include "motion_exec.h"
+#include "control_server.h"
+#include "arbiter.h"
+
+static void finish_json(http_response_t *resp, json_writer_t *w)
+{
+    int len = json_finish(w);
+
+    if (len < 0) {
+        http_error(resp, 500, "响应过长");
+        return;
+    }
+    resp->body_len = len;
+}
+
+// 查询字符串中是否有 key=1
+static int query_flag(const char *query, const char *key)
+{
+    size_t key_len = strlen(key);
+    const char *p = query;
+
+    while (*p) {
+        if (strncmp(p, key, key_len) == 0 && p[key_len] == '=' && p[key_len + 1] == '1' &&
+            (p[key_len + 2] == '\0' || p[key_len + 2] == '&')) {
+            return 1;
+        }
+        p = strchr(p, '&');
+        if (p == NULL) break;
+        p++;
+    }
+    return 0;
+}
+
+static void write_status(json_writer_t *w, const motion_program_status_t *status)
+{
+    uint64_t end = status->end_ns ? status->end_ns : motion_now_ns();
+
+    json_object_begin(w, "program");
+    json_string(w, "state", motion_program_state_name(status->state));
+    json_int(w, "run", (long)status->run_id);
+    json_int(w, "line", status->line);
+    json_int(w, "pc", status->pc);
+    json_int(w, "instructions", status->count);
+    json_int(w, "steps", (long)status->steps);
+    json_int(w, "elapsed_ms", status->start_ns ? (long)((end - status->start_ns) / 1000000ULL) : 0);
+    json_double(w, "late_max_us", status->late_max_ns / 1000.0, 1);
+    json_double(w, "late_avg_us", status->timed_steps ? status->late_total_ns / 1000.0 / status->timed_steps : 0.0, 1);
+    if (status->error[0]) json_string(w, "error", status->error);
+    json_object_end(w);
+}
+
+// 程序结束时交还控制权 (被接管时持有者已经是接管的来源，不受影响)
+static void release_lease(void)
+{
+    arbiter_release(CONTROL_COMMANDER_PROGRAM);
+}
+
+static void handle_upload(const http_request_t *req, http_response_t *resp)
+{
+    static motion_program_t prog;  // 指令表较大，不放在事件循环线程的栈上
+    char error[PROGRAM_ERROR_SIZE];
+    json_writer_t w;
+    int dry_run = query_flag(req->query, "dry_run");
+
+    if (motion_program_compile(req->body, req->body_len, &prog, error, sizeof(error)) != 0) {
+        http_error(resp, 400, error);
+        return;
+    }
+    if (!dry_run) {
+        if (motion_program_running()) {
+            http_error(resp, 409, "已有程序在运行");
+            return;
+        }
+        // 程序持有控制权直到结束，不属于任何连接，断开连接不会打断程序；
+        // 优先级更高的遥控命令可以接管，自主程序的命令被拒绝
+        if (arbiter_acquire(CONTROL_COMMANDER_PROGRAM, ARBITER_PRIO_PROGRAM, ARBITER_LEASE_HOLD, 0) == ARBITER_DENIED) {
+            http_error(resp, 409, "控制权被优先级更高的来源持有");
+            return;
+        }
+        motion_program_set_finish_hook(release_lease);
+        if (motion_program_start(&prog) != 0) {
+            release_lease();
+            http_error(resp, 409, "已有程序在运行");
+            return;
+        }
+    }
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "success");
+    json_int(&w, "instructions", prog.count);
+    if (dry_run) {
+        json_bool(&w, "started", 0);
+    } else {
+        json_bool(&w, "started", 1);
+        json_int(&w, "run", (long)motion_program_get_status().run_id);
+    }
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static void handle_status(const http_request_t *req, http_response_t *resp)
+{
+    motion_program_status_t status = motion_program_get_status();
+    json_writer_t w;
+
+    (void)req;
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "success");
+    write_status(&w, &status);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static void handle_stop(const http_request_t *req, http_response_t *resp)
+{
+    json_writer_t w;
+
+    (void)req;
+    int running = motion_program_running();
+    motion_program_abort("停止请求");
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "success");
+    json_bool(&w, "was_running", running);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static const http_route_t g_routes[] = {
+    { HTTP_POST, "/api/program",      handle_upload },
+    { HTTP_GET,  "/api/program",      handle_status },
+    { HTTP_POST, "/api/program/stop", handle_stop },
+};
+
+const http_route_t *program_api_routes(int *count)
+{
+    *count = (int)(sizeof(g_routes) / sizeof(g_routes[0]));
+    return g_routes;
+}
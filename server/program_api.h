@@ -0,0 +1,15 @@
+#ifndef PROGRAM_API_H
+#define PROGRAM_API_H
+
+#include "http_server.h"
+
+// 运动程序HTTP接口 (控制服务器的HTTP端口，脚本格式见components/motion_program.h)
+//   POST /api/program         请求体为脚本文本，校验通过后立即执行；?dry_run=1 只校验不执行
+//   GET  /api/program         执行状态 (当前行、已执行步数、定时误差、结束原因)
+//   POST /api/program/stop    停止程序并停车
+// 程序以ARBITER_PRIO_PROGRAM持有控制权直到结束：遥控客户端持有控制权时拒绝启动 (409)，
+// 程序运行期间收到遥控的运动命令时由手动命令接管，共享内存邮箱等较低优先级的命令被拒绝。
+
+const http_route_t *program_api_routes(int *count);
+
+#endif // PROGRAM_API_H
@@ -0,0 +1,432 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 小车控制二进制协议 (服务器和Qt客户端共用，C/C++均可包含)
+//
+// 每帧 = 16字节帧头 + 定长负载，多字节字段均为小端序：
+//   偏移 0  u8   magic       固定为PROTO_MAGIC，文本命令不会以该字节开头，服务器据此识别协议
+//   偏移 1  u8   type        消息类型 (proto_msg_type_t)
+//   偏移 2  u8   flags       PROTO_FLAG_*
+//   偏移 3  u8   length      负载长度 (字节)
+//   偏移 4  u32  seq         发送方序号，每帧递增
+//   偏移 8  u64  timestamp   发送方单调时钟 (微秒)
+//
+// 解析直接在接收缓冲区上进行，负载以指针形式返回，不做拷贝。
+// TCP连接上帧首尾相接；UDP通道每个数据报恰好一帧。
+// TCP连接订阅遥测后，服务器会在ACK之间穿插主动推送的遥测帧。
+
+#define PROTO_MAGIC        0xA5
+#define PROTO_HEADER_SIZE  16
+#define PROTO_MAX_PAYLOAD  48
+#define PROTO_MAX_FRAME    (PROTO_HEADER_SIZE + PROTO_MAX_PAYLOAD)
+
+// 帧头标志
+#define PROTO_FLAG_ACK_REQ     0x01   // 请求服务器回复ACK
+#define PROTO_FLAG_APPLIED_REQ 0x02   // 请求命令写入PWM后回复APPLIED
+
+// 消息类型
+typedef enum {
+    PROTO_MSG_DRIVE     = 0x01,   // 客户端->服务器：运动命令
+    PROTO_MSG_SUBSCRIBE = 0x02,   // 客户端->服务器：订阅遥测
+    PROTO_MSG_PING      = 0x03,   // 客户端->服务器：延迟探测 (无负载)
+    PROTO_MSG_LEASE     = 0x04,   // 客户端->服务器：申请/释放控制权 (TCP)
+    PROTO_MSG_ACK       = 0x81,   // 服务器->客户端：命令确认
+    PROTO_MSG_TELEMETRY = 0x82,   // 服务器->客户端：遥测
+    PROTO_MSG_PONG      = 0x83,   // 服务器->客户端：延迟探测回复
+    PROTO_MSG_APPLIED   = 0x84    // 服务器->客户端：命令已写入PWM
+} proto_msg_type_t;
+
+// 运动命令 (与文本命令一一对应)
+typedef enum {
+    PROTO_MOTION_STOP = 0,
+    PROTO_MOTION_FORWARD,
+    PROTO_MOTION_BACKWARD,
+    PROTO_MOTION_SPINLEFT,
+    PROTO_MOTION_SPINRIGHT,
+    PROTO_MOTION_FORWARDLEFT,
+    PROTO_MOTION_FORWARDRIGHT,
+    PROTO_MOTION_BACKWARDLEFT,
+    PROTO_MOTION_BACKWARDRIGHT,
+    PROTO_MOTION_COUNT
+} proto_motion_t;
+
+// ACK状态
+typedef enum {
+    PROTO_STATUS_OK = 0,
+    PROTO_STATUS_STALE,           // 序号不大于已执行的命令，已丢弃
+    PROTO_STATUS_INVALID,         // 负载无效
+    PROTO_STATUS_SUPERSEDED,      // UDP：同一批收到的更新命令已取代本命令
+    PROTO_STATUS_DENIED           // 控制权被其他来源持有 (或本连接是观察者)，命令未执行
+} proto_status_t;
+
+// 帧头 (解码后)
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint8_t length;
+    uint32_t seq;
+    uint64_t timestamp_us;
+} proto_header_t;
+
+// 运动命令负载 (4字节)
+//   u8 motion, u8 speed (0~100，0表示使用服务器默认速度), u8 turn_ratio (0~100，内侧轮减速比例), u8 保留
+#define PROTO_DRIVE_SIZE 4
+typedef struct {
+    uint8_t motion;
+    uint8_t speed;
+    uint8_t turn_ratio;
+} proto_drive_t;
+
+// ACK负载 (20字节)，APPLIED使用相同布局
+//   u32 ack_seq, u32 latency_us (服务器处理延迟), u64 echo_us (原样返回命令帧的timestamp), u8 status, 3字节保留
+//   APPLIED的latency_us为服务器读入命令到执行线程写入PWM的时间，
+//   status为PROTO_STATUS_SUPERSEDED时命令被后续命令取代而未执行
+#define PROTO_ACK_SIZE 20
+typedef struct {
+    uint32_t ack_seq;
+    uint32_t latency_us;
+    uint64_t echo_us;
+    uint8_t status;
+} proto_ack_t;
+
+// PONG负载 (16字节)
+//   u64 echo_us (原样返回PING帧的timestamp), u64 rx_us (服务器读入PING的时间，服务器时钟)
+//   帧头timestamp为服务器发送时间，两者之差为服务器内部停留时间
+#define PROTO_PONG_SIZE 16
+typedef struct {
+    uint64_t echo_us;
+    uint64_t rx_us;
+} proto_pong_t;
+
+// 控制权租约负载 (4字节)
+//   u8 priority (0为只读观察者，1自主程序，2运动程序，3遥控 (默认)，4接管，最大15)，
+//   u8 flags (PROTO_LEASE_*)，u16 lease_ms (0表示空闲租约：每条命令续约，空闲1秒后其他来源可以接管；
+//   非0表示限时租约：到期前没有新命令时服务器停车)
+//   设置之后本连接的运动命令都按该优先级和租约申请控制权；ACK的status为OK或DENIED
+#define PROTO_LEASE_SIZE    4
+#define PROTO_LEASE_RELEASE 0x01  // 释放控制权 (持有时停车)，之后的命令重新申请
+typedef struct {
+    uint8_t priority;
+    uint8_t flags;
+    uint16_t lease_ms;
+} proto_lease_t;
+
+// 遥测字段 (订阅掩码和遥测帧的有效字段共用)
+#define PROTO_TLM_MOTION    0x01  // 运动状态 (get_motion_state)
+#define PROTO_TLM_ENV       0x02  // 温湿度 (DHT11)
+#define PROTO_TLM_DISTANCE  0x04  // 超声波距离
+#define PROTO_TLM_DISPLAY   0x08  // 数码管段码
+#define PROTO_TLM_RGB       0x10  // RGB灯状态
+#define PROTO_TLM_ALL       0x1f
+
+#define PROTO_TLM_MAX_HZ    50
+
+// 订阅负载 (8字节)
+//   u32 fields (PROTO_TLM_*，0表示取消订阅), u16 rate_hz (1~PROTO_TLM_MAX_HZ), 2字节保留
+#define PROTO_SUBSCRIBE_SIZE 8
+typedef struct {
+    uint32_t fields;
+    uint16_t rate_hz;
+} proto_subscribe_t;
+
+// 遥测负载 (40字节，字段位置固定，fields标明本帧中有效的字段)
+//   偏移 0  u32 fields
+//   偏移 4  i16 left_speed, i16 right_speed, u8 motion (motion_type_t), u8 moving, 2字节保留
+//   偏移 12 u32 motion_seq
+//   偏移 16 i16 temperature (0.1°C), u16 humidity (0.1%), u32 env_age_ms (距上次成功读取的时间)
+//   偏移 24 i16 distance_cm, 2字节保留, u32 distance_age_ms
+//   偏移 32 u8[4] display (数码管段码，从左到右)
+//   偏移 36 u8 red, u8 green, u8 blue, 1字节保留
+#define PROTO_TELEMETRY_SIZE 40
+typedef struct {
+    uint32_t fields;
+    int16_t left_speed;
+    int16_t right_speed;
+    uint8_t motion;
+    uint8_t moving;
+    uint32_t motion_seq;
+    int16_t temperature_x10;
+    uint16_t humidity_x10;
+    uint32_t env_age_ms;
+    int16_t distance_cm;
+    uint32_t distance_age_ms;
+    uint8_t display[4];
+    uint8_t rgb[3];
+} proto_telemetry_t;
+
+// 一个完整帧：payload指向接收缓冲区
+typedef struct {
+    proto_header_t header;
+    const uint8_t *payload;
+} proto_frame_t;
+
+// ---------------- 小端序读写 ----------------
+
+static inline void proto_put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void proto_put_u32(uint8_t *p, uint32_t v)
+{
+    proto_put_u16(p, (uint16_t)v);
+    proto_put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static inline void proto_put_u64(uint8_t *p, uint64_t v)
+{
+    proto_put_u32(p, (uint32_t)v);
+    proto_put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint16_t proto_get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t proto_get_u32(const uint8_t *p)
+{
+    return (uint32_t)proto_get_u16(p) | ((uint32_t)proto_get_u16(p + 2) << 16);
+}
+
+static inline uint64_t proto_get_u64(const uint8_t *p)
+{
+    return (uint64_t)proto_get_u32(p) | ((uint64_t)proto_get_u32(p + 4) << 32);
+}
+
+// ---------------- 编码 ----------------
+
+// 写入帧头，返回帧头长度
+static inline size_t proto_encode_header(uint8_t *buf, uint8_t type, uint8_t flags, uint8_t length,
+                                         uint32_t seq, uint64_t timestamp_us)
+{
+    buf[0] = PROTO_MAGIC;
+    buf[1] = type;
+    buf[2] = flags;
+    buf[3] = length;
+    proto_put_u32(buf + 4, seq);
+    proto_put_u64(buf + 8, timestamp_us);
+    return PROTO_HEADER_SIZE;
+}
+
+// 编码运动命令帧，返回帧长度
+static inline size_t proto_encode_drive(uint8_t *buf, uint32_t seq, uint64_t timestamp_us, uint8_t flags,
+                                        uint8_t motion, uint8_t speed, uint8_t turn_ratio)
+{
+    uint8_t *payload = buf + PROTO_HEADER_SIZE;
+
+    proto_encode_header(buf, PROTO_MSG_DRIVE, flags, PROTO_DRIVE_SIZE, seq, timestamp_us);
+    payload[0] = motion;
+    payload[1] = speed;
+    payload[2] = turn_ratio;
+    payload[3] = 0;
+    return PROTO_HEADER_SIZE + PROTO_DRIVE_SIZE;
+}
+
+// 编码ACK或APPLIED帧，返回帧长度
+static inline size_t proto_encode_ack_type(uint8_t *buf, uint8_t type, uint32_t seq, uint64_t timestamp_us,
+                                           const proto_ack_t *ack)
+{
+    uint8_t *payload = buf + PROTO_HEADER_SIZE;
+
+    proto_encode_header(buf, type, 0, PROTO_ACK_SIZE, seq, timestamp_us);
+    proto_put_u32(payload, ack->ack_seq);
+    proto_put_u32(payload + 4, ack->latency_us);
+    proto_put_u64(payload + 8, ack->echo_us);
+    payload[16] = ack->status;
+    payload[17] = payload[18] = payload[19] = 0;
+    return PROTO_HEADER_SIZE + PROTO_ACK_SIZE;
+}
+
+static inline size_t proto_encode_ack(uint8_t *buf, uint32_t seq, uint64_t timestamp_us, const proto_ack_t *ack)
+{
+    return proto_encode_ack_type(buf, PROTO_MSG_ACK, seq, timestamp_us, ack);
+}
+
+static inline size_t proto_encode_applied(uint8_t *buf, uint32_t seq, uint64_t timestamp_us, const proto_ack_t *ack)
+{
+    return proto_encode_ack_type(buf, PROTO_MSG_APPLIED, seq, timestamp_us, ack);
+}
+
+// 编码PING帧 (只有帧头)，返回帧长度
+static inline size_t proto_encode_ping(uint8_t *buf, uint32_t seq, uint64_t timestamp_us)
+{
+    return proto_encode_header(buf, PROTO_MSG_PING, 0, 0, seq, timestamp_us);
+}
+
+// 编码PONG帧，返回帧长度
+static inline size_t proto_encode_pong(uint8_t *buf, uint32_t seq, uint64_t timestamp_us, const proto_pong_t *pong)
+{
+    uint8_t *payload = buf + PROTO_HEADER_SIZE;
+
+    proto_encode_header(buf, PROTO_MSG_PONG, 0, PROTO_PONG_SIZE, seq, timestamp_us);
+    proto_put_u64(payload, pong->echo_us);
+    proto_put_u64(payload + 8, pong->rx_us);
+    return PROTO_HEADER_SIZE + PROTO_PONG_SIZE;
+}
+
+// 编码订阅帧，返回帧长度
+static inline size_t proto_encode_subscribe(uint8_t *buf, uint32_t seq, uint64_t timestamp_us,
+                                            uint32_t fields, uint16_t rate_hz)
+{
+    uint8_t *payload = buf + PROTO_HEADER_SIZE;
+
+    proto_encode_header(buf, PROTO_MSG_SUBSCRIBE, 0, PROTO_SUBSCRIBE_SIZE, seq, timestamp_us);
+    proto_put_u32(payload, fields);
+    proto_put_u16(payload + 4, rate_hz);
+    proto_put_u16(payload + 6, 0);
+    return PROTO_HEADER_SIZE + PROTO_SUBSCRIBE_SIZE;
+}
+
+// 编码租约帧，返回帧长度
+static inline size_t proto_encode_lease(uint8_t *buf, uint32_t seq, uint64_t timestamp_us, uint8_t flags,
+                                        const proto_lease_t *lease)
+{
+    uint8_t *payload = buf + PROTO_HEADER_SIZE;
+
+    proto_encode_header(buf, PROTO_MSG_LEASE, flags, PROTO_LEASE_SIZE, seq, timestamp_us);
+    payload[0] = lease->priority;
+    payload[1] = lease->flags;
+    proto_put_u16(payload + 2, lease->lease_ms);
+    return PROTO_HEADER_SIZE + PROTO_LEASE_SIZE;
+}
+
+// 编码遥测帧，返回帧长度
+static inline size_t proto_encode_telemetry(uint8_t *buf, uint32_t seq, uint64_t timestamp_us,
+                                            const proto_telemetry_t *tlm)
+{
+    uint8_t *payload = buf + PROTO_HEADER_SIZE;
+
+    proto_encode_header(buf, PROTO_MSG_TELEMETRY, 0, PROTO_TELEMETRY_SIZE, seq, timestamp_us);
+    proto_put_u32(payload, tlm->fields);
+    proto_put_u16(payload + 4, (uint16_t)tlm->left_speed);
+    proto_put_u16(payload + 6, (uint16_t)tlm->right_speed);
+    payload[8] = tlm->motion;
+    payload[9] = tlm->moving;
+    proto_put_u16(payload + 10, 0);
+    proto_put_u32(payload + 12, tlm->motion_seq);
+    proto_put_u16(payload + 16, (uint16_t)tlm->temperature_x10);
+    proto_put_u16(payload + 18, tlm->humidity_x10);
+    proto_put_u32(payload + 20, tlm->env_age_ms);
+    proto_put_u16(payload + 24, (uint16_t)tlm->distance_cm);
+    proto_put_u16(payload + 26, 0);
+    proto_put_u32(payload + 28, tlm->distance_age_ms);
+    for (int i = 0; i < 4; i++) payload[32 + i] = tlm->display[i];
+    payload[36] = tlm->rgb[0];
+    payload[37] = tlm->rgb[1];
+    payload[38] = tlm->rgb[2];
+    payload[39] = 0;
+    return PROTO_HEADER_SIZE + PROTO_TELEMETRY_SIZE;
+}
+
+// ---------------- 解码 ----------------
+
+// 从buf开头解析一帧：返回帧长度；数据不足一帧时返回0；
+// 帧头无效 (magic错误或负载过长) 时返回-1，调用者应跳过一个字节重新同步
+static inline int proto_parse(const uint8_t *buf, size_t len, proto_frame_t *frame)
+{
+    if (len < 1) return 0;
+    if (buf[0] != PROTO_MAGIC) return -1;
+    if (len < PROTO_HEADER_SIZE) return 0;
+    if (buf[3] > PROTO_MAX_PAYLOAD) return -1;
+
+    size_t total = PROTO_HEADER_SIZE + buf[3];
+    if (len < total) return 0;
+
+    frame->header.type = buf[1];
+    frame->header.flags = buf[2];
+    frame->header.length = buf[3];
+    frame->header.seq = proto_get_u32(buf + 4);
+    frame->header.timestamp_us = proto_get_u64(buf + 8);
+    frame->payload = buf + PROTO_HEADER_SIZE;
+    return (int)total;
+}
+
+// 解码运动命令负载，长度不符时返回-1
+static inline int proto_decode_drive(const proto_frame_t *frame, proto_drive_t *drive)
+{
+    if (frame->header.type != PROTO_MSG_DRIVE || frame->header.length != PROTO_DRIVE_SIZE) return -1;
+    drive->motion = frame->payload[0];
+    drive->speed = frame->payload[1];
+    drive->turn_ratio = frame->payload[2];
+    return 0;
+}
+
+// 解码ACK或APPLIED负载，类型或长度不符时返回-1
+static inline int proto_decode_ack_type(const proto_frame_t *frame, uint8_t type, proto_ack_t *ack)
+{
+    if (frame->header.type != type || frame->header.length != PROTO_ACK_SIZE) return -1;
+    ack->ack_seq = proto_get_u32(frame->payload);
+    ack->latency_us = proto_get_u32(frame->payload + 4);
+    ack->echo_us = proto_get_u64(frame->payload + 8);
+    ack->status = frame->payload[16];
+    return 0;
+}
+
+static inline int proto_decode_ack(const proto_frame_t *frame, proto_ack_t *ack)
+{
+    return proto_decode_ack_type(frame, PROTO_MSG_ACK, ack);
+}
+
+static inline int proto_decode_applied(const proto_frame_t *frame, proto_ack_t *ack)
+{
+    return proto_decode_ack_type(frame, PROTO_MSG_APPLIED, ack);
+}
+
+// 解码PONG负载，长度不符时返回-1
+static inline int proto_decode_pong(const proto_frame_t *frame, proto_pong_t *pong)
+{
+    if (frame->header.type != PROTO_MSG_PONG || frame->header.length != PROTO_PONG_SIZE) return -1;
+    pong->echo_us = proto_get_u64(frame->payload);
+    pong->rx_us = proto_get_u64(frame->payload + 8);
+    return 0;
+}
+
+// 解码订阅负载，长度不符时返回-1
+static inline int proto_decode_subscribe(const proto_frame_t *frame, proto_subscribe_t *sub)
+{
+    if (frame->header.type != PROTO_MSG_SUBSCRIBE || frame->header.length != PROTO_SUBSCRIBE_SIZE) return -1;
+    sub->fields = proto_get_u32(frame->payload);
+    sub->rate_hz = proto_get_u16(frame->payload + 4);
+    return 0;
+}
+
+// 解码租约负载，长度不符时返回-1
+static inline int proto_decode_lease(const proto_frame_t *frame, proto_lease_t *lease)
+{
+    if (frame->header.type != PROTO_MSG_LEASE || frame->header.length != PROTO_LEASE_SIZE) return -1;
+    lease->priority = frame->payload[0];
+    lease->flags = frame->payload[1];
+    lease->lease_ms = proto_get_u16(frame->payload + 2);
+    return 0;
+}
+
+// 解码遥测负载，长度不符时返回-1
+static inline int proto_decode_telemetry(const proto_frame_t *frame, proto_telemetry_t *tlm)
+{
+    const uint8_t *p = frame->payload;
+
+    if (frame->header.type != PROTO_MSG_TELEMETRY || frame->header.length != PROTO_TELEMETRY_SIZE) return -1;
+    tlm->fields = proto_get_u32(p);
+    tlm->left_speed = (int16_t)proto_get_u16(p + 4);
+    tlm->right_speed = (int16_t)proto_get_u16(p + 6);
+    tlm->motion = p[8];
+    tlm->moving = p[9];
+    tlm->motion_seq = proto_get_u32(p + 12);
+    tlm->temperature_x10 = (int16_t)proto_get_u16(p + 16);
+    tlm->humidity_x10 = proto_get_u16(p + 18);
+    tlm->env_age_ms = proto_get_u32(p + 20);
+    tlm->distance_cm = (int16_t)proto_get_u16(p + 24);
+    tlm->distance_age_ms = proto_get_u32(p + 28);
+    for (int i = 0; i < 4; i++) tlm->display[i] = p[32 + i];
+    tlm->rgb[0] = p[36];
+    tlm->rgb[1] = p[37];
+    tlm->rgb[2] = p[38];
+    return 0;
+}
+
+#endif // PROTOCOL_H
@@ -0,0 +1,266 @@
+// 小车控制服务器 (替代qt/wiringPi_TCPServer.py)：TCP命令通道 + UDP遥控通道
+// + HTTP端口 (WebSocket实时数据推送、运动程序上传) + 共享内存状态块 (本地进程)
+// 用法: control_server [-p 端口] [-s 速度%] [-d 死人开关毫秒] [-w HTTP端口，0表示不启用]
+//                      [-m 共享内存名称，""表示不启用] [-r 记录文件] [-M 指标端口，0表示不启用]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <wiringPi.h>
+#include "control.h"
+#include "motion_exec.h"
+#include "event_loop.h"
+#include "control_server.h"
+#include "udp_teleop.h"
+#include "apply_tracker.h"
+#include "http_server.h"
+#include "dashboard.h"
+#include "program_api.h"
+#include "shm_status.h"
+#include "arbiter.h"
+#include "recorder.h"
+#include "motion_program.h"
+#include "rgb.h"
+#include "beep.h"
+#include "servo.h"
+#include "sensor_cache.h"
+#include "DHT.h"
+#include "usonic.h"
+#include "startup.h"
+#include "logger.h"
+#include "metrics.h"
+
+static event_loop_t g_loop;
+static int g_ws_port = DASHBOARD_PORT;
+static const char *g_shm_name = SHM_STATUS_NAME;
+static const char *g_record_path = NULL;
+static int g_metrics_port = METRICS_PORT;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    event_loop_stop(&g_loop);
+}
+
+static int pin_in_use(const motor_pinmap_t *map, int pin)
+{
+    return pin == map->left_fwd || pin == map->left_rev || pin == map->right_fwd || pin == map->right_rev;
+}
+
+// 遥测使用的传感器：与电机接线冲突的传感器不采样
+static unsigned int telemetry_sensors(const motor_pinmap_t *map)
+{
+    unsigned int sensors = 0;
+
+    if (pin_in_use(map, DHT_PIN)) {
+        printf("DHT11引脚%d与电机接线冲突，不采样温湿度\n", DHT_PIN);
+    } else {
+        sensors |= SENSOR_CACHE_DHT;
+    }
+    if (pin_in_use(map, TRIG) || pin_in_use(map, ECHO)) {
+        printf("超声波引脚%d/%d与电机接线冲突，不采样距离\n", TRIG, ECHO);
+    } else {
+        sensors |= SENSOR_CACHE_DISTANCE;
+    }
+    return sensors;
+}
+
+// 运动程序可用的设备：与电机接线冲突的设备不可用
+static unsigned int program_devices(const motor_pinmap_t *map, unsigned int sensors)
+{
+    unsigned int devices = 0;
+
+    if (!pin_in_use(map, R) && !pin_in_use(map, G) && !pin_in_use(map, B)) devices |= PROGRAM_DEV_RGB;
+    if (!pin_in_use(map, BEEP_PIN)) devices |= PROGRAM_DEV_BEEP;
+    if (!pin_in_use(map, SERVO_PIN)) devices |= PROGRAM_DEV_SERVO;
+    if (sensors & SENSOR_CACHE_DISTANCE) devices |= PROGRAM_DEV_DISTANCE;
+    return devices;
+}
+
+// 记录传感器缓存的新读数 (记录线程每个周期调用)
+static void record_sensors(void)
+{
+    static uint32_t last_seq = 0;
+    sensor_reading_t reading;
+
+    sensor_cache_get(&reading);
+    if (reading.seq == last_seq) return;
+    last_seq = reading.seq;
+    recorder_log(REC_SENSOR, reading.valid, 0, reading.distance_cm, (int)(reading.humidity * 10),
+                 (int)(reading.temperature * 10));
+}
+
+// "stats"回复中追加控制权仲裁、UDP通道、实时数据推送、共享内存邮箱、记录和日志的统计
+static int format_extra_stats(char *buf, int size)
+{
+    int len = arbiter_format_stats(buf, size);
+
+    if (len < size - 2) {
+        buf[len++] = ' ';
+        len += udp_teleop_format_stats(buf + len, size - len);
+    }
+
+    if (g_ws_port > 0 && len < size - 2) {
+        buf[len++] = ' ';
+        len += dashboard_format_stats(buf + len, size - len);
+    }
+    if (g_shm_name[0] != '\0' && len < size - 2) {
+        buf[len++] = ' ';
+        len += shm_status_format_stats(buf + len, size - len);
+    }
+    if (g_record_path != NULL && len < size - 2) {
+        buf[len++] = ' ';
+        len += recorder_format_stats(buf + len, size - len);
+    }
+    if (len < size - 2) {
+        buf[len++] = ' ';
+        len += log_format_stats(buf + len, size - len);
+    }
+    return len;
+}
+
+static void print_usage(const char *prog)
+{
+    printf("用法: %s [-p 端口] [-s 速度%%] [-d 死人开关毫秒] [-w HTTP端口] [-m 共享内存名称] [-r 记录文件] [-M 指标端口]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    motor_pinmap_t pinmap = MOTOR_PINMAP_HBRIDGE;
+    int port = CONTROL_SERVER_PORT;
+    int speed = CONTROL_DEFAULT_SPEED;
+    int deadman_ms = UDP_DEADMAN_MS;
+    int route_count;
+    int opt;
+
+    startup_mark();
+    while ((opt = getopt(argc, argv, "p:s:d:w:m:r:M:h")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 's':
+                speed = atoi(optarg);
+                break;
+            case 'd':
+                deadman_ms = atoi(optarg);
+                break;
+            case 'w':
+                g_ws_port = atoi(optarg);
+                break;
+            case 'm':
+                g_shm_name = optarg;
+                break;
+            case 'r':
+                g_record_path = optarg;
+                break;
+            case 'M':
+                g_metrics_port = atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (wiringPiSetupGpio() == -1) {
+        printf("初始化 wiringPi 失败!\n");
+        return 1;
+    }
+
+    // 不设置SA_RESTART，收到信号时epoll_wait立即返回
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (event_loop_init(&g_loop) != 0 || log_start(NULL) != 0) {
+        return 1;
+    }
+    control_init_pinmap(&pinmap);
+    // 电机初始化之后开始记录，回放工具 (bench/replay.c) 初始化后以同样的状态开始回放
+    if (g_record_path != NULL && recorder_start(g_record_path, record_sensors) != 0) {
+        control_cleanup();
+        event_loop_close(&g_loop);
+        return 1;
+    }
+    unsigned int sensors = telemetry_sensors(&pinmap);
+    motion_program_init(program_devices(&pinmap, sensors));
+    const http_route_t *routes = program_api_routes(&route_count);
+    if (apply_tracker_init(&g_loop) != 0 || arbiter_start(&g_loop) != 0) {
+        apply_tracker_close();
+        control_cleanup();
+        recorder_stop();
+        event_loop_close(&g_loop);
+        return 1;
+    }
+    // UDP遥控通道与TCP使用相同端口号
+    if (control_server_start(&g_loop, port, speed) != 0 ||
+        udp_teleop_start(&g_loop, port, deadman_ms) != 0 ||
+        (g_ws_port > 0 && (http_server_start(&g_loop, g_ws_port, routes, route_count) != 0 || dashboard_start(&g_loop) != 0)) ||
+        shm_status_start(&g_loop, g_shm_name) != 0) {
+        http_server_stop();
+        dashboard_stop();
+        udp_teleop_stop();
+        control_server_stop();
+        arbiter_stop();
+        apply_tracker_close();
+        control_cleanup();
+        recorder_stop();
+        event_loop_close(&g_loop);
+        return 1;
+    }
+    control_server_set_stats_hook(format_extra_stats);
+    sensor_cache_start(sensors);
+    // 指标导出失败不影响控制
+    metrics_serve_start(g_metrics_port);
+    startup_log("开始接受命令");
+
+    event_loop_run(&g_loop);
+
+    // 退出前打印统计信息
+    control_server_stats_t stats = control_server_get_stats();
+    char line[512];
+    control_server_format_stats(&stats, line, sizeof(line));
+    printf("\n%s\n", line);
+    udp_teleop_format_stats(line, sizeof(line));
+    printf("%s\n", line);
+    arbiter_format_stats(line, sizeof(line));
+    printf("%s\n", line);
+    if (g_ws_port > 0) {
+        dashboard_format_stats(line, sizeof(line));
+        printf("%s\n", line);
+    }
+    if (g_shm_name[0] != '\0') {
+        shm_status_format_stats(line, sizeof(line));
+        printf("%s\n", line);
+    }
+
+    motion_latency_t latency = motion_exec_get_latency();
+    printf("命令到PWM延迟: 平均 %.1fus, 最大 %.1fus (%lu 条)\n",
+           latency.count ? latency.total_ns / 1000.0 / latency.count : 0.0,
+           latency.max_ns / 1000.0, latency.count);
+
+    metrics_serve_stop();
+    shm_status_stop();
+    http_server_stop();
+    dashboard_stop();
+    udp_teleop_stop();
+    control_server_stop();
+    apply_tracker_close();
+    motion_program_close();
+    arbiter_stop();
+    sensor_cache_stop();
+    printf("正在清理GPIO端口\n");
+    control_cleanup();
+    if (g_record_path != NULL) {
+        recorder_stop();
+        recorder_format_stats(line, sizeof(line));
+        printf("%s\n", line);
+    }
+    event_loop_close(&g_loop);
+    return 0;
+}
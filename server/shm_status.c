@@ -0,0 +1,303 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shm_status.h"
+#include "event_loop.h"
+#include "control_server.h"
+#include "arbiter.h"
+#include "control.h"
+#include "motion_exec.h"
+#include "motion_program.h"
+#include "protocol.h"
+#include "sensor_cache.h"
+#include "clock.h"
+#include "rgb.h"
+#include "logger.h"
+
+#define SHM_STUCK_TICKS     50     // 槽位内容一直不完整 (生产者写入出错) 时跳过该命令
+#define SHM_PRODUCER_CHECK  500    // 每隔多少个周期检查占用邮箱的进程是否还在
+
+typedef struct {
+    unsigned long publishes;       // 发布的状态更新 (各部分合计)
+    unsigned long commands;        // 取出的有效命令
+    unsigned long applied;         // 执行的命令
+    unsigned long superseded;      // 被同一周期内更新的命令取代
+    unsigned long rejected;        // 无效命令
+    unsigned long denied;          // 控制权被优先级更高的来源持有而未执行
+    unsigned long producer_exits;  // 占用邮箱的进程退出后释放邮箱的次数
+} shm_stats_t;
+
+static event_source_t g_timer = { -1, NULL, NULL, NULL };
+static shm_status_t *g_shm;
+static size_t g_map_size;
+static char g_name[64];
+static shm_stats_t g_stats;
+static unsigned long g_ticks;
+static uint32_t g_stuck_seq;       // 内容不完整的槽位序号
+static unsigned int g_stuck_ticks;
+
+// 上一次发布的内容，没有变化时不写入 (避免读者无谓重试)
+static uint32_t g_last_motion_seq;
+static int g_last_commander;
+static uint32_t g_last_sensor_seq;
+static uint8_t g_last_panel[8];
+
+// 写入一个部分：seqlock保护部分开头的lock之后的全部字段
+static void publish(void *section, const void *value, size_t size)
+{
+    seqlock_t *lock = (seqlock_t *)section;
+
+    seqlock_write_begin(lock);
+    seqlock_copy_in((uint8_t *)section + sizeof(seqlock_t), (const uint8_t *)value + sizeof(seqlock_t),
+                    size - sizeof(seqlock_t));
+    seqlock_write_end(lock);
+    g_stats.publishes++;
+}
+
+static void publish_state(uint64_t now)
+{
+    motion_state_t state = get_motion_state();
+    int commander = arbiter_holder();
+
+    if (state.seq != g_last_motion_seq || commander != g_last_commander || g_shm->motion.updates == 0) {
+        shm_motion_t motion;
+        memset(&motion, 0, sizeof(motion));
+        motion.updates = g_shm->motion.updates + 1;
+        motion.updated_ns = now;
+        motion.left_speed = state.left_speed;
+        motion.right_speed = state.right_speed;
+        motion.motion = state.current_motion;
+        motion.moving = state.is_moving;
+        motion.motion_seq = state.seq;
+        motion.commander = commander;
+        motion.motion_ns = state.timestamp_ns;
+        publish(&g_shm->motion, &motion, sizeof(motion));
+        g_last_motion_seq = state.seq;
+        g_last_commander = commander;
+    }
+
+    sensor_reading_t reading;
+    sensor_cache_get(&reading);
+    if (reading.seq != g_last_sensor_seq || g_shm->sensors.updates == 0) {
+        shm_sensors_t sensors;
+        memset(&sensors, 0, sizeof(sensors));
+        sensors.updates = g_shm->sensors.updates + 1;
+        sensors.updated_ns = now;
+        sensors.temperature_x10 = (int32_t)(reading.temperature * 10.0f);
+        sensors.humidity_x10 = (uint32_t)(reading.humidity * 10.0f);
+        sensors.distance_cm = reading.distance_cm;
+        sensors.valid = reading.valid;
+        sensors.env_ns = reading.env_ns;
+        sensors.distance_ns = reading.distance_ns;
+        publish(&g_shm->sensors, &sensors, sizeof(sensors));
+        g_last_sensor_seq = reading.seq;
+    }
+
+    uint8_t panel_now[8] = { 0 };
+    int red, green, blue;
+    clock_get_display(panel_now);
+    rgb_get_state(&red, &green, &blue);
+    panel_now[4] = (uint8_t)red;
+    panel_now[5] = (uint8_t)green;
+    panel_now[6] = (uint8_t)blue;
+    if (memcmp(panel_now, g_last_panel, sizeof(panel_now)) != 0 || g_shm->panel.updates == 0) {
+        shm_panel_t panel;
+        memset(&panel, 0, sizeof(panel));
+        panel.updates = g_shm->panel.updates + 1;
+        panel.updated_ns = now;
+        memcpy(panel.display, panel_now, 4);
+        memcpy(panel.rgb, panel_now + 4, 4);
+        publish(&g_shm->panel, &panel, sizeof(panel));
+        memcpy(g_last_panel, panel_now, sizeof(panel_now));
+    }
+
+    __atomic_store_n(&g_shm->header.heartbeat_ns, now, __ATOMIC_RELEASE);
+}
+
+static int valid_command(const shm_cmd_t *cmd)
+{
+    if (cmd->type == SHM_CMD_MOTION) {
+        return cmd->arg[0] >= 0 && cmd->arg[0] < PROTO_MOTION_COUNT;
+    }
+    if (cmd->type == SHM_CMD_DRIVE) {
+        return cmd->arg[0] >= -100 && cmd->arg[0] <= 100 && cmd->arg[1] >= -100 && cmd->arg[1] <= 100;
+    }
+    return 0;
+}
+
+static void execute(const shm_cmd_t *cmd)
+{
+    // 邮箱的使用者通常是本地自主程序，优先级低于遥控和运动程序
+    if (arbiter_acquire(CONTROL_COMMANDER_SHM, ARBITER_PRIO_AUTONOMY, ARBITER_LEASE_IDLE, 0) == ARBITER_DENIED) {
+        g_stats.denied++;
+        __atomic_store_n(&g_shm->mailbox.denied, g_shm->mailbox.denied + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (cmd->type == SHM_CMD_MOTION) {
+        control_server_dispatch(cmd->arg[0], cmd->arg[1], cmd->arg[2]);
+    } else {
+        motion_program_takeover("手动命令接管");
+        control_drive(cmd->arg[0], cmd->arg[1]);
+    }
+    g_stats.applied++;
+    __atomic_store_n(&g_shm->mailbox.applied, g_shm->mailbox.applied + 1, __ATOMIC_RELAXED);
+}
+
+// 取出邮箱中的命令：同一周期内只执行最新的一条 (运动命令都是持续动作，旧命令会被立即覆盖)
+static void drain_mailbox(void)
+{
+    shm_mailbox_t *mb = &g_shm->mailbox;
+    uint32_t head = mb->head;
+    uint32_t tail = __atomic_load_n(&mb->tail, __ATOMIC_ACQUIRE);
+    shm_cmd_t latest = {0};
+    int have_latest = 0;
+
+    // tail不可能超前一整圈：生产者出错，丢弃未取出的命令
+    if (tail - head > SHM_MAILBOX_SLOTS) {
+        g_stats.rejected += tail - head;
+        __atomic_store_n(&mb->rejected, mb->rejected + (tail - head), __ATOMIC_RELAXED);
+        __atomic_store_n(&mb->head, tail, __ATOMIC_RELEASE);
+        return;
+    }
+
+    while (head != tail) {
+        shm_cmd_t cmd = {0};
+        seqlock_copy_out(&cmd, &mb->slots[head % SHM_MAILBOX_SLOTS], sizeof(cmd));
+
+        if (cmd.seq != head + 1 ||
+            cmd.check != shm_cmd_check(cmd.seq, cmd.type, cmd.arg[0], cmd.arg[1], cmd.arg[2])) {
+            // 生产者没有内存屏障时槽位内容可能晚于tail可见，下一周期再取
+            if (g_stuck_seq != head + 1) {
+                g_stuck_seq = head + 1;
+                g_stuck_ticks = 0;
+            }
+            if (++g_stuck_ticks < SHM_STUCK_TICKS) break;
+            g_stats.rejected++;
+            __atomic_store_n(&mb->rejected, mb->rejected + 1, __ATOMIC_RELAXED);
+        } else if (!valid_command(&cmd)) {
+            g_stats.rejected++;
+            __atomic_store_n(&mb->rejected, mb->rejected + 1, __ATOMIC_RELAXED);
+        } else {
+            g_stats.commands++;
+            if (have_latest) {
+                g_stats.superseded++;
+                __atomic_store_n(&mb->superseded, mb->superseded + 1, __ATOMIC_RELAXED);
+            }
+            latest = cmd;
+            have_latest = 1;
+        }
+        head++;
+    }
+
+    if (have_latest) execute(&latest);
+    // 执行完成后再推进head：生产者看到head越过自己的命令时命令已经生效
+    __atomic_store_n(&mb->head, head, __ATOMIC_RELEASE);
+}
+
+// 占用邮箱的进程退出后释放邮箱；最近的运动命令来自邮箱时停车
+static void check_producer(void)
+{
+    uint32_t pid = __atomic_load_n(&g_shm->mailbox.producer_pid, __ATOMIC_ACQUIRE);
+
+    if (pid == 0 || kill((pid_t)pid, 0) == 0 || errno != ESRCH) return;
+
+    shm_mailbox_release(g_shm, pid);
+    g_stats.producer_exits++;
+    if (arbiter_release(CONTROL_COMMANDER_SHM)) {
+        control_stop();
+        log_warn("共享内存邮箱的进程%u已退出，已停车", pid);
+    }
+}
+
+static void timer_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+
+    drain_mailbox();
+    publish_state(motion_now_ns());
+    if (++g_ticks % SHM_PRODUCER_CHECK == 0) check_producer();
+}
+
+int shm_status_start(event_loop_t *loop, const char *name)
+{
+    if (name == NULL || name[0] == '\0') return 0;
+
+    snprintf(g_name, sizeof(g_name), "%s", name);
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_ticks = 0;
+    g_stuck_seq = 0;
+
+    // 上次异常退出留下的区域不再复用，仍映射着旧区域的客户端通过心跳停止发现服务器已退出
+    shm_unlink(g_name);
+    int fd = shm_open(g_name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0660);
+    if (fd < 0) {
+        perror("创建共享内存失败");
+        return -1;
+    }
+    // 不受umask影响：同组的用户进程可以读取状态和提交命令
+    fchmod(fd, 0660);
+
+    long page = sysconf(_SC_PAGESIZE);
+    g_map_size = (sizeof(shm_status_t) + page - 1) / page * page;
+    if (ftruncate(fd, g_map_size) < 0) {
+        perror("设置共享内存大小失败");
+        close(fd);
+        shm_unlink(g_name);
+        return -1;
+    }
+    g_shm = mmap(NULL, g_map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (g_shm == MAP_FAILED) {
+        perror("映射共享内存失败");
+        g_shm = NULL;
+        shm_unlink(g_name);
+        return -1;
+    }
+
+    g_shm->header.version = SHM_STATUS_VERSION;
+    g_shm->header.size = sizeof(shm_status_t);
+    g_shm->header.daemon_pid = (uint32_t)getpid();
+    g_shm->header.start_ns = motion_now_ns();
+    g_last_commander = arbiter_holder();
+    publish_state(g_shm->header.start_ns);
+    // magic最后写入：客户端看到magic时其余内容已初始化
+    __atomic_store_n(&g_shm->header.magic, SHM_STATUS_MAGIC, __ATOMIC_RELEASE);
+
+    if (event_timer_create(loop, &g_timer, timer_on_event, NULL) != 0 ||
+        event_timer_set(&g_timer, SHM_TICK_MS, SHM_TICK_MS) != 0) {
+        shm_status_stop();
+        return -1;
+    }
+
+    printf("共享内存状态块: /dev/shm%s (%zu 字节)\n", g_name, sizeof(shm_status_t));
+    return 0;
+}
+
+void shm_status_stop(void)
+{
+    event_loop_remove(&g_timer);
+    if (g_shm == NULL) return;
+
+    __atomic_store_n(&g_shm->header.magic, 0, __ATOMIC_RELEASE);
+    munmap(g_shm, g_map_size);
+    g_shm = NULL;
+    shm_unlink(g_name);
+}
+
+int shm_status_format_stats(char *buf, int size)
+{
+    int len = snprintf(buf, size,
+                       "shm_publishes=%lu shm_commands=%lu shm_applied=%lu shm_superseded=%lu shm_rejected=%lu "
+                       "shm_denied=%lu shm_producer_exits=%lu",
+                       g_stats.publishes, g_stats.commands, g_stats.applied, g_stats.superseded,
+                       g_stats.rejected, g_stats.denied, g_stats.producer_exits);
+    if (len >= size) len = size - 1;
+    return len;
+}
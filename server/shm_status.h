@@ -0,0 +1,177 @@
+#ifndef SHM_STATUS_H
+#define SHM_STATUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "seqlock.h"
+
+// 共享内存状态块和命令邮箱 (本地进程使用，不经过TCP)
+// 控制服务器创建POSIX共享内存 (/dev/shm/<名称>)，按固定布局发布运动状态、传感器读数、数码管和RGB灯状态，
+// 各部分由独立的seqlock保护；本地客户端映射同一区域后直接读取，也可以通过单生产者单消费者的命令邮箱
+// 提交运动命令：写入槽位后递增tail即可，不需要任何系统调用，服务器每SHM_TICK_MS取出一次。
+// 邮箱命令以自主程序优先级 (ARBITER_PRIO_AUTONOMY) 申请控制权，遥控或运动程序持有控制权时不执行。
+//
+// 布局是对外接口：只能在末尾追加字段，改变已有字段时增加SHM_STATUS_VERSION。
+// 所有字段按自然对齐排列，没有编译器插入的填充 (见文件末尾的_Static_assert)，
+// Python可以用ctypes.Structure按同样的顺序声明后从mmap映射 (qt/car_shm.py)。
+//
+// 读取：seq为奇数时正在写入；读取前后seq相同且为偶数时数据一致，否则重试。
+// 提交命令：邮箱同一时间只能有一个生产者，先把producer_pid从0改为自己的pid占用邮箱；
+// tail - head < SHM_MAILBOX_SLOTS时写入slots[tail % SHM_MAILBOX_SLOTS]，seq = tail + 1，
+// check = shm_cmd_check(...)，最后tail加1。服务器发现占用的进程退出后释放邮箱，
+// 并在最近的运动命令来自邮箱时停车。
+// 没有内存屏障的写入者 (如Python) 也能使用：服务器只接受seq和check都匹配的槽位，
+// 内容还没有完整可见时下一次再取。
+
+#define SHM_STATUS_NAME     "/rpi_car_status"
+#define SHM_STATUS_MAGIC    0x43495052u   // "RPIC"
+#define SHM_STATUS_VERSION  1
+#define SHM_TICK_MS         2             // 发布状态和取出命令的周期
+#define SHM_MAILBOX_SLOTS   64            // 2的幂
+#define SHM_CMD_SALT        0x5a17c0deu
+
+// 邮箱命令类型
+#define SHM_CMD_MOTION      1   // arg[0]=PROTO_MOTION_*, arg[1]=速度(0为默认), arg[2]=转弯内侧减速比例(%)
+#define SHM_CMD_DRIVE       2   // arg[0]=线速度, arg[1]=角速度 (正数左转), -100~100
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                 // sizeof(shm_status_t)
+    uint32_t daemon_pid;
+    uint64_t start_ns;             // 服务器启动时间 (CLOCK_MONOTONIC)
+    uint64_t heartbeat_ns;         // 每个周期更新，长时间不变说明服务器已退出
+} shm_header_t;
+
+typedef struct {
+    seqlock_t lock;
+    uint32_t updates;              // 发布次数
+    uint64_t updated_ns;           // 发布时间
+    int32_t left_speed;
+    int32_t right_speed;
+    uint32_t motion;               // motion_type_t
+    uint32_t moving;
+    uint32_t motion_seq;           // 运动状态序号 (每次写入PWM加1)
+    int32_t commander;             // 控制权持有者 (CONTROL_COMMANDER_*或TCP连接编号)
+    uint64_t motion_ns;            // 运动状态更新时间
+} shm_motion_t;
+
+typedef struct {
+    seqlock_t lock;
+    uint32_t updates;
+    uint64_t updated_ns;
+    int32_t temperature_x10;       // 0.1°C
+    uint32_t humidity_x10;         // 0.1%
+    int32_t distance_cm;
+    uint32_t valid;                // SENSOR_VALID_*
+    uint64_t env_ns;               // 读取时间，0表示从未成功读取
+    uint64_t distance_ns;
+} shm_sensors_t;
+
+typedef struct {
+    seqlock_t lock;
+    uint32_t updates;
+    uint64_t updated_ns;
+    uint8_t display[4];            // 数码管段码
+    uint8_t rgb[4];                // 红、绿、蓝 (0/1)，rgb[3]保留
+} shm_panel_t;
+
+typedef struct {
+    uint32_t seq;                  // 命令序号 (tail + 1)
+    uint16_t type;                 // SHM_CMD_*
+    uint16_t reserved;
+    int32_t arg[3];
+    uint32_t check;                // shm_cmd_check()
+} shm_cmd_t;
+
+typedef struct {
+    // 生产者写入
+    uint32_t producer_pid;         // 占用邮箱的进程，0表示空闲
+    uint32_t tail;                 // 已写入的命令数
+    uint8_t producer_pad[56];
+    // 服务器写入 (与生产者的字段不在同一缓存行)
+    uint32_t head;                 // 已取出的命令数
+    uint32_t applied;              // 已执行的命令数
+    uint32_t superseded;           // 同一周期内被后续运动命令取代的命令数
+    uint32_t rejected;             // 无效的命令数
+    uint32_t denied;               // 控制权被优先级更高的来源持有而未执行的命令数
+    uint8_t consumer_pad[44];
+    shm_cmd_t slots[SHM_MAILBOX_SLOTS];
+} shm_mailbox_t;
+
+typedef struct {
+    shm_header_t header;
+    shm_motion_t motion;
+    shm_sensors_t sensors;
+    shm_panel_t panel;
+    uint8_t pad[104];              // 邮箱从第256字节开始
+    shm_mailbox_t mailbox;
+} shm_status_t;
+
+_Static_assert(offsetof(shm_status_t, motion) == 32, "shm布局");
+_Static_assert(offsetof(shm_status_t, sensors) == 80, "shm布局");
+_Static_assert(offsetof(shm_status_t, panel) == 128, "shm布局");
+_Static_assert(offsetof(shm_status_t, mailbox) == 256, "shm布局");
+_Static_assert(offsetof(shm_mailbox_t, head) == 64, "shm布局");
+_Static_assert(sizeof(shm_cmd_t) == 24, "shm布局");
+_Static_assert(sizeof(shm_status_t) == 256 + 128 + 24 * SHM_MAILBOX_SLOTS, "shm布局");
+
+static inline uint32_t shm_cmd_check(uint32_t seq, uint16_t type, int32_t a0, int32_t a1, int32_t a2)
+{
+    return seq ^ type ^ (uint32_t)a0 ^ ((uint32_t)a1 << 8 | (uint32_t)a1 >> 24) ^
+           ((uint32_t)a2 << 16 | (uint32_t)a2 >> 16) ^ SHM_CMD_SALT;
+}
+
+// ---------------- 客户端辅助函数 (C) ----------------
+
+// 读取一份一致的快照 (section为&shm->motion等，size为对应结构体大小)
+static inline void shm_status_read(const void *section, void *out, size_t size)
+{
+    const seqlock_t *lock = (const seqlock_t *)section;
+    seqlock_read(lock, out, section, size);
+}
+
+// 占用/释放邮箱，成功返回0
+static inline int shm_mailbox_claim(shm_status_t *shm, uint32_t pid)
+{
+    uint32_t expected = 0;
+    return __atomic_compare_exchange_n(&shm->mailbox.producer_pid, &expected, pid, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+static inline void shm_mailbox_release(shm_status_t *shm, uint32_t pid)
+{
+    uint32_t expected = pid;
+    __atomic_compare_exchange_n(&shm->mailbox.producer_pid, &expected, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+// 提交一条命令 (不阻塞，不进入内核)：邮箱已满时返回-1，成功返回命令序号
+static inline int64_t shm_mailbox_push(shm_status_t *shm, uint16_t type, int32_t a0, int32_t a1, int32_t a2)
+{
+    shm_mailbox_t *mb = &shm->mailbox;
+    uint32_t tail = __atomic_load_n(&mb->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&mb->head, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= SHM_MAILBOX_SLOTS) return -1;
+
+    shm_cmd_t *slot = &mb->slots[tail % SHM_MAILBOX_SLOTS];
+    uint32_t seq = tail + 1;
+    __atomic_store_n(&slot->type, type, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->arg[0], a0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->arg[1], a1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->arg[2], a2, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->check, shm_cmd_check(seq, type, a0, a1, a2), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&mb->tail, seq, __ATOMIC_RELEASE);
+    return seq;
+}
+
+// ---------------- 服务器 ----------------
+
+// 创建并映射共享内存 (name为空字符串时不启用)
+struct event_loop;
+int shm_status_start(struct event_loop *loop, const char *name);
+void shm_status_stop(void);
+int shm_status_format_stats(char *buf, int size);
+
+#endif // SHM_STATUS_H
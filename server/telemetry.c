@@ -0,0 +1,48 @@
+#include <string.h>
+#include "telemetry.h"
+#include "control.h"
+#include "sensor_cache.h"
+#include "clock.h"
+#include "rgb.h"
+
+static uint32_t age_ms(uint64_t now_ns, uint64_t then_ns)
+{
+    uint64_t ms = now_ns > then_ns ? (now_ns - then_ns) / 1000000ULL : 0;
+    return ms > UINT32_MAX ? UINT32_MAX : (uint32_t)ms;
+}
+
+void telemetry_collect(proto_telemetry_t *tlm, uint64_t now_ns)
+{
+    motion_state_t state = get_motion_state();
+    sensor_reading_t reading;
+    int red, green, blue;
+
+    memset(tlm, 0, sizeof(*tlm));
+    tlm->fields = PROTO_TLM_MOTION | PROTO_TLM_DISPLAY | PROTO_TLM_RGB;
+
+    tlm->left_speed = (int16_t)state.left_speed;
+    tlm->right_speed = (int16_t)state.right_speed;
+    tlm->motion = (uint8_t)state.current_motion;
+    tlm->moving = (uint8_t)state.is_moving;
+    tlm->motion_seq = state.seq;
+
+    sensor_cache_get(&reading);
+    if (reading.valid & SENSOR_VALID_ENV) {
+        tlm->fields |= PROTO_TLM_ENV;
+        tlm->temperature_x10 = (int16_t)(reading.temperature * 10.0f);
+        tlm->humidity_x10 = (uint16_t)(reading.humidity * 10.0f);
+        tlm->env_age_ms = age_ms(now_ns, reading.env_ns);
+    }
+    if (reading.valid & SENSOR_VALID_DISTANCE) {
+        tlm->fields |= PROTO_TLM_DISTANCE;
+        tlm->distance_cm = (int16_t)reading.distance_cm;
+        tlm->distance_age_ms = age_ms(now_ns, reading.distance_ns);
+    }
+
+    clock_get_display(tlm->display);
+
+    rgb_get_state(&red, &green, &blue);
+    tlm->rgb[0] = (uint8_t)red;
+    tlm->rgb[1] = (uint8_t)green;
+    tlm->rgb[2] = (uint8_t)blue;
+}
@@ -0,0 +1,13 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "protocol.h"
+
+// 遥测快照：汇总运动状态、传感器缓存、数码管和RGB灯状态
+// 各数据源都是无锁读取，可在事件循环中按订阅频率调用。
+
+// 采集一份快照，tlm->fields为当前有效的字段 (传感器从未成功读取时不含对应字段)
+void telemetry_collect(proto_telemetry_t *tlm, uint64_t now_ns);
+
+#endif // TELEMETRY_H
@@ -0,0 +1,298 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "udp_teleop.h"
+#include "control_server.h"
+#include "motion_exec.h"
+#include "protocol.h"
+#include "apply_tracker.h"
+#include "arbiter.h"
+#include "logger.h"
+#include "trace.h"
+
+// 发送方 (按地址和端口区分)
+typedef struct {
+    struct sockaddr_in addr;
+    int in_use;
+    int have_seq;                  // 已接受过命令 (last_seq有效；序号0也是合法序号)
+    uint32_t last_seq;             // 已接受的最大序号
+    uint64_t last_ns;              // 最近一次收到命令的时间
+    uint32_t tx_seq;               // 发往该发送方的ACK序号
+} udp_peer_t;
+
+// 本批次中某个发送方的最新命令
+typedef struct {
+    udp_peer_t *peer;
+    proto_frame_t frame;
+    proto_drive_t drive;
+} udp_pending_t;
+
+static event_source_t g_socket = { -1, NULL, NULL, NULL };
+static event_source_t g_deadman = { -1, NULL, NULL, NULL };
+static unsigned int g_deadman_ms = UDP_DEADMAN_MS;
+static udp_peer_t g_peers[UDP_TELEOP_MAX_PEERS];
+static udp_teleop_stats_t g_stats;
+
+// 接收缓冲区 (recvmmsg一次读取一批数据报)
+static uint8_t g_rx_buf[UDP_TELEOP_BATCH][PROTO_MAX_FRAME];
+static struct sockaddr_in g_rx_addr[UDP_TELEOP_BATCH];
+static struct iovec g_rx_iov[UDP_TELEOP_BATCH];
+static struct mmsghdr g_rx_msgs[UDP_TELEOP_BATCH];
+
+// 查找发送方，不存在时占用空闲或最久未活动的位置
+static udp_peer_t *find_peer(const struct sockaddr_in *addr, uint64_t now)
+{
+    udp_peer_t *oldest = &g_peers[0];
+
+    for (int i = 0; i < UDP_TELEOP_MAX_PEERS; i++) {
+        udp_peer_t *peer = &g_peers[i];
+        if (peer->in_use && peer->addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
+            peer->addr.sin_port == addr->sin_port) {
+            return peer;
+        }
+        if (!peer->in_use || peer->last_ns < oldest->last_ns) {
+            oldest = peer;
+            if (!peer->in_use) break;
+        }
+    }
+
+    if (oldest->in_use) apply_tracker_cancel(oldest);
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->addr = *addr;
+    oldest->in_use = 1;
+    oldest->last_ns = now;
+    return oldest;
+}
+
+static void send_ack(udp_peer_t *peer, const proto_frame_t *frame, uint8_t status, uint64_t latency_ns)
+{
+    uint8_t out[PROTO_MAX_FRAME];
+    proto_ack_t ack;
+
+    if (!(frame->header.flags & PROTO_FLAG_ACK_REQ)) return;
+
+    ack.ack_seq = frame->header.seq;
+    ack.latency_us = (uint32_t)(latency_ns / 1000);
+    ack.echo_us = frame->header.timestamp_us;
+    ack.status = status;
+    size_t len = proto_encode_ack(out, peer->tx_seq++, motion_now_ns() / 1000, &ack);
+    sendto(g_socket.fd, out, len, MSG_DONTWAIT, (struct sockaddr *)&peer->addr, sizeof(peer->addr));
+}
+
+// 命令写入PWM后回复APPLIED (由apply_tracker回调)
+static void reply_applied(void *ctx, const proto_ack_t *applied)
+{
+    udp_peer_t *peer = (udp_peer_t *)ctx;
+    uint8_t out[PROTO_MAX_FRAME];
+    size_t len = proto_encode_applied(out, peer->tx_seq++, motion_now_ns() / 1000, applied);
+
+    sendto(g_socket.fd, out, len, MSG_DONTWAIT, (struct sockaddr *)&peer->addr, sizeof(peer->addr));
+}
+
+// 延迟探测：立即回复PONG，不影响命令序号
+static void reply_pong(const struct sockaddr_in *addr, const proto_frame_t *frame, uint64_t recv_ns)
+{
+    uint8_t out[PROTO_MAX_FRAME];
+    proto_pong_t pong;
+
+    pong.echo_us = frame->header.timestamp_us;
+    pong.rx_us = recv_ns / 1000;
+    size_t len = proto_encode_pong(out, frame->header.seq, motion_now_ns() / 1000, &pong);
+    sendto(g_socket.fd, out, len, MSG_DONTWAIT, (const struct sockaddr *)addr, sizeof(*addr));
+}
+
+// 运动中每执行一条命令重新开始死人开关计时，停车时关闭
+static void arm_deadman(int moving)
+{
+    event_timer_set(&g_deadman, moving ? g_deadman_ms : 0, 0);
+}
+
+static void deadman_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+
+    // 期间有其他来源接管时不干预
+    if (!arbiter_release(CONTROL_COMMANDER_UDP)) return;
+
+    control_stop();
+    g_stats.deadman_stops++;
+    log_warn("UDP遥控命令超时 (%u ms)，已停车", g_deadman_ms);
+}
+
+// 检查一个数据报，较新的命令放入pending (每个发送方只保留最新一条)
+static void classify(udp_pending_t *pending, int *count, const uint8_t *data, size_t len,
+                     const struct sockaddr_in *addr, uint64_t now)
+{
+    proto_frame_t frame;
+    proto_drive_t drive;
+
+    // 每个数据报恰好一帧
+    if (proto_parse(data, len, &frame) == (int)len && frame.header.type == PROTO_MSG_PING) {
+        g_stats.pings++;
+        reply_pong(addr, &frame, now);
+        return;
+    }
+    if (proto_parse(data, len, &frame) != (int)len ||
+        proto_decode_drive(&frame, &drive) != 0 || drive.motion >= PROTO_MOTION_COUNT) {
+        g_stats.invalid++;
+        return;
+    }
+
+    udp_peer_t *peer = find_peer(addr, now);
+    g_stats.received++;
+
+    // 长时间没有消息的发送方 (通常是客户端重启) 重新开始序号
+    int fresh = !peer->have_seq || (now - peer->last_ns > (uint64_t)UDP_PEER_IDLE_MS * 1000000ULL);
+    peer->last_ns = now;
+
+    if (!fresh && (int32_t)(frame.header.seq - peer->last_seq) <= 0) {
+        g_stats.stale++;
+        send_ack(peer, &frame, PROTO_STATUS_STALE, 0);
+        return;
+    }
+
+    if (!fresh && frame.header.seq - peer->last_seq > 1) {
+        g_stats.lost += frame.header.seq - peer->last_seq - 1;
+    }
+    peer->last_seq = frame.header.seq;
+    peer->have_seq = 1;
+
+    for (int i = 0; i < *count; i++) {
+        if (pending[i].peer == peer) {
+            g_stats.superseded++;
+            send_ack(peer, &pending[i].frame, PROTO_STATUS_SUPERSEDED, 0);
+            pending[i].frame = frame;
+            pending[i].drive = drive;
+            return;
+        }
+    }
+    pending[*count].peer = peer;
+    pending[*count].frame = frame;
+    pending[*count].drive = drive;
+    (*count)++;
+}
+
+static void socket_on_event(event_source_t *src, uint32_t events)
+{
+    udp_pending_t pending[UDP_TELEOP_BATCH];
+    int count = 0;
+
+    (void)events;
+
+    for (int i = 0; i < UDP_TELEOP_BATCH; i++) {
+        g_rx_msgs[i].msg_hdr.msg_namelen = sizeof(g_rx_addr[i]);
+    }
+    int n = recvmmsg(src->fd, g_rx_msgs, UDP_TELEOP_BATCH, MSG_DONTWAIT, NULL);
+    if (n <= 0) return;
+
+    uint64_t recv_ns = motion_now_ns();
+    TRACE_BEGIN("net", "udp_commands");
+    for (int i = 0; i < n; i++) {
+        // 帧 (frame.payload) 指向g_rx_buf，本次回调结束前有效
+        classify(pending, &count, g_rx_buf[i], g_rx_msgs[i].msg_len, &g_rx_addr[i], recv_ns);
+    }
+
+    // 按到达顺序执行各发送方的最新命令 (所有发送方作为同一个遥控来源申请控制权)
+    for (int i = 0; i < count; i++) {
+        udp_pending_t *p = &pending[i];
+
+        if (arbiter_acquire(CONTROL_COMMANDER_UDP, ARBITER_PRIO_REMOTE, ARBITER_LEASE_IDLE, 0) == ARBITER_DENIED) {
+            g_stats.denied++;
+            send_ack(p->peer, &p->frame, PROTO_STATUS_DENIED, 0);
+            continue;
+        }
+        control_server_dispatch(p->drive.motion, p->drive.speed, p->drive.turn_ratio);
+        if (p->frame.header.flags & PROTO_FLAG_APPLIED_REQ) {
+            apply_tracker_add(p->peer, reply_applied, motion_exec_last_id(), &p->frame, recv_ns);
+        }
+        arm_deadman(p->drive.motion != PROTO_MOTION_STOP);
+
+        uint64_t latency = motion_now_ns() - recv_ns;
+        latency_record(&g_stats.latency, latency);
+        g_stats.applied++;
+        send_ack(p->peer, &p->frame, PROTO_STATUS_OK, latency);
+    }
+    TRACE_END("net", "udp_commands");
+}
+
+// 启动UDP遥控通道
+int udp_teleop_start(event_loop_t *loop, int port, unsigned int deadman_ms)
+{
+    struct sockaddr_in addr;
+
+    if (deadman_ms > 0) g_deadman_ms = deadman_ms;
+    memset(&g_stats, 0, sizeof(g_stats));
+    memset(g_peers, 0, sizeof(g_peers));
+
+    for (int i = 0; i < UDP_TELEOP_BATCH; i++) {
+        g_rx_iov[i].iov_base = g_rx_buf[i];
+        g_rx_iov[i].iov_len = sizeof(g_rx_buf[i]);
+        memset(&g_rx_msgs[i], 0, sizeof(g_rx_msgs[i]));
+        g_rx_msgs[i].msg_hdr.msg_iov = &g_rx_iov[i];
+        g_rx_msgs[i].msg_hdr.msg_iovlen = 1;
+        g_rx_msgs[i].msg_hdr.msg_name = &g_rx_addr[i];
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("创建UDP socket失败");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("绑定UDP端口失败");
+        close(fd);
+        return -1;
+    }
+
+    g_socket.fd = fd;
+    g_socket.handler = socket_on_event;
+    g_socket.ctx = NULL;
+    if (event_loop_add(loop, &g_socket, EPOLLIN) != 0) {
+        close(fd);
+        g_socket.fd = -1;
+        return -1;
+    }
+
+    if (event_timer_create(loop, &g_deadman, deadman_on_event, NULL) != 0) {
+        event_loop_remove(&g_socket);
+        return -1;
+    }
+
+    printf("UDP遥控通道正在%d端口监听 (死人开关 %u ms)\n", port, g_deadman_ms);
+    return 0;
+}
+
+void udp_teleop_stop(void)
+{
+    event_loop_remove(&g_deadman);
+    event_loop_remove(&g_socket);
+}
+
+udp_teleop_stats_t udp_teleop_get_stats(void)
+{
+    return g_stats;
+}
+
+int udp_teleop_format_stats(char *buf, int size)
+{
+    int len = snprintf(buf, size,
+                       "udp_received=%lu udp_applied=%lu udp_stale=%lu udp_superseded=%lu udp_lost=%lu "
+                       "udp_invalid=%lu udp_denied=%lu udp_deadman=%lu udp_pings=%lu udp_avg_us=%.2f udp_p99_us=%.0f "
+                       "udp_max_us=%.2f",
+                       g_stats.received, g_stats.applied, g_stats.stale, g_stats.superseded, g_stats.lost,
+                       g_stats.invalid, g_stats.denied, g_stats.deadman_stops, g_stats.pings, latency_avg_us(&g_stats.latency),
+                       latency_percentile_us(&g_stats.latency, 99.0), g_stats.latency.max_ns / 1000.0);
+    if (len >= size) len = size - 1;
+    return len;
+}
@@ -0,0 +1,40 @@
+#ifndef UDP_TELEOP_H
+#define UDP_TELEOP_H
+
+#include <stdint.h>
+#include "event_loop.h"
+#include "latency_stats.h"
+
+// UDP遥控通道
+// 每个数据报是一帧protocol.h格式的DRIVE命令，序号单调递增。
+// 只执行每个发送方最新的命令：序号不大于已执行命令的数据报 (旧的或重复的) 直接丢弃，
+// 同一次读取到的多条命令只执行最新一条。不存在TCP的队头阻塞，丢失的命令由客户端
+// 周期性重发当前状态弥补。运动中超过死人开关时间没有收到新命令时自动停车。
+
+#define UDP_TELEOP_PORT        25500
+#define UDP_TELEOP_MAX_PEERS   8
+#define UDP_TELEOP_BATCH       32      // 每次recvmmsg最多读取的数据报数
+#define UDP_DEADMAN_MS         300     // 死人开关超时
+#define UDP_PEER_IDLE_MS       2000    // 发送方空闲超过该时间后重新开始序号 (客户端重启)
+
+typedef struct {
+    unsigned long received;        // 收到的有效命令
+    unsigned long applied;         // 执行的命令
+    unsigned long stale;           // 旧的或重复的命令
+    unsigned long superseded;      // 被同批次更新命令取代的命令
+    unsigned long lost;            // 按序号间隔推算的丢失命令
+    unsigned long invalid;         // 无法解析的数据报
+    unsigned long denied;          // 控制权被其他来源持有而未执行的命令
+    unsigned long deadman_stops;   // 死人开关停车次数
+    unsigned long pings;           // 延迟探测
+    latency_stats_t latency;       // 数据报读入到电机函数返回的延迟
+} udp_teleop_stats_t;
+
+int udp_teleop_start(event_loop_t *loop, int port, unsigned int deadman_ms);
+void udp_teleop_stop(void);
+udp_teleop_stats_t udp_teleop_get_stats(void);
+
+// 格式化统计信息，返回写入长度 (可作为control_server的附加统计)
+int udp_teleop_format_stats(char *buf, int size);
+
+#endif // UDP_TELEOP_H
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <time.h>
+#include "wiringPi.h"
+#include "softPwm.h"
+#include "sim_gpio.h"
+
+// 单个模拟引脚
+typedef struct {
+    int mode;
+    int level;
+    int pwm_value;
+    int pwm_range;
+    int isr_mode;
+    void (*isr)(void);
+    sim_read_hook_t read_hook;
+    void *read_ctx;
+    unsigned long writes;
+} sim_pin_t;
+
+static sim_pin_t g_pins[SIM_GPIO_PINS];
+static struct timespec g_epoch;
+static int g_epoch_set = 0;
+
+static int sim_pin_valid(int pin)
+{
+    return pin >= 0 && pin < SIM_GPIO_PINS;
+}
+
+static uint64_t sim_now_us(void)
+{
+    struct timespec ts;
+
+    if (!g_epoch_set) {
+        clock_gettime(CLOCK_MONOTONIC, &g_epoch);
+        g_epoch_set = 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - g_epoch.tv_sec) * 1000000ULL +
+           (uint64_t)((ts.tv_nsec - g_epoch.tv_nsec) / 1000);
+}
+
+int wiringPiSetupGpio(void)
+{
+    clock_gettime(CLOCK_MONOTONIC, &g_epoch);
+    g_epoch_set = 1;
+    printf("[SIM] 使用模拟GPIO后端\n");
+    return 0;
+}
+
+void pinMode(int pin, int mode)
+{
+    if (!sim_pin_valid(pin)) return;
+    // 输出引脚切换为输入时释放总线，按外设应答 (如TM1637的ACK) 处理为低电平
+    if (g_pins[pin].mode == OUTPUT && mode == INPUT) g_pins[pin].level = LOW;
+    g_pins[pin].mode = mode;
+}
+
+void pullUpDnControl(int pin, int pud)
+{
+    if (!sim_pin_valid(pin)) return;
+    if (pud == PUD_UP) g_pins[pin].level = HIGH;
+    if (pud == PUD_DOWN) g_pins[pin].level = LOW;
+}
+
+void digitalWrite(int pin, int value)
+{
+    if (!sim_pin_valid(pin)) return;
+    g_pins[pin].level = value ? HIGH : LOW;
+    g_pins[pin].writes++;
+}
+
+int digitalRead(int pin)
+{
+    if (!sim_pin_valid(pin)) return LOW;
+    if (g_pins[pin].read_hook != NULL) {
+        return g_pins[pin].read_hook(pin, g_pins[pin].read_ctx);
+    }
+    return __atomic_load_n(&g_pins[pin].level, __ATOMIC_RELAXED);
+}
+
+int wiringPiISR(int pin, int mode, void (*function)(void))
+{
+    if (!sim_pin_valid(pin)) return -1;
+    g_pins[pin].isr_mode = mode;
+    g_pins[pin].isr = function;
+    return 0;
+}
+
+void delay(unsigned int howLong)
+{
+    struct timespec ts = { howLong / 1000, (long)(howLong % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+void delayMicroseconds(unsigned int howLong)
+{
+    // 短延时忙等，与wiringPi行为一致
+    if (howLong < 100) {
+        uint64_t end = sim_now_us() + howLong;
+        while (sim_now_us() < end)
+            ;
+        return;
+    }
+    struct timespec ts = { howLong / 1000000, (long)(howLong % 1000000) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+unsigned int millis(void)
+{
+    return (unsigned int)(sim_now_us() / 1000);
+}
+
+unsigned int micros(void)
+{
+    return (unsigned int)sim_now_us();
+}
+
+int softPwmCreate(int pin, int value, int range)
+{
+    if (!sim_pin_valid(pin)) return -1;
+    g_pins[pin].mode = OUTPUT;
+    g_pins[pin].pwm_range = range;
+    g_pins[pin].pwm_value = value;
+    return 0;
+}
+
+void softPwmWrite(int pin, int value)
+{
+    if (!sim_pin_valid(pin)) return;
+    if (value < 0) value = 0;
+    if (g_pins[pin].pwm_range > 0 && value > g_pins[pin].pwm_range) value = g_pins[pin].pwm_range;
+    __atomic_store_n(&g_pins[pin].pwm_value, value, __ATOMIC_RELAXED);
+    g_pins[pin].writes++;
+}
+
+void softPwmStop(int pin)
+{
+    if (!sim_pin_valid(pin)) return;
+    g_pins[pin].pwm_value = 0;
+    g_pins[pin].pwm_range = 0;
+}
+
+// 设置输入电平，电平变化满足中断条件时调用注册的中断函数
+void sim_gpio_set_input(int pin, int value)
+{
+    int old_level;
+    sim_pin_t *p;
+
+    if (!sim_pin_valid(pin)) return;
+    p = &g_pins[pin];
+
+    value = value ? HIGH : LOW;
+    old_level = __atomic_exchange_n(&p->level, value, __ATOMIC_RELAXED);
+    if (old_level == value || p->isr == NULL) return;
+
+    if (p->isr_mode == INT_EDGE_BOTH ||
+        (p->isr_mode == INT_EDGE_RISING && value == HIGH) ||
+        (p->isr_mode == INT_EDGE_FALLING && value == LOW)) {
+        p->isr();
+    }
+}
+
+void sim_gpio_set_read_hook(int pin, sim_read_hook_t hook, void *ctx)
+{
+    if (!sim_pin_valid(pin)) return;
+    g_pins[pin].read_ctx = ctx;
+    g_pins[pin].read_hook = hook;
+}
+
+int sim_gpio_get_output(int pin)
+{
+    return sim_pin_valid(pin) ? g_pins[pin].level : LOW;
+}
+
+int sim_gpio_get_pwm(int pin)
+{
+    return sim_pin_valid(pin) ? __atomic_load_n(&g_pins[pin].pwm_value, __ATOMIC_RELAXED) : 0;
+}
+
+int sim_gpio_get_pwm_range(int pin)
+{
+    return sim_pin_valid(pin) ? g_pins[pin].pwm_range : 0;
+}
+
+unsigned long sim_gpio_write_count(int pin)
+{
+    return sim_pin_valid(pin) ? g_pins[pin].writes : 0;
+}
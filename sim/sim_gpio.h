@@ -0,0 +1,20 @@
+#ifndef SIM_GPIO_H
+#define SIM_GPIO_H
+
+#include "wiringPi.h"
+
+// 模拟GPIO数量 (BCM编号0-39)
+#define SIM_GPIO_PINS 40
+
+// 输入引脚读取钩子：设置后digitalRead调用钩子获取电平 (用于模拟传感器时序)
+typedef int (*sim_read_hook_t)(int pin, void *ctx);
+
+// 模拟器控制接口 (供模拟对象和基准测试使用)
+void sim_gpio_set_input(int pin, int value);
+void sim_gpio_set_read_hook(int pin, sim_read_hook_t hook, void *ctx);
+int sim_gpio_get_output(int pin);
+int sim_gpio_get_pwm(int pin);
+int sim_gpio_get_pwm_range(int pin);
+unsigned long sim_gpio_write_count(int pin);
+
+#endif // SIM_GPIO_H
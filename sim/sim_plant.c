@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <time.h>
+#include "sim_gpio.h"
+#include "sim_plant.h"
+
+static sim_plant_config_t g_config;
+static pthread_t g_thread;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int g_running = 0;
+
+// 模拟状态 (由g_lock保护)
+static float g_speed[SIM_PLANT_WHEELS];      // 转速 (转/秒)
+static double g_position[SIM_PLANT_WHEELS];  // 累计转数
+static long g_edge_index[SIM_PLANT_WHEELS];  // 当前所在编码器格
+static float g_load[SIM_PLANT_WHEELS];       // 负载 (转/秒)
+
+// 读取PWM引脚得到带符号占空比 (-1 ~ 1)
+static float sim_plant_duty(const sim_wheel_t *wheel)
+{
+    int range = sim_gpio_get_pwm_range(wheel->fwd_pin);
+    int value;
+
+    if (range <= 0) return 0.0f;
+
+    value = sim_gpio_get_pwm(wheel->fwd_pin);
+    if (wheel->rev_pin >= 0) {
+        value -= sim_gpio_get_pwm(wheel->rev_pin);
+    }
+    return (float)value / range;
+}
+
+static void sim_plant_step(float dt)
+{
+    int toggles[SIM_PLANT_WHEELS];
+
+    pthread_mutex_lock(&g_lock);
+    for (int i = 0; i < SIM_PLANT_WHEELS; i++) {
+        const sim_wheel_t *wheel = &g_config.wheel[i];
+        float duty = sim_plant_duty(wheel);
+        float target = 0.0f;
+
+        if (fabsf(duty) * 100.0f >= wheel->deadband) {
+            target = wheel->gain * duty * g_config.battery;
+            // 负载总是阻碍转动
+            if (target > 0) target = fmaxf(0.0f, target - g_load[i]);
+            else target = fminf(0.0f, target + g_load[i]);
+        }
+
+        g_speed[i] += (target - g_speed[i]) * dt / wheel->tau;
+        g_position[i] += g_speed[i] * dt;
+
+        long index = (long)floor(g_position[i] * g_config.edges_per_rev);
+        toggles[i] = (int)labs(index - g_edge_index[i]);
+        g_edge_index[i] = index;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    // 每跨过一格翻转一次编码器电平 (在锁外触发中断)
+    for (int i = 0; i < SIM_PLANT_WHEELS; i++) {
+        int pin = g_config.wheel[i].enc_pin;
+        for (int n = 0; n < toggles[i]; n++) {
+            sim_gpio_set_input(pin, !digitalRead(pin));
+        }
+    }
+}
+
+static void *sim_plant_thread(void *arg)
+{
+    struct timespec next;
+    long period_ns = 1000000000L / g_config.rate_hz;
+    float dt = 1.0f / g_config.rate_hz;
+
+    (void)arg;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (g_running) {
+        next.tv_nsec += period_ns;
+        while (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+        sim_plant_step(dt);
+    }
+    return NULL;
+}
+
+int sim_plant_start(const sim_plant_config_t *config)
+{
+    if (g_running) return 0;
+
+    g_config = *config;
+    if (g_config.rate_hz <= 0) g_config.rate_hz = 2000;
+    if (g_config.edges_per_rev <= 0) g_config.edges_per_rev = 40;
+    if (g_config.battery <= 0) g_config.battery = 1.0f;
+
+    for (int i = 0; i < SIM_PLANT_WHEELS; i++) {
+        if (g_config.wheel[i].tau <= 0) g_config.wheel[i].tau = 0.1f;
+        g_speed[i] = 0.0f;
+        g_position[i] = 0.0;
+        g_edge_index[i] = 0;
+        g_load[i] = 0.0f;
+    }
+
+    g_running = 1;
+    if (pthread_create(&g_thread, NULL, sim_plant_thread, NULL) != 0) {
+        g_running = 0;
+        return -1;
+    }
+    printf("[SIM] 电机模拟对象启动 (%d Hz, 每转%d个编码器边沿)\n",
+           g_config.rate_hz, g_config.edges_per_rev);
+    return 0;
+}
+
+void sim_plant_stop(void)
+{
+    if (!g_running) return;
+    g_running = 0;
+    pthread_join(g_thread, NULL);
+}
+
+void sim_plant_set_battery(float scale)
+{
+    pthread_mutex_lock(&g_lock);
+    g_config.battery = scale;
+    pthread_mutex_unlock(&g_lock);
+}
+
+void sim_plant_set_load(int wheel, float load_rps)
+{
+    if (wheel < 0 || wheel >= SIM_PLANT_WHEELS) return;
+    pthread_mutex_lock(&g_lock);
+    g_load[wheel] = load_rps;
+    pthread_mutex_unlock(&g_lock);
+}
+
+void sim_plant_get_speed(float *left_rps, float *right_rps)
+{
+    pthread_mutex_lock(&g_lock);
+    *left_rps = g_speed[0];
+    *right_rps = g_speed[1];
+    pthread_mutex_unlock(&g_lock);
+}
+
+void sim_plant_get_position(double *left_rev, double *right_rev)
+{
+    pthread_mutex_lock(&g_lock);
+    *left_rev = g_position[0];
+    *right_rev = g_position[1];
+    pthread_mutex_unlock(&g_lock);
+}
@@ -0,0 +1,37 @@
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+// 直流减速电机 + 单相编码器的模拟对象 (make SIM=1)
+// 按固定频率读取模拟PWM引脚的占空比，用一阶模型积分出转速和转角，
+// 转角每跨过一格就翻转编码器引脚电平，触发注册的GPIO中断。
+
+#define SIM_PLANT_WHEELS 2
+
+typedef struct {
+    int fwd_pin;        // 正转PWM引脚
+    int rev_pin;        // 反转PWM引脚，-1表示无
+    int enc_pin;        // 编码器输出引脚
+    float gain;         // 满占空比时的稳态转速 (转/秒)
+    float tau;          // 机械时间常数 (秒)
+    float deadband;     // 死区占空比 (%)，低于此值不转
+} sim_wheel_t;
+
+typedef struct {
+    sim_wheel_t wheel[SIM_PLANT_WHEELS];
+    int edges_per_rev;  // 每转编码器边沿数
+    float battery;      // 电池电压系数 (1.0为标称电压)
+    int rate_hz;        // 仿真步进频率
+} sim_plant_config_t;
+
+int sim_plant_start(const sim_plant_config_t *config);
+void sim_plant_stop(void);
+
+// 扰动：电池电压系数和单轮负载 (转/秒)
+void sim_plant_set_battery(float scale);
+void sim_plant_set_load(int wheel, float load_rps);
+
+// 真实转速和累计转数 (用于评估控制效果)
+void sim_plant_get_speed(float *left_rps, float *right_rps);
+void sim_plant_get_position(double *left_rev, double *right_rev);
+
+#endif // SIM_PLANT_H
@@ -0,0 +1,18 @@
+#ifndef SIM_SOFTPWM_H
+#define SIM_SOFTPWM_H
+
+// 主机模拟用softPwm接口 (make SIM=1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int softPwmCreate(int pin, int value, int range);
+void softPwmWrite(int pin, int value);
+void softPwmStop(int pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_SOFTPWM_H
@@ -0,0 +1,45 @@
+#ifndef SIM_WIRINGPI_H
+#define SIM_WIRINGPI_H
+
+// 主机模拟用wiringPi接口 (make SIM=1)
+// 只实现本项目用到的函数，GPIO状态保存在内存中，时间函数使用CLOCK_MONOTONIC。
+
+#include <stdint.h>
+#include <unistd.h>
+
+#define INPUT  0
+#define OUTPUT 1
+
+#define LOW  0
+#define HIGH 1
+
+#define PUD_OFF  0
+#define PUD_DOWN 1
+#define PUD_UP   2
+
+#define INT_EDGE_SETUP   0
+#define INT_EDGE_FALLING 1
+#define INT_EDGE_RISING  2
+#define INT_EDGE_BOTH    3
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int wiringPiSetupGpio(void);
+void pinMode(int pin, int mode);
+void pullUpDnControl(int pin, int pud);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int wiringPiISR(int pin, int mode, void (*function)(void));
+
+void delay(unsigned int howLong);
+void delayMicroseconds(unsigned int howLong);
+unsigned int millis(void);
+unsigned int micros(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIM_WIRINGPI_H
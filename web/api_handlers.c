@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "api_handlers.h"
+#include "json.h"
+#include "sensor_cache.h"
+#include "rgb.h"
+#include "beep.h"
+#include "servo.h"
+
+// 读数超过采样周期的3倍没有更新时报告为"stale"
+#define API_STALE_PERIODS 3
+
+static event_source_t g_beep_timer = { -1, NULL, NULL, NULL };
+static unsigned int g_sensors = 0;
+static int g_servo_active = 0;     // 舵机已占用GPIO18 (软件PWM)
+static int g_servo_angle = 90;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// 序列化完成后设置响应长度，缓冲区不够时返回500
+static void finish_json(http_response_t *resp, json_writer_t *w)
+{
+    int len = json_finish(w);
+
+    if (len < 0) {
+        http_error(resp, 500, "响应过长");
+        return;
+    }
+    resp->body_len = len;
+}
+
+static const char *reading_status(unsigned int sensor, uint32_t valid_flag, const sensor_reading_t *r,
+                                  uint64_t sample_ns, unsigned int period_ms, uint64_t now)
+{
+    if (!(g_sensors & sensor)) return "disabled";
+    if (!(r->valid & valid_flag)) return "unavailable";
+    if (now - sample_ns > (uint64_t)period_ms * API_STALE_PERIODS * 1000000ULL) return "stale";
+    return "success";
+}
+
+static long age_ms(uint64_t sample_ns, uint64_t now)
+{
+    return sample_ns ? (long)((now - sample_ns) / 1000000ULL) : -1;
+}
+
+static int beep_available(void)
+{
+    return !(g_servo_active && BEEP_PIN == SERVO_PIN);
+}
+
+// ---------------- GET ----------------
+
+static void handle_status(const http_request_t *req, http_response_t *resp)
+{
+    sensor_reading_t r;
+    json_writer_t w;
+    uint64_t now = now_ns();
+
+    (void)req;
+    sensor_cache_get(&r);
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "online");
+    json_int(&w, "timestamp", (long)time(NULL));
+    json_object_begin(&w, "components");
+    json_string(&w, "rgb", "ready");
+    json_string(&w, "beep", !beep_available() ? "unavailable" : (beep_get_state() ? "on" : "ready"));
+    json_string(&w, "servo", g_servo_active ? "active" : "ready");
+    json_string(&w, "dht11", reading_status(SENSOR_CACHE_DHT, SENSOR_VALID_ENV, &r, r.env_ns,
+                                            SENSOR_DHT_PERIOD_MS, now));
+    json_string(&w, "ultrasonic", reading_status(SENSOR_CACHE_DISTANCE, SENSOR_VALID_DISTANCE, &r, r.distance_ns,
+                                                 SENSOR_DISTANCE_PERIOD_MS, now));
+    json_object_end(&w);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static void write_dht(json_writer_t *w, const sensor_reading_t *r, uint64_t now)
+{
+    json_object_begin(w, "dht11");
+    if (r->valid & SENSOR_VALID_ENV) {
+        json_double(w, "temperature", r->temperature, 1);
+        json_double(w, "humidity", r->humidity, 1);
+    } else {
+        json_null(w, "temperature");
+        json_null(w, "humidity");
+    }
+    json_string(w, "status", reading_status(SENSOR_CACHE_DHT, SENSOR_VALID_ENV, r, r->env_ns,
+                                            SENSOR_DHT_PERIOD_MS, now));
+    json_int(w, "age_ms", age_ms(r->env_ns, now));
+    json_object_end(w);
+}
+
+static void write_distance(json_writer_t *w, const char *key, const sensor_reading_t *r, uint64_t now)
+{
+    if (key != NULL) json_object_begin(w, key);
+    if (r->valid & SENSOR_VALID_DISTANCE) {
+        json_int(w, "distance", r->distance_cm);
+    } else {
+        json_null(w, "distance");
+    }
+    json_string(w, "status", reading_status(SENSOR_CACHE_DISTANCE, SENSOR_VALID_DISTANCE, r, r->distance_ns,
+                                            SENSOR_DISTANCE_PERIOD_MS, now));
+    json_int(w, "age_ms", age_ms(r->distance_ns, now));
+    if (key != NULL) json_object_end(w);
+}
+
+static void handle_sensors(const http_request_t *req, http_response_t *resp)
+{
+    sensor_reading_t r;
+    json_writer_t w;
+    uint64_t now = now_ns();
+
+    (void)req;
+    sensor_cache_get(&r);
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_int(&w, "timestamp", (long)time(NULL));
+    json_object_begin(&w, "sensors");
+    write_dht(&w, &r, now);
+    write_distance(&w, "ultrasonic", &r, now);
+    json_object_end(&w);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static void handle_distance(const http_request_t *req, http_response_t *resp)
+{
+    sensor_reading_t r;
+    json_writer_t w;
+    uint64_t now = now_ns();
+
+    (void)req;
+    sensor_cache_get(&r);
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_int(&w, "timestamp", (long)time(NULL));
+    write_distance(&w, NULL, &r, now);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+// ---------------- POST ----------------
+
+static void handle_rgb(const http_request_t *req, http_response_t *resp)
+{
+    char action[16];
+    char color[16];
+    json_writer_t w;
+    int red = 0, green = 0, blue = 0;
+
+    if (json_get_string(req->body, req->body_len, "action", action, sizeof(action)) != 0) {
+        http_error(resp, 400, "缺少action字段");
+        return;
+    }
+
+    if (strcmp(action, "on") == 0) {
+        if (json_get_string(req->body, req->body_len, "color", color, sizeof(color)) != 0) {
+            http_error(resp, 400, "缺少color字段");
+            return;
+        }
+        if (strcmp(color, "red") == 0) {
+            red = 1;
+        } else if (strcmp(color, "green") == 0) {
+            green = 1;
+        } else if (strcmp(color, "blue") == 0) {
+            blue = 1;
+        } else if (strcmp(color, "white") == 0) {
+            red = green = blue = 1;
+        } else {
+            http_error(resp, 400, "不支持的颜色");
+            return;
+        }
+    } else if (strcmp(action, "off") != 0) {
+        http_error(resp, 400, "不支持的action");
+        return;
+    }
+
+    rgb_set_color(red, green, blue);
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "success");
+    json_object_begin(&w, "rgb");
+    json_int(&w, "red", red);
+    json_int(&w, "green", green);
+    json_int(&w, "blue", blue);
+    json_object_end(&w);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static void beep_timer_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+    if (beep_available()) beep_off();
+}
+
+static void handle_beep(const http_request_t *req, http_response_t *resp)
+{
+    char action[16];
+    long duration = API_BEEP_DEFAULT_MS;
+    json_writer_t w;
+
+    if (json_get_string(req->body, req->body_len, "action", action, sizeof(action)) != 0) {
+        http_error(resp, 400, "缺少action字段");
+        return;
+    }
+    if (!beep_available()) {
+        http_error(resp, 409, "GPIO18已被舵机占用");
+        return;
+    }
+
+    if (strcmp(action, "beep") == 0) {
+        if (json_get_int(req->body, req->body_len, "duration", &duration) == 0 &&
+            (duration <= 0 || duration > API_BEEP_MAX_MS)) {
+            http_error(resp, 400, "duration超出范围");
+            return;
+        }
+        // 响铃期间再次请求时重新计时
+        beep_on();
+        event_timer_set(&g_beep_timer, (unsigned int)duration, 0);
+    } else if (strcmp(action, "off") == 0) {
+        beep_off();
+        event_timer_set(&g_beep_timer, 0, 0);
+        duration = 0;
+    } else {
+        http_error(resp, 400, "不支持的action");
+        return;
+    }
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "success");
+    json_int(&w, "duration", duration);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static void handle_servo(const http_request_t *req, http_response_t *resp)
+{
+    long angle;
+    json_writer_t w;
+
+    if (json_get_int(req->body, req->body_len, "angle", &angle) != 0) {
+        http_error(resp, 400, "缺少angle字段");
+        return;
+    }
+    if (angle < SERVO_MIN_ANGLE || angle > SERVO_MAX_ANGLE) {
+        http_error(resp, 400, "angle超出范围 (0-180)");
+        return;
+    }
+
+    // 第一次使用时接管GPIO18 (不调用servo_init：它在软件PWM创建失败时退出进程，这里要返回503；
+    // 而且它会先把舵机转回中位，再转到请求的角度)
+    if (!g_servo_active) {
+        if (BEEP_PIN == SERVO_PIN && beep_get_state()) {
+            http_error(resp, 409, "GPIO18正在被蜂鸣器使用");
+            return;
+        }
+        if (softPwmCreate(SERVO_PIN, 0, SERVO_PWM_RANGE) != 0) {
+            http_error(resp, 503, "软件PWM创建失败");
+            return;
+        }
+        g_servo_active = 1;
+    }
+    servo_set_angle((int)angle);
+    g_servo_angle = (int)angle;
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "success");
+    json_int(&w, "angle", g_servo_angle);
+    json_object_end(&w);
+    finish_json(resp, &w);
+}
+
+static const http_route_t g_routes[] = {
+    { HTTP_GET,  "/api/status",   handle_status },
+    { HTTP_GET,  "/api/sensors",  handle_sensors },
+    { HTTP_GET,  "/api/distance", handle_distance },
+    { HTTP_POST, "/api/rgb",      handle_rgb },
+    { HTTP_POST, "/api/beep",     handle_beep },
+    { HTTP_POST, "/api/servo",    handle_servo },
+};
+
+const http_route_t *api_handlers_routes(int *count)
+{
+    *count = (int)(sizeof(g_routes) / sizeof(g_routes[0]));
+    return g_routes;
+}
+
+int api_handlers_init(event_loop_t *loop, unsigned int sensors)
+{
+    g_sensors = sensors;
+    g_servo_active = 0;
+    return event_timer_create(loop, &g_beep_timer, beep_timer_on_event, NULL);
+}
+
+void api_handlers_close(void)
+{
+    event_loop_remove(&g_beep_timer);
+    if (g_servo_active) {
+        softPwmStop(SERVO_PIN);
+        g_servo_active = 0;
+    } else {
+        beep_off();
+    }
+}
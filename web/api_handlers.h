@@ -0,0 +1,21 @@
+#ifndef API_HANDLERS_H
+#define API_HANDLERS_H
+
+#include "event_loop.h"
+#include "http_server.h"
+
+// Web API (README "Web API文档")
+// 传感器数据来自sensor_cache的缓存读数，请求路径上不读取传感器；
+// 蜂鸣器的定时关闭由事件循环的定时器完成，处理函数都立即返回。
+// 蜂鸣器和舵机共用GPIO18：舵机启用后 (第一次设置角度) 蜂鸣器接口返回409。
+
+#define API_BEEP_DEFAULT_MS  200
+#define API_BEEP_MAX_MS      5000
+
+// sensors为传给sensor_cache_start的传感器掩码 (未采样的传感器状态为"disabled")
+int api_handlers_init(event_loop_t *loop, unsigned int sensors);
+void api_handlers_close(void);
+
+const http_route_t *api_handlers_routes(int *count);
+
+#endif // API_HANDLERS_H
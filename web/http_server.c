@@ -0,0 +1,770 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "http_server.h"
+#include "json.h"
+#include "websocket.h"
+
+// 响应头的最大长度，发送缓冲区至少剩余HTTP_RESPONSE_MAX字节时才处理下一个请求
+#define HTTP_HEADER_MAX   256
+#define HTTP_RESPONSE_MAX (HTTP_HEADER_MAX + HTTP_RESPONSE_BODY)
+
+// 单个HTTP连接 (升级为WebSocket后即http_ws_t)
+struct http_conn {
+    event_source_t src;
+    int in_use;
+    uint32_t events;               // 当前注册的epoll事件
+    int paused;                    // 发送缓冲区满，暂停读取
+    int closing;                   // 发送完已有响应后关闭
+    int peer_closed;               // 客户端已关闭写方向
+    uint64_t last_ns;              // 最近一次收发数据的时间
+    uint64_t last_rx_ns;           // 最近一次收到数据的时间 (WebSocket超时判断)
+    const http_ws_handler_t *ws;   // 已升级为WebSocket时的处理函数
+    void *ws_ctx;
+    size_t in_len;
+    size_t out_len;
+    size_t out_sent;
+    char in[HTTP_RECV_BUF];
+    char out[HTTP_SEND_BUF];
+};
+typedef struct http_conn http_conn_t;
+
+static event_source_t g_listener = { -1, NULL, NULL, NULL };
+static event_source_t g_idle_timer = { -1, NULL, NULL, NULL };
+static http_conn_t g_conns[HTTP_MAX_CLIENTS];
+static const http_route_t *g_routes = NULL;
+static int g_route_count = 0;
+static http_server_stats_t g_stats;
+static const http_ws_handler_t *g_ws_routes[HTTP_MAX_WS_ROUTES];
+static int g_ws_route_count = 0;
+static http_conn_t *g_current = NULL;  // 正在处理事件的连接
+
+// 处理函数写入响应体的缓冲区 (单线程，所有连接共用)
+static char g_body[HTTP_RESPONSE_BODY];
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static const char *status_text(int status)
+{
+    switch (status) {
+        case 200: return "OK";
+        case 101: return "Switching Protocols";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Internal Server Error";
+    }
+}
+
+void http_error(http_response_t *resp, int status, const char *message)
+{
+    json_writer_t w;
+
+    json_init(&w, resp->body, resp->body_size);
+    json_object_begin(&w, NULL);
+    json_string(&w, "status", "error");
+    json_string(&w, "message", message);
+    json_object_end(&w);
+
+    int len = json_finish(&w);
+    resp->status = status;
+    resp->content_type = "application/json";
+    resp->body_len = len > 0 ? (size_t)len : 0;
+}
+
+// ---------------- 请求解析 ----------------
+
+// 请求行和请求头之外解析出的信息
+typedef struct {
+    size_t length;                 // 请求总长度 (含请求体)
+    int keep_alive;
+    int upgrade;                   // Upgrade: websocket
+    int ws_version_ok;             // Sec-WebSocket-Version: 13
+    const char *ws_key;            // Sec-WebSocket-Key
+    size_t ws_key_len;
+} request_info_t;
+
+static int header_is(const char *name, size_t len, const char *expected)
+{
+    return len == strlen(expected) && strncasecmp(name, expected, len) == 0;
+}
+
+static int value_has_token(const char *value, size_t len, const char *token)
+{
+    size_t token_len = strlen(token);
+
+    for (size_t i = 0; i + token_len <= len; i++) {
+        if (strncasecmp(value + i, token, token_len) == 0) return 1;
+    }
+    return 0;
+}
+
+// 解析data开头的一个请求：完整时返回1，需要更多数据时返回0，出错时返回-HTTP状态码。
+// 只有在请求完整时才会就地修改缓冲区 (在路径和查询字符串末尾写'\0')。
+static int parse_request(char *data, size_t avail, http_request_t *req, request_info_t *info)
+{
+    static const char empty[] = "";
+    char *hdr_end = memmem(data, avail, "\r\n\r\n", 4);
+
+    if (hdr_end == NULL) return avail >= HTTP_RECV_BUF ? -431 : 0;
+    size_t hdr_len = (size_t)(hdr_end - data) + 4;
+
+    // 请求行: METHOD SP target SP version
+    char *line_end = memchr(data, '\r', hdr_len);
+    char *sp1 = memchr(data, ' ', line_end - data);
+    if (sp1 == NULL) return -400;
+    char *target = sp1 + 1;
+    char *sp2 = memchr(target, ' ', line_end - target);
+    if (sp2 == NULL || sp2 == target) return -400;
+    char *version = sp2 + 1;
+    size_t version_len = (size_t)(line_end - version);
+
+    if (version_len == 8 && memcmp(version, "HTTP/1.1", 8) == 0) {
+        info->keep_alive = 1;
+    } else if (version_len == 8 && memcmp(version, "HTTP/1.0", 8) == 0) {
+        info->keep_alive = 0;
+    } else {
+        return -400;
+    }
+
+    // 请求头
+    size_t content_length = 0;
+    info->upgrade = 0;
+    info->ws_version_ok = 0;
+    info->ws_key = NULL;
+    info->ws_key_len = 0;
+    char *p = line_end + 2;
+    while (p < hdr_end + 2) {
+        char *eol = memchr(p, '\r', hdr_end + 2 - p);
+        char *colon = memchr(p, ':', eol - p);
+        if (colon == NULL) return -400;
+
+        size_t name_len = (size_t)(colon - p);
+        char *value = colon + 1;
+        while (value < eol && (*value == ' ' || *value == '\t')) value++;
+        size_t value_len = (size_t)(eol - value);
+        while (value_len > 0 && (value[value_len - 1] == ' ' || value[value_len - 1] == '\t')) value_len--;
+
+        if (header_is(p, name_len, "Content-Length")) {
+            if (value_len == 0) return -400;
+            content_length = 0;
+            for (size_t i = 0; i < value_len; i++) {
+                if (value[i] < '0' || value[i] > '9') return -400;
+                content_length = content_length * 10 + (value[i] - '0');
+                if (content_length > HTTP_MAX_BODY) return -413;
+            }
+        } else if (header_is(p, name_len, "Connection")) {
+            if (value_has_token(value, value_len, "close")) info->keep_alive = 0;
+            if (value_has_token(value, value_len, "keep-alive")) info->keep_alive = 1;
+        } else if (header_is(p, name_len, "Upgrade")) {
+            info->upgrade = value_has_token(value, value_len, "websocket");
+        } else if (header_is(p, name_len, "Sec-WebSocket-Key")) {
+            info->ws_key = value;
+            info->ws_key_len = value_len;
+        } else if (header_is(p, name_len, "Sec-WebSocket-Version")) {
+            info->ws_version_ok = (value_len == 2 && memcmp(value, "13", 2) == 0);
+        } else if (header_is(p, name_len, "Transfer-Encoding")) {
+            // 不支持分块请求体
+            return -501;
+        }
+        p = eol + 2;
+    }
+
+    info->length = hdr_len + content_length;
+    if (avail < info->length) return info->length > HTTP_RECV_BUF ? -413 : 0;
+
+    // 请求完整，就地截断路径
+    *sp2 = '\0';
+    char *query = memchr(target, '?', sp2 - target);
+    if (query != NULL) {
+        *query = '\0';
+        req->query = query + 1;
+    } else {
+        req->query = empty;
+    }
+    req->path = target;
+
+    size_t method_len = (size_t)(sp1 - data);
+    if (method_len == 3 && memcmp(data, "GET", 3) == 0) {
+        req->method = HTTP_GET;
+    } else if (method_len == 4 && memcmp(data, "POST", 4) == 0) {
+        req->method = HTTP_POST;
+    } else if (method_len == 7 && memcmp(data, "OPTIONS", 7) == 0) {
+        req->method = HTTP_OPTIONS;
+    } else {
+        req->method = HTTP_OTHER;
+    }
+    req->body = data + hdr_len;
+    req->body_len = content_length;
+    return 1;
+}
+
+// ---------------- 响应 ----------------
+
+// 写入一个完整响应 (调用前已确认发送缓冲区剩余至少HTTP_RESPONSE_MAX字节)
+static void append_response(http_conn_t *c, const http_response_t *resp, int keep_alive)
+{
+    const char *extra = "";
+    char *out = c->out + c->out_len;
+
+    // 浏览器跨域请求的预检响应
+    if (resp->status == 204) {
+        extra = "Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n"
+                "Access-Control-Allow-Headers: Content-Type\r\n";
+    }
+    int n = snprintf(out, HTTP_HEADER_MAX,
+                     "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                     "Access-Control-Allow-Origin: *\r\n%sConnection: %s\r\n\r\n",
+                     resp->status, status_text(resp->status), resp->content_type, resp->body_len,
+                     extra, keep_alive ? "keep-alive" : "close");
+    if (n >= HTTP_HEADER_MAX) n = HTTP_HEADER_MAX - 1;
+    memcpy(out + n, resp->body, resp->body_len);
+    c->out_len += n + resp->body_len;
+
+    if (resp->status >= 400) g_stats.errors++;
+}
+
+// 握手成功后连接改为WebSocket，之后接收缓冲区中的数据按WebSocket帧解析
+static void upgrade_websocket(http_conn_t *c, const http_ws_handler_t *handler, const http_request_t *req,
+                              const request_info_t *info)
+{
+    char accept[WS_ACCEPT_SIZE];
+
+    if (info->ws_key == NULL || !info->ws_version_ok) {
+        http_response_t resp = { 0, NULL, g_body, sizeof(g_body), 0 };
+        http_error(&resp, 400, "WebSocket握手无效");
+        append_response(c, &resp, 0);
+        c->closing = 1;
+        return;
+    }
+
+    ws_accept_key(info->ws_key, info->ws_key_len, accept);
+    c->out_len += snprintf(c->out + c->out_len, HTTP_HEADER_MAX,
+                           "HTTP/1.1 101 %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: %s\r\n\r\n", status_text(101), accept);
+
+    // 推送的数据只关心最新状态：缩小内核发送缓冲区，慢客户端尽早体现在http_ws_pending上
+    int sndbuf = HTTP_WS_SNDBUF;
+    setsockopt(c->src.fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+
+    c->ws = handler;
+    c->ws_ctx = NULL;
+    g_stats.websocket_total++;
+    g_stats.websocket_active++;
+    if (handler->on_open(c, req) != 0) {
+        http_ws_close(c, WS_CLOSE_POLICY);
+    }
+}
+
+static void handle_request(http_conn_t *c, const http_request_t *req, const request_info_t *info)
+{
+    http_response_t resp;
+    int keep_alive = info->keep_alive;
+    int path_found = 0;
+
+    resp.status = 200;
+    resp.content_type = "application/json";
+    resp.body = g_body;
+    resp.body_size = sizeof(g_body);
+    resp.body_len = 0;
+
+    if (req->method == HTTP_OPTIONS) {
+        resp.status = 204;
+        append_response(c, &resp, keep_alive);
+        return;
+    }
+
+    if (req->method == HTTP_GET && info->upgrade) {
+        for (int i = 0; i < g_ws_route_count; i++) {
+            if (strcmp(g_ws_routes[i]->path, req->path) == 0) {
+                upgrade_websocket(c, g_ws_routes[i], req, info);
+                return;
+            }
+        }
+    }
+
+    for (int i = 0; i < g_route_count; i++) {
+        if (strcmp(g_routes[i].path, req->path) != 0) continue;
+        path_found = 1;
+        if (g_routes[i].method == req->method) {
+            g_routes[i].handler(req, &resp);
+            append_response(c, &resp, keep_alive);
+            return;
+        }
+    }
+
+    if (path_found) {
+        http_error(&resp, 405, "请求方法不支持");
+    } else {
+        http_error(&resp, 404, "接口不存在");
+    }
+    append_response(c, &resp, keep_alive);
+}
+
+// ---------------- 连接管理 ----------------
+
+static void conn_close(http_conn_t *c)
+{
+    if (c->ws != NULL) {
+        // 先清除，on_close中不能再向该连接发送
+        const http_ws_handler_t *handler = c->ws;
+        c->ws = NULL;
+        g_stats.websocket_active--;
+        handler->on_close(c);
+    }
+    event_loop_remove(&c->src);
+    c->in_use = 0;
+    g_stats.connections_active--;
+}
+
+static void conn_update_events(http_conn_t *c)
+{
+    uint32_t events = 0;
+
+    // 水平触发：暂停读取或准备关闭时不能保留EPOLLIN/EPOLLRDHUP，否则会一直就绪
+    if (!c->paused && !c->closing) events |= EPOLLIN | EPOLLRDHUP;
+    if (c->out_len > c->out_sent) events |= EPOLLOUT;
+    if (events != c->events && event_loop_modify(&c->src, events) == 0) {
+        c->events = events;
+    }
+}
+
+// 尽量发送缓冲区中的响应，socket写满时保留剩余部分
+static int conn_flush(http_conn_t *c)
+{
+    while (c->out_sent < c->out_len) {
+        ssize_t n = send(c->src.fd, c->out + c->out_sent, c->out_len - c->out_sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        c->out_sent += n;
+        c->last_ns = now_ns();
+    }
+
+    if (c->out_sent > 0) {
+        c->out_len -= c->out_sent;
+        memmove(c->out, c->out + c->out_sent, c->out_len);
+        c->out_sent = 0;
+    }
+    return 0;
+}
+
+static int out_space(const http_conn_t *c)
+{
+    return HTTP_SEND_BUF - c->out_len >= HTTP_RESPONSE_MAX;
+}
+
+// 处理接收缓冲区中的WebSocket帧 (不支持分片消息)
+static int ws_process(http_conn_t *c)
+{
+    size_t off = 0;
+
+    while (!c->closing && off < c->in_len) {
+        ws_frame_t frame;
+        int n = ws_parse_frame(c->in + off, c->in_len - off, HTTP_RECV_BUF - WS_MAX_HEADER, &frame);
+        if (n == 0) break;
+        if (n < 0) {
+            http_ws_close(c, WS_CLOSE_PROTOCOL);
+            off = c->in_len;
+            break;
+        }
+        off += n;
+
+        switch (frame.opcode) {
+            case WS_OP_TEXT:
+            case WS_OP_BINARY:
+                if (!frame.fin) {
+                    http_ws_close(c, WS_CLOSE_TOO_BIG);
+                    break;
+                }
+                g_stats.ws_messages++;
+                c->ws->on_message(c, frame.opcode, frame.payload, frame.len);
+                break;
+            case WS_OP_PING:
+                http_ws_send(c, WS_OP_PONG, frame.payload, frame.len);
+                break;
+            case WS_OP_PONG:
+                break;
+            case WS_OP_CLOSE:
+                // 回复关闭帧 (只带回关闭码)，发送完后断开
+                http_ws_send(c, WS_OP_CLOSE, frame.payload, frame.len >= 2 ? 2 : 0);
+                c->closing = 1;
+                break;
+            default:
+                http_ws_close(c, WS_CLOSE_PROTOCOL);
+                break;
+        }
+        if (c->ws == NULL) break;
+    }
+
+    if (off > 0) {
+        c->in_len -= off;
+        memmove(c->in, c->in + off, c->in_len);
+    }
+    if (c->peer_closed) c->closing = 1;
+    return 0;
+}
+
+// 依次处理接收缓冲区中的完整请求
+static int conn_process(http_conn_t *c)
+{
+    if (c->ws != NULL) return ws_process(c);
+
+    size_t off = 0;
+    int handled = 0;
+
+    while (!c->closing && c->ws == NULL && off < c->in_len) {
+        http_request_t req;
+        request_info_t info;
+
+        // 发送缓冲区放不下下一个响应：先发送，仍然不够时暂停读取
+        if (!out_space(c)) {
+            if (conn_flush(c) != 0) return -1;
+            if (!out_space(c)) {
+                c->paused = 1;
+                g_stats.read_paused++;
+                break;
+            }
+        }
+
+        int ret = parse_request(c->in + off, c->in_len - off, &req, &info);
+        if (ret == 0) break;
+        if (ret < 0) {
+            http_response_t resp = { 0, NULL, g_body, sizeof(g_body), 0 };
+            http_error(&resp, -ret, "请求格式错误");
+            append_response(c, &resp, 0);
+            c->closing = 1;
+            off = c->in_len;
+            break;
+        }
+
+        if (handled++ > 0) g_stats.pipelined++;
+        g_stats.requests++;
+        handle_request(c, &req, &info);
+        if (!info.keep_alive && c->ws == NULL) c->closing = 1;
+        off += info.length;
+    }
+
+    if (off > 0) {
+        c->in_len -= off;
+        memmove(c->in, c->in + off, c->in_len);
+    }
+    // 升级请求之后已经到达的数据是WebSocket帧
+    if (c->ws != NULL && !c->closing) return ws_process(c);
+    // 客户端不再发送：处理完已收到的请求后关闭
+    if (c->peer_closed && !c->paused) c->closing = 1;
+    return 0;
+}
+
+static void conn_handle_event(http_conn_t *c, uint32_t events)
+{
+    event_source_t *src = &c->src;
+
+    if (events & EPOLLERR) {
+        conn_close(c);
+        return;
+    }
+
+    if (events & EPOLLOUT) {
+        if (conn_flush(c) != 0) {
+            conn_close(c);
+            return;
+        }
+        // 客户端取走了响应，继续处理暂停期间留在缓冲区中的请求
+        if (c->paused && out_space(c)) {
+            c->paused = 0;
+            if (conn_process(c) != 0 || conn_flush(c) != 0) {
+                conn_close(c);
+                return;
+            }
+        }
+    }
+
+    if ((events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) && !c->paused && !c->closing &&
+        c->in_len < HTTP_RECV_BUF) {
+        // 水平触发：每次事件只读一次，多个连接之间保持公平
+        ssize_t n = recv(src->fd, c->in + c->in_len, HTTP_RECV_BUF - c->in_len, 0);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EINTR) {
+                conn_close(c);
+                return;
+            }
+        } else {
+            if (n == 0) {
+                c->peer_closed = 1;
+            } else {
+                c->in_len += n;
+                c->last_ns = now_ns();
+                c->last_rx_ns = c->last_ns;
+            }
+            // 本次读取中的所有响应合并为一次发送
+            if (conn_process(c) != 0 || conn_flush(c) != 0) {
+                conn_close(c);
+                return;
+            }
+        }
+    }
+
+    if (c->closing && c->out_len == 0) {
+        conn_close(c);
+        return;
+    }
+    conn_update_events(c);
+}
+
+static void conn_on_event(event_source_t *src, uint32_t events)
+{
+    // 回调中的http_ws_close只做标记，由conn_handle_event在最后关闭连接
+    g_current = (http_conn_t *)src->ctx;
+    conn_handle_event(g_current, events);
+    g_current = NULL;
+}
+
+// 关闭超过HTTP_KEEPALIVE_MS没有收发数据的连接；
+// WebSocket连接空闲时发送PING，超过HTTP_WS_TIMEOUT_MS没有收到任何数据 (包括PONG) 时关闭
+static void idle_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+    if (event_timer_read(src) == 0) return;
+
+    uint64_t now = now_ns();
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        http_conn_t *c = &g_conns[i];
+        if (!c->in_use) continue;
+
+        if (c->ws != NULL) {
+            if (now - c->last_rx_ns > (uint64_t)HTTP_WS_TIMEOUT_MS * 1000000ULL) {
+                g_stats.idle_closed++;
+                conn_close(c);
+            } else if (now - c->last_ns > (uint64_t)HTTP_WS_PING_MS * 1000000ULL) {
+                http_ws_send(c, WS_OP_PING, NULL, 0);
+            }
+        } else if (now - c->last_ns > (uint64_t)HTTP_KEEPALIVE_MS * 1000000ULL) {
+            g_stats.idle_closed++;
+            conn_close(c);
+        }
+    }
+}
+
+static http_conn_t *conn_alloc(void)
+{
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        if (!g_conns[i].in_use) return &g_conns[i];
+    }
+    return NULL;
+}
+
+static void listener_on_event(event_source_t *src, uint32_t events)
+{
+    (void)events;
+
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept4(src->fd, (struct sockaddr *)&addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EINTR) perror("accept失败");
+            return;
+        }
+
+        http_conn_t *c = conn_alloc();
+        if (c == NULL) {
+            g_stats.connections_rejected++;
+            close(fd);
+            continue;
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        c->in_use = 1;
+        c->events = EPOLLIN | EPOLLRDHUP;
+        c->paused = 0;
+        c->closing = 0;
+        c->peer_closed = 0;
+        c->last_ns = now_ns();
+        c->last_rx_ns = c->last_ns;
+        c->ws = NULL;
+        c->ws_ctx = NULL;
+        c->in_len = 0;
+        c->out_len = 0;
+        c->out_sent = 0;
+        c->src.fd = fd;
+        c->src.handler = conn_on_event;
+        c->src.ctx = c;
+        if (event_loop_add(src->loop, &c->src, c->events) != 0) {
+            close(fd);
+            c->src.fd = -1;
+            c->in_use = 0;
+            continue;
+        }
+
+        g_stats.connections_total++;
+        g_stats.connections_active++;
+    }
+}
+
+// 启动HTTP服务器：routes在服务器运行期间必须保持有效
+int http_server_start(event_loop_t *loop, int port, const http_route_t *routes, int route_count)
+{
+    struct sockaddr_in addr;
+    int one = 1;
+
+    g_routes = routes;
+    g_route_count = route_count;
+    memset(&g_stats, 0, sizeof(g_stats));
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        g_conns[i].in_use = 0;
+        g_conns[i].src.fd = -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("创建socket失败");
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        perror("绑定端口失败");
+        close(fd);
+        return -1;
+    }
+
+    g_listener.fd = fd;
+    g_listener.handler = listener_on_event;
+    g_listener.ctx = NULL;
+    if (event_loop_add(loop, &g_listener, EPOLLIN) != 0) {
+        close(fd);
+        g_listener.fd = -1;
+        return -1;
+    }
+
+    if (event_timer_create(loop, &g_idle_timer, idle_on_event, NULL) != 0 ||
+        event_timer_set(&g_idle_timer, 1000, 1000) != 0) {
+        event_loop_remove(&g_idle_timer);
+        event_loop_remove(&g_listener);
+        return -1;
+    }
+
+    printf("Web服务器正在所有网口的%d端口监听中 (最多%d个连接)\n", port, HTTP_MAX_CLIENTS);
+    return 0;
+}
+
+void http_server_stop(void)
+{
+    for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+        if (g_conns[i].in_use) conn_close(&g_conns[i]);
+    }
+    event_loop_remove(&g_idle_timer);
+    event_loop_remove(&g_listener);
+    g_ws_route_count = 0;
+}
+
+int http_server_add_websocket(const http_ws_handler_t *handler)
+{
+    if (g_ws_route_count >= HTTP_MAX_WS_ROUTES) return -1;
+    g_ws_routes[g_ws_route_count++] = handler;
+    return 0;
+}
+
+// ---------------- WebSocket ----------------
+
+int http_ws_send(http_ws_t *ws, int opcode, const void *data, size_t len)
+{
+    http_conn_t *c = ws;
+    uint8_t header[WS_MAX_HEADER];
+
+    if (c->ws == NULL || c->closing) return -1;
+    if (HTTP_SEND_BUF - c->out_len < WS_MAX_HEADER + len) return -1;
+
+    size_t n = ws_frame_header(header, opcode, len);
+    memcpy(c->out + c->out_len, header, n);
+    if (len > 0) memcpy(c->out + c->out_len + n, data, len);
+    c->out_len += n + len;
+
+    // 事件回调中由conn_handle_event统一发送
+    if (c != g_current) {
+        if (conn_flush(c) != 0) {
+            conn_close(c);
+            return -1;
+        }
+        conn_update_events(c);
+    }
+    return 0;
+}
+
+size_t http_ws_pending(const http_ws_t *ws)
+{
+    return ws->out_len - ws->out_sent;
+}
+
+void http_ws_close(http_ws_t *ws, uint16_t code)
+{
+    http_conn_t *c = ws;
+    uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+
+    if (c->ws == NULL || c->closing) return;
+    http_ws_send(c, WS_OP_CLOSE, payload, sizeof(payload));
+    c->closing = 1;
+    if (c != g_current && c->in_use) {
+        if (c->out_len == 0) {
+            conn_close(c);
+        } else {
+            conn_update_events(c);
+        }
+    }
+}
+
+void http_ws_set_ctx(http_ws_t *ws, void *ctx)
+{
+    ws->ws_ctx = ctx;
+}
+
+void *http_ws_get_ctx(const http_ws_t *ws)
+{
+    return ws->ws_ctx;
+}
+
+http_server_stats_t http_server_get_stats(void)
+{
+    return g_stats;
+}
+
+int http_server_format_stats(char *buf, int size)
+{
+    int len = snprintf(buf, size,
+                       "http_requests=%lu http_pipelined=%lu http_errors=%lu http_connections=%lu "
+                       "http_rejected=%lu http_idle_closed=%lu http_read_paused=%lu ws_upgrades=%lu ws_messages=%lu",
+                       g_stats.requests, g_stats.pipelined, g_stats.errors, g_stats.connections_total,
+                       g_stats.connections_rejected, g_stats.idle_closed, g_stats.read_paused,
+                       g_stats.websocket_total, g_stats.ws_messages);
+    if (len >= size) len = size - 1;
+    return len;
+}
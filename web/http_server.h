@@ -0,0 +1,103 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "event_loop.h"
+
+// 嵌入式HTTP/1.1服务器 (Web API)
+// 与控制服务器相同的单线程epoll循环，每个连接使用固定大小的收发缓冲区，运行中不分配内存。
+// 支持keep-alive和流水线：一次读取中的多个请求依次处理，响应按顺序合并为一次发送；
+// 发送缓冲区放不下下一个响应时暂停读取该连接，直到客户端取走已有的响应。
+// 请求处理函数必须立即返回，不能在事件循环中等待传感器或延时。
+// 带Upgrade: websocket的GET请求路径匹配已注册的WebSocket路由时，连接升级为WebSocket (RFC 6455)。
+
+#define HTTP_SERVER_PORT     8080
+#define HTTP_MAX_CLIENTS     64
+#define HTTP_RECV_BUF        4096   // 请求头和请求体的总长度上限
+#define HTTP_SEND_BUF        16384
+#define HTTP_MAX_BODY        2048   // 请求体上限 (运动程序脚本)
+#define HTTP_RESPONSE_BODY   2048   // 响应体上限
+#define HTTP_KEEPALIVE_MS    15000  // 空闲连接超时
+#define HTTP_MAX_WS_ROUTES   4
+#define HTTP_WS_SNDBUF       2048   // WebSocket连接的内核发送缓冲区 (内核会加倍)
+#define HTTP_WS_PING_MS      10000  // WebSocket连接空闲时发送PING的间隔
+#define HTTP_WS_TIMEOUT_MS   30000  // WebSocket连接没有收到任何数据的超时
+
+typedef enum {
+    HTTP_GET = 0,
+    HTTP_POST,
+    HTTP_OPTIONS,
+    HTTP_OTHER
+} http_method_t;
+
+typedef struct {
+    http_method_t method;
+    const char *path;              // 不含查询字符串，以'\0'结尾
+    const char *query;             // '?'之后的部分，没有时为空字符串
+    const char *body;              // 不以'\0'结尾，长度为body_len
+    size_t body_len;
+} http_request_t;
+
+typedef struct {
+    int status;
+    const char *content_type;
+    char *body;                    // 服务器提供的缓冲区 (HTTP_RESPONSE_BODY字节)
+    size_t body_size;
+    size_t body_len;
+} http_response_t;
+
+typedef void (*http_handler_t)(const http_request_t *req, http_response_t *resp);
+
+// 路由表：method和path完全匹配
+typedef struct {
+    http_method_t method;
+    const char *path;
+    http_handler_t handler;
+} http_route_t;
+
+typedef struct {
+    unsigned long requests;        // 已处理的请求
+    unsigned long pipelined;       // 与前一个请求在同一次读取中到达的请求
+    unsigned long errors;          // 4xx/5xx响应
+    unsigned long connections_total;
+    unsigned long connections_rejected;
+    unsigned long idle_closed;     // keep-alive超时关闭
+    unsigned long read_paused;     // 发送缓冲区满而暂停读取的次数
+    unsigned long websocket_total; // 累计WebSocket升级数
+    unsigned long ws_messages;     // 收到的WebSocket消息
+    int connections_active;
+    int websocket_active;
+} http_server_stats_t;
+
+// 升级为WebSocket的连接
+typedef struct http_conn http_ws_t;
+
+// WebSocket路由：回调都在事件循环线程中调用
+typedef struct {
+    const char *path;
+    int (*on_open)(http_ws_t *ws, const http_request_t *req);  // 返回非0时以1008关闭
+    void (*on_message)(http_ws_t *ws, int opcode, const char *data, size_t len);
+    void (*on_close)(http_ws_t *ws);
+} http_ws_handler_t;
+
+int http_server_start(event_loop_t *loop, int port, const http_route_t *routes, int route_count);
+void http_server_stop(void);
+http_server_stats_t http_server_get_stats(void);
+int http_server_format_stats(char *buf, int size);
+
+// 注册WebSocket路由 (handler在服务器运行期间必须保持有效)
+int http_server_add_websocket(const http_ws_handler_t *handler);
+
+// 发送一条消息 (WS_OP_TEXT/WS_OP_BINARY)：发送缓冲区放不下时返回-1，不阻塞
+int http_ws_send(http_ws_t *ws, int opcode, const void *data, size_t len);
+// 还没有写入socket的字节数 (用于背压判断)
+size_t http_ws_pending(const http_ws_t *ws);
+void http_ws_close(http_ws_t *ws, uint16_t code);
+void http_ws_set_ctx(http_ws_t *ws, void *ctx);
+void *http_ws_get_ctx(const http_ws_t *ws);
+
+// 处理函数使用的辅助函数：写入JSON错误响应 {"status":"error","message":...}
+void http_error(http_response_t *resp, int status, const char *message);
+
+#endif // HTTP_SERVER_H
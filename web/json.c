@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "json.h"
+
+// ---------------- 写入 ----------------
+
+void json_init(json_writer_t *w, char *buf, size_t size)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->overflow = (size == 0);
+    w->depth = 0;
+    w->count[0] = 0;
+    if (size > 0) buf[0] = '\0';
+}
+
+int json_finish(json_writer_t *w)
+{
+    if (w->overflow || w->depth != 0) return -1;
+    w->buf[w->len] = '\0';
+    return (int)w->len;
+}
+
+// 始终为结尾的'\0'保留一个字节
+static void put(json_writer_t *w, const char *s, size_t n)
+{
+    if (w->overflow) return;
+    if (w->len + n >= w->size) {
+        w->overflow = 1;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_char(json_writer_t *w, char c)
+{
+    put(w, &c, 1);
+}
+
+static void put_escaped(json_writer_t *w, const char *s)
+{
+    put_char(w, '"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            put_char(w, '\\');
+            put_char(w, (char)c);
+        } else if (c < 0x20) {
+            char tmp[8];
+            int n = snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+            put(w, tmp, n);
+        } else {
+            put_char(w, (char)c);
+        }
+    }
+    put_char(w, '"');
+}
+
+// 成员之间的逗号和键名
+static void begin_value(json_writer_t *w, const char *key)
+{
+    if (w->count[w->depth]++ > 0) put_char(w, ',');
+    if (key != NULL) {
+        put_escaped(w, key);
+        put_char(w, ':');
+    }
+}
+
+static void begin_container(json_writer_t *w, const char *key, char open)
+{
+    begin_value(w, key);
+    put_char(w, open);
+    if (w->depth + 1 >= JSON_MAX_DEPTH) {
+        w->overflow = 1;
+        return;
+    }
+    w->depth++;
+    w->count[w->depth] = 0;
+}
+
+static void end_container(json_writer_t *w, char close)
+{
+    put_char(w, close);
+    if (w->depth > 0) w->depth--;
+}
+
+void json_object_begin(json_writer_t *w, const char *key)
+{
+    begin_container(w, key, '{');
+}
+
+void json_object_end(json_writer_t *w)
+{
+    end_container(w, '}');
+}
+
+void json_array_begin(json_writer_t *w, const char *key)
+{
+    begin_container(w, key, '[');
+}
+
+void json_array_end(json_writer_t *w)
+{
+    end_container(w, ']');
+}
+
+void json_string(json_writer_t *w, const char *key, const char *value)
+{
+    begin_value(w, key);
+    put_escaped(w, value);
+}
+
+void json_int(json_writer_t *w, const char *key, long value)
+{
+    char tmp[24];
+    int n = snprintf(tmp, sizeof(tmp), "%ld", value);
+
+    begin_value(w, key);
+    put(w, tmp, n);
+}
+
+void json_double(json_writer_t *w, const char *key, double value, int decimals)
+{
+    char tmp[32];
+
+    // NaN和无穷大不是合法的JSON数字
+    if (!isfinite(value)) {
+        json_null(w, key);
+        return;
+    }
+    int n = snprintf(tmp, sizeof(tmp), "%.*f", decimals, value);
+    begin_value(w, key);
+    put(w, tmp, n < (int)sizeof(tmp) ? n : (int)sizeof(tmp) - 1);
+}
+
+void json_bool(json_writer_t *w, const char *key, int value)
+{
+    begin_value(w, key);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w, const char *key)
+{
+    begin_value(w, key);
+    put(w, "null", 4);
+}
+
+// ---------------- 读取 ----------------
+
+static const char *skip_ws(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+    return p;
+}
+
+// p指向起始引号，返回结束引号之后的位置
+static const char *skip_string(const char *p, const char *end)
+{
+    for (p++; p < end; p++) {
+        if (*p == '\\') {
+            p++;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return NULL;
+}
+
+static const char *skip_value(const char *p, const char *end)
+{
+    if (p >= end) return NULL;
+    if (*p == '"') return skip_string(p, end);
+
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        while (p < end) {
+            if (*p == '"') {
+                p = skip_string(p, end);
+                if (p == NULL) return NULL;
+                continue;
+            }
+            if (*p == '{' || *p == '[') {
+                depth++;
+            } else if (*p == '}' || *p == ']') {
+                if (--depth == 0) return p + 1;
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    // 数字、true/false/null
+    const char *start = p;
+    while (p < end && strchr(",}] \t\r\n", *p) == NULL) p++;
+    return p > start ? p : NULL;
+}
+
+// 返回顶层对象中key对应值的起始位置
+static const char *find_member(const char *json, size_t len, const char *key)
+{
+    const char *end = json + len;
+    size_t key_len = strlen(key);
+    const char *p = skip_ws(json, end);
+
+    if (p >= end || *p != '{') return NULL;
+    p++;
+    for (;;) {
+        p = skip_ws(p, end);
+        if (p >= end || *p != '"') return NULL;
+
+        const char *name = p + 1;
+        p = skip_string(p, end);
+        if (p == NULL) return NULL;
+        size_t name_len = (size_t)(p - 1 - name);
+
+        p = skip_ws(p, end);
+        if (p >= end || *p != ':') return NULL;
+        p = skip_ws(p + 1, end);
+        if (name_len == key_len && memcmp(name, key, key_len) == 0) return p;
+
+        p = skip_value(p, end);
+        if (p == NULL) return NULL;
+        p = skip_ws(p, end);
+        if (p >= end || *p != ',') return NULL;
+        p++;
+    }
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// 请求体不一定以'\0'结尾，只在[json, json+len)范围内读取
+int json_get_string(const char *json, size_t len, const char *key, char *out, size_t out_size)
+{
+    const char *end = json + len;
+    const char *p = find_member(json, len, key);
+    size_t n = 0;
+
+    if (p == NULL || p >= end || *p != '"' || out_size == 0) return -1;
+
+    for (p++; p < end && *p != '"'; p++) {
+        char c = *p;
+        if (c == '\\') {
+            if (++p >= end) return -1;
+            switch (*p) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'u':
+                    // 只需要ASCII的字段值，其他字符用'?'代替
+                    if (end - p < 5) return -1;
+                    {
+                        unsigned int code = 0;
+                        for (int i = 1; i <= 4; i++) {
+                            int digit = hex_digit(p[i]);
+                            if (digit < 0) return -1;
+                            code = code * 16 + digit;
+                        }
+                        c = code < 0x80 ? (char)code : '?';
+                    }
+                    p += 4;
+                    break;
+                default: c = *p; break;
+            }
+        }
+        if (n + 1 >= out_size) return -1;
+        out[n++] = c;
+    }
+    if (p >= end) return -1;
+    out[n] = '\0';
+    return 0;
+}
+
+int json_get_int(const char *json, size_t len, const char *key, long *out)
+{
+    const char *end = json + len;
+    const char *p = find_member(json, len, key);
+    int negative = 0;
+    long value = 0;
+
+    if (p == NULL || p >= end) return -1;
+    if (*p == '-') {
+        negative = 1;
+        p++;
+    }
+    if (p >= end || *p < '0' || *p > '9') return -1;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (value > 100000000L) return -1;
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    // 小数和指数不是整数
+    if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) return -1;
+
+    *out = negative ? -value : value;
+    return 0;
+}
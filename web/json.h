@@ -0,0 +1,39 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+
+// 轻量JSON读写 (Web API使用，不分配内存)
+// 写：直接序列化到调用者提供的缓冲区，空间不足时置overflow，json_finish返回-1。
+// 读：在请求体中查找顶层对象的字段，不建立语法树。
+
+#define JSON_MAX_DEPTH 8
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    int overflow;
+    int depth;
+    int count[JSON_MAX_DEPTH];     // 各层已写入的成员数 (决定是否需要逗号)
+} json_writer_t;
+
+void json_init(json_writer_t *w, char *buf, size_t size);
+int json_finish(json_writer_t *w);  // 返回JSON长度，溢出时返回-1
+
+// key为NULL时写入顶层值或数组元素
+void json_object_begin(json_writer_t *w, const char *key);
+void json_object_end(json_writer_t *w);
+void json_array_begin(json_writer_t *w, const char *key);
+void json_array_end(json_writer_t *w);
+void json_string(json_writer_t *w, const char *key, const char *value);
+void json_int(json_writer_t *w, const char *key, long value);
+void json_double(json_writer_t *w, const char *key, double value, int decimals);
+void json_bool(json_writer_t *w, const char *key, int value);
+void json_null(json_writer_t *w, const char *key);
+
+// 读取顶层对象中的字段：找到且类型正确时返回0
+int json_get_string(const char *json, size_t len, const char *key, char *out, size_t out_size);
+int json_get_int(const char *json, size_t len, const char *key, long *out);
+
+#endif // JSON_H
@@ -0,0 +1,22 @@
+#ifndef SHA1_H
+#define SHA1_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// SHA-1 (只用于WebSocket握手的Sec-WebSocket-Accept计算)
+
+#define SHA1_DIGEST_SIZE 20
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;               // 已输入的字节数
+    uint8_t block[64];
+    size_t used;
+} sha1_ctx_t;
+
+void sha1_init(sha1_ctx_t *ctx);
+void sha1_update(sha1_ctx_t *ctx, const void *data, size_t len);
+void sha1_final(sha1_ctx_t *ctx, uint8_t digest[SHA1_DIGEST_SIZE]);
+
+#endif // SHA1_H
@@ -0,0 +1,92 @@
+#include <string.h>
+#include "websocket.h"
+#include "sha1.h"
+
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+static void base64_encode(const uint8_t *data, size_t len, char *out)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
+
+    for (i = 0; i + 2 < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+        *out++ = table[(v >> 18) & 0x3f];
+        *out++ = table[(v >> 12) & 0x3f];
+        *out++ = table[(v >> 6) & 0x3f];
+        *out++ = table[v & 0x3f];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)data[i] << 16 | (i + 1 < len ? (uint32_t)data[i + 1] << 8 : 0);
+        *out++ = table[(v >> 18) & 0x3f];
+        *out++ = table[(v >> 12) & 0x3f];
+        *out++ = i + 1 < len ? table[(v >> 6) & 0x3f] : '=';
+        *out++ = '=';
+    }
+    *out = '\0';
+}
+
+void ws_accept_key(const char *key, size_t key_len, char out[WS_ACCEPT_SIZE])
+{
+    sha1_ctx_t ctx;
+    uint8_t digest[SHA1_DIGEST_SIZE];
+
+    sha1_init(&ctx);
+    sha1_update(&ctx, key, key_len);
+    sha1_update(&ctx, WS_GUID, strlen(WS_GUID));
+    sha1_final(&ctx, digest);
+    base64_encode(digest, sizeof(digest), out);
+}
+
+size_t ws_frame_header(uint8_t *buf, int opcode, size_t len)
+{
+    buf[0] = 0x80 | (opcode & 0x0f);    // FIN，服务器不分片
+    if (len < 126) {
+        buf[1] = (uint8_t)len;
+        return 2;
+    }
+    if (len <= 0xffff) {
+        buf[1] = 126;
+        buf[2] = (uint8_t)(len >> 8);
+        buf[3] = (uint8_t)len;
+        return 4;
+    }
+    buf[1] = 127;
+    for (int i = 0; i < 8; i++) buf[2 + i] = (uint8_t)((uint64_t)len >> (56 - i * 8));
+    return 10;
+}
+
+int ws_parse_frame(char *data, size_t avail, size_t max_payload, ws_frame_t *frame)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    size_t pos = 2;
+    uint64_t len;
+
+    if (avail < 2) return 0;
+    // 客户端发往服务器的帧必须带掩码
+    if (!(p[1] & 0x80)) return -1;
+
+    len = p[1] & 0x7f;
+    if (len == 126) {
+        if (avail < 4) return 0;
+        len = (uint64_t)p[2] << 8 | p[3];
+        pos = 4;
+    } else if (len == 127) {
+        if (avail < 10) return 0;
+        len = 0;
+        for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+        pos = 10;
+    }
+    if (len > max_payload) return -1;
+    if (avail < pos + 4 + len) return 0;
+
+    const uint8_t *mask = p + pos;
+    char *payload = data + pos + 4;
+    for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+
+    frame->fin = (p[0] & 0x80) != 0;
+    frame->opcode = p[0] & 0x0f;
+    frame->payload = payload;
+    frame->len = (size_t)len;
+    return (int)(pos + 4 + len);
+}
@@ -0,0 +1,43 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// WebSocket帧编解码和握手 (RFC 6455，http_server.c使用)
+
+#define WS_OP_CONTINUATION 0x0
+#define WS_OP_TEXT         0x1
+#define WS_OP_BINARY       0x2
+#define WS_OP_CLOSE        0x8
+#define WS_OP_PING         0x9
+#define WS_OP_PONG         0xa
+
+// 关闭码
+#define WS_CLOSE_NORMAL        1000
+#define WS_CLOSE_PROTOCOL      1002
+#define WS_CLOSE_UNSUPPORTED   1003
+#define WS_CLOSE_POLICY        1008
+#define WS_CLOSE_TOO_BIG       1009
+
+#define WS_MAX_HEADER  14          // 服务器发出的帧头最长10字节，客户端帧头 (带掩码) 最长14字节
+#define WS_ACCEPT_SIZE 29          // Sec-WebSocket-Accept (28字符 + '\0')
+
+typedef struct {
+    int fin;
+    int opcode;
+    char *payload;                 // 已去掉掩码，指向接收缓冲区
+    size_t len;
+} ws_frame_t;
+
+// 由Sec-WebSocket-Key计算Sec-WebSocket-Accept
+void ws_accept_key(const char *key, size_t key_len, char out[WS_ACCEPT_SIZE]);
+
+// 写入服务器帧头 (不带掩码)，返回帧头长度
+size_t ws_frame_header(uint8_t *buf, int opcode, size_t len);
+
+// 解析客户端帧并就地去掉掩码：完整时返回帧长度，不完整返回0，
+// 未带掩码或负载超过max_payload时返回-1
+int ws_parse_frame(char *data, size_t avail, size_t max_payload, ws_frame_t *frame);
+
+#endif // WEBSOCKET_H
@@ -0,0 +1,96 @@
+// Web API服务器：HTTP/1.1 REST接口控制RGB灯、蜂鸣器、舵机，读取缓存的传感器数据
+// 用法: web_main [-p 端口] [-M 指标端口，0表示不启用]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <wiringPi.h>
+#include "event_loop.h"
+#include "http_server.h"
+#include "api_handlers.h"
+#include "sensor_cache.h"
+#include "rgb.h"
+#include "beep.h"
+#include "logger.h"
+#include "metrics.h"
+
+static event_loop_t g_loop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    event_loop_stop(&g_loop);
+}
+
+static void print_usage(const char *prog)
+{
+    printf("用法: %s [-p 端口] [-M 指标端口]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int sensors = SENSOR_CACHE_DHT | SENSOR_CACHE_DISTANCE;
+    int port = HTTP_SERVER_PORT;
+    int metrics_port = METRICS_PORT;
+    int route_count;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:M:h")) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'M':
+                metrics_port = atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (wiringPiSetupGpio() == -1) {
+        printf("初始化 wiringPi 失败!\n");
+        return 1;
+    }
+
+    // 不设置SA_RESTART，收到信号时epoll_wait立即返回
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (event_loop_init(&g_loop) != 0 || log_start(NULL) != 0) {
+        return 1;
+    }
+
+    rgb_init();
+    beep_init();
+    const http_route_t *routes = api_handlers_routes(&route_count);
+    if (api_handlers_init(&g_loop, sensors) != 0 ||
+        http_server_start(&g_loop, port, routes, route_count) != 0) {
+        api_handlers_close();
+        event_loop_close(&g_loop);
+        return 1;
+    }
+    sensor_cache_start(sensors);
+    // 指标导出失败不影响Web服务
+    metrics_serve_start(metrics_port);
+
+    event_loop_run(&g_loop);
+
+    char line[256];
+    http_server_format_stats(line, sizeof(line));
+    printf("\n%s\n", line);
+
+    metrics_serve_stop();
+    http_server_stop();
+    api_handlers_close();
+    sensor_cache_stop();
+    rgb_cleanup();
+    event_loop_close(&g_loop);
+    return 0;
+}